@@ -77,6 +77,7 @@ namespace AudioCommon
 					std::string audio_file_name = File::GetUserPath(D_DUMPAUDIO_IDX) + "audiodump.wav";
 					File::CreateFullPath(audio_file_name);
 					mixer->StartLogAudio(audio_file_name);
+					mixer->StartLogDSPAudio(File::GetUserPath(D_DUMPAUDIO_IDX) + "dspdump.wav");
 				}
 
 				return soundStream;
@@ -99,8 +100,10 @@ namespace AudioCommon
 		{
 			soundStream->Stop();
 			if (SConfig::GetInstance().m_DumpAudio)
+			{
 				soundStream->GetMixer()->StopLogAudio();
-				//soundStream->StopLogAudio();
+				soundStream->GetMixer()->StopLogDSPAudio();
+			}
 			delete soundStream;
 			soundStream = nullptr;
 		}
@@ -180,4 +183,17 @@ namespace AudioCommon
 
 		soundStream->Update();
 	}
+
+	void SendAIStreamingBuffer(short *samples, unsigned int num_samples, unsigned int sample_rate)
+	{
+		if (!soundStream)
+			return;
+
+		CMixer* pMixer = soundStream->GetMixer();
+
+		if (pMixer && samples)
+		{
+			pMixer->PushStreamingSamples(samples, num_samples, sample_rate);
+		}
+	}
 }
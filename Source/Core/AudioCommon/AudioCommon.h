@@ -21,4 +21,5 @@ namespace AudioCommon
 	void UpdateSoundStream();
 	void ClearAudioBuffer(bool mute);
 	void SendAIBuffer(short* samples, unsigned int num_samples);
+	void SendAIStreamingBuffer(short* samples, unsigned int num_samples, unsigned int sample_rate);
 }
@@ -2,10 +2,12 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <cmath>
+
 #include "AudioCommon/AudioCommon.h"
 #include "AudioCommon/Mixer.h"
-#include "Common/Atomic.h"
 #include "Common/CPUDetect.h"
+#include "Common/MathUtil.h"
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/HW/AudioInterface.h"
@@ -14,36 +16,252 @@
 // UGLINESS
 #include "Core/PowerPC/PowerPC.h"
 
-#if _M_SSE >= 0x301 && !(defined __GNUC__ && !defined __SSSE3__)
-#include <tmmintrin.h>
+#if _M_X86
+#include <emmintrin.h>
 #endif
 
-// Executed from sound stream thread
-unsigned int CMixer::Mix(short* samples, unsigned int numSamples, bool consider_framelimit)
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Linear interpolation between the current and next frame of the ring:
+//   out = (cur * (0x10000 - frac) + next * frac) >> 16
+static unsigned int ResampleLinear(const short* buffer, short* samples, unsigned int num_frames,
+                                   u32 indexW, u32& indexR, u32& frac, u32 ratio, bool use_simd)
 {
-	if (!samples)
-		return 0;
+	unsigned int frame = 0;
+
+#if _M_X86
+	// Four frames at a time. Positions and fractions are stepped in scalar code, the
+	// interpolation itself uses pmaddwd on (cur, next) pairs. The weights don't fit in
+	// 16 bits, so they are split into their high and low bytes, which keeps the result
+	// bit exact with the scalar loop below.
+	while (use_simd && frame + 4 <= num_frames)
+	{
+		u32 pos[4], fracs[4];
+		u32 r = indexR, f = frac;
+		bool available = true;
+		for (int i = 0; i < 4; i++)
+		{
+			available &= ((indexW - r) & INDEX_MASK) > 2;
+			pos[i] = r;
+			fracs[i] = f;
+			f += ratio;
+			r += 2 * (u16)(f >> 16);
+			f &= 0xffff;
+		}
+		if (!available)
+			break;
+
+		__m128i pairs[4], weights_hi[4], weights_lo[4];
+		for (int i = 0; i < 4; i++)
+		{
+			__m128i cur = _mm_cvtsi32_si128(*(const u32*)&buffer[pos[i] & INDEX_MASK]);
+			__m128i next = _mm_cvtsi32_si128(*(const u32*)&buffer[(pos[i] + 2) & INDEX_MASK]);
+			// cur0 cur1 next0 next1 -> cur0 next0 cur1 next1
+			pairs[i] = _mm_shufflelo_epi16(_mm_unpacklo_epi32(cur, next), _MM_SHUFFLE(3, 1, 2, 0));
+
+			u32 wcur = 0x10000 - fracs[i];
+			u32 wnext = fracs[i];
+			weights_hi[i] = _mm_set1_epi32((int)((wnext >> 8) << 16 | (wcur >> 8)));
+			weights_lo[i] = _mm_set1_epi32((int)((wnext & 0xff) << 16 | (wcur & 0xff)));
+		}
+
+		__m128i pairs01 = _mm_unpacklo_epi64(pairs[0], pairs[1]);
+		__m128i pairs23 = _mm_unpacklo_epi64(pairs[2], pairs[3]);
+		__m128i hi01 = _mm_madd_epi16(pairs01, _mm_unpacklo_epi64(weights_hi[0], weights_hi[1]));
+		__m128i hi23 = _mm_madd_epi16(pairs23, _mm_unpacklo_epi64(weights_hi[2], weights_hi[3]));
+		__m128i lo01 = _mm_madd_epi16(pairs01, _mm_unpacklo_epi64(weights_lo[0], weights_lo[1]));
+		__m128i lo23 = _mm_madd_epi16(pairs23, _mm_unpacklo_epi64(weights_lo[2], weights_lo[3]));
+		__m128i out01 = _mm_srai_epi32(_mm_add_epi32(_mm_slli_epi32(hi01, 8), lo01), 16);
+		__m128i out23 = _mm_srai_epi32(_mm_add_epi32(_mm_slli_epi32(hi23, 8), lo23), 16);
+
+		__m128i* dst = (__m128i*)&samples[frame * 2];
+		_mm_storeu_si128(dst, _mm_adds_epi16(_mm_loadu_si128(dst), _mm_packs_epi32(out01, out23)));
 
-	std::lock_guard<std::mutex> lk(m_csMixing);
+		indexR = r;
+		frac = f;
+		frame += 4;
+	}
+#endif
 
-	if (PowerPC::GetState() != PowerPC::CPU_RUNNING)
+	for (; frame < num_frames && ((indexW - indexR) & INDEX_MASK) > 2; frame++)
 	{
-		// Silence
-		memset(samples, 0, numSamples * 4);
-		return numSamples;
+		u32 indexR2 = indexR + 2; //next sample
+
+		for (int channel = 0; channel < 2; channel++)
+		{
+			s16 s1 = buffer[(indexR + channel) & INDEX_MASK]; //current
+			s16 s2 = buffer[(indexR2 + channel) & INDEX_MASK]; //next
+			int sample = ((s1 << 16) + (s2 - s1) * (u16)frac) >> 16;
+			sample += samples[frame * 2 + channel];
+			MathUtil::Clamp(&sample, -32768, 32767);
+			samples[frame * 2 + channel] = sample;
+		}
+
+		frac += ratio;
+		indexR += 2 * (u16)(frac >> 16);
+		frac &= 0xffff;
 	}
 
-	unsigned int currentSample = 0;
+	return frame;
+}
+
+// 8 tap windowed sinc, in 64 phases plus the first phase of the next frame.
+// The taps start at indexR and the output is interpolated between the 4th
+// and 5th of them, so it lags the linear resampler by three input frames.
+static const int POLYPHASE_TAPS = 8;
+static const int POLYPHASE_PHASES = 64;
+// The coefficients of each phase add up to 1 << POLYPHASE_SHIFT
+static const int POLYPHASE_SHIFT = 14;
+
+struct PolyphaseTable
+{
+	GC_ALIGNED16(s16 coefs[POLYPHASE_PHASES + 1][POLYPHASE_TAPS]);
+
+	PolyphaseTable()
+	{
+		// A little below the input's Nyquist frequency, to keep the images
+		// of upsampling down
+		const double cutoff = 0.9;
+		for (int phase = 0; phase <= POLYPHASE_PHASES; phase++)
+		{
+			double taps[POLYPHASE_TAPS];
+			double total = 0.0;
+			for (int tap = 0; tap < POLYPHASE_TAPS; tap++)
+			{
+				const double x = tap - (POLYPHASE_TAPS / 2 - 1) - (double)phase / POLYPHASE_PHASES;
+				const double sinc = x == 0.0 ? cutoff : sin(M_PI * cutoff * x) / (M_PI * x);
+				const double window = 0.42 + 0.5 * cos(M_PI * x / (POLYPHASE_TAPS / 2)) + 0.08 * cos(2 * M_PI * x / (POLYPHASE_TAPS / 2));
+				taps[tap] = sinc * window;
+				total += taps[tap];
+			}
+
+			// Unity gain after rounding, the error goes to the largest tap
+			int sum = 0;
+			int largest = 0;
+			for (int tap = 0; tap < POLYPHASE_TAPS; tap++)
+			{
+				coefs[phase][tap] = (s16)floor(taps[tap] / total * (1 << POLYPHASE_SHIFT) + 0.5);
+				sum += coefs[phase][tap];
+				if (taps[tap] > taps[largest])
+					largest = tap;
+			}
+			coefs[phase][largest] += (1 << POLYPHASE_SHIFT) - sum;
+		}
+	}
+};
+
+static unsigned int ResamplePolyphase(const short* buffer, short* samples, unsigned int num_frames,
+                                      u32 indexW, u32& indexR, u32& frac, u32 ratio, bool use_simd)
+{
+	static const PolyphaseTable table;
+	unsigned int frame = 0;
+
+#if _M_X86
+	// Four frames at a time, each one as two pmaddwd over its taps with the
+	// channels split into pairs. Integer sums don't depend on their order and
+	// the saturation matches the scalar loop, so the result is bit exact.
+	while (use_simd && frame + 4 <= num_frames)
+	{
+		u32 pos[4], phases[4];
+		u32 r = indexR, f = frac;
+		bool available = true;
+		for (int i = 0; i < 4; i++)
+		{
+			available &= ((indexW - r) & INDEX_MASK) > 2 * (POLYPHASE_TAPS - 1);
+			pos[i] = r;
+			phases[i] = (f + 0x200) >> 10;
+			f += ratio;
+			r += 2 * (u16)(f >> 16);
+			f &= 0xffff;
+		}
+		if (!available)
+			break;
+
+		__m128i out[4];
+		for (int i = 0; i < 4; i++)
+		{
+			GC_ALIGNED16(short wrapped[2 * POLYPHASE_TAPS]);
+			const short* src = &buffer[pos[i] & INDEX_MASK];
+			if ((pos[i] & INDEX_MASK) + 2 * POLYPHASE_TAPS > INDEX_MASK + 1)
+			{
+				for (int j = 0; j < 2 * POLYPHASE_TAPS; j++)
+					wrapped[j] = buffer[(pos[i] + j) & INDEX_MASK];
+				src = wrapped;
+			}
+
+			// c0 c1 c0 c1 c2 c3 c2 c3 and c4 c5 c4 c5 c6 c7 c6 c7
+			__m128i coefs = _mm_load_si128((const __m128i*)table.coefs[phases[i]]);
+			__m128i coefs0123 = _mm_shuffle_epi32(coefs, _MM_SHUFFLE(1, 1, 0, 0));
+			__m128i coefs4567 = _mm_shuffle_epi32(coefs, _MM_SHUFFLE(3, 3, 2, 2));
+
+			// L0 R0 L1 R1 L2 R2 L3 R3 -> L0 L1 R0 R1 L2 L3 R2 R3
+			__m128i frames0123 = _mm_loadu_si128((const __m128i*)src);
+			__m128i frames4567 = _mm_loadu_si128((const __m128i*)(src + 8));
+			frames0123 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(frames0123, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+			frames4567 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(frames4567, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+
+			// L R L R, then the halves added up
+			__m128i sum = _mm_add_epi32(_mm_madd_epi16(frames0123, coefs0123), _mm_madd_epi16(frames4567, coefs4567));
+			sum = _mm_add_epi32(sum, _mm_unpackhi_epi64(sum, sum));
+			out[i] = _mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(1 << (POLYPHASE_SHIFT - 1))), POLYPHASE_SHIFT);
+		}
+
+		__m128i out01 = _mm_unpacklo_epi64(out[0], out[1]);
+		__m128i out23 = _mm_unpacklo_epi64(out[2], out[3]);
+		__m128i* dst = (__m128i*)&samples[frame * 2];
+		_mm_storeu_si128(dst, _mm_adds_epi16(_mm_loadu_si128(dst), _mm_packs_epi32(out01, out23)));
+
+		indexR = r;
+		frac = f;
+		frame += 4;
+	}
+#endif
+
+	for (; frame < num_frames && ((indexW - indexR) & INDEX_MASK) > 2 * (POLYPHASE_TAPS - 1); frame++)
+	{
+		const s16* coefs = table.coefs[(frac + 0x200) >> 10];
+		for (int channel = 0; channel < 2; channel++)
+		{
+			int sum = 0;
+			for (int tap = 0; tap < POLYPHASE_TAPS; tap++)
+				sum += buffer[(indexR + 2 * tap + channel) & INDEX_MASK] * coefs[tap];
+
+			// The filter can overshoot. Saturated on its own first, like the
+			// packs before the adds in the SSE2 loop.
+			int sample = (sum + (1 << (POLYPHASE_SHIFT - 1))) >> POLYPHASE_SHIFT;
+			MathUtil::Clamp(&sample, -32768, 32767);
+			sample += samples[frame * 2 + channel];
+			MathUtil::Clamp(&sample, -32768, 32767);
+			samples[frame * 2 + channel] = sample;
+		}
+
+		frac += ratio;
+		indexR += 2 * (u16)(frac >> 16);
+		frac &= 0xffff;
+	}
+
+	return frame;
+}
+
+unsigned int ResampleFrames(const short* buffer, short* samples, unsigned int num_frames,
+                            u32 indexW, u32& indexR, u32& frac, u32 ratio,
+                            ResampleQuality quality, bool use_simd)
+{
+	if (quality == RESAMPLE_POLYPHASE)
+		return ResamplePolyphase(buffer, samples, num_frames, indexW, indexR, frac, ratio, use_simd);
+	return ResampleLinear(buffer, samples, num_frames, indexW, indexR, frac, ratio, use_simd);
+}
 
-	// Cache access in non-volatile variable
-	// This is the only function changing the read value, so it's safe to
-	// cache it locally although it's written here.
-	// The writing pointer will be modified outside, but it will only increase,
-	// so we will just ignore new written data while interpolating.
-	// Without this cache, the compiler wouldn't be allowed to optimize the
-	// interpolation loop.
-	u32 indexR = Common::AtomicLoad(m_indexR);
-	u32 indexW = Common::AtomicLoad(m_indexW);
+// Executed from sound stream thread
+void CMixer::MixerFifo::Mix(short* samples, unsigned int numSamples, bool consider_framelimit)
+{
+	// The reader position is only ever written here, the writer position only
+	// grows, so whatever gets pushed while we are resampling is simply picked
+	// up on the next call.
+	u32 indexR = m_indexR.load(std::memory_order_relaxed);
+	u32 indexW = m_indexW.load(std::memory_order_acquire);
 
 	float numLeft = ((indexW - indexR) & INDEX_MASK) / 2;
 	m_numLeftI = (numLeft + m_numLeftI*(CONTROL_AVG-1)) / CONTROL_AVG;
@@ -56,70 +274,117 @@ unsigned int CMixer::Mix(short* samples, unsigned int numSamples, bool consider_
 	//remember fractional offset
 
 	u32 framelimit = SConfig::GetInstance().m_Framelimit;
-	float aid_sample_rate = AudioInterface::GetAIDSampleRate() + offset;
+	float aid_sample_rate = m_input_sample_rate.load(std::memory_order_relaxed) + offset;
 	if (consider_framelimit && framelimit > 2)
 	{
 		aid_sample_rate = aid_sample_rate * (framelimit - 1) * 5 / VideoInterface::TargetRefreshRate;
 	}
 
-	static u32 frac = 0;
-	const u32 ratio = (u32)( 65536.0f * aid_sample_rate / (float)m_sampleRate );
+	const u32 ratio = (u32)( 65536.0f * aid_sample_rate / (float)m_mixer->m_sampleRate );
 
 	if (ratio > 0x10000)
 		ERROR_LOG(AUDIO, "ratio out of range");
 
-	for (; currentSample < numSamples*2 && ((indexW-indexR) & INDEX_MASK) > 2; currentSample+=2) {
-		u32 indexR2 = indexR + 2; //next sample
+	const ResampleQuality quality = SConfig::GetInstance().m_DSPResampleQuality == RESAMPLE_POLYPHASE ?
+		RESAMPLE_POLYPHASE : RESAMPLE_LINEAR;
+	unsigned int currentSample = 2 * ResampleFrames(m_buffer, samples, numSamples, indexW, indexR, m_frac, ratio, quality);
 
-		s16 l1 = Common::swap16(m_buffer[indexR & INDEX_MASK]); //current
-		s16 l2 = Common::swap16(m_buffer[indexR2 & INDEX_MASK]); //next
-		int sampleL = ((l1 << 16) + (l2 - l1) * (u16)frac)  >> 16;
-		samples[currentSample+1] = sampleL;
-
-		s16 r1 = Common::swap16(m_buffer[(indexR + 1) & INDEX_MASK]); //current
-		s16 r2 = Common::swap16(m_buffer[(indexR2 + 1) & INDEX_MASK]); //next
-		int sampleR = ((r1 << 16) + (r2 - r1) * (u16)frac)  >> 16;
-		samples[currentSample] = sampleR;
+	// Padding
+	if (m_pad_with_last_frame)
+	{
+		short s[2];
+		s[0] = m_buffer[(indexR - 2) & INDEX_MASK];
+		s[1] = m_buffer[(indexR - 1) & INDEX_MASK];
+		for (; currentSample < numSamples*2; currentSample+=2)
+		{
+			int sampleL = samples[currentSample] + s[0];
+			MathUtil::Clamp(&sampleL, -32768, 32767);
+			samples[currentSample] = sampleL;
 
-		frac += ratio;
-		indexR += 2 * (u16)(frac >> 16);
-		frac &= 0xffff;
+			int sampleR = samples[currentSample+1] + s[1];
+			MathUtil::Clamp(&sampleR, -32768, 32767);
+			samples[currentSample+1] = sampleR;
+		}
 	}
 
-	// Padding
-	unsigned short s[2];
-	s[0] = Common::swap16(m_buffer[(indexR - 1) & INDEX_MASK]);
-	s[1] = Common::swap16(m_buffer[(indexR - 2) & INDEX_MASK]);
-	for (; currentSample < numSamples*2; currentSample+=2)
+	// Publish the consumed space to the writer
+	m_indexR.store(indexR, std::memory_order_release);
+}
+
+unsigned int CMixer::MixerFifo::NumFreeSamples() const
+{
+	// indexW == indexR results in empty buffer, so indexR must always be smaller than indexW
+	u32 used = (m_indexW.load(std::memory_order_relaxed) - m_indexR.load(std::memory_order_acquire)) & INDEX_MASK;
+	return MAX_SAMPLES * 2 - used;
+}
+
+bool CMixer::MixerFifo::PushSamples(const short* samples, unsigned int num_samples, bool big_endian)
+{
+	// Check if we have enough free space
+	if (num_samples * 2 >= NumFreeSamples())
+		return false;
+
+	// AyuanX: Actual re-sampling work has been moved to sound thread
+	// to alleviate the workload on main thread
+	// and we simply store raw data here to make fast mem copy
+	u32 indexW = m_indexW.load(std::memory_order_relaxed);
+	if (big_endian)
 	{
-		samples[currentSample] = s[0];
-		samples[currentSample+1] = s[1];
+		// AI DMA frames come in the opposite channel order from what the backends expect
+		for (unsigned int i = 0; i < num_samples * 2; i += 2)
+		{
+			m_buffer[(indexW + i) & INDEX_MASK] = Common::swap16(samples[i + 1]);
+			m_buffer[(indexW + i + 1) & INDEX_MASK] = Common::swap16(samples[i]);
+		}
+	}
+	else
+	{
+		int over_bytes = num_samples * 4 - (MAX_SAMPLES * 2 - (indexW & INDEX_MASK)) * sizeof(short);
+		if (over_bytes > 0)
+		{
+			memcpy(&m_buffer[indexW & INDEX_MASK], samples, num_samples * 4 - over_bytes);
+			memcpy(&m_buffer[0], samples + (num_samples * 4 - over_bytes) / sizeof(short), over_bytes);
+		}
+		else
+		{
+			memcpy(&m_buffer[indexW & INDEX_MASK], samples, num_samples * 4);
+		}
 	}
 
-	// Flush cached variable
-	Common::AtomicStore(m_indexR, indexR);
+	// Publish the new frames to the audio thread
+	m_indexW.store(indexW + num_samples * 2, std::memory_order_release);
+	return true;
+}
+
+// Executed from sound stream thread
+unsigned int CMixer::Mix(short* samples, unsigned int numSamples, bool consider_framelimit)
+{
+	if (!samples)
+		return 0;
+
+	// Never wait for the emulator here, a paused emulator means silence anyway.
+	std::unique_lock<std::mutex> lk(m_csMixing, std::try_to_lock);
+
+	memset(samples, 0, numSamples * 4);
+
+	if (!lk.owns_lock() || PowerPC::GetState() != PowerPC::CPU_RUNNING)
+		return numSamples;
+
+	m_dma_mixer.Mix(samples, numSamples, consider_framelimit);
+	m_streaming_mixer.Mix(samples, numSamples, consider_framelimit);
 
-	// Add the DTK Music
-	// Re-sampling is done inside
-	AudioInterface::Callback_GetStreaming(samples, numSamples, m_sampleRate);
 	if (m_logAudio)
 		g_wave_writer.AddStereoSamples(samples, numSamples);
 
 	return numSamples;
 }
 
-
 void CMixer::PushSamples(const short *samples, unsigned int num_samples)
 {
-	// Cache access in non-volatile variable
-	// indexR isn't allowed to cache in the audio throttling loop as it
-	// needs to get updates to not deadlock.
-	u32 indexW = Common::AtomicLoad(m_indexW);
-
 	if (m_throttle)
 	{
 		// The auto throttle function. This loop will put a ceiling on the CPU MHz.
-		while (num_samples * 2 + ((indexW - Common::AtomicLoad(m_indexR)) & INDEX_MASK) >= MAX_SAMPLES * 2)
+		while (num_samples * 2 >= m_dma_mixer.NumFreeSamples())
 		{
 			if (*PowerPC::GetStatePtr() != PowerPC::CPU_RUNNING || soundStream->IsMuted())
 				break;
@@ -131,27 +396,44 @@ void CMixer::PushSamples(const short *samples, unsigned int num_samples)
 		}
 	}
 
-	// Check if we have enough free space
-	// indexW == m_indexR results in empty buffer, so indexR must always be smaller than indexW
-	if (num_samples * 2 + ((indexW - Common::AtomicLoad(m_indexR)) & INDEX_MASK) >= MAX_SAMPLES * 2)
-		return;
+	m_dma_mixer.SetInputSampleRate(AudioInterface::GetAIDSampleRate());
+	m_dma_mixer.PushSamples(samples, num_samples, true);
 
-	// AyuanX: Actual re-sampling work has been moved to sound thread
-	// to alleviate the workload on main thread
-	// and we simply store raw data here to make fast mem copy
-	int over_bytes = num_samples * 4 - (MAX_SAMPLES * 2 - (indexW & INDEX_MASK)) * sizeof(short);
-	if (over_bytes > 0)
+	if (m_logDSPAudio)
+		m_dsp_wave_writer.AddStereoSamplesBE(samples, num_samples);
+}
+
+void CMixer::PushStreamingSamples(const short *samples, unsigned int num_samples, unsigned int sample_rate)
+{
+	m_streaming_mixer.SetInputSampleRate(sample_rate);
+	m_streaming_mixer.PushSamples(samples, num_samples, false);
+}
+
+void CMixer::StartLogDSPAudio(const std::string& filename)
+{
+	if (!m_logDSPAudio)
 	{
-		memcpy(&m_buffer[indexW & INDEX_MASK], samples, num_samples * 4 - over_bytes);
-		memcpy(&m_buffer[0], samples + (num_samples * 4 - over_bytes) / sizeof(short), over_bytes);
+		m_logDSPAudio = true;
+		m_dsp_wave_writer.Start(filename, AudioInterface::GetAIDSampleRate());
+		m_dsp_wave_writer.SetSkipSilence(false);
+		NOTICE_LOG(DSPHLE, "Starting DSP audio logging");
 	}
 	else
 	{
-		memcpy(&m_buffer[indexW & INDEX_MASK], samples, num_samples * 4);
+		WARN_LOG(DSPHLE, "DSP audio logging has already been started");
 	}
-
-	Common::AtomicAdd(m_indexW, num_samples * 2);
-
-	return;
 }
 
+void CMixer::StopLogDSPAudio()
+{
+	if (m_logDSPAudio)
+	{
+		m_logDSPAudio = false;
+		m_dsp_wave_writer.Stop();
+		NOTICE_LOG(DSPHLE, "Stopping DSP audio logging");
+	}
+	else
+	{
+		WARN_LOG(DSPHLE, "DSP audio logging has already been stopped");
+	}
+}
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <string>
 
 #include "AudioCommon/WaveFile.h"
@@ -18,6 +19,23 @@
 #define CONTROL_FACTOR  0.2  // in freq_shift per fifo size offset
 #define CONTROL_AVG     32
 
+// How the mixer resamples to the output rate, [DSP] ResampleQuality
+enum ResampleQuality
+{
+	RESAMPLE_LINEAR = 0,
+	// 8 tap windowed sinc, less aliasing and high frequency loss than linear
+	RESAMPLE_POLYPHASE = 1,
+};
+
+// Adds up to num_frames stereo frames from the ring, read from indexR in
+// steps of ratio (16.16 fixed point), to samples, saturating. Returns the
+// number of frames rendered, which is less than num_frames if the ring ran
+// dry. The SSE2 code is bit exact with the scalar code, which use_simd =
+// false forces.
+unsigned int ResampleFrames(const short* ring, short* samples, unsigned int num_frames,
+                            u32 indexW, u32& indexR, u32& frac, u32 ratio,
+                            ResampleQuality quality, bool use_simd = true);
+
 class CMixer {
 
 public:
@@ -26,17 +44,17 @@ public:
 		, m_dacSampleRate(DACSampleRate)
 		, m_bits(16)
 		, m_channels(2)
+		, m_dma_mixer(this, DACSampleRate, true)
+		// Streaming stops being pushed when the stream stops, so repeating
+		// its last frame would add a constant offset to the DMA audio
+		, m_streaming_mixer(this, AISampleRate, false)
 		, m_logAudio(0)
-		, m_indexW(0)
-		, m_indexR(0)
-		, m_numLeftI(0.0f)
+		, m_logDSPAudio(false)
 	{
 		// AyuanX: The internal (Core & DSP) sample rate is fixed at 32KHz
 		// So when AI/DAC sample rate differs than 32KHz, we have to do re-sampling
 		m_sampleRate = BackendSampleRate;
 
-		memset(m_buffer, 0, sizeof(m_buffer));
-
 		INFO_LOG(AUDIO_INTERFACE, "Mixer is initialized (AISampleRate:%i, DACSampleRate:%i)", AISampleRate, DACSampleRate);
 	}
 
@@ -46,7 +64,10 @@ public:
 	virtual unsigned int Mix(short* samples, unsigned int numSamples, bool consider_framelimit = true);
 
 	// Called from main thread
+	// DMA samples come straight from emulated RAM, so they are big endian.
 	virtual void PushSamples(const short* samples, unsigned int num_samples);
+	// Disc streaming samples, already decoded and scaled by the AI volume.
+	virtual void PushStreamingSamples(const short* samples, unsigned int num_samples, unsigned int sample_rate);
 	unsigned int GetSampleRate() const {return m_sampleRate;}
 
 	void SetThrottle(bool use) { m_throttle = use;}
@@ -81,30 +102,76 @@ public:
 		}
 	}
 
+	// The DMA samples as the DSP produced them, before they are resampled to
+	// the output rate
+	void StartLogDSPAudio(const std::string& filename);
+	void StopLogDSPAudio();
+
+	// Held by the emulator while it is paused for savestates and the like.
+	// Mix() only tries to take it and outputs silence instead of waiting.
 	std::mutex& MixerCritical() { return m_csMixing; }
 
 	float GetCurrentSpeed() const { return m_speed; }
 	void UpdateSpeed(volatile float val) { m_speed = val; }
 
 protected:
+	// Wait-free single producer (emulator) / single consumer (audio thread)
+	// ring of native endian stereo frames, resampled to the output rate on Mix().
+	class MixerFifo {
+	public:
+		// An underrun repeats the last frame when pad_with_last_frame is set,
+		// and is silent otherwise.
+		MixerFifo(CMixer *mixer, unsigned int sample_rate, bool pad_with_last_frame)
+			: m_mixer(mixer)
+			, m_pad_with_last_frame(pad_with_last_frame)
+			, m_input_sample_rate(sample_rate)
+			, m_indexW(0)
+			, m_indexR(0)
+			, m_numLeftI(0.0f)
+			, m_frac(0)
+		{
+			memset(m_buffer, 0, sizeof(m_buffer));
+		}
+
+		// Only call from the producer thread.
+		// Returns false if there isn't enough free space for all samples.
+		bool PushSamples(const short* samples, unsigned int num_samples, bool big_endian);
+		unsigned int NumFreeSamples() const;
+		void SetInputSampleRate(unsigned int rate) { m_input_sample_rate.store(rate, std::memory_order_relaxed); }
+
+		// Only call from the audio thread. Adds the resampled frames to samples.
+		void Mix(short* samples, unsigned int numSamples, bool consider_framelimit);
+
+	private:
+		CMixer *m_mixer;
+		const bool m_pad_with_last_frame;
+		std::atomic<unsigned int> m_input_sample_rate;
+		GC_ALIGNED16(short m_buffer[MAX_SAMPLES * 2]);
+		std::atomic<u32> m_indexW;
+		std::atomic<u32> m_indexR;
+		// Only touched by the audio thread
+		float m_numLeftI;
+		u32 m_frac;
+	};
+
 	unsigned int m_sampleRate;
 	unsigned int m_aiSampleRate;
 	unsigned int m_dacSampleRate;
 	int m_bits;
 	int m_channels;
 
+	MixerFifo m_dma_mixer;
+	MixerFifo m_streaming_mixer;
+
 	WaveFileWriter g_wave_writer;
+	WaveFileWriter m_dsp_wave_writer;
 
 	bool m_logAudio;
+	bool m_logDSPAudio;
 
 	bool m_throttle;
 
-	short m_buffer[MAX_SAMPLES * 2];
-	volatile u32 m_indexW;
-	volatile u32 m_indexR;
-
 	std::mutex m_csMixing;
-	float m_numLeftI;
 
 	volatile float m_speed; // Current rate of the emulation (1.0 = 100% speed)
 private:
@@ -120,7 +120,7 @@ void WaveFileWriter::AddStereoSamplesBE(const short *sample_data, u32 count)
 	if (!file)
 		PanicAlertT("WaveFileWriter - file not open.");
 
-	if (count > BUF_SIZE * 2)
+	if (count * 2 > BUF_SIZE)
 		PanicAlert("WaveFileWriter - buffer too small (count = %u).", count);
 
 	if (skip_silence)
@@ -137,8 +137,11 @@ void WaveFileWriter::AddStereoSamplesBE(const short *sample_data, u32 count)
 			return;
 	}
 
-	for (u32 i = 0; i < count * 2; i++)
-		conv_buffer[i] = Common::swap16((u16)sample_data[i]);
+	for (u32 i = 0; i < count * 2; i += 2)
+	{
+		conv_buffer[i] = Common::swap16((u16)sample_data[i + 1]);
+		conv_buffer[i + 1] = Common::swap16((u16)sample_data[i]);
+	}
 
 	file.WriteBytes(conv_buffer, count * 4);
 	audio_size += count * 4;
@@ -38,6 +38,7 @@ public:
 	void SetSkipSilence(bool skip) { skip_silence = skip; }
 
 	void AddStereoSamples(const short *sample_data, u32 count);
-	void AddStereoSamplesBE(const short *sample_data, u32 count);  // big endian
+	// Big endian with the right channel first, the way AI DMA frames are
+	void AddStereoSamplesBE(const short *sample_data, u32 count);
 	u32 GetAudioSize() const { return audio_size; }
 };
@@ -13,10 +13,13 @@
 // - Zero backwards/forwards compatibility
 // - Serialization code for anything complex has to be manually written.
 
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <deque>
 #include <list>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <type_traits>
@@ -25,6 +28,7 @@
 
 #include "Common/Common.h"
 #include "Common/FileUtil.h"
+#include "Common/Timer.h"
 
 // ewww
 #if _LIBCPP_VERSION
@@ -47,6 +51,136 @@ struct LinkedListItem : public T
 	LinkedListItem<T> *next;
 };
 
+// Fletcher style checksum over 64-bit words which can be fed in arbitrarily
+// split pieces. Meant to catch corruption, nothing more.
+class StreamChecksum
+{
+public:
+	StreamChecksum() : m_sum1(0), m_sum2(0), m_word(0), m_word_bytes(0), m_length(0) {}
+
+	void Update(const u8* data, size_t size)
+	{
+		m_length += size;
+		for (; size && m_word_bytes; size--)
+			AddByte(*data++);
+		for (; size >= 8; size -= 8, data += 8)
+		{
+			u64 word;
+			memcpy(&word, data, 8);
+			AddWord(word);
+		}
+		for (; size; size--)
+			AddByte(*data++);
+	}
+
+	u32 Finish()
+	{
+		if (m_word_bytes)
+			AddWord(m_word);
+		u64 sum = m_sum2 ^ (m_sum1 * 0x9E3779B97F4A7C15ULL) ^ m_length;
+		return (u32)(sum ^ (sum >> 32));
+	}
+
+private:
+	void AddWord(u64 word)
+	{
+		m_sum1 += word;
+		m_sum2 += m_sum1;
+		m_word = 0;
+		m_word_bytes = 0;
+	}
+
+	void AddByte(u8 byte)
+	{
+		m_word |= (u64)byte << (8 * m_word_bytes);
+		if (++m_word_bytes == 8)
+			AddWord(m_word);
+	}
+
+	u64 m_sum1, m_sum2;
+	u64 m_word;
+	u32 m_word_bytes;
+	u64 m_length;
+};
+
+// Append-only byte buffer for single pass serialization. The storage is a list
+// of fixed size chunks, so growing it never moves what was already written,
+// and Clear() keeps the chunks around for the next use.
+class ChunkedBuffer
+{
+public:
+	ChunkedBuffer() : m_size(0) {}
+
+	void Clear() { m_size = 0; }
+	void Free() { m_chunks.clear(); m_size = 0; }
+	size_t GetSize() const { return m_size; }
+
+	void Append(const void* data, size_t size)
+	{
+		const u8* src = static_cast<const u8*>(data);
+		while (size)
+		{
+			const size_t chunk = m_size / CHUNK_SIZE;
+			const size_t offset = m_size % CHUNK_SIZE;
+			if (chunk == m_chunks.size())
+				m_chunks.emplace_back(new u8[CHUNK_SIZE]);
+
+			const size_t count = std::min(size, CHUNK_SIZE - offset);
+			memcpy(m_chunks[chunk].get() + offset, src, count);
+			src += count;
+			size -= count;
+			m_size += count;
+		}
+	}
+
+	// Patches already appended data
+	void Overwrite(size_t offset, const void* data, size_t size)
+	{
+		const u8* src = static_cast<const u8*>(data);
+		ForEachRange(offset, size, [&](const u8* dest, size_t count) {
+			memcpy(const_cast<u8*>(dest), src, count);
+			src += count;
+		});
+	}
+
+	// Calls f(const u8* data, size_t size) for the parts making up the given
+	// range, in order.
+	template <typename F>
+	void ForEachRange(size_t offset, size_t size, F f) const
+	{
+		while (size)
+		{
+			const size_t chunk_offset = offset % CHUNK_SIZE;
+			const size_t count = std::min(size, CHUNK_SIZE - chunk_offset);
+			f(m_chunks[offset / CHUNK_SIZE].get() + chunk_offset, count);
+			offset += count;
+			size -= count;
+		}
+	}
+
+	template <typename F>
+	void ForEachChunk(F f) const
+	{
+		ForEachRange(0, m_size, f);
+	}
+
+	void CopyTo(std::vector<u8>& buffer) const
+	{
+		buffer.resize(m_size);
+		size_t pos = 0;
+		ForEachChunk([&](const u8* data, size_t size) {
+			memcpy(&buffer[pos], data, size);
+			pos += size;
+		});
+	}
+
+private:
+	static const size_t CHUNK_SIZE = 1 << 20;
+
+	std::vector<std::unique_ptr<u8[]>> m_chunks;
+	size_t m_size;
+};
+
 // Wrapper class
 class PointerWrap
 {
@@ -62,8 +196,39 @@ public:
 	u8 **ptr;
 	Mode mode;
 
+	// Time spent since the previous marker, per marker. Only collected when set.
+	typedef std::vector<std::pair<std::string, u64>> MarkerTimes;
+
+	// Position and size of the data of every section written to the arena,
+	// in order. Only collected when set.
+	struct WrittenSection
+	{
+		u32 offset;
+		u32 size;
+	};
+	typedef std::vector<WrittenSection> SectionTable;
+
 public:
-	PointerWrap(u8 **ptr_, Mode mode_) : ptr(ptr_), mode(mode_) {}
+	// When reading, end_ is the end of the buffer. DoSection refuses sections
+	// that claim to run past it.
+	PointerWrap(u8 **ptr_, Mode mode_, const u8* end_ = nullptr)
+		: ptr(ptr_), mode(mode_), end(end_), arena(nullptr), arena_pos(nullptr), marker_times(nullptr), marker_time(0), section_table(nullptr) {}
+
+	// Writes everything in a single pass by appending to the arena, so there
+	// is no need to measure the size first. ptr only counts bytes then.
+	explicit PointerWrap(ChunkedBuffer* arena_)
+		: ptr(&arena_pos), mode(MODE_WRITE), end(nullptr), arena(arena_), arena_pos(nullptr), marker_times(nullptr), marker_time(0), section_table(nullptr) {}
+
+	void SetMarkerTimes(MarkerTimes* times)
+	{
+		marker_times = times;
+		marker_time = Common::Timer::GetTimeUs();
+	}
+
+	void SetSectionTable(SectionTable* table)
+	{
+		section_table = table;
+	}
 
 	void SetMode(Mode mode_) { mode = mode_; }
 	Mode GetMode() const { return mode; }
@@ -172,8 +337,7 @@ public:
 	template <typename T>
 	void DoArray(T* x, u32 count)
 	{
-		for (u32 i = 0; i != count; ++i)
-			Do(x[i]);
+		DoArray(x, count, std::integral_constant<bool, IsTriviallyCopyable(T)>());
 	}
 
 	template <typename T>
@@ -262,6 +426,80 @@ public:
 		}
 	}
 
+	// Wraps whatever do_state serializes in a named section carrying its size
+	// and checksum. A broken or mismatching state is then pinned down to the
+	// subsystem it comes from, and tools can walk the sections of a state
+	// without deserializing it (see State::ReadSections).
+	template <typename F>
+	void DoSection(const std::string& name, F do_state)
+	{
+		if (!DoSectionName(name))
+			return;
+
+		u8* const fields = *ptr;
+		const size_t arena_fields = arena ? arena->GetSize() : 0;
+		u32 size = 0;
+		u32 checksum = 0;
+		if (!CheckRemaining(name, 2 * sizeof(u32)))
+			return;
+		Do(size);
+		Do(checksum);
+		u8* const start = *ptr;
+
+		if (!CheckRemaining(name, size))
+			return;
+		if ((mode == MODE_READ || mode == MODE_VERIFY) && GetChecksum(start, size) != checksum)
+		{
+			PanicAlertT("Error: Savestate section \"%s\" is corrupted. Aborting savestate load...", name.c_str());
+			mode = PointerWrap::MODE_MEASURE;
+			return;
+		}
+
+		do_state(*this);
+
+		const u32 used = (u32)(*ptr - start);
+		if (mode == MODE_WRITE)
+		{
+			if (arena)
+			{
+				StreamChecksum sum;
+				arena->ForEachRange(arena_fields + 2 * sizeof(u32), used, [&](const u8* data, size_t count) {
+					sum.Update(data, count);
+				});
+				checksum = sum.Finish();
+				arena->Overwrite(arena_fields, &used, sizeof(u32));
+				arena->Overwrite(arena_fields + sizeof(u32), &checksum, sizeof(u32));
+				if (section_table)
+				{
+					WrittenSection section = { (u32)(arena_fields + 2 * sizeof(u32)), used };
+					section_table->push_back(section);
+				}
+			}
+			else
+			{
+				checksum = GetChecksum(start, used);
+				memcpy(fields, &used, sizeof(u32));
+				memcpy(fields + sizeof(u32), &checksum, sizeof(u32));
+			}
+		}
+		else if ((mode == MODE_READ || mode == MODE_VERIFY) && used != size)
+		{
+			PanicAlertT("Error: Savestate section \"%s\" holds %u bytes, but %u were read. Aborting savestate load...",
+				name.c_str(), size, used);
+			mode = PointerWrap::MODE_MEASURE;
+			return;
+		}
+
+		RecordMarkerTime(name);
+	}
+
+	static u32 GetChecksum(const u8* data, size_t size)
+	{
+		StreamChecksum sum;
+		sum.Update(data, size);
+		return sum.Finish();
+	}
+
 	void DoMarker(const std::string& prevName, u32 arbitraryNumber = 0x42)
 	{
 		u32 cookie = arbitraryNumber;
@@ -273,41 +511,126 @@ public:
 				prevName.c_str(), cookie, cookie, arbitraryNumber, arbitraryNumber);
 			mode = PointerWrap::MODE_MEASURE;
 		}
+
+		RecordMarkerTime(prevName);
 	}
 
+	// Section names are stored as a length prefixed string
+	static const u32 MAX_SECTION_NAME = 64;
+
 private:
-	__forceinline void DoByte(u8& x)
+	const u8* end;
+	ChunkedBuffer* arena;
+	u8* arena_pos;
+	MarkerTimes* marker_times;
+	u64 marker_time;
+	SectionTable* section_table;
+
+	void RecordMarkerTime(const std::string& name)
+	{
+		if (marker_times)
+		{
+			u64 now = Common::Timer::GetTimeUs();
+			marker_times->emplace_back(name, now - marker_time);
+			marker_time = now;
+		}
+	}
+
+	// Only checks when reading a buffer with a known end
+	bool CheckRemaining(const std::string& name, size_t size)
+	{
+		if ((mode != MODE_READ && mode != MODE_VERIFY) || !end)
+			return true;
+
+		if (*ptr > end || (size_t)(end - *ptr) < size)
+		{
+			PanicAlertT("Error: Savestate section \"%s\" is truncated. Aborting savestate load...", name.c_str());
+			mode = PointerWrap::MODE_MEASURE;
+			return false;
+		}
+		return true;
+	}
+
+	bool DoSectionName(const std::string& name)
+	{
+		u32 length = (u32)name.size();
+		if (!CheckRemaining(name, sizeof(u32)))
+			return false;
+		Do(length);
+		if (mode != MODE_READ && mode != MODE_VERIFY)
+		{
+			DoVoid((void*)name.data(), length);
+			return true;
+		}
+
+		std::string found;
+		if (length <= MAX_SECTION_NAME)
+		{
+			if (!CheckRemaining(name, length))
+				return false;
+			found.assign(reinterpret_cast<const char*>(*ptr), length);
+			*ptr += length;
+		}
+		if (found != name || length > MAX_SECTION_NAME)
+		{
+			PanicAlertT("Error: Expected savestate section \"%s\", found \"%s\". Aborting savestate load...",
+				name.c_str(), found.c_str());
+			mode = PointerWrap::MODE_MEASURE;
+			return false;
+		}
+		return true;
+	}
+
+	// Plain data goes through DoVoid in one piece
+	template <typename T>
+	void DoArray(T* x, u32 count, std::true_type)
+	{
+		DoVoid((void*)x, count * sizeof(T));
+	}
+
+	template <typename T>
+	void DoArray(T* x, u32 count, std::false_type)
+	{
+		for (u32 i = 0; i != count; ++i)
+			Do(x[i]);
+	}
+
+	void DoVoid(void *data, u32 size)
 	{
 		switch (mode)
 		{
 		case MODE_READ:
-			x = **ptr;
+			memcpy(data, *ptr, size);
 			break;
 
 		case MODE_WRITE:
-			**ptr = x;
+			if (arena)
+				arena->Append(data, size);
+			else
+				memcpy(*ptr, data, size);
 			break;
 
 		case MODE_MEASURE:
 			break;
 
 		case MODE_VERIFY:
-			_dbg_assert_msg_(COMMON, (x == **ptr),
-				"Savestate verification failure: %d (0x%X) (at %p) != %d (0x%X) (at %p).\n",
-					x, x, &x, **ptr, **ptr, *ptr);
+			// The check is compiled out along with _dbg_assert_msg_
+#if MAX_LOGLEVEL >= DEBUG_LEVEL
+			for (u32 i = 0; i != size; ++i)
+			{
+				u8& x = reinterpret_cast<u8*>(data)[i];
+				_dbg_assert_msg_(COMMON, (x == (*ptr)[i]),
+					"Savestate verification failure: %d (0x%X) (at %p) != %d (0x%X) (at %p).\n",
+						x, x, &x, (*ptr)[i], (*ptr)[i], *ptr + i);
+			}
+#endif
 			break;
 
 		default:
 			break;
 		}
 
-		++(*ptr);
-	}
-
-	void DoVoid(void *data, u32 size)
-	{
-		for (u32 i = 0; i != size; ++i)
-			DoByte(reinterpret_cast<u8*>(data)[i]);
+		*ptr += size;
 	}
 };
 
@@ -373,7 +696,7 @@ public:
 		}
 
 		u8* ptr = &buffer[0];
-		PointerWrap p(&ptr, PointerWrap::MODE_READ);
+		PointerWrap p(&ptr, PointerWrap::MODE_READ, ptr + sz);
 		_class.DoState(p);
 
 		INFO_LOG(COMMON, "ChunkReader: Done loading %s" , _rFilename.c_str());
@@ -393,19 +716,14 @@ public:
 		}
 
 		// Get data
-		u8 *ptr = nullptr;
-		PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
-		_class.DoState(p);
-		size_t const sz = (size_t)ptr;
-		std::vector<u8> buffer(sz);
-		ptr = &buffer[0];
-		p.SetMode(PointerWrap::MODE_WRITE);
+		ChunkedBuffer buffer;
+		PointerWrap p(&buffer);
 		_class.DoState(p);
 
 		// Create header
 		SChunkHeader header;
 		header.Revision = _Revision;
-		header.ExpectedSize = (u32)sz;
+		header.ExpectedSize = (u32)buffer.GetSize();
 
 		// Write to file
 		if (!pFile.WriteArray(&header, 1))
@@ -414,7 +732,11 @@ public:
 			return false;
 		}
 
-		if (!pFile.WriteArray(&buffer[0], sz))
+		bool success = true;
+		buffer.ForEachChunk([&](const u8* data, size_t size) {
+			success = success && pFile.WriteBytes(data, size);
+		});
+		if (!success)
 		{
 			ERROR_LOG(COMMON,"ChunkReader: Failed writing data");
 			return false;
@@ -3,13 +3,27 @@
 // Refer to the license.txt file included.
 
 
+#include <cstring>
+
+#include "Common/CPUDetect.h"
 #include "Common/Hash.h"
 #if _M_SSE >= 0x402
-#include "Common/CPUDetect.h"
 #include <nmmintrin.h>
 #endif
+#if _M_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
 
-static u64 (*ptrHashFunction)(const u8 *src, int len, u32 samples) = &GetMurmurHash3;
+// Lets the AVX2 hash use AVX2 intrinsics while the rest of the file is built
+// for SSE2. MSVC allows that without being asked.
+#if defined(__GNUC__) && _M_X86
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+static u64 (*ptrHashFunction)(const u8 *src, int len, u32 samples) = &GetStripeHash;
 
 // uint32_t
 // WARNING - may read one more byte!
@@ -492,6 +506,217 @@ u64 GetHashHiresTexture(const u8 *src, int len, u32 samples)
 }
 #endif
 
+/*
+ * Stripe hash: processes 64 byte stripes in eight 64 bit lanes, modeled after
+ * the long input loop of XXH3. Each lane adds the product of the low and high
+ * halves of (input ^ key) to itself and the raw input to its neighbour, which
+ * only needs 32x32->64 bit multiplies and so maps directly onto SSE2 and AVX2.
+ * The generic, SSE2 and AVX2 versions return the same hashes.
+ *
+ * With samples != 0, only about samples / 8 evenly spaced stripes are hashed,
+ * like the other texture hashes do with samples 8 byte words.
+ */
+static const int STRIPE_SIZE = 64;
+static const int STRIPES_PER_SCRAMBLE = 16;
+static const u64 STRIPE_PRIME32 = 0x9E3779B1;
+static const u64 STRIPE_PRIME64 = 0x9E3779B185EBCA87ULL;
+
+static const u64 s_stripe_key[8] =
+{
+	0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL, 0xdb979083e96dd4deULL, 0x1f67b3b7a4a44072ULL,
+	0x78e5c0cc4ee679cbULL, 0x2172ffcc7dd05a82ULL, 0x8e2443f7744608b8ULL, 0x4c263a81e69035e0ULL,
+};
+
+static inline u64 ReadStripeWord(const u8* p)
+{
+	u64 value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static inline void AccumulateStripe(u64* acc, const u8* p)
+{
+	for (int i = 0; i < 8; ++i)
+	{
+		const u64 data = ReadStripeWord(p + i * 8);
+		const u64 key = data ^ s_stripe_key[i];
+		acc[i ^ 1] += data;
+		acc[i] += (key & 0xFFFFFFFF) * (key >> 32);
+	}
+}
+
+static inline void ScrambleStripeAccumulators(u64* acc)
+{
+	for (int i = 0; i < 8; ++i)
+	{
+		acc[i] ^= acc[i] >> 47;
+		acc[i] ^= s_stripe_key[i];
+		acc[i] *= STRIPE_PRIME32;
+	}
+}
+
+static inline int GetStripeStep(int stripes, u32 samples)
+{
+	if (samples == 0)
+		return 1;
+	const int wanted = max(samples / 8, 1u);
+	return max(stripes / wanted, 1);
+}
+
+// Hashes the bytes after the last full stripe and mixes down the lanes
+static u64 FinishStripeHash(u64* acc, const u8* src, int len)
+{
+	if (len & (STRIPE_SIZE - 1))
+	{
+		if (len >= STRIPE_SIZE)
+		{
+			AccumulateStripe(acc, src + len - STRIPE_SIZE);
+		}
+		else
+		{
+			u8 last[STRIPE_SIZE] = {};
+			memcpy(last, src, len);
+			AccumulateStripe(acc, last);
+		}
+	}
+
+	u64 h = (u64)len * STRIPE_PRIME64;
+	for (int i = 0; i < 8; ++i)
+	{
+		h ^= acc[i] + s_stripe_key[i];
+		h = (h ^ (h >> 29)) * STRIPE_PRIME64;
+	}
+	h ^= h >> 32;
+	return h;
+}
+
+static void InitStripeAccumulators(u64* acc)
+{
+	for (int i = 0; i < 8; ++i)
+		acc[i] = s_stripe_key[7 - i];
+}
+
+#if !_M_X86
+u64 GetStripeHash(const u8 *src, int len, u32 samples)
+{
+	u64 acc[8];
+	InitStripeAccumulators(acc);
+
+	const int stripes = len / STRIPE_SIZE;
+	const int step = GetStripeStep(stripes, samples);
+	int count = 0;
+	for (int i = 0; i < stripes; i += step)
+	{
+		AccumulateStripe(acc, src + i * STRIPE_SIZE);
+		if (++count % STRIPES_PER_SCRAMBLE == 0)
+			ScrambleStripeAccumulators(acc);
+	}
+
+	return FinishStripeHash(acc, src, len);
+}
+
+u64 GetStripeHashAVX2(const u8 *src, int len, u32 samples)
+{
+	return GetStripeHash(src, len, samples);
+}
+#else
+u64 GetStripeHash(const u8 *src, int len, u32 samples)
+{
+	u64 acc[8];
+	InitStripeAccumulators(acc);
+
+	__m128i vacc[4];
+	__m128i vkey[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		vacc[i] = _mm_loadu_si128((const __m128i*)&acc[i * 2]);
+		vkey[i] = _mm_loadu_si128((const __m128i*)&s_stripe_key[i * 2]);
+	}
+	const __m128i prime = _mm_set1_epi32((u32)STRIPE_PRIME32);
+
+	const int stripes = len / STRIPE_SIZE;
+	const int step = GetStripeStep(stripes, samples);
+	int count = 0;
+	for (int s = 0; s < stripes; s += step)
+	{
+		const u8* p = src + s * STRIPE_SIZE;
+		for (int i = 0; i < 4; ++i)
+		{
+			const __m128i data = _mm_loadu_si128((const __m128i*)(p + i * 16));
+			const __m128i key = _mm_xor_si128(data, vkey[i]);
+			const __m128i product = _mm_mul_epu32(key, _mm_srli_epi64(key, 32));
+			const __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+			vacc[i] = _mm_add_epi64(vacc[i], _mm_add_epi64(product, swapped));
+		}
+
+		if (++count % STRIPES_PER_SCRAMBLE == 0)
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				__m128i a = _mm_xor_si128(vacc[i], _mm_srli_epi64(vacc[i], 47));
+				a = _mm_xor_si128(a, vkey[i]);
+				const __m128i lo = _mm_mul_epu32(a, prime);
+				const __m128i hi = _mm_mul_epu32(_mm_srli_epi64(a, 32), prime);
+				vacc[i] = _mm_add_epi64(lo, _mm_slli_epi64(hi, 32));
+			}
+		}
+	}
+
+	for (int i = 0; i < 4; ++i)
+		_mm_storeu_si128((__m128i*)&acc[i * 2], vacc[i]);
+	return FinishStripeHash(acc, src, len);
+}
+
+TARGET_AVX2 u64 GetStripeHashAVX2(const u8 *src, int len, u32 samples)
+{
+	u64 acc[8];
+	InitStripeAccumulators(acc);
+
+	__m256i vacc[2];
+	__m256i vkey[2];
+	for (int i = 0; i < 2; ++i)
+	{
+		vacc[i] = _mm256_loadu_si256((const __m256i*)&acc[i * 4]);
+		vkey[i] = _mm256_loadu_si256((const __m256i*)&s_stripe_key[i * 4]);
+	}
+	const __m256i prime = _mm256_set1_epi32((u32)STRIPE_PRIME32);
+
+	const int stripes = len / STRIPE_SIZE;
+	const int step = GetStripeStep(stripes, samples);
+	int count = 0;
+	for (int s = 0; s < stripes; s += step)
+	{
+		const u8* p = src + s * STRIPE_SIZE;
+		for (int i = 0; i < 2; ++i)
+		{
+			const __m256i data = _mm256_loadu_si256((const __m256i*)(p + i * 32));
+			const __m256i key = _mm256_xor_si256(data, vkey[i]);
+			const __m256i product = _mm256_mul_epu32(key, _mm256_srli_epi64(key, 32));
+			const __m256i swapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+			vacc[i] = _mm256_add_epi64(vacc[i], _mm256_add_epi64(product, swapped));
+		}
+
+		if (++count % STRIPES_PER_SCRAMBLE == 0)
+		{
+			for (int i = 0; i < 2; ++i)
+			{
+				__m256i a = _mm256_xor_si256(vacc[i], _mm256_srli_epi64(vacc[i], 47));
+				a = _mm256_xor_si256(a, vkey[i]);
+				const __m256i lo = _mm256_mul_epu32(a, prime);
+				const __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+				vacc[i] = _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32));
+			}
+		}
+	}
+
+	for (int i = 0; i < 2; ++i)
+		_mm256_storeu_si256((__m256i*)&acc[i * 4], vacc[i]);
+	// Avoid the AVX-SSE transition penalty in the scalar code that follows
+	_mm256_zeroupper();
+	return FinishStripeHash(acc, src, len);
+}
+#endif
+
 u64 GetHash64(const u8 *src, int len, u32 samples)
 {
 	return ptrHashFunction(src, len, samples);
@@ -504,15 +729,14 @@ void SetHash64Function(bool useHiresTextures)
 	{
 		ptrHashFunction = &GetHashHiresTexture;
 	}
-#if _M_SSE >= 0x402
-	else if (cpu_info.bSSE4_2 && !useHiresTextures) // sse crc32 version
+	else if (cpu_info.bAVX2)
 	{
-		ptrHashFunction = &GetCRC32;
+		ptrHashFunction = &GetStripeHashAVX2;
 	}
-#endif
 	else
 	{
-		ptrHashFunction = &GetMurmurHash3;
+		// Faster than both the SSE4.2 CRC32 and Murmur versions, see HashTest
+		ptrHashFunction = &GetStripeHash;
 	}
 }
 
@@ -15,5 +15,7 @@ u32 HashEctor(const u8* ptr, int length);            // JUNK. DO NOT USE FOR NEW
 u64 GetCRC32(const u8 *src, int len, u32 samples);   // SSE4.2 version of CRC32
 u64 GetHashHiresTexture(const u8 *src, int len, u32 samples);
 u64 GetMurmurHash3(const u8 *src, int len, u32 samples);
+u64 GetStripeHash(const u8 *src, int len, u32 samples);     // SIMD friendly, SSE2 version on x86
+u64 GetStripeHashAVX2(const u8 *src, int len, u32 samples); // Same hashes, needs cpu_info.bAVX2
 u64 GetHash64(const u8 *src, int len, u32 samples);
 void SetHash64Function(bool useHiresTextures);
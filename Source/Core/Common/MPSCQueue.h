@@ -0,0 +1,115 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+// a bounded lockless thread-safe,
+// multiple writer, single reader queue
+//
+// Based on Dmitry Vyukov's bounded MPMC queue: every cell carries a sequence
+// number which tells writers whether the cell is free and the reader whether
+// it has been published. Writers only contend on a single CAS of the write
+// position. Push() fails instead of blocking when the queue is full.
+
+#include <atomic>
+#include <cstddef>
+
+#include "Common/CommonTypes.h"
+
+namespace Common
+{
+
+template <typename T, size_t Size>
+class MPSCQueue
+{
+	static_assert(Size >= 2 && (Size & (Size - 1)) == 0, "MPSCQueue size must be a power of two");
+
+public:
+	MPSCQueue() : m_write_pos(0), m_read_pos(0)
+	{
+		for (size_t i = 0; i < Size; ++i)
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	// Safe to call from any thread. Returns false if the queue is full.
+	// If retries is given, it is incremented once for every time another writer got in the way.
+	bool Push(const T& t, u32* retries = nullptr)
+	{
+		Cell* cell;
+		size_t pos = m_write_pos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			cell = &m_cells[pos & (Size - 1)];
+			size_t seq = cell->sequence.load(std::memory_order_acquire);
+			ptrdiff_t diff = (ptrdiff_t)seq - (ptrdiff_t)pos;
+
+			if (diff == 0)
+			{
+				if (m_write_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				pos = m_write_pos.load(std::memory_order_relaxed);
+			}
+
+			if (retries)
+				++*retries;
+		}
+
+		cell->data = t;
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Only call from the reader thread. Returns false if the queue is empty,
+	// or if the next element was claimed by a writer that hasn't finished writing it yet.
+	bool Pop(T& t)
+	{
+		Cell* cell = &m_cells[m_read_pos & (Size - 1)];
+		size_t seq = cell->sequence.load(std::memory_order_acquire);
+		if ((ptrdiff_t)seq - (ptrdiff_t)(m_read_pos + 1) < 0)
+			return false;
+
+		t = cell->data;
+		cell->sequence.store(m_read_pos + Size, std::memory_order_release);
+		++m_read_pos;
+		return true;
+	}
+
+	// Only call from the reader thread.
+	bool Empty() const
+	{
+		const Cell* cell = &m_cells[m_read_pos & (Size - 1)];
+		return (ptrdiff_t)cell->sequence.load(std::memory_order_acquire) - (ptrdiff_t)(m_read_pos + 1) < 0;
+	}
+
+	// Only call from the reader thread, after Pop returned false. True if that
+	// was because a writer claimed the next element but hasn't finished it yet.
+	bool IsNextUnpublished() const
+	{
+		return m_write_pos.load(std::memory_order_acquire) != m_read_pos;
+	}
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		T data;
+	};
+
+	Cell m_cells[Size];
+
+	// keep the writer and reader positions on separate cache lines
+	u8 m_pad0[64];
+	std::atomic<size_t> m_write_pos;
+	u8 m_pad1[64];
+	size_t m_read_pos;
+};
+
+}
@@ -32,6 +32,21 @@ u32 Timer::GetTimeMs()
 #endif
 }
 
+u64 Timer::GetTimeUs()
+{
+#ifdef _WIN32
+	LARGE_INTEGER freq, counter;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&counter);
+	return (u64)(counter.QuadPart / freq.QuadPart * 1000000 +
+	             counter.QuadPart % freq.QuadPart * 1000000 / freq.QuadPart);
+#else
+	struct timeval t;
+	(void)gettimeofday(&t, nullptr);
+	return ((u64)t.tv_sec * 1000000 + t.tv_usec);
+#endif
+}
+
 // --------------------------------------------
 // Initiate, Start, Stop, and Update the time
 // --------------------------------------------
@@ -0,0 +1,87 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include "Common/WorkerPool.h"
+
+namespace Common
+{
+
+WorkerPool::WorkerPool(int num_threads)
+	: m_func(nullptr), m_count(0), m_next(0), m_pending(0), m_generation(0), m_quit(false)
+{
+	for (int i = 0; i < num_threads; ++i)
+		m_threads.emplace_back(&WorkerPool::WorkerLoop, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lk(m_lock);
+		m_quit = true;
+	}
+	m_work_available.notify_all();
+
+	for (std::thread& thread : m_threads)
+		thread.join();
+}
+
+void WorkerPool::ParallelFor(int count, const std::function<void(int)>& func)
+{
+	u32 generation;
+	{
+		std::lock_guard<std::mutex> lk(m_lock);
+		m_func = &func;
+		m_count = count;
+		m_next = 0;
+		m_pending = count;
+		generation = ++m_generation;
+	}
+	m_work_available.notify_all();
+
+	RunIterations(generation);
+
+	std::unique_lock<std::mutex> lk(m_lock);
+	m_work_done.wait(lk, [this] { return m_pending == 0; });
+	m_func = nullptr;
+}
+
+void WorkerPool::RunIterations(u32 generation)
+{
+	std::unique_lock<std::mutex> lk(m_lock);
+	// A worker that wakes up late must not pick up iterations of a later loop
+	// with the function of this one, so every iteration is checked against
+	// the loop it was started for.
+	while (m_generation == generation && m_next < m_count)
+	{
+		int i = m_next++;
+		const std::function<void(int)>& func = *m_func;
+		lk.unlock();
+
+		func(i);
+
+		lk.lock();
+		if (--m_pending == 0)
+			m_work_done.notify_one();
+	}
+}
+
+void WorkerPool::WorkerLoop()
+{
+	u32 seen = 0;
+	while (true)
+	{
+		u32 generation;
+		{
+			std::unique_lock<std::mutex> lk(m_lock);
+			m_work_available.wait(lk, [&] { return m_quit || m_generation != seen; });
+			if (m_quit)
+				return;
+			generation = seen = m_generation;
+		}
+
+		RunIterations(generation);
+	}
+}
+
+}  // namespace Common
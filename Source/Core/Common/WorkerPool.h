@@ -0,0 +1,56 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+// A fixed set of threads which run the iterations of a loop together with the
+// calling thread.
+//
+// Meant for short bursts of work that come back often, like mixing one audio
+// frame: the threads are started once and wait for the next loop in between.
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace Common
+{
+
+class WorkerPool
+{
+public:
+	explicit WorkerPool(int num_threads);
+	~WorkerPool();
+
+	int GetThreadCount() const { return (int)m_threads.size(); }
+
+	// Calls func(i) for every i in [0, count), on the workers and the calling
+	// thread, in no particular order. Returns once all of them are done.
+	// Only one thread may call this at a time.
+	void ParallelFor(int count, const std::function<void(int)>& func);
+
+private:
+	void WorkerLoop();
+	// Runs iterations of the current loop until there are none left
+	void RunIterations(u32 generation);
+
+	std::vector<std::thread> m_threads;
+
+	std::mutex m_lock;
+	std::condition_variable m_work_available;
+	std::condition_variable m_work_done;
+
+	const std::function<void(int)>* m_func;
+	int m_count;
+	int m_next;
+	int m_pending;
+	u32 m_generation;
+	bool m_quit;
+};
+
+}  // namespace Common
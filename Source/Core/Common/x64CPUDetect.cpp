@@ -42,7 +42,7 @@ static inline void do_cpuid(unsigned int *eax, unsigned int *ebx,
 		"movl  %%ebx,%1;"
 		: "=a" (*eax),
 		  "=S" (*ebx),
-		  "=c" (*ecx),
+		  "+c" (*ecx),
 		  "=d" (*edx)
 		: "a"  (*eax)
 		: "rbx"
@@ -53,7 +53,7 @@ static inline void do_cpuid(unsigned int *eax, unsigned int *ebx,
 		"movl  %%ebx,%1;"
 		: "=a" (*eax),
 		  "=S" (*ebx),
-		  "=c" (*ecx),
+		  "+c" (*ecx),
 		  "=d" (*edx)
 		: "a"  (*eax)
 		: "ebx"
@@ -204,6 +204,13 @@ void CPUInfo::Detect()
 			}
 		}
 	}
+	if (max_std_fn >= 7)
+	{
+		// Structured extended feature flags, subleaf 0
+		__cpuid(cpu_id, 0x00000007);
+		if (bAVX && ((cpu_id[1] >> 5) & 1))
+			bAVX2 = true;
+	}
 	if (max_ex_fn >= 0x80000004) {
 		// Extract brand string
 		__cpuid(cpu_id, 0x80000002);
@@ -262,6 +269,7 @@ std::string CPUInfo::Summarize()
 	if (bSSE4_2) sum += ", SSE4.2";
 	if (HTT) sum += ", HTT";
 	if (bAVX) sum += ", AVX";
+	if (bAVX2) sum += ", AVX2";
 	if (bFMA) sum += ", FMA";
 	if (bAES) sum += ", AES";
 	if (bMOVBE) sum += ", MOVBE";
@@ -19,6 +19,8 @@
 // Zero Codes: any code with no address.  These codes are used to do special operations like memory copy, etc
 // -------------------------------------------------------------------------------------------------------------
 
+#include <algorithm>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -71,12 +73,32 @@ enum
 	SUB_MASTER_CODE   = 0x03,
 };
 
+// Compiled op types
+enum
+{
+	OP_NOP,
+	OP_END,
+	// Lines that end the code with an error, which RunCode reports
+	OP_RUN_CODE,
+	OP_WRITE,
+	OP_WRITE_POINTER,
+	OP_ADD,
+	OP_IF,
+	// These two take up their line and the next one
+	OP_FILL_AND_SLIDE,
+	OP_MEMORY_COPY,
+};
+
 // pointer to the code currently being run, (used by log messages that include the code name)
 static ARCode const* current_code = nullptr;
 
 static bool b_RanOnce = false;
 static std::vector<ARCode> arCodes;
 static std::vector<ARCode> activeCodes;
+// Compiled from activeCodes after their first run, which logs what they do
+static std::vector<ARCompiledCode> compiledCodes;
+// The RAM the pointers in compiledCodes point to
+static u8* compiledRAM = nullptr;
 static bool logSelf = false;
 static std::vector<std::string> arLog;
 
@@ -255,11 +277,23 @@ void RunAllActive()
 {
 	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bEnableCheats)
 	{
-		for (auto& activeCode : activeCodes)
+		const bool run_compiled = b_RanOnce;
+		if (run_compiled && (compiledCodes.size() != activeCodes.size() || compiledRAM != Memory::GetMainRAMPtr()))
 		{
-			if (activeCode.active)
+			compiledCodes.clear();
+			for (const ARCode& activeCode : activeCodes)
+				compiledCodes.push_back(CompileCode(activeCode));
+			compiledRAM = Memory::GetMainRAMPtr();
+		}
+
+		for (size_t i = 0; i < activeCodes.size(); ++i)
+		{
+			if (activeCodes[i].active)
 			{
-				activeCode.active = RunCode(activeCode);
+				if (run_compiled)
+					activeCodes[i].active = RunCompiledCode(compiledCodes[i]);
+				else
+					activeCodes[i].active = RunCode(activeCodes[i]);
 				LogInfo("\n");
 			}
 		}
@@ -427,6 +461,412 @@ bool RunCode(const ARCode &arcode)
 
 	return true;
 }
+
+// Host pointer to a range of main RAM, or nullptr if it isn't all in RAM
+static u8* GetRAMPointer(u32 address, u64 size)
+{
+#ifdef ENABLE_MEM_CHECK
+	// Memory checks only see accesses through Memory::Read/Write
+	return nullptr;
+#else
+	if ((address >> 28) != 0x8 || (address & 0x0FFFFFFF) + size > Memory::REALRAM_SIZE)
+		return nullptr;
+	return Memory::GetMainRAMPtr() + (address & Memory::RAM_MASK);
+#endif
+}
+
+// The range written by a fill and slide op, in the order it is written
+static void GetFillAndSlideRange(const ARCompiledOp& op, s64* first, s64* last)
+{
+	*first = op.addr;
+	*last = op.addr + (s64)op.addr_incr * (op.count - 1);
+}
+
+ARCompiledCode CompileCode(const ARCode &arcode)
+{
+	ARCompiledCode compiled;
+	compiled.name = arcode.name;
+	compiled.lines = arcode.ops;
+
+	const u32 num_lines = (u32)arcode.ops.size();
+	compiled.ops.resize(num_lines);
+
+	// The line after the first "00000000 40000000" line after each line, where
+	// skipping all lines until one ends
+	std::vector<u32> after_endif(num_lines);
+	u32 next_endif = num_lines;
+	for (u32 i = num_lines; i-- > 0;)
+	{
+		after_endif[i] = next_endif;
+		if (arcode.ops[i].cmd_addr == 0 && arcode.ops[i].value == 0x40000000)
+			next_endif = i + 1;
+	}
+
+	// Every line is compiled as if a code started on it, because conditionals
+	// can skip to the second line of a fill and slide or memory copy
+	for (u32 i = 0; i < num_lines; ++i)
+	{
+		const ARAddr addr(arcode.ops[i].cmd_addr);
+		const u32 data = arcode.ops[i].value;
+		ARCompiledOp& op = compiled.ops[i];
+
+		if (addr >= 0x00002000 && addr < 0x00003000)
+		{
+			op.type = OP_RUN_CODE;
+		}
+		else if (0x0 == addr)
+		{
+			switch (data >> 29)
+			{
+			case ZCODE_END:
+				op.type = OP_END;
+				break;
+
+			case ZCODE_NORM:
+				break;
+
+			case ZCODE_04:
+			{
+				// Without a next line it does nothing
+				if (i + 1 == num_lines)
+					break;
+
+				const ARAddr next_addr(arcode.ops[i + 1].cmd_addr);
+				const u32 next_data = arcode.ops[i + 1].value;
+				const ARAddr fill(data);
+				if (0x3 == ((data >> 25) & 0x03))
+				{
+					if ((next_data & ~0x7FFF) != 0)
+					{
+						op.type = OP_RUN_CODE;
+						op.num_lines = 2;
+						break;
+					}
+					op.type = OP_MEMORY_COPY;
+					op.addr = next_addr.GCAddress();
+					op.value = data | 0x06000000;
+					op.count = (u8)(next_data & 0x7FFF);
+				}
+				else if (fill.size == DATATYPE_32BIT_FLOAT)
+				{
+					op.type = OP_RUN_CODE;
+					op.num_lines = 2;
+				}
+				else
+				{
+					op.type = OP_FILL_AND_SLIDE;
+					op.size = fill.size;
+					op.addr = fill.GCAddress();
+					op.value = next_addr;
+					op.count = (next_data & 0xFF0000) >> 16;
+					op.addr_incr = (s16)(next_data & 0xFFFF) * (1 << fill.size);
+					op.value_incr = (s8)(next_data >> 24);
+					if (op.count)
+					{
+						s64 first, last;
+						GetFillAndSlideRange(op, &first, &last);
+						const s64 start = std::min(first, last);
+						const s64 end = std::max(first, last) + (1 << fill.size);
+						if (start >= 0 && GetRAMPointer((u32)start, end - start))
+							op.ptr = GetRAMPointer(op.addr, 1);
+					}
+				}
+				break;
+			}
+
+			default:
+				op.type = OP_RUN_CODE;
+				break;
+			}
+		}
+		else if (addr.type == 0x00)
+		{
+			const u32 new_addr = addr.GCAddress();
+			op.addr = new_addr;
+			op.size = std::min<u8>(addr.size, DATATYPE_32BIT);
+			switch (addr.subtype)
+			{
+			case SUB_RAM_WRITE:
+				op.type = OP_WRITE;
+				if (addr.size == DATATYPE_8BIT)
+				{
+					op.value = data & 0xFF;
+					op.count = (data >> 8) + 1;
+				}
+				else if (addr.size == DATATYPE_16BIT)
+				{
+					op.value = data & 0xFFFF;
+					op.count = (data >> 16) + 1;
+				}
+				else
+				{
+					op.value = data;
+					op.count = 1;
+				}
+				op.ptr = GetRAMPointer(new_addr, (u64)op.count << op.size);
+				break;
+
+			case SUB_WRITE_POINTER:
+				op.type = OP_WRITE_POINTER;
+				if (addr.size == DATATYPE_8BIT)
+				{
+					op.value = data & 0xFF;
+					op.count = data >> 8;
+				}
+				else if (addr.size == DATATYPE_16BIT)
+				{
+					op.value = data & 0xFFFF;
+					op.count = (data >> 16) << 1;
+				}
+				else
+				{
+					op.value = data;
+				}
+				op.ptr = GetRAMPointer(new_addr, 4);
+				break;
+
+			case SUB_ADD_CODE:
+				op.type = OP_ADD;
+				op.size = addr.size;
+				op.value = data;
+				op.ptr = GetRAMPointer(new_addr, 1 << op.size);
+				break;
+
+			default:
+				op.type = OP_RUN_CODE;
+				break;
+			}
+		}
+		else
+		{
+			op.type = OP_IF;
+			op.addr = addr.GCAddress();
+			op.size = std::min<u8>(addr.size, DATATYPE_32BIT);
+			op.compare = addr.type;
+			op.value = data & (op.size == DATATYPE_8BIT ? 0xFF : op.size == DATATYPE_16BIT ? 0xFFFF : 0xFFFFFFFF);
+			op.ptr = GetRAMPointer(op.addr, 1 << op.size);
+			switch (addr.subtype)
+			{
+			case CONDTIONAL_ONE_LINE:
+			case CONDTIONAL_TWO_LINES:
+				op.skip_to = std::min(i + 2 + addr.subtype, num_lines);
+				break;
+			case CONDTIONAL_ALL_LINES_UNTIL:
+				op.skip_to = after_endif[i];
+				break;
+			case CONDTIONAL_ALL_LINES:
+				op.skip_to = num_lines;
+				break;
+			}
+		}
+
+		if (op.type == OP_RUN_CODE)
+		{
+			op.count = i;
+			op.num_lines = std::max<u8>(op.num_lines, 1);
+		}
+	}
+
+	return compiled;
+}
+
+bool RunCompiledCode(const ARCompiledCode &compiled)
+{
+	const ARCompiledOp* const ops = compiled.ops.data();
+	const u32 num_ops = (u32)compiled.ops.size();
+
+	u32 i = 0;
+	while (i < num_ops)
+	{
+		const ARCompiledOp& op = ops[i];
+		u32 next = i + 1;
+
+		switch (op.type)
+		{
+		case OP_NOP:
+			break;
+
+		case OP_END:
+			return true;
+
+		case OP_RUN_CODE:
+		{
+			ARCode arcode;
+			arcode.name = compiled.name;
+			arcode.ops.assign(compiled.lines.begin() + op.count, compiled.lines.begin() + op.count + op.num_lines);
+			arcode.active = true;
+			arcode.user_defined = false;
+			return RunCode(arcode);
+		}
+
+		case OP_WRITE:
+			if (op.ptr)
+			{
+				switch (op.size)
+				{
+				case DATATYPE_8BIT:
+					memset(op.ptr, op.value, op.count);
+					break;
+				case DATATYPE_16BIT:
+					for (u32 j = 0; j < op.count; ++j)
+						*(u16*)(op.ptr + j * 2) = Common::swap16((u16)op.value);
+					break;
+				default:
+					*(u32*)op.ptr = Common::swap32(op.value);
+					break;
+				}
+				Memory::MarkWritten(op.addr, op.count << op.size);
+			}
+			else
+			{
+				for (u32 j = 0; j < op.count; ++j)
+				{
+					switch (op.size)
+					{
+					case DATATYPE_8BIT:  Memory::Write_U8(op.value, op.addr + j); break;
+					case DATATYPE_16BIT: Memory::Write_U16(op.value, op.addr + j * 2); break;
+					default:             Memory::Write_U32(op.value, op.addr); break;
+					}
+				}
+			}
+			break;
+
+		case OP_WRITE_POINTER:
+		{
+			const u32 ptr = op.ptr ? Common::swap32(*(u32*)op.ptr) : Memory::Read_U32(op.addr);
+			switch (op.size)
+			{
+			case DATATYPE_8BIT:  Memory::Write_U8(op.value, ptr + op.count); break;
+			case DATATYPE_16BIT: Memory::Write_U16(op.value, ptr + op.count); break;
+			default:             Memory::Write_U32(op.value, ptr); break;
+			}
+			break;
+		}
+
+		case OP_ADD:
+			if (op.ptr)
+			{
+				switch (op.size)
+				{
+				case DATATYPE_8BIT:
+					*op.ptr += (u8)op.value;
+					break;
+				case DATATYPE_16BIT:
+					*(u16*)op.ptr = Common::swap16(Common::swap16(*(u16*)op.ptr) + (u16)op.value);
+					break;
+				case DATATYPE_32BIT:
+					*(u32*)op.ptr = Common::swap32(Common::swap32(*(u32*)op.ptr) + op.value);
+					break;
+				default:
+				{
+					const u32 read = Common::swap32(*(u32*)op.ptr);
+					const float fread = *((float*)&read) + (float)op.value;
+					*(u32*)op.ptr = Common::swap32(*((u32*)&fread));
+					break;
+				}
+				}
+				Memory::MarkWritten(op.addr, 1 << op.size);
+			}
+			else
+			{
+				switch (op.size)
+				{
+				case DATATYPE_8BIT:
+					Memory::Write_U8(Memory::Read_U8(op.addr) + op.value, op.addr);
+					break;
+				case DATATYPE_16BIT:
+					Memory::Write_U16(Memory::Read_U16(op.addr) + op.value, op.addr);
+					break;
+				case DATATYPE_32BIT:
+					Memory::Write_U32(Memory::Read_U32(op.addr) + op.value, op.addr);
+					break;
+				default:
+				{
+					const u32 read = Memory::Read_U32(op.addr);
+					const float fread = *((float*)&read) + (float)op.value;
+					Memory::Write_U32(*((u32*)&fread), op.addr);
+					break;
+				}
+				}
+			}
+			break;
+
+		case OP_IF:
+		{
+			u32 value;
+			switch (op.size)
+			{
+			case DATATYPE_8BIT:
+				value = op.ptr ? *op.ptr : Memory::Read_U8(op.addr);
+				break;
+			case DATATYPE_16BIT:
+				value = op.ptr ? Common::swap16(*(u16*)op.ptr) : Memory::Read_U16(op.addr);
+				break;
+			default:
+				value = op.ptr ? Common::swap32(*(u32*)op.ptr) : Memory::Read_U32(op.addr);
+				break;
+			}
+			// Compiled codes only run once b_RanOnce is set, so this doesn't log
+			if (!CompareValues(value, op.value, op.compare))
+				next = op.skip_to;
+			break;
+		}
+
+		case OP_FILL_AND_SLIDE:
+		{
+			u32 val = op.value;
+			if (op.ptr)
+			{
+				u8* ptr = op.ptr;
+				for (u32 j = 0; j < op.count; ++j)
+				{
+					switch (op.size)
+					{
+					case DATATYPE_8BIT:  *ptr = (u8)val; break;
+					case DATATYPE_16BIT: *(u16*)ptr = Common::swap16((u16)val); break;
+					default:             *(u32*)ptr = Common::swap32(val); break;
+					}
+					ptr += op.addr_incr;
+					val += op.value_incr;
+				}
+
+				s64 first, last;
+				GetFillAndSlideRange(op, &first, &last);
+				const u32 start = (u32)std::min(first, last);
+				Memory::MarkWritten(start, (u32)(std::max(first, last) - start) + (1 << op.size));
+			}
+			else
+			{
+				u32 curr_addr = op.addr;
+				for (u32 j = 0; j < op.count; ++j)
+				{
+					switch (op.size)
+					{
+					case DATATYPE_8BIT:  Memory::Write_U8(val & 0xFF, curr_addr); break;
+					case DATATYPE_16BIT: Memory::Write_U16(val & 0xFFFF, curr_addr); break;
+					default:             Memory::Write_U32(val, curr_addr); break;
+					}
+					curr_addr += op.addr_incr;
+					val += op.value_incr;
+				}
+			}
+			next = i + 2;
+			break;
+		}
+
+		case OP_MEMORY_COPY:
+			for (u32 j = 0; j < op.count; ++j)
+				Memory::Write_U32(Memory::Read_U32(op.addr + j), op.value + j);
+			next = i + 2;
+			break;
+		}
+
+		i = next;
+	}
+
+	return true;
+}
+
 size_t GetCodeListSize()
 {
 	return arCodes.size();
@@ -461,6 +901,7 @@ void UpdateActiveList()
 	SConfig::GetInstance().m_LocalCoreStartupParameter.bEnableCheats = false;
 	b_RanOnce = false;
 	activeCodes.clear();
+	compiledCodes.clear();
 	for (auto& arCode : arCodes)
 	{
 		if (arCode.active)
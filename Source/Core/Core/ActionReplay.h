@@ -25,8 +25,40 @@ struct ARCode
 	bool user_defined;
 };
 
+// A code decoded once into one op per line, with the addresses resolved, so
+// that running it every frame doesn't parse every line again. Host pointers
+// into RAM stay valid until memory is set up again.
+struct ARCompiledOp
+{
+	u8 type;
+	u8 size;
+	u8 compare;
+	// Lines an op run through RunCode is made of
+	u8 num_lines;
+	u32 addr;
+	u32 value;
+	// Bytes or values to write, the pointer offset, or the first line for RunCode
+	u32 count;
+	s32 addr_incr;
+	s32 value_incr;
+	// Line to continue at when a conditional is false
+	u32 skip_to;
+	// addr in RAM, or nullptr to go through Memory::Read/Write
+	u8* ptr;
+};
+
+struct ARCompiledCode
+{
+	std::string name;
+	std::vector<AREntry> lines;
+	std::vector<ARCompiledOp> ops;
+};
+
 void RunAllActive();
 bool RunCode(const ARCode &arcode);
+ARCompiledCode CompileCode(const ARCode &arcode);
+// Has the same effect and result as RunCode on the code it was compiled from
+bool RunCompiledCode(const ARCompiledCode &compiled);
 void LoadCodes(const IniFile &globalini, const IniFile &localIni, bool forceLoad);
 void LoadCodes(std::vector<ARCode> &_arCodes, IniFile &globalini, IniFile &localIni);
 size_t GetCodeListSize();
@@ -110,6 +110,7 @@ static const struct
 	{ "UndoSaveState",       351 /* WXK_F12 */,   4 /* wxMOD_SHIFT */ },
 	{ "SaveStateFile",       0,                   0 /* wxMOD_NONE */ },
 	{ "LoadStateFile",       0,                   0 /* wxMOD_NONE */ },
+	{ "Rewind",              0,                   0 /* wxMOD_NONE */ },
 };
 
 SConfig::SConfig()
@@ -234,6 +235,10 @@ void SConfig::SaveSettings()
 	ini.Set("Core", "DSPThread",        m_LocalCoreStartupParameter.bDSPThread);
 	ini.Set("Core", "DSPHLE",           m_LocalCoreStartupParameter.bDSPHLE);
 	ini.Set("Core", "SkipIdle",         m_LocalCoreStartupParameter.bSkipIdle);
+	ini.Set("Core", "JITCarryRegisters", m_LocalCoreStartupParameter.bJITCarryRegisters);
+	ini.Set("Core", "JITRegions",       m_LocalCoreStartupParameter.bJITRegions);
+	ini.Set("Core", "RewindInterval",   m_LocalCoreStartupParameter.iRewindInterval);
+	ini.Set("Core", "RewindBudget",     m_LocalCoreStartupParameter.iRewindBudget);
 	ini.Set("Core", "DefaultGCM",       m_LocalCoreStartupParameter.m_strDefaultGCM);
 	ini.Set("Core", "DVDRoot",          m_LocalCoreStartupParameter.m_strDVDRoot);
 	ini.Set("Core", "Apploader",        m_LocalCoreStartupParameter.m_strApploader);
@@ -269,6 +274,10 @@ void SConfig::SaveSettings()
 
 	// DSP
 	ini.Set("DSP", "EnableJIT", m_DSPEnableJIT);
+	ini.Set("DSP", "MaxSkew", m_DSPMaxSkew);
+	ini.Set("DSP", "HLEVoiceThreads", m_DSPHLEVoiceThreads);
+	ini.Set("DSP", "HLEPolyphase", m_DSPHLEPolyphase);
+	ini.Set("DSP", "ResampleQuality", m_DSPResampleQuality);
 	ini.Set("DSP", "DumpAudio", m_DumpAudio);
 	ini.Set("DSP", "Backend", sBackend);
 	ini.Set("DSP", "Volume", m_Volume);
@@ -390,6 +399,10 @@ void SConfig::LoadSettings()
 		ini.Get("Core", "DSPHLE",            &m_LocalCoreStartupParameter.bDSPHLE,       true);
 		ini.Get("Core", "CPUThread",         &m_LocalCoreStartupParameter.bCPUThread,    true);
 		ini.Get("Core", "SkipIdle",          &m_LocalCoreStartupParameter.bSkipIdle,     true);
+		ini.Get("Core", "JITCarryRegisters", &m_LocalCoreStartupParameter.bJITCarryRegisters, false);
+		ini.Get("Core", "JITRegions",        &m_LocalCoreStartupParameter.bJITRegions, false);
+		ini.Get("Core", "RewindInterval",    &m_LocalCoreStartupParameter.iRewindInterval, 0);
+		ini.Get("Core", "RewindBudget",      &m_LocalCoreStartupParameter.iRewindBudget, 256);
 		ini.Get("Core", "DefaultGCM",        &m_LocalCoreStartupParameter.m_strDefaultGCM);
 		ini.Get("Core", "DVDRoot",           &m_LocalCoreStartupParameter.m_strDVDRoot);
 		ini.Get("Core", "Apploader",         &m_LocalCoreStartupParameter.m_strApploader);
@@ -434,6 +447,10 @@ void SConfig::LoadSettings()
 
 		// DSP
 		ini.Get("DSP", "EnableJIT", &m_DSPEnableJIT, true);
+		ini.Get("DSP", "MaxSkew", &m_DSPMaxSkew, 0);
+		ini.Get("DSP", "HLEVoiceThreads", &m_DSPHLEVoiceThreads, 0);
+		ini.Get("DSP", "HLEPolyphase", &m_DSPHLEPolyphase, false);
+		ini.Get("DSP", "ResampleQuality", &m_DSPResampleQuality, 0);
 		ini.Get("DSP", "DumpAudio", &m_DumpAudio, false);
 	#if defined __linux__ && HAVE_ALSA
 		ini.Get("DSP", "Backend", &sBackend, BACKEND_ALSA);
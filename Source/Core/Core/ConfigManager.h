@@ -80,6 +80,18 @@ struct SConfig : NonCopyable
 
 	// DSP settings
 	bool m_DSPEnableJIT;
+	// How many DSP cycles the LLE DSP thread may fall behind the CPU.
+	// 0 keeps the two in lock-step.
+	int m_DSPMaxSkew;
+	// Worker threads the AX HLE ucodes spread their voices across.
+	// 0 processes them on the emulation thread.
+	int m_DSPHLEVoiceThreads;
+	// Use the DROM coefficients for polyphase resampling in AX HLE, when
+	// dsp_coef.bin is available, instead of linear interpolation.
+	bool m_DSPHLEPolyphase;
+	// How the mixer resamples to the output rate, see ResampleQuality in
+	// AudioCommon/Mixer.h
+	int m_DSPResampleQuality;
 	bool m_DumpAudio;
 	int m_Volume;
 	std::string sBackend;
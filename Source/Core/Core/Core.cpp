@@ -31,6 +31,7 @@
 #include "Core/Movie.h"
 #include "Core/NetPlayProto.h"
 #include "Core/PatchEngine.h"
+#include "Core/Rewind.h"
 #include "Core/State.h"
 #include "Core/VolumeHandler.h"
 #include "Core/Boot/Boot.h"
@@ -633,6 +634,8 @@ void VideoThrottle()
 	}
 
 	DrawnVideo++;
+
+	Rewind::FrameUpdate();
 }
 
 // Executed from GPU thread
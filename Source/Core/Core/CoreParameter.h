@@ -79,6 +79,7 @@ enum Hotkey
 	HK_UNDO_SAVE_STATE,
 	HK_SAVE_STATE_FILE,
 	HK_LOAD_STATE_FILE,
+	HK_REWIND,
 
 	NUM_HOTKEYS,
 };
@@ -103,6 +104,11 @@ struct SCoreStartupParameter
 
 	// JIT (shared between JIT and JITIL)
 	bool bJITNoBlockCache, bJITBlockLinking;
+	// Keep hot registers in host registers across linked Jit64 blocks
+	bool bJITCarryRegisters;
+	// Compile Jit64 blocks as regions, with leaf functions inlined and forward
+	// branches inside the block
+	bool bJITRegions;
 	bool bJITOff;
 	bool bJITLoadStoreOff, bJITLoadStorelXzOff, bJITLoadStorelwzOff, bJITLoadStorelbzxOff;
 	bool bJITLoadStoreFloatingOff;
@@ -122,6 +128,9 @@ struct SCoreStartupParameter
 	bool bDSPThread;
 	bool bDSPHLE;
 	bool bSkipIdle;
+	// Rewind history, see Rewind.h. 0 disables it.
+	int iRewindInterval;
+	int iRewindBudget;
 	bool bNTSC;
 	bool bForceNTSCJ;
 	bool bHLE_BS2;
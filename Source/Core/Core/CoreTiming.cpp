@@ -2,11 +2,16 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
 #include <cinttypes>
+#include <functional>
 #include <string>
+#include <tuple>
 #include <vector>
 
 #include "Common/FifoQueue.h"
+#include "Common/MPSCQueue.h"
 #include "Common/StringUtil.h"
 #include "Common/Thread.h"
 
@@ -17,6 +22,7 @@
 #include "VideoCommon/VideoBackendBase.h"
 
 #define MAX_SLICE_LENGTH 20000
+#define TS_QUEUE_SIZE 1024
 
 namespace CoreTiming
 {
@@ -29,22 +35,56 @@ struct EventType
 
 std::vector<EventType> event_types;
 
-struct BaseEvent
+struct Event
 {
 	s64 time;
+	u64 fifo_order;
 	u64 userdata;
 	int type;
+	u32 slot;
 };
 
-typedef LinkedListItem<BaseEvent> Event;
+// Sort by time, unless the times are the same, in which case sort by the order added to the queue
+static bool operator>(const Event& left, const Event& right)
+{
+	return std::tie(left.time, left.fifo_order) > std::tie(right.time, right.fifo_order);
+}
+
+// Every queued event owns a slot, which is what an EventHandle refers to.
+// The generation is bumped whenever the slot is released so stale handles are ignored.
+struct EventSlot
+{
+	u32 generation;
+	bool cancelled;
+};
 
 // STATE_TO_SAVE
-static Event *first;
+// The queue is a min-heap using std::make_heap/push_heap/pop_heap.
+// We don't use std::priority_queue because we need to be able to serialize, unserialize and
+// erase arbitrary events (RemoveEvent()) regardless of the queue order. These aren't accomodated
+// by the standard adaptor class.
+static std::vector<Event> eventQueue;
+static u64 eventFifoId;
+
+// Events scheduled from other threads. They normally go through the lockless tsQueue,
+// if that is full they are put in tsOverflowQueue under tsWriteLock instead. Once that
+// happened, every writer keeps using the overflow queue until the CPU thread has emptied
+// it, so events from the same thread are never reordered.
+static Common::MPSCQueue<Event, TS_QUEUE_SIZE> tsQueue;
 static std::mutex tsWriteLock;
-Common::FifoQueue<BaseEvent, false> tsQueue;
+static Common::FifoQueue<Event, false> tsOverflowQueue;
+static std::atomic<bool> tsOverflowed;
+// Set after pushing a threadsafe event, lets the CPU thread skip MoveEvents cheaply.
+static std::atomic<bool> tsPending;
+
+// Contention counters for the threadsafe path
+static std::atomic<u32> tsRetries;
+static std::atomic<u32> tsOverflows;
+static u32 tsEventsMoved;
+static u32 tsMoves;
 
-// event pools
-Event *eventPool = nullptr;
+static std::vector<EventSlot> eventSlots;
+static std::vector<u32> freeEventSlots;
 
 int downcount, slicelength;
 int maxSliceLength = MAX_SLICE_LENGTH;
@@ -62,20 +102,87 @@ int ev_lost;
 
 void (*advanceCallback)(int cyclesExecuted) = nullptr;
 
-Event* GetNewEvent()
+static u32 AllocateEventSlot()
 {
-	if (!eventPool)
-		return new Event;
+	if (freeEventSlots.empty())
+	{
+		EventSlot slot = { 1, false };
+		eventSlots.push_back(slot);
+		return (u32)eventSlots.size() - 1;
+	}
 
-	Event* ev = eventPool;
-	eventPool = ev->next;
+	u32 slot = freeEventSlots.back();
+	freeEventSlots.pop_back();
+	return slot;
+}
+
+static void FreeEventSlot(u32 slot)
+{
+	eventSlots[slot].generation++;
+	eventSlots[slot].cancelled = false;
+	freeEventSlots.push_back(slot);
+}
+
+static bool IsCancelled(const Event& ev)
+{
+	return eventSlots[ev.slot].cancelled;
+}
+
+static EventHandle PushEvent(Event ev)
+{
+	ev.fifo_order = eventFifoId++;
+	ev.slot = AllocateEventSlot();
+	eventQueue.push_back(ev);
+	std::push_heap(eventQueue.begin(), eventQueue.end(), std::greater<Event>());
+
+	return ((u64)eventSlots[ev.slot].generation << 32) | ev.slot;
+}
+
+// The caller is responsible for releasing the slot of the returned event.
+static Event PopEvent()
+{
+	std::pop_heap(eventQueue.begin(), eventQueue.end(), std::greater<Event>());
+	Event ev = eventQueue.back();
+	eventQueue.pop_back();
 	return ev;
 }
 
-void FreeEvent(Event* ev)
+// Cancelled events are left in the heap until they reach the top.
+static void DropCancelledEvents()
+{
+	while (!eventQueue.empty() && IsCancelled(eventQueue.front()))
+		FreeEventSlot(PopEvent().slot);
+}
+
+// Runs all events which are due, in order.
+static void RunDueEvents()
+{
+	DropCancelledEvents();
+
+	while (!eventQueue.empty() && eventQueue.front().time <= globalTimer)
+	{
+		//LOG(POWERPC, "[Scheduler] %s     (%lld, %lld) ",
+		//             event_types[eventQueue.front().type].name.c_str(), (u64)globalTimer, (u64)eventQueue.front().time);
+		Event evt = PopEvent();
+		FreeEventSlot(evt.slot);
+		event_types[evt.type].callback(evt.userdata, (int)(globalTimer - evt.time));
+
+		DropCancelledEvents();
+	}
+}
+
+// Returns the pending events in the order they will be executed, skipping cancelled ones.
+static std::vector<Event> GetSortedEvents()
 {
-	ev->next = eventPool;
-	eventPool = ev;
+	std::vector<Event> events;
+	events.reserve(eventQueue.size());
+	for (const Event& ev : eventQueue)
+	{
+		if (!IsCancelled(ev))
+			events.push_back(ev);
+	}
+	std::sort(events.begin(), events.end(), [](const Event& left, const Event& right) { return right > left; });
+	return events;
 }
 
 static void EmptyTimedCallback(u64 userdata, int cyclesLate) {}
@@ -104,9 +211,23 @@ int RegisterEvent(const std::string& name, TimedCallback callback)
 	return (int)event_types.size() - 1;
 }
 
+// Drops all cancelled events, not just the ones on top of the heap.
+static void PurgeCancelledEvents()
+{
+	auto cancelled = std::partition(eventQueue.begin(), eventQueue.end(), [](const Event& ev) { return !IsCancelled(ev); });
+	if (cancelled == eventQueue.end())
+		return;
+
+	for (auto it = cancelled; it != eventQueue.end(); ++it)
+		FreeEventSlot(it->slot);
+	eventQueue.erase(cancelled, eventQueue.end());
+	std::make_heap(eventQueue.begin(), eventQueue.end(), std::greater<Event>());
+}
+
 void UnregisterAllEvents()
 {
-	if (first)
+	PurgeCancelledEvents();
+	if (!eventQueue.empty())
 		PanicAlertT("Cannot unregister events with events pending");
 	event_types.clear();
 }
@@ -118,25 +239,27 @@ void Init()
 	globalTimer = 0;
 	idledCycles = 0;
 
+	tsRetries = 0;
+	tsOverflows = 0;
+	tsEventsMoved = 0;
+	tsMoves = 0;
+
 	ev_lost = RegisterEvent("_lost_event", &EmptyTimedCallback);
 }
 
 void Shutdown()
 {
-	std::lock_guard<std::mutex> lk(tsWriteLock);
+	INFO_LOG(POWERPC, "%s", GetThreadsafeEventStats().c_str());
+
 	MoveEvents();
 	ClearPendingEvents();
 	UnregisterAllEvents();
 
-	while (eventPool)
-	{
-		Event *ev = eventPool;
-		eventPool = ev->next;
-		delete ev;
-	}
+	eventSlots.clear();
+	freeEventSlots.clear();
 }
 
-void EventDoState(PointerWrap &p, BaseEvent* ev)
+void EventDoState(PointerWrap &p, Event* ev)
 {
 	p.Do(ev->time);
 
@@ -172,7 +295,6 @@ void EventDoState(PointerWrap &p, BaseEvent* ev)
 
 void DoState(PointerWrap &p)
 {
-	std::lock_guard<std::mutex> lk(tsWriteLock);
 	p.Do(downcount);
 	p.Do(slicelength);
 	p.Do(globalTimer);
@@ -185,7 +307,36 @@ void DoState(PointerWrap &p)
 
 	MoveEvents();
 
-	p.DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, EventDoState>(first);
+	// The events are stored in the same layout PointerWrap::DoLinkedList used to produce,
+	// in execution order, so older savestates stay loadable.
+	if (p.GetMode() == PointerWrap::MODE_READ)
+	{
+		ClearPendingEvents();
+
+		while (true)
+		{
+			u8 shouldExist = 0;
+			p.Do(shouldExist);
+			if (shouldExist != 1)
+				break;
+
+			Event ev;
+			EventDoState(p, &ev);
+			PushEvent(ev);
+		}
+	}
+	else
+	{
+		for (Event& ev : GetSortedEvents())
+		{
+			u8 shouldExist = 1;
+			p.Do(shouldExist);
+			EventDoState(p, &ev);
+		}
+
+		u8 shouldExist = 0;
+		p.Do(shouldExist);
+	}
 	p.DoMarker("CoreTimingEvents");
 }
 
@@ -203,12 +354,26 @@ u64 GetIdleTicks()
 // schedule things to be executed on the main thread.
 void ScheduleEvent_Threadsafe(int cyclesIntoFuture, int event_type, u64 userdata)
 {
-	std::lock_guard<std::mutex> lk(tsWriteLock);
 	Event ne;
+	ne.fifo_order = 0;
+	ne.slot = 0;
 	ne.time = globalTimer + cyclesIntoFuture;
 	ne.type = event_type;
 	ne.userdata = userdata;
-	tsQueue.Push(ne);
+
+	u32 retries = 0;
+	if (tsOverflowed.load(std::memory_order_acquire) || !tsQueue.Push(ne, &retries))
+	{
+		std::lock_guard<std::mutex> lk(tsWriteLock);
+		tsOverflowed.store(true, std::memory_order_relaxed);
+		tsOverflowQueue.Push(ne);
+		tsOverflows.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	if (retries)
+		tsRetries.fetch_add(retries, std::memory_order_relaxed);
+
+	tsPending.store(true, std::memory_order_release);
 }
 
 // Same as ScheduleEvent_Threadsafe(0, ...) EXCEPT if we are already on the CPU thread
@@ -227,42 +392,28 @@ void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata)
 
 void ClearPendingEvents()
 {
-	while (first)
-	{
-		Event *e = first->next;
-		FreeEvent(first);
-		first = e;
-	}
-}
-
-void AddEventToQueue(Event* ne)
-{
-	Event* prev = nullptr;
-	Event** pNext = &first;
-	for (;;)
-	{
-		Event*& next = *pNext;
-		if (!next || ne->time < next->time)
-		{
-			ne->next = next;
-			next = ne;
-			break;
-		}
-		prev = next;
-		pNext = &prev->next;
-	}
+	for (const Event& ev : eventQueue)
+		FreeEventSlot(ev.slot);
+	eventQueue.clear();
 }
 
 // This must be run ONLY from within the cpu thread
 // cyclesIntoFuture may be VERY inaccurate if called from anything else
 // than Advance
-void ScheduleEvent(int cyclesIntoFuture, int event_type, u64 userdata)
+EventHandle ScheduleEvent(int cyclesIntoFuture, int event_type, u64 userdata)
 {
-	Event *ne = GetNewEvent();
-	ne->userdata = userdata;
-	ne->type = event_type;
-	ne->time = globalTimer + cyclesIntoFuture;
-	AddEventToQueue(ne);
+	Event ne;
+	ne.userdata = userdata;
+	ne.type = event_type;
+	ne.time = globalTimer + cyclesIntoFuture;
+	return PushEvent(ne);
+}
+
+void CancelEvent(EventHandle handle)
+{
+	u32 slot = (u32)handle;
+	if (slot < eventSlots.size() && eventSlots[slot].generation == (u32)(handle >> 32))
+		eventSlots[slot].cancelled = true;
 }
 
 void RegisterAdvanceCallback(void (*callback)(int cyclesExecuted))
@@ -272,54 +423,30 @@ void RegisterAdvanceCallback(void (*callback)(int cyclesExecuted))
 
 bool IsScheduled(int event_type)
 {
-	if (!first)
-		return false;
-	Event *e = first;
-	while (e) {
-		if (e->type == event_type)
+	for (const Event& ev : eventQueue)
+	{
+		if (ev.type == event_type && !IsCancelled(ev))
 			return true;
-		e = e->next;
 	}
 	return false;
 }
 
 void RemoveEvent(int event_type)
 {
-	if (!first)
-		return;
-
-	while (first)
+	auto it = std::remove_if(eventQueue.begin(), eventQueue.end(), [&](const Event& ev)
 	{
-		if (first->type == event_type)
-		{
-			Event *next = first->next;
-			FreeEvent(first);
-			first = next;
-		}
-		else
-		{
-			break;
-		}
-	}
+		if (ev.type != event_type)
+			return false;
 
-	if (!first)
-		return;
+		FreeEventSlot(ev.slot);
+		return true;
+	});
 
-	Event *prev = first;
-	Event *ptr = prev->next;
-	while (ptr)
+	// Removing random items breaks the invariant so we have to re-establish it.
+	if (it != eventQueue.end())
 	{
-		if (ptr->type == event_type)
-		{
-			prev->next = ptr->next;
-			FreeEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
-		}
+		eventQueue.erase(it, eventQueue.end());
+		std::make_heap(eventQueue.begin(), eventQueue.end(), std::greater<Event>());
 	}
 }
 
@@ -353,36 +480,41 @@ void ResetSliceLength()
 void ProcessFifoWaitEvents()
 {
 	MoveEvents();
+	RunDueEvents();
+}
 
-	if (!first)
+void MoveEvents()
+{
+	// The exchange can't be reordered with the pops below, so an event pushed
+	// after it always leaves tsPending set for the next call.
+	if (!tsPending.exchange(false, std::memory_order_acq_rel))
 		return;
+	tsMoves++;
 
-	while (first)
+	Event evt;
+	while (tsQueue.Pop(evt))
 	{
-		if (first->time <= globalTimer)
-		{
-			Event* evt = first;
-			first = first->next;
-			event_types[evt->type].callback(evt->userdata, (int)(globalTimer - evt->time));
-			FreeEvent(evt);
-		}
-		else
-		{
-			break;
-		}
+		PushEvent(evt);
+		tsEventsMoved++;
 	}
-}
 
-void MoveEvents()
-{
-	BaseEvent sevt;
-	while (tsQueue.Pop(sevt))
+	// A writer is still filling in the next event. The overflow queue can only
+	// hold events pushed after it, so they have to wait for the next call too.
+	if (tsQueue.IsNextUnpublished())
+	{
+		tsPending.store(true, std::memory_order_relaxed);
+		return;
+	}
+
+	if (tsOverflowed.load(std::memory_order_acquire))
 	{
-		Event *evt = GetNewEvent();
-		evt->time = sevt.time;
-		evt->userdata = sevt.userdata;
-		evt->type = sevt.type;
-		AddEventToQueue(evt);
+		std::lock_guard<std::mutex> lk(tsWriteLock);
+		while (tsOverflowQueue.Pop(evt))
+		{
+			PushEvent(evt);
+			tsEventsMoved++;
+		}
+		tsOverflowed.store(false, std::memory_order_release);
 	}
 }
 
@@ -394,31 +526,16 @@ void Advance()
 	globalTimer += cyclesExecuted;
 	downcount = slicelength;
 
-	while (first)
-	{
-		if (first->time <= globalTimer)
-		{
-			//LOG(POWERPC, "[Scheduler] %s     (%lld, %lld) ",
-			//             event_types[first->type].name ? event_types[first->type].name : "?", (u64)globalTimer, (u64)first->time);
-			Event* evt = first;
-			first = first->next;
-			event_types[evt->type].callback(evt->userdata, (int)(globalTimer - evt->time));
-			FreeEvent(evt);
-		}
-		else
-		{
-			break;
-		}
-	}
+	RunDueEvents();
 
-	if (!first)
+	if (eventQueue.empty())
 	{
 		WARN_LOG(POWERPC, "WARNING - no events in queue. Setting downcount to 10000");
 		downcount += 10000;
 	}
 	else
 	{
-		slicelength = (int)(first->time - globalTimer);
+		slicelength = (int)(eventQueue.front().time - globalTimer);
 		if (slicelength > maxSliceLength)
 			slicelength = maxSliceLength;
 		downcount = slicelength;
@@ -430,11 +547,9 @@ void Advance()
 
 void LogPendingEvents()
 {
-	Event *ptr = first;
-	while (ptr)
+	for (const Event& ev : GetSortedEvents())
 	{
-		INFO_LOG(POWERPC, "PENDING: Now: %" PRId64 " Pending: %" PRId64 " Type: %d", globalTimer, ptr->time, ptr->type);
-		ptr = ptr->next;
+		INFO_LOG(POWERPC, "PENDING: Now: %" PRId64 " Pending: %" PRId64 " Type: %d", globalTimer, ev.time, ev.type);
 	}
 }
 
@@ -459,23 +574,28 @@ void Idle()
 
 std::string GetScheduledEventsSummary()
 {
-	Event *ptr = first;
 	std::string text = "Scheduled events\n";
 	text.reserve(1000);
-	while (ptr)
+	for (const Event& ev : GetSortedEvents())
 	{
-		unsigned int t = ptr->type;
+		unsigned int t = ev.type;
 		if (t >= event_types.size())
 			PanicAlertT("Invalid event type %i", t);
 
-		const std::string& name = event_types[ptr->type].name;
+		const std::string& name = event_types[ev.type].name;
 
-		text += StringFromFormat("%s : %" PRIi64 " %016" PRIx64 "\n", name.c_str(), ptr->time, ptr->userdata);
-		ptr = ptr->next;
+		text += StringFromFormat("%s : %" PRIi64 " %016" PRIx64 "\n", name.c_str(), ev.time, ev.userdata);
 	}
+	text += GetThreadsafeEventStats();
 	return text;
 }
 
+std::string GetThreadsafeEventStats()
+{
+	return StringFromFormat("Threadsafe events: %u moved in %u batches, %u push retries, %u overflows\n",
+		tsEventsMoved, tsMoves, tsRetries.load(), tsOverflows.load());
+}
+
 u32 GetFakeDecStartValue()
 {
 	return fakeDecStartValue;
@@ -30,6 +30,9 @@ void Shutdown();
 
 typedef void (*TimedCallback)(u64 userdata, int cyclesLate);
 
+// Identifies a single scheduled event, see CancelEvent. Handles don't survive savestate loads.
+typedef u64 EventHandle;
+
 u64 GetTicks();
 u64 GetIdleTicks();
 
@@ -41,7 +44,7 @@ void UnregisterAllEvents();
 
 // userdata MAY NOT CONTAIN POINTERS. userdata might get written and reloaded from disk,
 // when we implement state saves.
-void ScheduleEvent(int cyclesIntoFuture, int event_type, u64 userdata=0);
+EventHandle ScheduleEvent(int cyclesIntoFuture, int event_type, u64 userdata=0);
 void ScheduleEvent_Threadsafe(int cyclesIntoFuture, int event_type, u64 userdata=0);
 void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata=0);
 
@@ -49,6 +52,8 @@ void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata=0);
 void RemoveEvent(int event_type);
 void RemoveAllEvents(int event_type);
 bool IsScheduled(int event_type);
+// Cancels a single event in O(1). Does nothing if the event has already run.
+void CancelEvent(EventHandle handle);
 void Advance();
 void MoveEvents();
 void ProcessFifoWaitEvents();
@@ -66,6 +71,8 @@ void ResetSliceLength();
 void RegisterAdvanceCallback(void (*callback)(int cyclesExecuted));
 
 std::string GetScheduledEventsSummary();
+// Counters for events scheduled from other threads: push retries and overflows show contention.
+std::string GetThreadsafeEventStats();
 
 u32 GetFakeDecStartValue();
 void SetFakeDecStartValue(u32 val);
@@ -306,13 +306,13 @@ int DSPCore_RunCycles(int cycles)
 			DSPCore_SetExternalInterrupt(false);
 		}
 
+		if (g_dsp.reset_dspjit_codespace)
+			dspjit->ClearIRAMandDSPJITCodespaceReset();
+
 		cyclesLeft = cycles;
 		DSPCompiledCode pExecAddr = (DSPCompiledCode)dspjit->enterDispatcher;
 		pExecAddr();
 
-		if (g_dsp.reset_dspjit_codespace)
-			dspjit->ClearIRAMandDSPJITCodespaceReset();
-
 		return cyclesLeft;
 	}
 
@@ -370,23 +370,6 @@ void DSPCore_Step()
 void CompileCurrent()
 {
 	dspjit->Compile(g_dsp.pc);
-
-	bool retry = true;
-
-	while (retry)
-	{
-		retry = false;
-		for (u16 i = 0x0000; i < 0xffff; ++i)
-		{
-			if (!dspjit->unresolvedJumps[i].empty())
-			{
-				u16 addrToCompile = dspjit->unresolvedJumps[i].front();
-				dspjit->Compile(addrToCompile);
-				if (!dspjit->unresolvedJumps[i].empty())
-					retry = true;
-			}
-		}
-	}
 }
 
 u16 DSPCore_ReadRegister(int reg)
@@ -4,6 +4,8 @@
 
 #include <cstring>
 
+#include "Common/Hash.h"
+
 #include "Core/DSP/DSPAnalyzer.h"
 #include "Core/DSP/DSPCore.h"
 #include "Core/DSP/DSPEmitter.h"
@@ -13,6 +15,7 @@
 
 #define MAX_BLOCK_SIZE 250
 #define DSP_IDLE_SKIP_CYCLES 0x1000
+#define MAX_BLOCK_TABLES 8
 
 using namespace Gen;
 
@@ -22,44 +25,82 @@ DSPEmitter::DSPEmitter() : gpr(*this), storeIndex(-1), storeIndex2(-1)
 
 	AllocCodeSpace(COMPILED_CODE_SIZE);
 
-	blocks = new DSPCompiledCode[MAX_BLOCKS];
-	blockLinks = new Block[MAX_BLOCKS];
-	blockSize = new u16[MAX_BLOCKS];
-
 	compileSR = 0;
 	compileSR |= SR_INT_ENABLE;
 	compileSR |= SR_EXT_INT_ENABLE;
 
+	compileCount = 0;
+	tableUseCount = 0;
+	currentTable = nullptr;
+	iramHash = 0;
+
+	// The first table gets filled with the stub
 	CompileDispatcher();
 	stubEntryPoint = CompileStub();
+	SelectBlockTable(iramHash);
+}
 
+DSPEmitter::~DSPEmitter()
+{
+	FreeCodeSpace();
+}
+
+void DSPEmitter::ResetBlockTable(DSPBlockTable *table)
+{
 	//clear all of the block references
 	for (int i = 0x0000; i < MAX_BLOCKS; i++)
 	{
-		blocks[i] = (DSPCompiledCode)stubEntryPoint;
-		blockLinks[i] = nullptr;
-		blockSize[i] = 0;
+		table->blocks[i] = (DSPCompiledCode)stubEntryPoint;
+		table->blockLinks[i] = nullptr;
+		table->blockSize[i] = 0;
 	}
+	table->unresolvedLinks.clear();
 }
 
-DSPEmitter::~DSPEmitter()
+void DSPEmitter::SelectBlockTable(u64 hash)
 {
-	delete[] blocks;
-	delete[] blockLinks;
-	delete[] blockSize;
-	FreeCodeSpace();
+	auto it = blockTables.find(hash);
+	if (it == blockTables.end())
+	{
+		if (blockTables.size() >= MAX_BLOCK_TABLES)
+		{
+			// Forget the least recently used ucode. Its code stays behind
+			// until the code space is reset, but nothing jumps into it anymore.
+			auto oldest = blockTables.end();
+			for (auto table = blockTables.begin(); table != blockTables.end(); ++table)
+			{
+				if (table->second.get() != currentTable &&
+				    (oldest == blockTables.end() || table->second->lastUsed < oldest->second->lastUsed))
+					oldest = table;
+			}
+			blockTables.erase(oldest);
+		}
+
+		it = blockTables.insert(std::make_pair(hash, std::unique_ptr<DSPBlockTable>(new DSPBlockTable))).first;
+		ResetBlockTable(it->second.get());
+	}
+
+	iramHash = hash;
+	currentTable = it->second.get();
+	currentTable->lastUsed = ++tableUseCount;
+	blocks = currentTable->blocks;
+	blockLinks = currentTable->blockLinks;
+	blockSize = currentTable->blockSize;
 }
 
 void DSPEmitter::ClearIRAM()
 {
-	for (int i = 0x0000; i < 0x1000; i++)
-	{
-		blocks[i] = (DSPCompiledCode)stubEntryPoint;
-		blockLinks[i] = nullptr;
-		blockSize[i] = 0;
-		unresolvedJumps[i].clear();
-	}
-	g_dsp.reset_dspjit_codespace = true;
+	// Reloading the same ucode, which most games do on every boot and often
+	// in between, keeps the blocks compiled for it.
+	u64 hash = GetMurmurHash3((const u8*)g_dsp.iram, DSP_IRAM_BYTE_SIZE, 0);
+	if (hash == iramHash)
+		return;
+
+	SelectBlockTable(hash);
+
+	// Start over before the new ucode runs if it might not fit anymore
+	if (GetSpaceLeft() < COMPILED_CODE_SIZE / 4)
+		g_dsp.reset_dspjit_codespace = true;
 }
 
 void DSPEmitter::ClearIRAMandDSPJITCodespaceReset()
@@ -68,17 +109,12 @@ void DSPEmitter::ClearIRAMandDSPJITCodespaceReset()
 	CompileDispatcher();
 	stubEntryPoint = CompileStub();
 
-	for (int i = 0x0000; i < 0x10000; i++)
-	{
-		blocks[i] = (DSPCompiledCode)stubEntryPoint;
-		blockLinks[i] = nullptr;
-		blockSize[i] = 0;
-		unresolvedJumps[i].clear();
-	}
+	blockTables.clear();
+	currentTable = nullptr;
+	SelectBlockTable(iramHash);
 	g_dsp.reset_dspjit_codespace = false;
 }
 
-
 // Must go out of block if exception is detected
 void DSPEmitter::checkExceptions(u32 retval)
 {
@@ -200,9 +236,18 @@ void DSPEmitter::EmitInstruction(UDSPInstruction inst)
 
 void DSPEmitter::Compile(u16 start_addr)
 {
+	if (GetSpaceLeft() < 0x10000)
+	{
+		// Leave the dispatcher without compiling, the code space gets reset
+		// before the next run.
+		g_dsp.reset_dspjit_codespace = true;
+		cyclesLeft = 0;
+		return;
+	}
+
 	// Remember the current block address for later
 	startAddr = start_addr;
-	unresolvedJumps[start_addr].clear();
+	compileCount++;
 
 	const u8 *entryPoint = AlignCode16();
 
@@ -236,9 +281,6 @@ void DSPEmitter::Compile(u16 start_addr)
 		blockSize[start_addr]++;
 		compilePC += opcode->size;
 
-		// If the block was trying to link into itself, remove the link
-		unresolvedJumps[start_addr].remove(compilePC);
-
 		fixup_pc = true;
 
 		// Handle loop condition, only if current instruction was flagged as a loop destination
@@ -328,29 +370,16 @@ void DSPEmitter::Compile(u16 start_addr)
 
 	blocks[start_addr] = (DSPCompiledCode)entryPoint;
 
-	// Mark this block as a linkable destination if it does not contain
-	// any unresolved CALL's
-	if (unresolvedJumps[start_addr].empty())
-	{
-		blockLinks[start_addr] = blockLinkEntry;
+	blockLinks[start_addr] = blockLinkEntry;
 
-		for (u16 i = 0x0000; i < 0xffff; ++i)
-		{
-			if (!unresolvedJumps[i].empty())
-			{
-				// Check if there were any blocks waiting for this block to be linkable
-				size_t size = unresolvedJumps[i].size();
-				unresolvedJumps[i].remove(start_addr);
-				if (unresolvedJumps[i].size() < size)
-				{
-					// Mark the block to be recompiled again
-					blocks[i] = (DSPCompiledCode)stubEntryPoint;
-					blockLinks[i] = nullptr;
-					blockSize[i] = 0;
-				}
-			}
-		}
+	// Point the jumps that were waiting for this block straight at it
+	auto waiting = currentTable->unresolvedLinks.equal_range(start_addr);
+	for (auto link = waiting.first; link != waiting.second; ++link)
+	{
+		XEmitter emit(link->second);
+		emit.JMP(blockLinkEntry, true);
 	}
+	currentTable->unresolvedLinks.erase(waiting.first, waiting.second);
 
 	if (blockSize[start_addr] == 0)
 	{
@@ -372,6 +401,57 @@ void DSPEmitter::Compile(u16 start_addr)
 	JMP(returnDispatcher, true);
 }
 
+// Jumps straight to the block at dest, taking the cycles of the current block
+// off first. Falls through when there are not enough cycles left for it.
+void DSPEmitter::WriteBlockLink(u16 dest)
+{
+	// Idle skipping blocks go through the dispatcher, which is where the
+	// skipped cycles are accounted. Jumps back into the middle of the current
+	// block have no entry point to link to.
+	if (DSPAnalyzer::code_flags[startAddr] & DSPAnalyzer::CODE_IDLE_SKIP)
+		return;
+	if (dest > startAddr && dest <= compilePC)
+		return;
+
+	// Count the branch as well, or a block that starts with a jump to
+	// itself would never run out of cycles
+	u16 cycles = blockSize[startAddr] + 1;
+
+	gpr.flushRegs();
+	MOV(16, R(ECX), M(&cyclesLeft));
+	CMP(16, R(ECX), Imm16(cycles));
+	FixupBranch notEnoughCycles = J_CC(CC_BE, true);
+	SUB(16, R(ECX), Imm16(cycles));
+	MOV(16, M(&cyclesLeft), R(ECX));
+
+	if (dest == startAddr)
+	{
+		JMP(blockLinkEntry, true);
+	}
+	else if (blockLinks[dest])
+	{
+		JMP(blockLinks[dest], true);
+	}
+	else
+	{
+		// The destination has not been compiled yet. Until it is, this jump
+		// leads back to the dispatcher, which gets told that no cycles were
+		// executed as they have been taken off already.
+		currentTable->unresolvedLinks.insert(std::make_pair(dest, GetWritableCodePtr()));
+		JMP(GetCodePtr() + 5, true);
+
+		DSPJitRegCache c(gpr);
+		MOV(16, M(&g_dsp.pc), Imm16(dest));
+		gpr.saveRegs();
+		XOR(32, R(EAX), R(EAX));
+		JMP(returnDispatcher, true);
+		gpr.loadRegs(false);
+		gpr.flushRegs(c, false);
+	}
+
+	SetJumpTarget(notEnoughCycles);
+}
+
 const u8 *DSPEmitter::CompileStub()
 {
 	const u8 *entryPoint = AlignCode16();
@@ -401,13 +481,16 @@ void DSPEmitter::CompileDispatcher()
 
 
 	// Execute block. Cycles executed returned in EAX.
+	// The table changes with the ucode, so it is looked up every time.
 #if _M_X86_32
 	MOVZX(32, 16, ECX, M(&g_dsp.pc));
-	MOV(32, R(EBX), ImmPtr(blocks));
+	MOV(32, R(EBX), ImmPtr(&blocks));
+	MOV(32, R(EBX), MatR(EBX));
 	JMPptr(MComplex(EBX, ECX, SCALE_4, 0));
 #else
 	MOVZX(64, 16, ECX, M(&g_dsp.pc));//for clarity, use 64 here.
-	MOV(64, R(RBX), ImmPtr(blocks));
+	MOV(64, R(RBX), ImmPtr(&blocks));
+	MOV(64, R(RBX), MatR(RBX));
 	JMPptr(MComplex(RBX, RCX, SCALE_8, 0));
 #endif
 
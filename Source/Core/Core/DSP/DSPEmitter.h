@@ -4,7 +4,8 @@
 
 #pragma once
 
-#include <list>
+#include <map>
+#include <memory>
 
 #include "Common/x64ABI.h"
 #include "Common/x64Emitter.h"
@@ -18,6 +19,19 @@
 typedef u32 (*DSPCompiledCode)();
 typedef const u8 *Block;
 
+// The compiled blocks for one IRAM image. Blocks only ever link to blocks
+// of the same table, so a table can be put aside when another ucode is
+// uploaded and used again as-is when the same ucode comes back.
+struct DSPBlockTable
+{
+	DSPCompiledCode blocks[MAX_BLOCKS];
+	Block blockLinks[MAX_BLOCKS];
+	u16 blockSize[MAX_BLOCKS];
+	// Jumps waiting for their destination block to be compiled
+	std::multimap<u16, u8*> unresolvedLinks;
+	u32 lastUsed;
+};
+
 class DSPEmitter : public Gen::X64CodeBlock
 {
 public:
@@ -34,6 +48,7 @@ public:
 	Block CompileStub();
 	void Compile(u16 start_addr);
 	void ClearCallFlag();
+	void WriteBlockLink(u16 dest);
 
 	bool FlagsNeeded();
 
@@ -250,12 +265,18 @@ public:
 	u16 startAddr;
 	Block *blockLinks;
 	u16 *blockSize;
-	std::list<u16> unresolvedJumps[MAX_BLOCKS];
+	u32 compileCount;
 
 	DSPJitRegCache gpr;
 private:
 	DSPCompiledCode *blocks;
 	Block blockLinkEntry;
+
+	// Block tables by hash of the IRAM they were compiled from
+	std::map<u64, std::unique_ptr<DSPBlockTable>> blockTables;
+	DSPBlockTable *currentTable;
+	u64 iramHash;
+	u32 tableUseCount;
 	u16 compileSR;
 
 	// The index of the last stored ext value (compile time).
@@ -265,12 +286,16 @@ private:
 	// Counts down.
 	// int cycles;
 
+	void SelectBlockTable(u64 hash);
+	void ResetBlockTable(DSPBlockTable *table);
+
 	void Update_SR_Register(Gen::X64Reg val = Gen::EAX);
 
 	void get_long_prod(Gen::X64Reg long_prod = Gen::RAX);
 	void get_long_prod_round_prodl(Gen::X64Reg long_prod = Gen::RAX);
 	void set_long_prod();
 	void round_long_acc(Gen::X64Reg long_acc = Gen::EAX);
+	void convert_long_acc(Gen::X64Reg long_acc = Gen::EAX);
 	void set_long_acc(int _reg, Gen::X64Reg acc = Gen::EAX);
 	void get_acc_h(int _reg, Gen::X64Reg acc = Gen::EAX, bool sign = true);
 	void set_acc_h(int _reg, Gen::OpArg arg = R(Gen::EAX));
@@ -303,14 +303,16 @@ inline s64 dsp_get_long_acc(int reg)
 	return ((s64)(g_dsp.r.ac[reg].val << 24) >> 24);
 }
 
-inline void dsp_set_long_acc(int _reg, s64 val)
+inline s64 dsp_convert_long_acc(s64 val) // s64 -> s40
 {
-	g_dsp.r.ac[_reg].val = (u64)val;
+	return ((val << 24) >> 24);
 }
 
-inline s64 dsp_convert_long_acc(s64 val) // s64 -> s40
+inline void dsp_set_long_acc(int _reg, s64 val)
 {
-	return ((val << 24) >> 24);
+	// $acR.h is only 8 bits wide and reads back sign extended, like
+	// dsp_op_write_reg stores it
+	g_dsp.r.ac[_reg].val = (u64)dsp_convert_long_acc(val);
 }
 
 inline s64 dsp_round_long_acc(s64 val)
@@ -69,30 +69,29 @@ void DSPEmitter::clrl(const UDSPInstruction opc)
 void DSPEmitter::andcf(const UDSPInstruction opc)
 {
 #if _M_X86_64
-	if (FlagsNeeded())
-	{
-		u8 reg  = (opc >> 8) & 0x1;
-//		u16 imm = dsp_fetch_code();
-		u16 imm = dsp_imem_read(compilePC+1);
-//		u16 val = dsp_get_acc_m(reg);
-		get_acc_m(reg);
-//		Update_SR_LZ(((val & imm) == imm) ? true : false);
-//		if ((val & imm) == imm)
-//			g_dsp.r.sr |= SR_LOGIC_ZERO;
-//		else
-//			g_dsp.r.sr &= ~SR_LOGIC_ZERO;
-		OpArg sr_reg;
-		gpr.getReg(DSP_REG_SR,sr_reg);
-		AND(16, R(RAX), Imm16(imm));
-		CMP(16, R(RAX), Imm16(imm));
-		FixupBranch notLogicZero = J_CC(CC_NE);
-		OR(16, sr_reg, Imm16(SR_LOGIC_ZERO));
-		FixupBranch exit = J();
-		SetJumpTarget(notLogicZero);
-		AND(16, sr_reg, Imm16(~SR_LOGIC_ZERO));
-		SetJumpTarget(exit);
-		gpr.putReg(DSP_REG_SR);
-	}
+	// Setting LZ is all ANDCF and ANDF do, and nothing else clears it, so it is
+	// needed even when the next arithmetic op rewrites the other flags
+	u8 reg  = (opc >> 8) & 0x1;
+//	u16 imm = dsp_fetch_code();
+	u16 imm = dsp_imem_read(compilePC+1);
+//	u16 val = dsp_get_acc_m(reg);
+	get_acc_m(reg);
+//	Update_SR_LZ(((val & imm) == imm) ? true : false);
+//	if ((val & imm) == imm)
+//		g_dsp.r.sr |= SR_LOGIC_ZERO;
+//	else
+//		g_dsp.r.sr &= ~SR_LOGIC_ZERO;
+	OpArg sr_reg;
+	gpr.getReg(DSP_REG_SR,sr_reg);
+	AND(16, R(RAX), Imm16(imm));
+	CMP(16, R(RAX), Imm16(imm));
+	FixupBranch notLogicZero = J_CC(CC_NE);
+	OR(16, sr_reg, Imm16(SR_LOGIC_ZERO));
+	FixupBranch exit = J();
+	SetJumpTarget(notLogicZero);
+	AND(16, sr_reg, Imm16(~SR_LOGIC_ZERO));
+	SetJumpTarget(exit);
+	gpr.putReg(DSP_REG_SR);
 #else
 	Default(opc);
 #endif
@@ -109,29 +108,26 @@ void DSPEmitter::andcf(const UDSPInstruction opc)
 void DSPEmitter::andf(const UDSPInstruction opc)
 {
 #if _M_X86_64
-	if (FlagsNeeded())
-	{
-		u8 reg  = (opc >> 8) & 0x1;
-//		u16 imm = dsp_fetch_code();
-		u16 imm = dsp_imem_read(compilePC+1);
-//		u16 val = dsp_get_acc_m(reg);
-		get_acc_m(reg);
-//		Update_SR_LZ(((val & imm) == 0) ? true : false);
-//		if ((val & imm) == 0)
-//			g_dsp.r.sr |= SR_LOGIC_ZERO;
-//		else
-//			g_dsp.r.sr &= ~SR_LOGIC_ZERO;
-		OpArg sr_reg;
-		gpr.getReg(DSP_REG_SR,sr_reg);
-		TEST(16, R(RAX), Imm16(imm));
-		FixupBranch notLogicZero = J_CC(CC_NE);
-		OR(16, sr_reg, Imm16(SR_LOGIC_ZERO));
-		FixupBranch exit = J();
-		SetJumpTarget(notLogicZero);
-		AND(16, sr_reg, Imm16(~SR_LOGIC_ZERO));
-		SetJumpTarget(exit);
-		gpr.putReg(DSP_REG_SR);
-	}
+	u8 reg  = (opc >> 8) & 0x1;
+//	u16 imm = dsp_fetch_code();
+	u16 imm = dsp_imem_read(compilePC+1);
+//	u16 val = dsp_get_acc_m(reg);
+	get_acc_m(reg);
+//	Update_SR_LZ(((val & imm) == 0) ? true : false);
+//	if ((val & imm) == 0)
+//		g_dsp.r.sr |= SR_LOGIC_ZERO;
+//	else
+//		g_dsp.r.sr &= ~SR_LOGIC_ZERO;
+	OpArg sr_reg;
+	gpr.getReg(DSP_REG_SR,sr_reg);
+	TEST(16, R(RAX), Imm16(imm));
+	FixupBranch notLogicZero = J_CC(CC_NE);
+	OR(16, sr_reg, Imm16(SR_LOGIC_ZERO));
+	FixupBranch exit = J();
+	SetJumpTarget(notLogicZero);
+	AND(16, sr_reg, Imm16(~SR_LOGIC_ZERO));
+	SetJumpTarget(exit);
+	gpr.putReg(DSP_REG_SR);
 #else
 	Default(opc);
 #endif
@@ -202,6 +198,7 @@ void DSPEmitter::cmp(const UDSPInstruction opc)
 		get_long_acc(1, RDX);
 //		s64 res = dsp_convert_long_acc(acc0 - acc1);
 		SUB(64, R(RAX), R(RDX));
+		convert_long_acc();
 //		Update_SR_Register64(res, isCarry2(acc0, res), isOverflow(acc0, -acc1, res)); // CF -> influence on ABS/0xa100
 		NEG(64, R(RDX));
 		Update_SR_Register64_Carry2(EAX, tmp1);
@@ -237,6 +234,7 @@ void DSPEmitter::cmpar(const UDSPInstruction opc)
 		SHL(64, R(RDX), Imm8(16));
 //		s64 res = dsp_convert_long_acc(sr - rr);
 		SUB(64, R(RAX), R(RDX));
+		convert_long_acc();
 //		Update_SR_Register64(res, isCarry2(sr, res), isOverflow(sr, -rr, res));
 		NEG(64, R(RDX));
 		Update_SR_Register64_Carry2(EAX, tmp1);
@@ -270,6 +268,7 @@ void DSPEmitter::cmpi(const UDSPInstruction opc)
 		MOV(64, R(RDX), Imm64((s64)(s16)imm << 16));
 //		s64 res = dsp_convert_long_acc(val - imm);
 		SUB(64, R(RAX), R(RDX));
+		convert_long_acc();
 //		Update_SR_Register64(res, isCarry2(val, res), isOverflow(val, -imm, res));
 		NEG(64, R(RDX));
 		Update_SR_Register64_Carry2(EAX, tmp1);
@@ -303,6 +302,7 @@ void DSPEmitter::cmpis(const UDSPInstruction opc)
 		MOV(64, R(RDX), Imm64((s64)(s8)opc << 16));
 //		s64 res = dsp_convert_long_acc(acc - val);
 		SUB(64, R(RAX), R(RDX));
+		convert_long_acc();
 //		Update_SR_Register64(res, isCarry2(acc, res), isOverflow(acc, -val, res));
 		NEG(64, R(RDX));
 		Update_SR_Register64_Carry2(EAX, tmp1);
@@ -621,8 +621,7 @@ void DSPEmitter::addr(const UDSPInstruction opc)
 //	Update_SR_Register64(res, isCarry(acc, res), isOverflow(acc, ax, res));
 	if (FlagsNeeded())
 	{
-		MOV(64, R(RCX), R(RAX));
-		set_long_acc(dreg, RCX);
+		set_long_acc(dreg);
 		Update_SR_Register64_Carry(EAX, tmp1);
 	}
 	else
@@ -660,8 +659,7 @@ void DSPEmitter::addax(const UDSPInstruction opc)
 //	Update_SR_Register64(res, isCarry(acc, res), isOverflow(acc, ax, res));
 	if (FlagsNeeded())
 	{
-		MOV(64, R(RCX), R(RAX));
-		set_long_acc(dreg, RCX);
+		set_long_acc(dreg);
 		Update_SR_Register64_Carry(EAX, tmp1);
 	}
 	else
@@ -698,8 +696,7 @@ void DSPEmitter::add(const UDSPInstruction opc)
 //	Update_SR_Register64(res, isCarry(acc0, res), isOverflow(acc0, acc1, res));
 	if (FlagsNeeded())
 	{
-		MOV(64, R(RCX), R(RAX));
-		set_long_acc(dreg, RCX);
+		set_long_acc(dreg);
 		Update_SR_Register64_Carry(EAX, tmp1);
 	}
 	else
@@ -736,8 +733,7 @@ void DSPEmitter::addp(const UDSPInstruction opc)
 //	Update_SR_Register64(res, isCarry(acc, res), isOverflow(acc, prod, res));
 	if (FlagsNeeded())
 	{
-		MOV(64, R(RCX), R(RAX));
-		set_long_acc(dreg, RCX);
+		set_long_acc(dreg);
 		Update_SR_Register64_Carry(EAX, tmp1);
 	}
 	else
@@ -777,8 +773,7 @@ void DSPEmitter::addaxl(const UDSPInstruction opc)
 //	Update_SR_Register64((s64)res, isCarry(acc, res), isOverflow((s64)acc, (s64)acx, (s64)res));
 	if (FlagsNeeded())
 	{
-		MOV(64, R(RCX), R(RAX));
-		set_long_acc(dreg, RCX);
+		set_long_acc(dreg);
 		Update_SR_Register64_Carry(EAX, tmp1);
 	}
 	else
@@ -819,8 +814,7 @@ void DSPEmitter::addi(const UDSPInstruction opc)
 //	Update_SR_Register64(res, isCarry(acc, res), isOverflow(acc, imm, res));
 	if (FlagsNeeded())
 	{
-		MOV(64, R(RCX), R(RAX));
-		set_long_acc(areg, RCX);
+		set_long_acc(areg);
 		Update_SR_Register64_Carry(EAX, tmp1);
 	}
 	else
@@ -860,8 +854,7 @@ void DSPEmitter::addis(const UDSPInstruction opc)
 //	Update_SR_Register64(res, isCarry(acc, res), isOverflow(acc, imm, res));
 	if (FlagsNeeded())
 	{
-		MOV(64, R(RCX), R(RAX));
-		set_long_acc(dreg, RCX);
+		set_long_acc(dreg);
 		Update_SR_Register64_Carry(EAX, tmp1);
 	}
 	else
@@ -897,8 +890,7 @@ void DSPEmitter::incm(const UDSPInstruction opc)
 	if (FlagsNeeded())
 	{
 		MOV(64, R(RDX), Imm32((u32)subtract));
-		MOV(64, R(RCX), R(RAX));
-		set_long_acc(dreg, RCX);
+		set_long_acc(dreg);
 		Update_SR_Register64_Carry(EAX, tmp1);
 	}
 	else
@@ -933,8 +925,7 @@ void DSPEmitter::inc(const UDSPInstruction opc)
 	if (FlagsNeeded())
 	{
 		MOV(64, R(RDX), Imm64(1));
-		MOV(64, R(RCX), R(RAX));
-		set_long_acc(dreg, RCX);
+		set_long_acc(dreg);
 		Update_SR_Register64_Carry(EAX, tmp1);
 	}
 	else
@@ -977,8 +968,7 @@ void DSPEmitter::subr(const UDSPInstruction opc)
 	if (FlagsNeeded())
 	{
 		NEG(64, R(RDX));
-		MOV(64, R(RCX), R(RAX));
-		set_long_acc(dreg, RCX);
+		set_long_acc(dreg);
 		Update_SR_Register64_Carry2(EAX, tmp1);
 	}
 	else
@@ -1017,8 +1007,7 @@ void DSPEmitter::subax(const UDSPInstruction opc)
 	if (FlagsNeeded())
 	{
 		NEG(64, R(RDX));
-		MOV(64, R(RCX), R(RAX));
-		set_long_acc(dreg, RCX);
+		set_long_acc(dreg);
 		Update_SR_Register64_Carry2(EAX, tmp1);
 	}
 	else
@@ -1055,8 +1044,7 @@ void DSPEmitter::sub(const UDSPInstruction opc)
 	if (FlagsNeeded())
 	{
 		NEG(64, R(RDX));
-		MOV(64, R(RCX), R(RAX));
-		set_long_acc(dreg, RCX);
+		set_long_acc(dreg);
 		Update_SR_Register64_Carry2(EAX, tmp1);
 	}
 	else
@@ -1093,8 +1081,7 @@ void DSPEmitter::subp(const UDSPInstruction opc)
 	if (FlagsNeeded())
 	{
 		NEG(64, R(RDX));
-		MOV(64, R(RCX), R(RAX));
-		set_long_acc(dreg, RCX);
+		set_long_acc(dreg);
 		Update_SR_Register64_Carry2(EAX, tmp1);
 	}
 	else
@@ -1130,8 +1117,7 @@ void DSPEmitter::decm(const UDSPInstruction opc)
 	if (FlagsNeeded())
 	{
 		MOV(64, R(RDX), Imm64(-subtract));
-		MOV(64, R(RCX), R(RAX));
-		set_long_acc(dreg, RCX);
+		set_long_acc(dreg);
 		Update_SR_Register64_Carry2(EAX, tmp1);
 	}
 	else
@@ -1166,8 +1152,7 @@ void DSPEmitter::dec(const UDSPInstruction opc)
 	if (FlagsNeeded())
 	{
 		MOV(64, R(RDX), Imm64(-1));
-		MOV(64, R(RCX), R(RAX));
-		set_long_acc(dreg, RCX);
+		set_long_acc(dreg);
 		Update_SR_Register64_Carry2(EAX, tmp1);
 	}
 	else
@@ -1445,8 +1430,10 @@ void DSPEmitter::lsr(const UDSPInstruction opc)
 	{
 		//	acc &= 0x000000FFFFFFFFFFULL; 	// Lop off the extraneous sign extension our 64-bit fake accum causes
 		SHL(64, R(RAX), Imm8(24));
+		SHR(64, R(RAX), Imm8(24));
 		//	acc >>= shift;
-		SHR(64, R(RAX), Imm8(shift + 24));
+		// Done separately, x86 only looks at the low 6 bits of the count
+		SHR(64, R(RAX), Imm8((u8)shift));
 	}
 
 //	dsp_set_long_acc(rreg, (s64)acc);
@@ -10,10 +10,11 @@
 using namespace Gen;
 
 // In: RAX: s64 _Value
-// Clobbers RDX
+// Clobbers RDX, or RCX if the value is in RDX
 void DSPEmitter::Update_SR_Register(Gen::X64Reg val)
 {
 #if _M_X86_64
+	X64Reg tmp = val == RDX ? RCX : RDX;
 	OpArg sr_reg;
 	gpr.getReg(DSP_REG_SR,sr_reg);
 	//	// 0x04
@@ -32,8 +33,8 @@ void DSPEmitter::Update_SR_Register(Gen::X64Reg val)
 
 	//	// 0x10
 	//	if (_Value != (s32)_Value) g_dsp.r[DSP_REG_SR] |= SR_OVER_S32;
-	MOVSX(64, 32, RDX, R(val));
-	CMP(64, R(RDX), R(val));
+	MOVSX(64, 32, tmp, R(val));
+	CMP(64, R(tmp), R(val));
 	FixupBranch noOverS32 = J_CC(CC_E);
 	OR(16, sr_reg, Imm16(SR_OVER_S32));
 	SetJumpTarget(noOverS32);
@@ -151,7 +152,7 @@ void DSPEmitter::Update_SR_Register64_Carry2(X64Reg val, X64Reg carry_ovfl)
 //	}
 //}
 
-// In: RAX: s64 _Value
+// In: RAX: s16 _Value, only the low 16 bits are looked at
 // Clobbers RDX
 void DSPEmitter::Update_SR_Register16(X64Reg val)
 {
@@ -162,14 +163,14 @@ void DSPEmitter::Update_SR_Register16(X64Reg val)
 
 	//	// 0x04
 	//	if (_Value == 0) g_dsp.r[DSP_REG_SR] |= SR_ARITH_ZERO;
-	CMP(64, R(val), Imm8(0));
+	CMP(16, R(val), Imm16(0));
 	FixupBranch notZero = J_CC(CC_NZ);
 	OR(16, sr_reg, Imm16(SR_ARITH_ZERO));
 	SetJumpTarget(notZero);
 
 	//	// 0x08
 	//	if (_Value < 0) g_dsp.r[DSP_REG_SR] |= SR_SIGN;
-	CMP(64, R(val), Imm8(0));
+	CMP(16, R(val), Imm16(0));
 	FixupBranch greaterThanEqual = J_CC(CC_GE);
 	OR(16, sr_reg, Imm16(SR_SIGN));
 	SetJumpTarget(greaterThanEqual);
@@ -193,28 +194,25 @@ void DSPEmitter::Update_SR_Register16(X64Reg val)
 #endif
 }
 
-// In: RAX: s64 _Value
+// In: RAX: s16 _Value
+// In: RCX: s64 accumulator
 // Clobbers RDX
 void DSPEmitter::Update_SR_Register16_OverS32(Gen::X64Reg val)
 {
 #if _M_X86_64
+	// Clears the other flags, so it has to go first
+	Update_SR_Register16(val);
+
 	OpArg sr_reg;
 	gpr.getReg(DSP_REG_SR,sr_reg);
-	AND(16, sr_reg, Imm16(~SR_CMP_MASK));
-
 	//	// 0x10
 	//	if (_Value != (s32)_Value) g_dsp.r[DSP_REG_SR] |= SR_OVER_S32;
-	MOVSX(64, 32, RCX, R(val));
-	CMP(64, R(RCX), R(val));
+	MOVSX(64, 32, RDX, R(RCX));
+	CMP(64, R(RDX), R(RCX));
 	FixupBranch noOverS32 = J_CC(CC_E);
 	OR(16, sr_reg, Imm16(SR_OVER_S32));
 	SetJumpTarget(noOverS32);
-
 	gpr.putReg(DSP_REG_SR);
-	//	// 0x20 - Checks if top bits of m are equal
-	//	if ((((u16)_Value >> 14) == 0) || (((u16)_Value >> 14) == 3))
-	//AND(32, R(val), Imm32(0xc0000000));
-	Update_SR_Register16(val);
 #endif
 }
 
@@ -157,9 +157,16 @@ void DSPEmitter::multiply_mulx(u8 axh0, u8 axh1)
 // direct use of prod regs by AX/AXWII (look @that part of ucode).
 void DSPEmitter::clrp(const UDSPInstruction opc)
 {
-	//64bit move to memory does not work. use 2 32bits
-	MOV(32, M(((u32*)&g_dsp.r.prod.val)+0), Imm32(0xfff00000U));
-	MOV(32, M(((u32*)&g_dsp.r.prod.val)+1), Imm32(0x001000ffU));
+#if _M_X86_64
+	// Goes through the register cache, prod might be in a host register
+	OpArg prod_reg;
+	gpr.getReg(DSP_REG_PROD_64, prod_reg, false);
+	MOV(64, R(RAX), Imm64(0x001000fffff00000ULL));
+	MOV(64, prod_reg, R(RAX));
+	gpr.putReg(DSP_REG_PROD_64, true);
+#else
+	Default(opc);
+#endif
 }
 
 // TSTPROD
@@ -197,7 +204,9 @@ void DSPEmitter::movp(const UDSPInstruction opc)
 //	s64 acc = dsp_get_long_prod();
 	get_long_prod();
 //	dsp_set_long_acc(dreg, acc);
-	set_long_acc(dreg);
+	// The flags come from the product before it is cut down to 40 bits
+	MOV(64, R(RCX), R(RAX));
+	set_long_acc(dreg, RCX);
 //	Update_SR_Register64(acc);
 	if (FlagsNeeded())
 	{
@@ -223,7 +232,9 @@ void DSPEmitter::movnp(const UDSPInstruction opc)
 	get_long_prod();
 	NEG(64, R(EAX));
 //	dsp_set_long_acc(dreg, acc);
-	set_long_acc(dreg);
+	// The flags come from the product before it is cut down to 40 bits
+	MOV(64, R(RCX), R(RAX));
+	set_long_acc(dreg, RCX);
 //	Update_SR_Register64(acc);
 	if (FlagsNeeded())
 	{
@@ -248,7 +259,9 @@ void DSPEmitter::movpz(const UDSPInstruction opc)
 //	s64 acc = dsp_get_long_prod_round_prodl();
 	get_long_prod_round_prodl();
 //	dsp_set_long_acc(dreg, acc);
-	set_long_acc(dreg);
+	// The flags come from the product before it is cut down to 40 bits
+	MOV(64, R(RCX), R(RAX));
+	set_long_acc(dreg, RCX);
 //	Update_SR_Register64(acc);
 	if (FlagsNeeded())
 	{
@@ -289,9 +302,10 @@ void DSPEmitter::addpaxz(const UDSPInstruction opc)
 //	Update_SR_Register64(res, isCarry(oldprod, res), false);
 	if (FlagsNeeded())
 	{
-		get_long_prod(RDX);
-		MOV(64, R(RCX), R(RAX));
-		set_long_acc(dreg, RCX);
+		get_long_prod(tmp1);
+		set_long_acc(dreg);
+		// Overflow is never set, having res in RDX makes the check come out false
+		MOV(64, R(RDX), R(RAX));
 		Update_SR_Register64_Carry(EAX, tmp1);
 	}
 	else
@@ -433,12 +447,13 @@ void DSPEmitter::mulmvz(const UDSPInstruction opc)
 	get_long_prod_round_prodl(RDX);
 //	dsp_set_long_acc(rreg, acc);
 	set_long_acc(rreg, RDX);
-	mul(opc);
 //	Update_SR_Register64(dsp_get_long_acc(rreg));
+	// mul() clobbers RDX, so the flags have to be done first
 	if (FlagsNeeded())
 	{
 		Update_SR_Register64(RDX);
 	}
+	mul(opc);
 #else
 	Default(opc);
 #endif
@@ -853,10 +853,22 @@ void DSPEmitter::get_long_acc(int _reg, X64Reg acc)
 #endif
 }
 
+// In: long_acc = s64 val
+// Out: long_acc = val sign extended from 40 bits
+void DSPEmitter::convert_long_acc(X64Reg long_acc)
+{
+#if _M_X86_64
+	SHL(64, R(long_acc), Imm8(64-40));
+	SAR(64, R(long_acc), Imm8(64-40));
+#endif
+}
+
 // In: acc = s64 val
+// Out: acc = val sign extended from 40 bits, as it was stored
 void DSPEmitter::set_long_acc(int _reg, X64Reg acc)
 {
 #if _M_X86_64
+	convert_long_acc(acc);
 	OpArg reg;
 	gpr.getReg(DSP_REG_ACC0_64+_reg, reg, false);
 	MOV(64, reg, R(acc));
@@ -50,6 +50,10 @@ This file mainly deals with the [Drive I/F], however [AIDFR] controls
   TODO maybe the files should be merged?
 */
 
+#include <algorithm>
+
+#include "AudioCommon/AudioCommon.h"
+#include "Common/ChunkFile.h"
 #include "Common/Common.h"
 #include "Common/MathUtil.h"
 
@@ -130,6 +134,12 @@ static u64 g_CPUCyclesPerSample = 0xFFFFFFFFFFFULL;
 static unsigned int g_AISSampleRate = 48000;
 static unsigned int g_AIDSampleRate = 32000;
 
+// Disc streaming decoder, not part of the state: a loaded state just
+// picks the stream up again from the drive's current position.
+static u64 g_LastStreamTime = 0;
+static int g_StreamPos = 0;
+static short g_StreamPCM[NGCADPCM::SAMPLES_PER_BLOCK * 2];
+
 void DoState(PointerWrap &p)
 {
 	p.DoPOD(m_Control);
@@ -140,6 +150,9 @@ void DoState(PointerWrap &p)
 	p.Do(g_AISSampleRate);
 	p.Do(g_AIDSampleRate);
 	p.Do(g_CPUCyclesPerSample);
+
+	if (p.GetMode() == PointerWrap::MODE_READ)
+		g_LastStreamTime = g_LastCPUTime;
 }
 
 static void GenerateAudioInterrupt();
@@ -163,6 +176,9 @@ void Init()
 	g_AISSampleRate = 48000;
 	g_AIDSampleRate = 32000;
 
+	g_LastStreamTime = 0;
+	g_StreamPos = 0;
+
 	et_AI = CoreTiming::RegisterEvent("AICallback", Update);
 }
 
@@ -204,6 +220,7 @@ void RegisterMMIO(MMIO::Mapping* mmio, u32 base)
 				DEBUG_LOG(AUDIO_INTERFACE, "%s streaming audio", tmpAICtrl.PSTAT ? "start":"stop");
 				m_Control.PSTAT = tmpAICtrl.PSTAT;
 				g_LastCPUTime = CoreTiming::GetTicks();
+				g_LastStreamTime = g_LastCPUTime;
 
 				// Tell Drive Interface to start/stop streaming
 				DVDInterface::g_bStream = tmpAICtrl.PSTAT;
@@ -278,111 +295,44 @@ void Callback_GetSampleRate(unsigned int &_AISampleRate, unsigned int &_DACSampl
 	_DACSampleRate = g_AIDSampleRate;
 }
 
-// Callback for the disc streaming
-// WARNING - called from audio thread
-unsigned int Callback_GetStreaming(short* _pDestBuffer, unsigned int _numSamples, unsigned int _sampleRate)
+// Decodes the disc stream up to the current time and hands it to the mixer.
+// This runs on the CPU thread, so the audio thread never has to touch the drive.
+void UpdateStreaming()
 {
-	if (m_Control.PSTAT && !CCPU::IsStepping())
+	const u64 ticks = CoreTiming::GetTicks();
+	if (!m_Control.PSTAT || ticks < g_LastStreamTime)
 	{
-		static int pos = 0;
-		static short pcm[NGCADPCM::SAMPLES_PER_BLOCK*2];
-		const int lvolume = m_Volume.left;
-		const int rvolume = m_Volume.right;
-
-		if (g_AISSampleRate == 48000 && _sampleRate == 32000)
-		{
-			_dbg_assert_msg_(AUDIO_INTERFACE, !(_numSamples & 1), "Number of Samples: %i must be even!", _numSamples);
-			_numSamples = _numSamples * 3 / 2;
-		}
-
-		int pcm_l = 0, pcm_r = 0;
-		for (unsigned int i = 0; i < _numSamples; i++)
-		{
-			if (pos == 0)
-				ReadStreamBlock(pcm);
-
-			if (g_AISSampleRate == 48000 && _sampleRate == 32000) //downsample 48>32
-			{
-				if (i % 3)
-				{
-					pcm_l = (((pcm_l + (int)pcm[pos*2]) / 2  * lvolume) >> 8) + (int)(*_pDestBuffer);
-					MathUtil::Clamp(&pcm_l, -32767, 32767);
-					*_pDestBuffer++ = pcm_l;
-
-					pcm_r = (((pcm_r + (int)pcm[pos*2+1]) / 2 * rvolume) >> 8) + (int)(*_pDestBuffer);
-					MathUtil::Clamp(&pcm_r, -32767, 32767);
-					*_pDestBuffer++ = pcm_r;
-				}
-				pcm_l = pcm[pos*2];
-				pcm_r = pcm[pos*2+1];
-
-				pos++;
-			}
-			else if (g_AISSampleRate == 32000 && _sampleRate == 48000) //upsample 32>48
-			{
-				//starts with one sample of 0
-				const u32 ratio = (u32)( 65536.0f * 32000.0f / (float)_sampleRate );
-				static u32 frac = 0;
-
-				static s16 l1 = 0;
-				static s16 l2 = 0;
-
-				if (frac >= 0x10000 || frac == 0)
-				{
-					frac &= 0xffff;
-
-					l1 = l2;           //current
-					l2 = pcm[pos * 2]; //next
-				}
-
-				pcm_l = ((l1 << 16) + (l2 - l1) * (u16)frac)  >> 16;
-				pcm_r = ((l1 << 16) + (l2 - l1) * (u16)frac)  >> 16;
-
-
-				pcm_l = (pcm_l * lvolume >> 8) + (int)(*_pDestBuffer);
-				MathUtil::Clamp(&pcm_l, -32767, 32767);
-				*_pDestBuffer++ = pcm_l;
-
-				pcm_r = (pcm_r * lvolume >> 8) + (int)(*_pDestBuffer);
-				MathUtil::Clamp(&pcm_r, -32767, 32767);
-				*_pDestBuffer++ = pcm_r;
-
-				frac += ratio;
-				pos += frac >> 16;
-
-			}
-			else //1:1 no resampling
-			{
-				pcm_l = (((int)pcm[pos*2] * lvolume) >> 8) + (int)(*_pDestBuffer);
-				MathUtil::Clamp(&pcm_l, -32767, 32767);
-				*_pDestBuffer++ = pcm_l;
+		g_LastStreamTime = ticks;
+		return;
+	}
 
-				pcm_r = (((int)pcm[pos*2+1] * rvolume) >> 8) + (int)(*_pDestBuffer);
-				MathUtil::Clamp(&pcm_r, -32767, 32767);
-				*_pDestBuffer++ = pcm_r;
+	u32 frames = static_cast<u32>((ticks - g_LastStreamTime) / g_CPUCyclesPerSample);
+	g_LastStreamTime += frames * g_CPUCyclesPerSample;
 
-				pos++;
-			}
+	const int lvolume = m_Volume.left;
+	const int rvolume = m_Volume.right;
 
-			if (pos == NGCADPCM::SAMPLES_PER_BLOCK)
-				pos = 0;
-		}
-	}
-	else
+	short buffer[NGCADPCM::SAMPLES_PER_BLOCK * 2];
+	while (frames)
 	{
-		// Don't overwrite existed sample data
-		/*
-		for (unsigned int i = 0; i < _numSamples * 2; i++)
+		u32 count = std::min<u32>(frames, NGCADPCM::SAMPLES_PER_BLOCK);
+		for (u32 i = 0; i < count; i++)
 		{
-			_pDestBuffer[i] = 0; //silence!
+			if (g_StreamPos == 0)
+				ReadStreamBlock(g_StreamPCM);
+
+			buffer[i * 2] = (g_StreamPCM[g_StreamPos * 2] * lvolume) >> 8;
+			buffer[i * 2 + 1] = (g_StreamPCM[g_StreamPos * 2 + 1] * rvolume) >> 8;
+
+			if (++g_StreamPos == NGCADPCM::SAMPLES_PER_BLOCK)
+				g_StreamPos = 0;
 		}
-		*/
-	}
 
-	return _numSamples;
+		AudioCommon::SendAIStreamingBuffer(buffer, count, g_AISSampleRate);
+		frames -= count;
+	}
 }
 
-// WARNING - called from audio thread
 void ReadStreamBlock(s16 *_pPCM)
 {
 	u8 tempADPCM[NGCADPCM::ONE_BLOCK_SIZE];
@@ -24,7 +24,9 @@ void Update(u64 userdata, int cyclesLate);
 
 // Called by DSP emulator
 void Callback_GetSampleRate(unsigned int &_AISampleRate, unsigned int &_DACSampleRate);
-unsigned int Callback_GetStreaming(short* _pDestBuffer, unsigned int _numSamples, unsigned int _sampleRate = 48000);
+
+// Pushes the disc streaming audio played since the last call to the mixer
+void UpdateStreaming();
 
 // Get the audio rates (48000 or 32000 only)
 unsigned int GetAIDSampleRate();
@@ -22,6 +22,10 @@ AXUCode::AXUCode(DSPHLE* dsphle, u32 crc)
 	DSP::GenerateDSPInterruptFromDSPEmu(DSP::INT_DSP);
 
 	LoadResamplingCoefficients();
+
+	int voice_threads = SConfig::GetInstance().m_DSPHLEVoiceThreads;
+	if (voice_threads > 0)
+		m_voice_workers.reset(new Common::WorkerPool(voice_threads));
 }
 
 AXUCode::~AXUCode()
@@ -33,6 +37,10 @@ void AXUCode::LoadResamplingCoefficients()
 {
 	m_coeffs_available = false;
 
+	// Without the coefficients voices fall back to linear interpolation.
+	if (!SConfig::GetInstance().m_DSPHLEPolyphase)
+		return;
+
 	std::string filenames[] = {
 		File::GetUserPath(D_GCUSER_IDX) + "dsp_coef.bin",
 		File::GetSysDirectory() + "/GC/dsp_coef.bin"
@@ -387,24 +395,23 @@ void AXUCode::ProcessPBList(u32 pb_addr)
 	// 32KHz to 48KHz, but AX always process at 32KHz.
 	const u32 spms = 32;
 
-	AXPB pb;
+	AXBuffers buffers = {{
+		m_samples_left,
+		m_samples_right,
+		m_samples_surround,
+		m_samples_auxA_left,
+		m_samples_auxA_right,
+		m_samples_auxA_surround,
+		m_samples_auxB_left,
+		m_samples_auxB_right,
+		m_samples_auxB_surround
+	}};
 
-	while (pb_addr)
-	{
-		AXBuffers buffers = {{
-			m_samples_left,
-			m_samples_right,
-			m_samples_surround,
-			m_samples_auxA_left,
-			m_samples_auxA_right,
-			m_samples_auxA_surround,
-			m_samples_auxB_left,
-			m_samples_auxB_right,
-			m_samples_auxB_surround
-		}};
-
-		if (!ReadPB(pb_addr, pb))
-			break;
+	MixPBList(pb_addr, buffers, m_voice_workers.get(), m_voice_scratch,
+	          [this, spms](u32 addr, AXBuffers voice_buffers) -> u32 {
+		AXPB pb;
+		if (!ReadPB(addr, pb))
+			return 0;
 
 		u32 updates_addr = HILO_TO_32(pb.updates.data);
 		u16* updates = (u16*)HLEMemory_Get_Pointer(updates_addr);
@@ -413,17 +420,17 @@ void AXUCode::ProcessPBList(u32 pb_addr)
 		{
 			ApplyUpdatesForMs(curr_ms, (u16*)&pb, pb.updates.num_updates, updates);
 
-			ProcessVoice(pb, buffers, spms, ConvertMixerControl(pb.mixer_control),
+			ProcessVoice(pb, voice_buffers, spms, ConvertMixerControl(pb.mixer_control),
 			             m_coeffs_available ? m_coeffs : nullptr);
 
 			// Forward the buffers
-			for (u32 i = 0; i < sizeof (buffers.ptrs) / sizeof (buffers.ptrs[0]); ++i)
-				buffers.ptrs[i] += spms;
+			for (u32 i = 0; i < sizeof (voice_buffers.ptrs) / sizeof (voice_buffers.ptrs[0]); ++i)
+				voice_buffers.ptrs[i] += spms;
 		}
 
-		WritePB(pb_addr, pb);
-		pb_addr = HILO_TO_32(pb.next_pb);
-	}
+		WritePB(addr, pb);
+		return HILO_TO_32(pb.next_pb);
+	});
 }
 
 void AXUCode::MixAUXSamples(int aux_id, u32 write_addr, u32 read_addr)
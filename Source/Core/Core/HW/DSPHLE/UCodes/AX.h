@@ -7,11 +7,14 @@
 // TODO:
 //  * Depop support
 //  * ITD support
-//  * Polyphase sample interpolation support (not very useful)
 //  * Dolby Pro 2 mixing with recent AX versions
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
+#include "Common/WorkerPool.h"
 #include "Core/HW/DSPHLE/UCodes/AXStructs.h"
 #include "Core/HW/DSPHLE/UCodes/UCodes.h"
 
@@ -96,6 +99,11 @@ protected:
 	bool m_coeffs_available;
 	s16 m_coeffs[0x800];
 
+	// Threads the voices of a PB list are spread across, if enabled, and the
+	// mixing buffers of all but the first of them.
+	std::unique_ptr<Common::WorkerPool> m_voice_workers;
+	std::vector<int> m_voice_scratch;
+
 	void LoadResamplingCoefficients();
 
 	// Copy a command list from memory to our temp buffer
@@ -12,15 +12,22 @@
 #error AXVoice.h included without specifying version
 #endif
 
-#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <vector>
 
 #include "Common/Common.h"
 #include "Common/MathUtil.h"
+#include "Common/WorkerPool.h"
 #include "Core/HW/DSP.h"
 #include "Core/HW/Memmap.h"
 #include "Core/HW/DSPHLE/UCodes/AX.h"
 #include "Core/HW/DSPHLE/UCodes/AXStructs.h"
 
+#if _M_X86
+#include <emmintrin.h>
+#endif
+
 #ifdef AX_GC
 # define PB_TYPE AXPB
 # define MAX_SAMPLES_PER_FRAME 32
@@ -127,26 +134,30 @@ void DumpPB(const PB_TYPE& pb)
 }
 #endif
 
-// Simulated accelerator state.
-static u32 acc_loop_addr, acc_end_addr;
-static u32* acc_cur_addr;
-static PB_TYPE* acc_pb;
-static bool acc_end_reached;
+// Simulated accelerator state. Kept per voice rather than global so that
+// voices can be processed on several threads at once.
+struct AcceleratorState
+{
+	u32 loop_addr, end_addr;
+	u32* cur_addr;
+	PB_TYPE* pb;
+	bool end_reached;
+};
 
 // Sets up the simulated accelerator.
-void AcceleratorSetup(PB_TYPE* pb, u32* cur_addr)
+void AcceleratorSetup(AcceleratorState& acc, PB_TYPE* pb, u32* cur_addr)
 {
-	acc_pb = pb;
-	acc_loop_addr = HILO_TO_32(pb->audio_addr.loop_addr);
-	acc_end_addr = HILO_TO_32(pb->audio_addr.end_addr);
-	acc_cur_addr = cur_addr;
-	acc_end_reached = false;
+	acc.pb = pb;
+	acc.loop_addr = HILO_TO_32(pb->audio_addr.loop_addr);
+	acc.end_addr = HILO_TO_32(pb->audio_addr.end_addr);
+	acc.cur_addr = cur_addr;
+	acc.end_reached = false;
 }
 
 // Reads a sample from the simulated accelerator. Also handles looping and
 // disabling streams that reached the end (this is done by an exception raised
 // by the accelerator on real hardware).
-u16 AcceleratorGetSample()
+u16 AcceleratorGetSample(AcceleratorState& acc)
 {
 	u16 ret;
 
@@ -154,29 +165,29 @@ u16 AcceleratorGetSample()
 	//
 	// On real hardware, this would raise an interrupt that is handled by the
 	// UCode. We simulate what this interrupt does here.
-	if ((*acc_cur_addr & ~1) == (acc_end_addr & ~1))
+	if ((*acc.cur_addr & ~1) == (acc.end_addr & ~1))
 	{
 		// loop back to loop_addr.
-		*acc_cur_addr = acc_loop_addr;
+		*acc.cur_addr = acc.loop_addr;
 
-		if (acc_pb->audio_addr.looping)
+		if (acc.pb->audio_addr.looping)
 		{
 			// Set the ADPCM infos to continue processing at loop_addr.
 			//
 			// For some reason, yn1 and yn2 aren't set if the voice is not of
 			// stream type. This is what the AX UCode does and I don't really
 			// know why.
-			acc_pb->adpcm.pred_scale = acc_pb->adpcm_loop_info.pred_scale;
-			if (!acc_pb->is_stream)
+			acc.pb->adpcm.pred_scale = acc.pb->adpcm_loop_info.pred_scale;
+			if (!acc.pb->is_stream)
 			{
-				acc_pb->adpcm.yn1 = acc_pb->adpcm_loop_info.yn1;
-				acc_pb->adpcm.yn2 = acc_pb->adpcm_loop_info.yn2;
+				acc.pb->adpcm.yn1 = acc.pb->adpcm_loop_info.yn1;
+				acc.pb->adpcm.yn2 = acc.pb->adpcm_loop_info.yn2;
 			}
 		}
 		else
 		{
 			// Non looping voice reached the end -> running = 0.
-			acc_pb->running = 0;
+			acc.pb->running = 0;
 
 #ifdef AX_WII
 			// One of the few meaningful differences between AXGC and AXWii:
@@ -184,78 +195,159 @@ u16 AcceleratorGetSample()
 			// samples at the loop address, AXWii has the 0000 samples
 			// internally in DRAM and use an internal pointer to it (loop addr
 			// does not contain 0000 samples on AXWii!).
-			acc_end_reached = true;
+			acc.end_reached = true;
 #endif
 		}
 	}
 
-	// See above for explanations about acc_end_reached.
-	if (acc_end_reached)
+	// See above for explanations about end_reached.
+	if (acc.end_reached)
 		return 0;
 
-	switch (acc_pb->audio_addr.sample_format)
+	switch (acc.pb->audio_addr.sample_format)
 	{
 		case 0x00: // ADPCM
 		{
 			// ADPCM decoding, not much to explain here.
-			if ((*acc_cur_addr & 15) == 0)
+			if ((*acc.cur_addr & 15) == 0)
 			{
-				acc_pb->adpcm.pred_scale = DSP::ReadARAM((*acc_cur_addr & ~15) >> 1);
-				*acc_cur_addr += 2;
+				acc.pb->adpcm.pred_scale = DSP::ReadARAM((*acc.cur_addr & ~15) >> 1);
+				*acc.cur_addr += 2;
 			}
 
-			int scale = 1 << (acc_pb->adpcm.pred_scale & 0xF);
-			int coef_idx = (acc_pb->adpcm.pred_scale >> 4) & 0x7;
+			int scale = 1 << (acc.pb->adpcm.pred_scale & 0xF);
+			int coef_idx = (acc.pb->adpcm.pred_scale >> 4) & 0x7;
 
-			s32 coef1 = acc_pb->adpcm.coefs[coef_idx * 2 + 0];
-			s32 coef2 = acc_pb->adpcm.coefs[coef_idx * 2 + 1];
+			s32 coef1 = acc.pb->adpcm.coefs[coef_idx * 2 + 0];
+			s32 coef2 = acc.pb->adpcm.coefs[coef_idx * 2 + 1];
 
-			int temp = (*acc_cur_addr & 1) ?
-					(DSP::ReadARAM(*acc_cur_addr >> 1) & 0xF) :
-					(DSP::ReadARAM(*acc_cur_addr >> 1) >> 4);
+			int temp = (*acc.cur_addr & 1) ?
+					(DSP::ReadARAM(*acc.cur_addr >> 1) & 0xF) :
+					(DSP::ReadARAM(*acc.cur_addr >> 1) >> 4);
 
 			if (temp >= 8)
 				temp -= 16;
 
-			int val = (scale * temp) + ((0x400 + coef1 * acc_pb->adpcm.yn1 + coef2 * acc_pb->adpcm.yn2) >> 11);
+			int val = (scale * temp) + ((0x400 + coef1 * acc.pb->adpcm.yn1 + coef2 * acc.pb->adpcm.yn2) >> 11);
 			MathUtil::Clamp(&val, -0x7FFF, 0x7FFF);
 
-			acc_pb->adpcm.yn2 = acc_pb->adpcm.yn1;
-			acc_pb->adpcm.yn1 = val;
-			*acc_cur_addr += 1;
+			acc.pb->adpcm.yn2 = acc.pb->adpcm.yn1;
+			acc.pb->adpcm.yn1 = val;
+			*acc.cur_addr += 1;
 			ret = val;
 			break;
 		}
 
 		case 0x0A: // 16-bit PCM audio
-			ret = (DSP::ReadARAM(*acc_cur_addr * 2) << 8) | DSP::ReadARAM(*acc_cur_addr * 2 + 1);
-			acc_pb->adpcm.yn2 = acc_pb->adpcm.yn1;
-			acc_pb->adpcm.yn1 = ret;
-			*acc_cur_addr += 1;
+			ret = (DSP::ReadARAM(*acc.cur_addr * 2) << 8) | DSP::ReadARAM(*acc.cur_addr * 2 + 1);
+			acc.pb->adpcm.yn2 = acc.pb->adpcm.yn1;
+			acc.pb->adpcm.yn1 = ret;
+			*acc.cur_addr += 1;
 			break;
 
 		case 0x19: // 8-bit PCM audio
-			ret = DSP::ReadARAM(*acc_cur_addr) << 8;
-			acc_pb->adpcm.yn2 = acc_pb->adpcm.yn1;
-			acc_pb->adpcm.yn1 = ret;
-			*acc_cur_addr += 1;
+			ret = DSP::ReadARAM(*acc.cur_addr) << 8;
+			acc.pb->adpcm.yn2 = acc.pb->adpcm.yn1;
+			acc.pb->adpcm.yn1 = ret;
+			*acc.cur_addr += 1;
 			break;
 
 		default:
-			ERROR_LOG(DSPHLE, "Unknown sample format: %d", acc_pb->audio_addr.sample_format);
+			ERROR_LOG(DSPHLE, "Unknown sample format: %d", acc.pb->audio_addr.sample_format);
 			return 0;
 	}
 
 	return ret;
 }
 
-// Reads samples from the input callback, resamples them to <count> samples at
-// the wanted sample rate (computed from the ratio, see below).
+// Reads <count> samples from the simulated accelerator.
+//
+// Samples between two frame headers and before the end address are decoded
+// in runs, with the decoder state kept in locals. Everything else (frame
+// headers, looping, the end of the stream) goes through AcceleratorGetSample.
+void AcceleratorGetSamples(AcceleratorState& acc, s16* output, u32 count)
+{
+	PB_TYPE* pb = acc.pb;
+	u32 i = 0;
+	while (i < count)
+	{
+		u32 addr = *acc.cur_addr;
+		u32 format = pb->audio_addr.sample_format;
+		bool known_format = format == 0x00 || format == 0x0A || format == 0x19;
+		if (acc.end_reached || !known_format || (addr & ~1) == (acc.end_addr & ~1) ||
+		    (format == 0x00 && (addr & 15) == 0))
+		{
+			output[i++] = AcceleratorGetSample(acc);
+			continue;
+		}
+
+		u32 run = count - i;
+		if (format == 0x00)
+			run = std::min(run, 16 - (addr & 15));
+		u32 end = acc.end_addr & ~1;
+		if (end > addr)
+			run = std::min(run, end - addr);
+
+		s32 yn1 = pb->adpcm.yn1;
+		s32 yn2 = pb->adpcm.yn2;
+		if (format == 0x00)
+		{
+			int scale = 1 << (pb->adpcm.pred_scale & 0xF);
+			int coef_idx = (pb->adpcm.pred_scale >> 4) & 0x7;
+			s32 coef1 = pb->adpcm.coefs[coef_idx * 2 + 0];
+			s32 coef2 = pb->adpcm.coefs[coef_idx * 2 + 1];
+
+			for (u32 j = 0; j < run; ++j, ++addr)
+			{
+				u8 byte = DSP::ReadARAM(addr >> 1);
+				int temp = (addr & 1) ? (byte & 0xF) : (byte >> 4);
+				if (temp >= 8)
+					temp -= 16;
+
+				int val = (scale * temp) + ((0x400 + coef1 * yn1 + coef2 * yn2) >> 11);
+				MathUtil::Clamp(&val, -0x7FFF, 0x7FFF);
+
+				yn2 = yn1;
+				yn1 = val;
+				output[i++] = val;
+			}
+		}
+		else if (format == 0x0A)
+		{
+			for (u32 j = 0; j < run; ++j, ++addr)
+			{
+				yn2 = yn1;
+				yn1 = (s16)((DSP::ReadARAM(addr * 2) << 8) | DSP::ReadARAM(addr * 2 + 1));
+				output[i++] = yn1;
+			}
+		}
+		else
+		{
+			for (u32 j = 0; j < run; ++j, ++addr)
+			{
+				yn2 = yn1;
+				yn1 = (s16)(DSP::ReadARAM(addr) << 8);
+				output[i++] = yn1;
+			}
+		}
+		pb->adpcm.yn1 = yn1;
+		pb->adpcm.yn2 = yn2;
+		*acc.cur_addr = addr;
+	}
+}
+
+// Resamples input samples to <count> samples at the wanted sample rate
+// (computed from the ratio, see below).
+//
+// <input> starts with the four history samples from <last_samples>, followed
+// by the new input samples: as many as the integer part of
+// curr_pos + count * ratio for LINEAR and POLYPHASE, and <count> for NEAREST.
+// <last_samples> is updated with the last four input samples used.
 //
 // If srctype is SRCTYPE_POLYPHASE, coefficients need to be provided as well
 // (or the srctype will automatically be changed to LINEAR).
 //
-// Returns the current position after resampling (including fractional part).
+// Returns the fractional part of the current position after resampling.
 //
 // The input to output ratio is set in <ratio>, which is a floating point num
 // stored as a 32b integer:
@@ -269,120 +361,137 @@ u16 AcceleratorGetSample()
 // We start getting samples not from sample 0, but 0.<curr_pos_frac>. This
 // avoids discontinuities in the audio stream, especially with very low ratios
 // which interpolate a lot of values between two "real" samples.
-u32 ResampleAudio(std::function<s16(u32)> input_callback, s16* output, u32 count,
-                  s16* last_samples, u32 curr_pos, u32 ratio, int srctype,
-                  const s16* coeffs)
+u32 ResampleAudio(const s16* input, s16* output, u32 count, s16* last_samples,
+                  u32 curr_pos, u32 ratio, int srctype, const s16* coeffs)
 {
-	int read_samples_count = 0;
-
-	// TODO(delroth): find out why the polyphase resampling algorithm causes
-	// audio glitches in Wii games with non integral ratios.
-
-	// If DSP DROM coefficients are available, support polyphase resampling.
-	if (0) // if (coeffs && srctype == SRCTYPE_POLYPHASE)
+	// Position in <input> of the oldest of the four samples the output is
+	// computed from.
+	u64 pos = curr_pos;
+
+	// If DSP DROM coefficients are available, support polyphase resampling:
+	// a 4 tap filter over the window, with one of 128 sets of coefficients
+	// picked by the fractional position. The result is saturated, truncating
+	// it wraps around whenever the filter overshoots on loud input.
+	if (coeffs && srctype == SRCTYPE_POLYPHASE)
 	{
-		s16 temp[4];
-		u32 idx = 0;
-
-		temp[idx++ & 3] = last_samples[0];
-		temp[idx++ & 3] = last_samples[1];
-		temp[idx++ & 3] = last_samples[2];
-		temp[idx++ & 3] = last_samples[3];
-
-		for (u32 i = 0; i < count; ++i)
+		u32 i = 0;
+
+#if _M_X86
+		// Four samples at a time. pmaddwd gives two partial sums per sample,
+		// which are shifted separately (keeping the carry out of their low
+		// bits) so that adding them can't overflow. Bit exact with the scalar
+		// loop, unless both taps of a pair are -0x8000 * -0x8000.
+		for (; i + 4 <= count; i += 4)
 		{
-			curr_pos += ratio;
-			while (curr_pos >= 0x10000)
+			__m128i sums[2];
+			for (int j = 0; j < 2; ++j)
 			{
-				temp[idx++ & 3] = input_callback(read_samples_count++);
-				curr_pos -= 0x10000;
+				pos += ratio;
+				__m128i in0 = _mm_loadl_epi64((const __m128i*)&input[pos >> 16]);
+				__m128i c0 = _mm_loadl_epi64((const __m128i*)&coeffs[((pos & 0xFFFF) >> 9) << 2]);
+				pos += ratio;
+				__m128i in1 = _mm_loadl_epi64((const __m128i*)&input[pos >> 16]);
+				__m128i c1 = _mm_loadl_epi64((const __m128i*)&coeffs[((pos & 0xFFFF) >> 9) << 2]);
+
+				// a0 b0 a1 b1 -> a0 a1 b0 b1
+				sums[j] = _mm_madd_epi16(_mm_unpacklo_epi64(in0, in1), _mm_unpacklo_epi64(c0, c1));
+				sums[j] = _mm_shuffle_epi32(sums[j], _MM_SHUFFLE(3, 1, 2, 0));
 			}
 
-			u16 curr_pos_frac = ((curr_pos & 0xFFFF) >> 9) << 2;
-			const s16* c = &coeffs[curr_pos_frac];
+			__m128i a = _mm_unpacklo_epi64(sums[0], sums[1]);
+			__m128i b = _mm_unpackhi_epi64(sums[0], sums[1]);
+			__m128i mask = _mm_set1_epi32(0x7FFF);
+			__m128i carry = _mm_srai_epi32(_mm_add_epi32(_mm_and_si128(a, mask), _mm_and_si128(b, mask)), 15);
+			__m128i result = _mm_add_epi32(_mm_add_epi32(_mm_srai_epi32(a, 15), _mm_srai_epi32(b, 15)), carry);
+			_mm_storel_epi64((__m128i*)&output[i], _mm_packs_epi32(result, result));
+		}
+#endif
 
-			s64 t0 = temp[idx++ & 3];
-			s64 t1 = temp[idx++ & 3];
-			s64 t2 = temp[idx++ & 3];
-			s64 t3 = temp[idx++ & 3];
+		for (; i < count; ++i)
+		{
+			pos += ratio;
+			const s16* in = &input[pos >> 16];
+			const s16* c = &coeffs[((pos & 0xFFFF) >> 9) << 2];
 
-			s64 samp = (t0 * c[0] + t1 * c[1] + t2 * c[2] + t3 * c[3]) >> 15;
+			s64 samp = ((s64)in[0] * c[0] + (s64)in[1] * c[1] + (s64)in[2] * c[2] + (s64)in[3] * c[3]) >> 15;
+			MathUtil::Clamp<s64>(&samp, -0x8000, 0x7FFF);
 
 			output[i] = (s16)samp;
 		}
-
-		last_samples[3] = temp[--idx & 3];
-		last_samples[2] = temp[--idx & 3];
-		last_samples[1] = temp[--idx & 3];
-		last_samples[0] = temp[--idx & 3];
 	}
 	else if (srctype == SRCTYPE_LINEAR || srctype == SRCTYPE_POLYPHASE)
 	{
-		// This is the circular buffer containing samples to use for the
-		// interpolation. It is initialized with the values from the PB, and it
-		// will be stored back to the PB at the end.
-		s16 temp[4];
-		u32 idx = 0;
-
-		temp[idx++ & 3] = last_samples[0];
-		temp[idx++ & 3] = last_samples[1];
-		temp[idx++ & 3] = last_samples[2];
-		temp[idx++ & 3] = last_samples[3];
-
-		for (u32 i = 0; i < count; ++i)
+		// Interpolate between the oldest sample and the next one, depending on
+		// the current fractional position. A fraction of 0 gives the oldest
+		// sample unchanged.
+		u32 i = 0;
+
+#if _M_X86
+		// Four samples at a time. The weights don't fit in 16 bits, so pmaddwd
+		// is done on their high and low bytes separately, which keeps the
+		// result bit exact with the scalar loop below.
+		for (; i + 4 <= count; i += 4)
 		{
-			curr_pos += ratio;
-
-			// While our current position is >= 1.0, push new samples to the
-			// circular buffer.
-			while (curr_pos >= 0x10000)
+			u32 pairs[4], weights_hi[4], weights_lo[4];
+			for (int j = 0; j < 4; ++j)
 			{
-				temp[idx++ & 3] = input_callback(read_samples_count++);
-				curr_pos -= 0x10000;
+				pos += ratio;
+				u32 frac = pos & 0xFFFF;
+				u32 inv_frac = 0x10000 - frac;
+				pairs[j] = *(const u32*)&input[pos >> 16];
+				weights_hi[j] = (frac >> 8) << 16 | (inv_frac >> 8);
+				weights_lo[j] = (frac & 0xff) << 16 | (inv_frac & 0xff);
 			}
 
-			// Get our current fractional position, used to know how much of
-			// curr0 and how much of curr1 the output sample should be.
-			u16 curr_frac = curr_pos & 0xFFFF;
-			u16 inv_curr_frac = -curr_frac;
-
-			// Interpolate! If curr_frac is 0, we can simply take the last
-			// sample without any multiplying.
-			s16 sample;
-			if (curr_frac)
-			{
-				s32 s0 = temp[idx++ & 3];
-				s32 s1 = temp[idx++ & 3];
-
-				sample = ((s0 * inv_curr_frac) + (s1 * curr_frac)) >> 16;
-				idx += 2;
-			}
-			else
-			{
-				sample = temp[idx++ & 3];
-				idx += 3;
-			}
-
-			output[i] = sample;
+			__m128i samples = _mm_set_epi32(pairs[3], pairs[2], pairs[1], pairs[0]);
+			__m128i hi = _mm_madd_epi16(samples, _mm_set_epi32(weights_hi[3], weights_hi[2], weights_hi[1], weights_hi[0]));
+			__m128i lo = _mm_madd_epi16(samples, _mm_set_epi32(weights_lo[3], weights_lo[2], weights_lo[1], weights_lo[0]));
+			__m128i result = _mm_srai_epi32(_mm_add_epi32(_mm_slli_epi32(hi, 8), lo), 16);
+			_mm_storel_epi64((__m128i*)&output[i], _mm_packs_epi32(result, result));
 		}
+#endif
 
-		// Update the four last_samples values.
-		last_samples[3] = temp[--idx & 3];
-		last_samples[2] = temp[--idx & 3];
-		last_samples[1] = temp[--idx & 3];
-		last_samples[0] = temp[--idx & 3];
+		for (; i < count; ++i)
+		{
+			pos += ratio;
+			const s16* in = &input[pos >> 16];
+			s32 frac = pos & 0xFFFF;
+			output[i] = (in[0] * (0x10000 - frac) + in[1] * frac) >> 16;
+		}
 	}
 	else // SRCTYPE_NEAREST
 	{
-		// No sample rate conversion here: simply read samples from the
-		// accelerator to the output buffer.
-		for (u32 i = 0; i < count; ++i)
-			output[i] = input_callback(i);
-
-		memcpy(last_samples, output + count - 4, 4 * sizeof (u16));
+		// No sample rate conversion here: simply copy the input samples to
+		// the output buffer.
+		memcpy(output, input + 4, count * sizeof (s16));
+		pos += (u64)count << 16;
 	}
 
-	return curr_pos;
+	// Update the four last_samples values.
+	memcpy(last_samples, input + (pos >> 16), 4 * sizeof (s16));
+
+	return pos & 0xFFFF;
+}
+
+// Resamples the count * 16 / 3 samples after the four history samples in
+// <input> from 32kHz to <count> samples for the Wii remote speaker, at 6kHz.
+//
+// 16 / 3 isn't exact in 16.16 fixed point. A third of the samples step by
+// 0x55556 and the others by 0x55555, so every call reads all of its input
+// and leaves the fractional position where it was. With 0x55555 throughout
+// the position fell behind by 2 / 65536 of a sample per ms, and a sample was
+// dropped from the stream whenever the fraction wrapped, about every 33s.
+u32 ResampleRemoteAudio(const s16* input, s16* output, u32 count, s16* last_samples,
+                        u32 curr_pos, const s16* coeffs)
+{
+	u32 long_steps = count / 3;
+	u32 short_steps = count - long_steps;
+	u32 read = (u32)((curr_pos + (u64)short_steps * 0x55555) >> 16);
+
+	curr_pos = ResampleAudio(input, output, short_steps, last_samples, curr_pos,
+	                         0x55555, SRCTYPE_POLYPHASE, coeffs);
+	return ResampleAudio(input + read, output + short_steps, long_steps, last_samples, curr_pos,
+	                     0x55556, SRCTYPE_POLYPHASE, coeffs);
 }
 
 // Read <count> input samples from ARAM, decoding and converting rate
@@ -390,21 +499,103 @@ u32 ResampleAudio(std::function<s16(u32)> input_callback, s16* output, u32 count
 void GetInputSamples(PB_TYPE& pb, s16* samples, u16 count, const s16* coeffs)
 {
 	u32 cur_addr = HILO_TO_32(pb.audio_addr.cur_addr);
-	AcceleratorSetup(&pb, &cur_addr);
+	AcceleratorState acc;
+	AcceleratorSetup(acc, &pb, &cur_addr);
 
 	if (coeffs)
 		coeffs += pb.coef_select * 0x200;
-	u32 curr_pos = ResampleAudio([](u32) { return AcceleratorGetSample(); },
-	                             samples, count, pb.src.last_samples,
-	                             pb.src.cur_addr_frac, HILO_TO_32(pb.src.ratio),
-	                             pb.src_type, coeffs);
-	pb.src.cur_addr_frac = (curr_pos & 0xFFFF);
+
+	// Decoded samples, after the four history samples the resampler needs.
+	// Enough for a pitch of 8 in one go, higher ones are split up.
+	const u32 MAX_INPUT_SAMPLES = MAX_SAMPLES_PER_FRAME * 8;
+	s16 input[4 + MAX_INPUT_SAMPLES];
+
+	u32 ratio = HILO_TO_32(pb.src.ratio);
+	u32 curr_pos = pb.src.cur_addr_frac;
+	bool resample = pb.src_type == SRCTYPE_LINEAR || pb.src_type == SRCTYPE_POLYPHASE;
+
+	while (count)
+	{
+		memcpy(input, pb.src.last_samples, sizeof (pb.src.last_samples));
+
+		u32 chunk = std::min<u32>(count, MAX_INPUT_SAMPLES);
+		u32 chunk_ratio = ratio;
+		if (resample && ratio)
+		{
+			chunk = (u32)std::min<u64>(chunk, (((u64)MAX_INPUT_SAMPLES << 16) - curr_pos) / ratio);
+			if (chunk == 0)
+			{
+				// A single output sample spans more input than fits in the
+				// buffer. Only the last samples matter, skip the others.
+				u32 skip = (u32)((curr_pos + (u64)ratio) >> 16) - MAX_INPUT_SAMPLES;
+				chunk_ratio -= skip << 16;
+				while (skip)
+				{
+					u32 skipped = std::min(skip, MAX_INPUT_SAMPLES);
+					AcceleratorGetSamples(acc, input + 4, skipped);
+					memmove(input, input + skipped, 4 * sizeof (s16));
+					skip -= skipped;
+				}
+				chunk = 1;
+			}
+		}
+
+		u32 needed = resample ? (u32)((curr_pos + (u64)chunk * chunk_ratio) >> 16) : chunk;
+		AcceleratorGetSamples(acc, input + 4, needed);
+		curr_pos = ResampleAudio(input, samples, chunk, pb.src.last_samples,
+		                         curr_pos, chunk_ratio, pb.src_type, coeffs);
+
+		samples += chunk;
+		count -= chunk;
+	}
+	pb.src.cur_addr_frac = curr_pos;
 
 	// Update current position in the PB.
 	pb.audio_addr.cur_addr_hi = (u16)(cur_addr >> 16);
 	pb.audio_addr.cur_addr_lo = (u16)(cur_addr & 0xFFFF);
 }
 
+#if _M_X86
+// (s16)((sample * volume) >> 15) on eight samples, with unsigned volumes.
+__m128i MulVolume(__m128i samples, __m128i volumes)
+{
+	__m128i lo = _mm_mullo_epi16(samples, volumes);
+	// pmulhw treats the volume as signed, add the missing sample * 0x10000
+	// back for volumes >= 0x8000.
+	__m128i hi = _mm_add_epi16(_mm_mulhi_epi16(samples, volumes),
+	                           _mm_and_si128(samples, _mm_srai_epi16(volumes, 15)));
+	return _mm_or_si128(_mm_slli_epi16(hi, 1), _mm_srli_epi16(lo, 15));
+}
+
+// Eight steps of a volume ramp, starting at <volume>.
+__m128i VolumeRamp(u16 volume, u16 delta)
+{
+	return _mm_add_epi16(_mm_set1_epi16(volume),
+	                     _mm_mullo_epi16(_mm_set_epi16(7, 6, 5, 4, 3, 2, 1, 0), _mm_set1_epi16(delta)));
+}
+#endif
+
+// Multiply samples by a volume ramp, in place.
+void ApplyVolumeRamp(s16* samples, u32 count, u16* volume, u16 volume_delta)
+{
+	u32 i = 0;
+
+#if _M_X86
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i* ptr = (__m128i*)&samples[i];
+		_mm_storeu_si128(ptr, MulVolume(_mm_loadu_si128(ptr), VolumeRamp(*volume, volume_delta)));
+		*volume += 8 * volume_delta;
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		samples[i] = ((s32)samples[i] * *volume) >> 15;
+		*volume += volume_delta;
+	}
+}
+
 // Add samples to an output buffer, with optional volume ramping.
 void MixAdd(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ramp)
 {
@@ -417,7 +608,21 @@ void MixAdd(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ra
 	if (!ramp)
 		volume_delta = 0;
 
-	for (u32 i = 0; i < count; ++i)
+	u32 i = 0;
+
+#if _M_X86
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i samples = MulVolume(_mm_loadu_si128((const __m128i*)&input[i]), VolumeRamp(volume, volume_delta));
+		__m128i* dst = (__m128i*)&out[i];
+		_mm_storeu_si128(dst, _mm_add_epi32(_mm_loadu_si128(dst), _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16)));
+		_mm_storeu_si128(dst + 1, _mm_add_epi32(_mm_loadu_si128(dst + 1), _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16)));
+		volume += 8 * volume_delta;
+		*dpop = (s16)_mm_extract_epi16(samples, 7);
+	}
+#endif
+
+	for (; i < count; ++i)
 	{
 		s64 sample = input[i];
 		sample *= volume;
@@ -430,6 +635,100 @@ void MixAdd(int* out, const s16* input, u32 count, u16* pvol, s16* dpop, bool ra
 	}
 }
 
+// Number of ints in each of the AXBuffers, for one PB list.
+#ifdef AX_GC
+const u32 BUFFER_SIZES[9] = {
+	32 * 5, 32 * 5, 32 * 5,
+	32 * 5, 32 * 5, 32 * 5,
+	32 * 5, 32 * 5, 32 * 5
+};
+#else
+const u32 BUFFER_SIZES[20] = {
+	32 * 3, 32 * 3, 32 * 3,
+	32 * 3, 32 * 3, 32 * 3,
+	32 * 3, 32 * 3, 32 * 3,
+	32 * 3, 32 * 3, 32 * 3,
+	6 * 3, 6 * 3, 6 * 3, 6 * 3,
+	6 * 3, 6 * 3, 6 * 3, 6 * 3
+};
+#endif
+
+// Processes the PB list starting at <pb_addr>. process_pb(addr, buffers) mixes
+// one voice into the given buffers and returns the address of the next PB, or
+// 0 if there is none or the PB could not be read.
+//
+// When worker threads are available, the voices are spread across them: each
+// one mixes a contiguous part of the list into its own zeroed buffers (from
+// <scratch>), which are added to the main buffers afterwards. Mixing only adds
+// integers, so the result is the same as walking the list on one thread. The
+// list is walked before any PB is processed, so PB updates that rewrite the
+// next_pb links are not supported in that mode.
+template <typename ProcessPB>
+void MixPBList(u32 pb_addr, const AXBuffers& buffers, Common::WorkerPool* workers,
+               std::vector<int>& scratch, ProcessPB process_pb)
+{
+	// Below that, waking the workers up costs more than it saves.
+	const u32 MIN_PARALLEL_PBS = 8;
+	const u32 MAX_PARALLEL_PBS = 256;
+	const u32 num_buffers = sizeof (buffers.ptrs) / sizeof (buffers.ptrs[0]);
+
+	if (workers && pb_addr)
+	{
+		u32 addresses[MAX_PARALLEL_PBS];
+		u32 num_pbs = 0;
+		u32 next = pb_addr;
+		while (next && num_pbs < MAX_PARALLEL_PBS)
+		{
+			const u16* pb = (const u16*)Memory::GetPointer(next);
+			if (!pb)
+				break;
+			addresses[num_pbs++] = next;
+			next = (Common::swap16(pb[0]) << 16) | Common::swap16(pb[1]);
+		}
+
+		if (num_pbs >= MIN_PARALLEL_PBS)
+		{
+			int num_tasks = std::min<int>(workers->GetThreadCount() + 1, num_pbs / 4);
+			u32 total_size = 0;
+			for (u32 size : BUFFER_SIZES)
+				total_size += size;
+			scratch.assign(total_size * (num_tasks - 1), 0);
+
+			workers->ParallelFor(num_tasks, [&](int task) {
+				AXBuffers task_buffers = buffers;
+				if (task != 0)
+				{
+					int* ptr = &scratch[total_size * (task - 1)];
+					for (u32 i = 0; i < num_buffers; ++i)
+					{
+						task_buffers.ptrs[i] = ptr;
+						ptr += BUFFER_SIZES[i];
+					}
+				}
+
+				for (u32 i = num_pbs * task / num_tasks; i < num_pbs * (task + 1) / num_tasks; ++i)
+					process_pb(addresses[i], task_buffers);
+			});
+
+			const int* src = scratch.data();
+			for (int task = 1; task < num_tasks; ++task)
+			{
+				for (u32 i = 0; i < num_buffers; ++i)
+				{
+					for (u32 j = 0; j < BUFFER_SIZES[i]; ++j)
+						buffers.ptrs[i][j] += *src++;
+				}
+			}
+
+			// Whatever did not fit is processed in order.
+			pb_addr = next;
+		}
+	}
+
+	while (pb_addr)
+		pb_addr = process_pb(pb_addr, buffers);
+}
+
 // Execute a low pass filter on the samples using one history value. Returns
 // the new history value.
 s16 LowPassFilter(s16* samples, u32 count, s16 yn1, u16 a0, u16 b0)
@@ -452,11 +751,7 @@ void ProcessVoice(PB_TYPE& pb, const AXBuffers& buffers, u16 count, AXMixControl
 	GetInputSamples(pb, samples, count, coeffs);
 
 	// Apply a global volume ramp using the volume envelope parameters.
-	for (u32 i = 0; i < count; ++i)
-	{
-		samples[i] = ((s32)samples[i] * pb.vol_env.cur_volume) >> 15;
-		pb.vol_env.cur_volume += pb.vol_env.cur_volume_delta;
-	}
+	ApplyVolumeRamp(samples, count, &pb.vol_env.cur_volume, pb.vol_env.cur_volume_delta);
 
 	// Optionally, execute a low pass filter
 	// TODO: LPF code is currently broken, causing Super Monkey Ball sound
@@ -520,14 +815,12 @@ void ProcessVoice(PB_TYPE& pb, const AXBuffers& buffers, u16 count, AXMixControl
 
 		// Interpolate at most 18 samples from the 96 samples we read before.
 		s16 wm_samples[18];
+		s16 wm_input[4 + MAX_SAMPLES_PER_FRAME];
+		memcpy(wm_input, pb.remote_src.last_samples, sizeof (pb.remote_src.last_samples));
+		memcpy(wm_input + 4, samples, count * sizeof (s16));
 
-		// We use ratio 0x55555 == (5 * 65536 + 21845) / 65536 == 5.3333 which
-		// is the nearest we can get to 96/18
-		u32 curr_pos = ResampleAudio([&samples](u32 i) { return samples[i]; },
-		                             wm_samples, wm_count, pb.remote_src.last_samples,
-		                             pb.remote_src.cur_addr_frac, 0x55555,
-		                             SRCTYPE_POLYPHASE, coeffs);
-		pb.remote_src.cur_addr_frac = curr_pos & 0xFFFF;
+		pb.remote_src.cur_addr_frac = ResampleRemoteAudio(wm_input, wm_samples, wm_count, pb.remote_src.last_samples,
+		                                                  pb.remote_src.cur_addr_frac, coeffs);
 
 		// Mix to main[0-3] and aux[0-3]
 #define WMCHAN_MIX_ON(n) (0 != ((pb.remote_mixer_control >> (2 * n)) & 3))
@@ -426,35 +426,34 @@ void AXWiiUCode::ReinjectUpdatesFields(AXPBWii& pb, u16* num_updates, u32 update
 
 void AXWiiUCode::ProcessPBList(u32 pb_addr)
 {
-	AXPBWii pb;
+	AXBuffers buffers = {{
+		m_samples_left,
+		m_samples_right,
+		m_samples_surround,
+		m_samples_auxA_left,
+		m_samples_auxA_right,
+		m_samples_auxA_surround,
+		m_samples_auxB_left,
+		m_samples_auxB_right,
+		m_samples_auxB_surround,
+		m_samples_auxC_left,
+		m_samples_auxC_right,
+		m_samples_auxC_surround,
+		m_samples_wm0,
+		m_samples_aux0,
+		m_samples_wm1,
+		m_samples_aux1,
+		m_samples_wm2,
+		m_samples_aux2,
+		m_samples_wm3,
+		m_samples_aux3
+	}};
 
-	while (pb_addr)
-	{
-		AXBuffers buffers = {{
-			m_samples_left,
-			m_samples_right,
-			m_samples_surround,
-			m_samples_auxA_left,
-			m_samples_auxA_right,
-			m_samples_auxA_surround,
-			m_samples_auxB_left,
-			m_samples_auxB_right,
-			m_samples_auxB_surround,
-			m_samples_auxC_left,
-			m_samples_auxC_right,
-			m_samples_auxC_surround,
-			m_samples_wm0,
-			m_samples_aux0,
-			m_samples_wm1,
-			m_samples_aux1,
-			m_samples_wm2,
-			m_samples_aux2,
-			m_samples_wm3,
-			m_samples_aux3
-		}};
-
-		if (!ReadPB(pb_addr, pb))
-			break;
+	MixPBList(pb_addr, buffers, m_voice_workers.get(), m_voice_scratch,
+	          [this](u32 addr, AXBuffers voice_buffers) -> u32 {
+		AXPBWii pb;
+		if (!ReadPB(addr, pb))
+			return 0;
 
 		u16 num_updates[3];
 		u16 updates[1024];
@@ -464,26 +463,26 @@ void AXWiiUCode::ProcessPBList(u32 pb_addr)
 			for (int curr_ms = 0; curr_ms < 3; ++curr_ms)
 			{
 				ApplyUpdatesForMs(curr_ms, (u16*)&pb, num_updates, updates);
-				ProcessVoice(pb, buffers, 32,
+				ProcessVoice(pb, voice_buffers, 32,
 				             ConvertMixerControl(HILO_TO_32(pb.mixer_control)),
 				             m_coeffs_available ? m_coeffs : nullptr);
 
 				// Forward the buffers
-				for (u32 i = 0; i < sizeof (buffers.ptrs) / sizeof (buffers.ptrs[0]); ++i)
-					buffers.ptrs[i] += 32;
+				for (u32 i = 0; i < sizeof (voice_buffers.ptrs) / sizeof (voice_buffers.ptrs[0]); ++i)
+					voice_buffers.ptrs[i] += 32;
 			}
 			ReinjectUpdatesFields(pb, num_updates, updates_addr);
 		}
 		else
 		{
-			ProcessVoice(pb, buffers, 96,
+			ProcessVoice(pb, voice_buffers, 96,
 			             ConvertMixerControl(HILO_TO_32(pb.mixer_control)),
 			             m_coeffs_available ? m_coeffs : nullptr);
 		}
 
-		WritePB(pb_addr, pb);
-		pb_addr = HILO_TO_32(pb.next_pb);
-	}
+		WritePB(addr, pb);
+		return HILO_TO_32(pb.next_pb);
+	});
 }
 
 void AXWiiUCode::MixAUXSamples(int aux_id, u32 write_addr, u32 read_addr, u16 volume)
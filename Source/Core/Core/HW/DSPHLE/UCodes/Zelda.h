@@ -145,6 +145,16 @@ public:
 		return res;
 	}
 
+	// AFC decoder
+	static void AFCdecodebuffer(const s16 *coef, const char *input, signed short *out, short *histp, short *hist2p, int type);
+
+	// Synthesized voice formats. These only depend on the PB (and the table
+	// sent by DsetupTable for wave tables).
+	static void RenderSynth_Constant(ZeldaVoicePB &PB, s32* _Buffer, int _Size);
+	static void RenderSynth_RectWave(ZeldaVoicePB &PB, s32* _Buffer, int _Size);
+	static void RenderSynth_SawWave(ZeldaVoicePB &PB, s32* _Buffer, int _Size);
+	static void RenderSynth_WaveTable(ZeldaVoicePB &PB, s32* _Buffer, int _Size, const s16* misc_table);
+
 private:
 	// These map CRC to behaviour.
 
@@ -264,18 +274,10 @@ private:
 
 	u8 *GetARAMPointer(u32 address);
 
-	// AFC decoder
-	static void AFCdecodebuffer(const s16 *coef, const char *input, signed short *out, short *histp, short *hist2p, int type);
-
 	void ReadVoicePB(u32 _Addr, ZeldaVoicePB& PB);
 	void WritebackVoicePB(u32 _Addr, ZeldaVoicePB& PB);
 
 	// Voice formats
-	void RenderSynth_Constant(ZeldaVoicePB &PB, s32* _Buffer, int _Size);
-	void RenderSynth_RectWave(ZeldaVoicePB &PB, s32* _Buffer, int _Size);
-	void RenderSynth_SawWave(ZeldaVoicePB &PB, s32* _Buffer, int _Size);
-	void RenderSynth_WaveTable(ZeldaVoicePB &PB, s32* _Buffer, int _Size);
-
 	void RenderVoice_PCM8(ZeldaVoicePB& PB, s16* _Buffer, int _Size);
 	void RenderVoice_PCM16(ZeldaVoicePB& PB, s16* _Buffer, int _Size);
 
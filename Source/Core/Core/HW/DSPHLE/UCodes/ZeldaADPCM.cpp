@@ -6,6 +6,47 @@
 #include "Common/MathUtil.h"
 #include "Core/HW/DSPHLE/UCodes/Zelda.h"
 
+#if _M_X86
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+
+// Sign extended and pre-shifted nibbles for every possible input byte: two 4
+// bit nibbles (<< 11) for type 9, four 2 bit ones (<< 13) for type 5.
+struct AFCNibbleTables
+{
+	s16 type9[256][2];
+	s16 type5[256][4];
+
+	AFCNibbleTables()
+	{
+		for (int byte = 0; byte < 256; byte++)
+		{
+			for (int i = 0; i < 2; i++)
+			{
+				int nibble = (byte >> (4 - 4 * i)) & 15;
+				if (nibble >= 8)
+					nibble -= 16;
+				type9[byte][i] = nibble << 11;
+			}
+
+			for (int i = 0; i < 4; i++)
+			{
+				int nibble = (byte >> (6 - 2 * i)) & 3;
+				if (nibble >= 2)
+					nibble -= 4;
+				type5[byte][i] = nibble << 13;
+			}
+		}
+	}
+};
+
+const AFCNibbleTables s_afc_nibbles;
+
+}
+
 void ZeldaUCode::AFCdecodebuffer(const s16 *coef, const char *src, signed short *out, short *histp, short *hist2p, int type)
 {
 	// First 2 nibbles are ADPCM scale etc.
@@ -13,19 +54,14 @@ void ZeldaUCode::AFCdecodebuffer(const s16 *coef, const char *src, signed short
 	short idx = (*src) & 0xf;
 	src++;
 
-	short nibbles[16];
+	const u8* data = (const u8*)src;
+	s16 nibbles[16];
 	if (type == 9)
 	{
-		for (int i = 0; i < 16; i += 2)
+		for (int i = 0; i < 8; i++)
 		{
-			nibbles[i + 0] = *src >> 4;
-			nibbles[i + 1] = *src & 15;
-			src++;
-		}
-		for (auto& nibble : nibbles) {
-			if (nibble >= 8)
-				nibble = nibble - 16;
-			nibble <<= 11;
+			nibbles[2 * i + 0] = s_afc_nibbles.type9[data[i]][0];
+			nibbles[2 * i + 1] = s_afc_nibbles.type9[data[i]][1];
 		}
 	}
 	else
@@ -33,28 +69,38 @@ void ZeldaUCode::AFCdecodebuffer(const s16 *coef, const char *src, signed short
 		// In Pikmin, Dolphin's engine sound is using AFC type 5, even though such a sound is hard
 		// to compare, it seems like to sound exactly like a real GC
 		// In Super Mario Sunshine, you can get such a sound by talking to/jumping on anyone
-		for (int i = 0; i < 16; i += 4)
+		for (int i = 0; i < 4; i++)
 		{
-			nibbles[i + 0] = (*src >> 6) & 0x03;
-			nibbles[i + 1] = (*src >> 4) & 0x03;
-			nibbles[i + 2] = (*src >> 2) & 0x03;
-			nibbles[i + 3] = (*src >> 0) & 0x03;
-			src++;
+			for (int j = 0; j < 4; j++)
+				nibbles[4 * i + j] = s_afc_nibbles.type5[data[i]][j];
 		}
+	}
 
-		for (auto& nibble : nibbles)
-		{
-			if (nibble >= 2)
-				nibble = nibble - 4;
-			nibble <<= 13;
-		}
+	// The scaled nibbles don't depend on the history, only the filter below
+	// has to run one sample at a time.
+	s32 scaled[16];
+#if _M_X86
+	__m128i scale = _mm_set1_epi16(delta);
+	for (int i = 0; i < 16; i += 8)
+	{
+		__m128i values = _mm_loadu_si128((const __m128i*)&nibbles[i]);
+		__m128i lo = _mm_mullo_epi16(values, scale);
+		__m128i hi = _mm_mulhi_epi16(values, scale);
+		_mm_storeu_si128((__m128i*)&scaled[i], _mm_unpacklo_epi16(lo, hi));
+		_mm_storeu_si128((__m128i*)&scaled[i + 4], _mm_unpackhi_epi16(lo, hi));
 	}
+#else
+	for (int i = 0; i < 16; i++)
+		scaled[i] = delta * nibbles[i];
+#endif
 
+	const int coef1 = coef[idx * 2];
+	const int coef2 = coef[idx * 2 + 1];
 	short hist = *histp;
 	short hist2 = *hist2p;
 	for (int i = 0; i < 16; i++)
 	{
-		int sample = delta * nibbles[i] + ((int)hist * coef[idx * 2]) + ((int)hist2 * coef[idx * 2 + 1]);
+		int sample = scaled[i] + ((int)hist * coef1) + ((int)hist2 * coef2);
 		sample >>= 11;
 		MathUtil::Clamp(&sample, -32768, 32767);
 		out[i] = sample;
@@ -2,6 +2,7 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cmath>
 
 #include "Core/HW/DSPHLE/UCodes/UCodes.h"
@@ -9,14 +10,14 @@
 
 void ZeldaUCode::RenderSynth_RectWave(ZeldaVoicePB &PB, s32* _Buffer, int _Size)
 {
-	s64 ratio = ((s64)PB.RatioInt << 16) * 16;
+	u64 ratio = ((u64)PB.RatioInt << 16) * 16;
 	s64 TrueSamplePosition = PB.CurSampleFrac;
 
 	// PB.Format == 0x3 -> Rectangular Wave, 0x0 -> Square Wave
 	unsigned int mask = PB.Format ? 3 : 1;
 	// int shift = PB.Format ? 2 : 1; // Unused?
 
-	u32 pos[2] = {0, 0};
+	u64 pos = 0;
 	int i = 0;
 
 	if (PB.KeyOff != 0)
@@ -46,34 +47,51 @@ _lRestart:
 			PB.RestartPos = PB.LoopStartPos;
 			PB.RemLength = PB.Length - PB.RestartPos;
 			PB.CurAddr =  PB.StartAddr + (PB.RestartPos << 1);
-			pos[1] = 0; pos[0] = 0;
+			pos = 0;
 		}
 	}
 
+	// The output only depends on the upper half of the position, and so does
+	// the end check, so the buffer is filled in runs of equal samples.
 	while (i < _Size)
 	{
-		s16 sample = ((pos[1] & mask) == mask) ? 0xc000 : 0x4000;
+		u32 pos_hi = (u32)(pos >> 32);
+		u32 played = (PB.CurAddr - PB.StartAddr) >> 1;
+		s32 sample = ((pos_hi & mask) == mask) ? -0x4000 : 0x4000;
 
-		TrueSamplePosition += (ratio >> 16);
+		u64 run = _Size - i;
+		if (pos_hi + played >= PB.Length)
+		{
+			// Only happens right after a restart: the end is caught after
+			// the first sample.
+			run = 1;
+		}
+		else if (ratio)
+		{
+			u64 to_next = 0x100000000ULL - (u32)pos;
+			run = std::min(run, (to_next + ratio - 1) / ratio);
+		}
 
-		_Buffer[i++] = (s32)sample;
+		for (u64 j = 0; j < run; j++)
+			_Buffer[i++] = sample;
+		pos += run * ratio;
+		TrueSamplePosition += run * (ratio >> 16);
 
-		(*(u64*)&pos) += ratio;
-		if ((pos[1] + ((PB.CurAddr - PB.StartAddr) >> 1)) >= PB.Length)
+		if ((u32)(pos >> 32) + played >= PB.Length)
 		{
 			PB.ReachedEnd = 1;
 			goto _lRestart;
 		}
 	}
 
-	if (PB.RemLength < pos[1])
+	if (PB.RemLength < (u32)(pos >> 32))
 	{
 		PB.RemLength = 0;
 		PB.ReachedEnd = 1;
 	}
 	else
 	{
-		PB.RemLength -= pos[1];
+		PB.RemLength -= (u32)(pos >> 32);
 	}
 
 	PB.CurSampleFrac = TrueSamplePosition & 0xFFFF;
@@ -122,7 +140,7 @@ inline u16 AddValueToReg(u32 ar, s32 ix)
 	return nar;
 }
 
-void ZeldaUCode::RenderSynth_WaveTable(ZeldaVoicePB &PB, s32* _Buffer, int _Size)
+void ZeldaUCode::RenderSynth_WaveTable(ZeldaVoicePB &PB, s32* _Buffer, int _Size, const s16* misc_table)
 {
 	u16 address;
 
@@ -156,18 +174,23 @@ void ZeldaUCode::RenderSynth_WaveTable(ZeldaVoicePB &PB, s32* _Buffer, int _Size
 	address = AddValueToReg(address, ((ACC0 >> 16) & 0xffff));
 	ACC0 &= 0xffff0000ffffULL;
 
+	// Each step adds less than the size of the wrapping (0x40 entries) to the
+	// address, so it simply wraps inside the table and the address of every
+	// sample follows from the total position, without carrying anything from
+	// one sample to the next.
+	u32 step = PB.RatioInt << 5;
+	u32 frac = ACC0 & 0xffff;
+	u16 table_base = address & ~0x3f;
 	for (int i = 0; i < 0x50; i++)
 	{
-		_Buffer[i] = m_misc_table[address];
-
-		ACC0 += PB.RatioInt << 5;
-		address = AddValueToReg(address, ((ACC0 >> 16) & 0xffff));
-
-		ACC0 &= 0xffff0000ffffULL;
+		u32 offset = (u32)((frac + (u64)i * step) >> 16);
+		_Buffer[i] = misc_table[table_base | ((address + offset) & 0x3f)];
 	}
 
+	u64 end_pos = frac + (u64)0x50 * step;
+	address = table_base | ((address + (u32)(end_pos >> 16)) & 0x3f);
+	ACC0 = (ACC0 & ~0xffffULL) | (end_pos & 0xffff);
+
 	ACC0 += address << 16;
 	PB.CurSampleFrac = (ACC0 >> 6) & 0xffff;
 }
-
-
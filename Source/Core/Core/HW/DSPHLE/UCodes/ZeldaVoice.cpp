@@ -561,7 +561,7 @@ void ZeldaUCode::RenderAddVoice(ZeldaVoicePB &PB, s32* _LeftBuffer, s32* _RightB
 		case 0x0007: // Example: "success" SFX in Pikmin 1, Pikmin 2 in a cave, not sure what sound it is.
 		case 0x000b: // Example: SFX in area selection menu in Pikmin
 		case 0x000c: // Example: beam of death/yellow force-field in Temple of the Gods, ZWW
-			RenderSynth_WaveTable(PB, m_voice_buffer, _Size);
+			RenderSynth_WaveTable(PB, m_voice_buffer, _Size, m_misc_table);
 			break;
 
 		default:
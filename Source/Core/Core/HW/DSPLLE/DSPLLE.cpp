@@ -2,7 +2,8 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
-#include "Common/Atomic.h"
+#include <algorithm>
+
 #include "Common/ChunkFile.h"
 #include "Common/Common.h"
 #include "Common/CommonPaths.h"
@@ -12,6 +13,7 @@
 #include "Common/LogManager.h"
 #include "Common/StdMutex.h"
 #include "Common/StdThread.h"
+#include "Common/StringUtil.h"
 
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
@@ -24,16 +26,26 @@
 #include "Core/DSP/DSPTables.h"
 #include "Core/HW/AudioInterface.h"
 #include "Core/HW/Memmap.h"
+#include "Core/HW/SystemTimers.h"
 
 #include "Core/HW/DSPLLE/DSPLLE.h"
 #include "Core/HW/DSPLLE/DSPLLEGlobals.h"
 #include "Core/HW/DSPLLE/DSPSymbols.h"
 
 
+// The JIT keeps the cycles left in 16 bits, so the DSP thread never runs
+// more than this in one go.
+static const u32 MAX_THREAD_SLICE = 0x8000;
+
 DSPLLE::DSPLLE()
+	: m_cycle_count(0)
 {
 	m_bIsRunning = false;
-	m_cycle_count = 0;
+	m_max_skew = 0;
+	m_sync_points = 0;
+	m_skew_waits = 0;
+	m_peak_skew = 0;
+	m_stats_ticks = 0;
 }
 
 Common::Event dspEvent;
@@ -76,7 +88,9 @@ void DSPLLE::DoState(PointerWrap &p)
 	p.DoArray(g_dsp.dram, DSP_DRAM_SIZE);
 	p.Do(cyclesLeft);
 	p.Do(init_hax);
-	p.Do(m_cycle_count);
+	u32 cycle_count = m_cycle_count.load();
+	p.Do(cycle_count);
+	m_cycle_count.store(cycle_count);
 }
 
 // Regular thread
@@ -86,19 +100,24 @@ void DSPLLE::dsp_thread(DSPLLE *dsp_lle)
 
 	while (dsp_lle->m_bIsRunning)
 	{
-		int cycles = (int)dsp_lle->m_cycle_count;
+		u32 cycles = std::min(dsp_lle->m_cycle_count.load(), MAX_THREAD_SLICE);
 		if (cycles > 0)
 		{
-			std::lock_guard<std::mutex> lk(dsp_lle->m_csDSPThreadActive);
-			if (dspjit)
-			{
-				DSPCore_RunCycles(cycles);
-			}
-			else
 			{
-				DSPInterpreter::RunCyclesThread(cycles);
+				std::lock_guard<std::mutex> lk(dsp_lle->m_csDSPThreadActive);
+				if (dspjit)
+				{
+					DSPCore_RunCycles(cycles);
+				}
+				else
+				{
+					DSPInterpreter::RunCyclesThread(cycles);
+				}
 			}
-			Common::AtomicStore(dsp_lle->m_cycle_count, 0);
+			// The CPU thread adds to this while we run
+			dsp_lle->m_cycle_count.fetch_sub(cycles);
+			// It may be waiting at a sync point or for the skew limit
+			ppcEvent.Set();
 		}
 		else
 		{
@@ -112,6 +131,7 @@ bool DSPLLE::Initialize(void *hWnd, bool bWii, bool bDSPThread)
 {
 	m_bWii = bWii;
 	m_bDSPThread = bDSPThread;
+	m_max_skew = (u32)std::max(SConfig::GetInstance().m_DSPMaxSkew, 0);
 
 	std::string irom_file = File::GetUserPath(D_GCUSER_IDX) + DSP_IROM;
 	std::string coef_file = File::GetUserPath(D_GCUSER_IDX) + DSP_COEF;
@@ -149,6 +169,8 @@ void DSPLLE::DSP_StopSoundStream()
 		ppcEvent.Set();
 		dspEvent.Set();
 		m_hDSPThread.join();
+		if (m_max_skew && !m_thread_stats.empty())
+			NOTICE_LOG(DSPLLE, "DSP thread: %s", m_thread_stats.c_str());
 	}
 }
 
@@ -159,6 +181,7 @@ void DSPLLE::Shutdown()
 
 u16 DSPLLE::DSP_WriteControlRegister(u16 _uFlag)
 {
+	SyncDSPThread();
 	DSPInterpreter::WriteCR(_uFlag);
 
 	// Check if the CPU has set an external interrupt (CR_EXTERNAL_INT)
@@ -182,11 +205,15 @@ u16 DSPLLE::DSP_WriteControlRegister(u16 _uFlag)
 
 u16 DSPLLE::DSP_ReadControlRegister()
 {
+	SyncDSPThread();
 	return DSPInterpreter::ReadCR();
 }
 
 u16 DSPLLE::DSP_ReadMailBoxHigh(bool _CPUMailbox)
 {
+	// Games poll the high half until mail shows up, the low half is only
+	// read once it has.
+	SyncDSPThread();
 	if (_CPUMailbox)
 		return gdsp_mbox_read_h(GDSP_MBOX_CPU);
 	else
@@ -269,14 +296,56 @@ void DSPLLE::DSP_Update(int cycles)
 	}
 	else
 	{
-		// Wait for dsp thread to complete its cycle. Note: this logic should be thought through.
-		ppcEvent.Wait();
-		Common::AtomicStore(m_cycle_count, dsp_cycles);
+		// In lock-step the DSP thread has to finish the previous slice before
+		// it gets the next one. Decoupled, it only has to stay within the skew.
+		if (m_cycle_count.load() > m_max_skew)
+		{
+			m_skew_waits++;
+			while (m_cycle_count.load() > m_max_skew && m_bIsRunning)
+				ppcEvent.Wait();
+		}
+		u32 skew = m_cycle_count.fetch_add(dsp_cycles) + dsp_cycles;
+		m_peak_skew = std::max(m_peak_skew, skew);
 		dspEvent.Set();
+		UpdateThreadStats(cycles);
+	}
+}
+
+void DSPLLE::SyncDSPThread()
+{
+	// Lock-step never lets the DSP thread get further behind than a slice
+	if (!m_bDSPThread || !m_max_skew)
+		return;
 
+	m_sync_points++;
+	while (m_cycle_count.load() > 0 && m_bIsRunning)
+	{
+		dspEvent.Set();
+		ppcEvent.Wait();
 	}
 }
 
+void DSPLLE::UpdateThreadStats(int cycles)
+{
+	// Counted in emulated time, so the numbers don't depend on the host speed
+	m_stats_ticks += cycles;
+	if (m_stats_ticks < SystemTimers::GetTicksPerSecond())
+		return;
+
+	m_thread_stats = StringFromFormat("%u sync points/s, %u skew waits/s, peak skew %u cycles",
+	                                  m_sync_points, m_skew_waits, m_peak_skew);
+	INFO_LOG(DSPLLE, "DSP thread: %s", m_thread_stats.c_str());
+	m_stats_ticks = 0;
+	m_sync_points = 0;
+	m_skew_waits = 0;
+	m_peak_skew = 0;
+}
+
+std::string DSPLLE::GetThreadStats() const
+{
+	return m_thread_stats;
+}
+
 u32 DSPLLE::DSP_UpdateRate()
 {
 	return 12600; // TO BE TWEAKED
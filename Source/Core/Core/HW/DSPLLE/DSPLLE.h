@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <string>
+
 #include "Common/Thread.h"
 
 #include "Core/DSPEmulator.h"
@@ -31,13 +34,34 @@ public:
 	virtual void DSP_StopSoundStream() override;
 	virtual u32 DSP_UpdateRate() override;
 
+	// Sync points, waits for the skew limit and the largest skew seen over the
+	// last emulated second, when the DSP runs on its own thread. Only call it
+	// from the CPU thread or while it is paused.
+	std::string GetThreadStats() const;
+
 private:
 	static void dsp_thread(DSPLLE* lpParameter);
 
+	// Called from the CPU thread before it looks at state the DSP thread
+	// changes. Waits until the DSP thread has run all the cycles it was given.
+	void SyncDSPThread();
+	void UpdateThreadStats(int cycles);
+
 	std::thread m_hDSPThread;
 	std::mutex m_csDSPThreadActive;
 	bool m_bWii;
 	bool m_bDSPThread;
 	bool m_bIsRunning;
-	volatile u32 m_cycle_count;
+	// DSP cycles the CPU thread has handed out that the DSP thread hasn't run yet
+	std::atomic<u32> m_cycle_count;
+	// 0 for lock-step, otherwise the DSP thread runs decoupled and the CPU
+	// thread only waits for it at sync points or when it is this far behind.
+	u32 m_max_skew;
+
+	// Only touched by the CPU thread
+	u32 m_sync_points;
+	u32 m_skew_waits;
+	u32 m_peak_skew;
+	u32 m_stats_ticks;
+	std::string m_thread_stats;
 };
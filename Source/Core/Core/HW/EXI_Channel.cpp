@@ -8,6 +8,7 @@
 #include "Core/HW/EXI.h"
 #include "Core/HW/EXI_Channel.h"
 #include "Core/HW/EXI_Device.h"
+#include "Core/HW/Memmap.h"
 #include "Core/HW/MMIO.h"
 #include "Core/HW/ProcessorInterface.h"
 #include "Core/PowerPC/PowerPC.h"
@@ -130,7 +131,10 @@ void CEXIChannel::RegisterMMIO(MMIO::Mapping* mmio, u32 base)
 					// DMA
 					switch (m_Control.RW)
 					{
-						case EXI_READ: pDevice->DMARead (m_DMAMemoryAddress, m_DMALength); break;
+						case EXI_READ:
+							pDevice->DMARead(m_DMAMemoryAddress, m_DMALength);
+							Memory::MarkWritten(m_DMAMemoryAddress, m_DMALength);
+							break;
 						case EXI_WRITE: pDevice->DMAWrite(m_DMAMemoryAddress, m_DMALength); break;
 						default: _dbg_assert_msg_(EXPANSIONINTERFACE,0,"EXI DMA: Unknown transfer type %i", m_Control.RW);
 					}
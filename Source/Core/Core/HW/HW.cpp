@@ -7,6 +7,7 @@
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
+#include "Core/Rewind.h"
 #include "Core/State.h"
 #include "Core/HW/AudioInterface.h"
 #include "Core/HW/CPU.h"
@@ -33,6 +34,7 @@ namespace HW
 		SystemTimers::PreInit();
 
 		State::Init();
+		Rewind::Init();
 
 		// Init the whole Hardware
 		AudioInterface::Init();
@@ -71,39 +73,27 @@ namespace HW
 			WII_IPC_HLE_Interface::Shutdown();
 		}
 
+		Rewind::Shutdown();
 		State::Shutdown();
 		CoreTiming::Shutdown();
 	}
 
 	void DoState(PointerWrap &p)
 	{
-		Memory::DoState(p);
-		p.DoMarker("Memory");
-		VideoInterface::DoState(p);
-		p.DoMarker("VideoInterface");
-		SerialInterface::DoState(p);
-		p.DoMarker("SerialInterface");
-		ProcessorInterface::DoState(p);
-		p.DoMarker("ProcessorInterface");
-		DSP::DoState(p);
-		p.DoMarker("DSP");
-		DVDInterface::DoState(p);
-		p.DoMarker("DVDInterface");
-		GPFifo::DoState(p);
-		p.DoMarker("GPFifo");
-		ExpansionInterface::DoState(p);
-		p.DoMarker("ExpansionInterface");
-		AudioInterface::DoState(p);
-		p.DoMarker("AudioInterface");
+		p.DoSection("Memory", Memory::DoState);
+		p.DoSection("VideoInterface", VideoInterface::DoState);
+		p.DoSection("SerialInterface", SerialInterface::DoState);
+		p.DoSection("ProcessorInterface", ProcessorInterface::DoState);
+		p.DoSection("DSP", DSP::DoState);
+		p.DoSection("DVDInterface", DVDInterface::DoState);
+		p.DoSection("GPFifo", GPFifo::DoState);
+		p.DoSection("ExpansionInterface", ExpansionInterface::DoState);
+		p.DoSection("AudioInterface", AudioInterface::DoState);
 
 		if (SConfig::GetInstance().m_LocalCoreStartupParameter.bWii)
 		{
-			WII_IPCInterface::DoState(p);
-			p.DoMarker("WII_IPCInterface");
-			WII_IPC_HLE_Interface::DoState(p);
-			p.DoMarker("WII_IPC_HLE_Interface");
+			p.DoSection("WII_IPCInterface", WII_IPCInterface::DoState);
+			p.DoSection("WII_IPC_HLE_Interface", WII_IPC_HLE_Interface::DoState);
 		}
-
-		p.DoMarker("WIIHW");
 	}
 }
@@ -8,10 +8,16 @@
 // However, if a JITed instruction (for example lwz) wants to access a bad memory area that call
 // may be redirected here (for example to Read_U32()).
 
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <vector>
+
 #include "Common/ChunkFile.h"
 #include "Common/Common.h"
 #include "Common/MemArena.h"
 #include "Common/MemoryUtil.h"
+#include "Common/Timer.h"
 
 #include "Core/ConfigManager.h"
 #include "Core/Core.h"
@@ -163,9 +169,133 @@ void Init()
 	m_IsInitialized = true;
 }
 
+// Incremental states keep a copy of every saved memory region, taken by
+// ResetStateDeltaBase(). The state then only contains the pages that differ
+// from that copy, found by comparing the two.
+//
+// The comparison sees every writer. The write watch doesn't: DMA, the HLE
+// ucodes and IPC HLE write through the physical view without faulting, and
+// protecting that view would make syscalls that read straight into emulated
+// RAM (disc reads, for one) fail instead of faulting.
+static const u32 DELTA_PAGE_SIZE = 0x1000;
+
+struct StateRegion
+{
+	u8* data;
+	u32 size;
+};
+
+static bool s_delta_states = false;
+static u32 s_delta_base_id = 0;
+static std::vector<std::vector<u8>> s_delta_base;
+
+static std::vector<StateRegion> GetStateRegions()
+{
+	std::vector<StateRegion> regions;
+	regions.push_back({m_pPhysicalRAM, RAM_SIZE});
+	regions.push_back({m_pVirtualL1Cache, L1_CACHE_SIZE});
+	if (bFakeVMEM)
+		regions.push_back({m_pVirtualFakeVMEM, FAKEVMEM_SIZE});
+	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bWii)
+		regions.push_back({m_pEXRAM, EXRAM_SIZE});
+	return regions;
+}
+
+void SetStateDelta(bool delta)
+{
+	s_delta_states = delta;
+}
+
+void ResetStateDeltaBase()
+{
+	static u32 s_base_counter = 0;
+
+	std::vector<StateRegion> regions = GetStateRegions();
+	s_delta_base.resize(regions.size());
+	for (size_t i = 0; i < regions.size(); i++)
+		s_delta_base[i].assign(regions[i].data, regions[i].data + regions[i].size);
+
+	// Different every time, so states can't be applied to the wrong base.
+	s_delta_base_id = (u32)Common::Timer::GetTimeMs() ^ (++s_base_counter << 24);
+}
+
+bool HasStateDeltaBase()
+{
+	return !s_delta_base.empty();
+}
+
+static void FindChangedPages(const StateRegion& region, const std::vector<u8>& base, std::vector<u32>& pages)
+{
+	pages.clear();
+	for (u32 page = 0; page < region.size / DELTA_PAGE_SIZE; page++)
+	{
+		if (memcmp(region.data + page * DELTA_PAGE_SIZE, &base[page * DELTA_PAGE_SIZE], DELTA_PAGE_SIZE))
+			pages.push_back(page);
+	}
+}
+
+static void DoDeltaState(PointerWrap &p)
+{
+	const PointerWrap::Mode mode = p.GetMode();
+	std::vector<StateRegion> regions = GetStateRegions();
+
+	u32 base_id = s_delta_base_id;
+	p.Do(base_id);
+
+	if (mode == PointerWrap::MODE_READ || mode == PointerWrap::MODE_VERIFY)
+	{
+		if (s_delta_base.size() != regions.size() || base_id != s_delta_base_id)
+		{
+			ERROR_LOG(MEMMAP, "Incremental state doesn't belong to the current base state");
+			p.SetMode(PointerWrap::MODE_MEASURE);
+			return;
+		}
+	}
+
+	std::vector<u32> pages;
+	for (size_t i = 0; i < regions.size(); i++)
+	{
+		if (mode == PointerWrap::MODE_WRITE || mode == PointerWrap::MODE_MEASURE)
+			FindChangedPages(regions[i], s_delta_base[i], pages);
+		p.Do(pages);
+
+		if (mode == PointerWrap::MODE_READ)
+			memcpy(regions[i].data, &s_delta_base[i][0], regions[i].size);
+
+		for (u32 page : pages)
+		{
+			if (page >= regions[i].size / DELTA_PAGE_SIZE)
+			{
+				// Mark the state as broken, see State::DoState
+				p.SetMode(PointerWrap::MODE_MEASURE);
+				return;
+			}
+			p.DoArray(regions[i].data + page * DELTA_PAGE_SIZE, DELTA_PAGE_SIZE);
+		}
+	}
+}
+
 void DoState(PointerWrap &p)
 {
 	bool wii = SConfig::GetInstance().m_LocalCoreStartupParameter.bWii;
+
+	// Loading replaces all of memory, behind the write watch's back
+	if (p.GetMode() == PointerWrap::MODE_READ)
+	{
+		MarkWritten(0, RAM_SIZE);
+		if (wii)
+			MarkWritten(0x10000000, EXRAM_SIZE);
+	}
+
+	u8 delta = s_delta_states && HasStateDeltaBase();
+	p.Do(delta);
+	if (delta)
+	{
+		DoDeltaState(p);
+		p.DoMarker("Memory delta");
+		return;
+	}
+
 	p.DoArray(m_pPhysicalRAM, RAM_SIZE);
 	//p.DoArray(m_pVirtualEFB, EFB_SIZE);
 	p.DoArray(m_pVirtualL1Cache, L1_CACHE_SIZE);
@@ -180,17 +310,240 @@ void DoState(PointerWrap &p)
 
 void Shutdown()
 {
+	SetWriteWatch(false);
 	m_IsInitialized = false;
 	u32 flags = 0;
 	if (SConfig::GetInstance().m_LocalCoreStartupParameter.bWii) flags |= MV_WII_ONLY;
 	if (bFakeVMEM) flags |= MV_FAKE_VMEM;
 	MemoryMap_Shutdown(views, num_views, flags, &g_arena);
+	std::vector<std::vector<u8>>().swap(s_delta_base);
 	g_arena.ReleaseSpace();
 	base = nullptr;
 	delete mmio_mapping;
 	INFO_LOG(MEMMAP, "Memory system shut down.");
 }
 
+// Write watch state. The page tables hold the RAM pages first, then the
+// EXRAM pages. s_watch_lock keeps WatchRange from protecting a page while
+// the fault handler unprotects it on another thread; it is a spin lock
+// because it is taken inside the fault handler.
+static const u32 WATCH_PAGE_SHIFT = 12;
+static const u32 WATCH_PAGE_SIZE = 1 << WATCH_PAGE_SHIFT;
+static const u32 WATCH_RAM_PAGES = RAM_SIZE >> WATCH_PAGE_SHIFT;
+static const u32 WATCH_PAGES = WATCH_RAM_PAGES + (EXRAM_SIZE >> WATCH_PAGE_SHIFT);
+
+// Changed by the texture cache on the GPU thread and at shutdown, read by the
+// CPU thread, the DMA paths and the fault handler
+std::atomic<bool> bWriteWatch(false);
+static std::atomic<u64> s_write_seq;
+static std::unique_ptr<std::atomic<u64>[]> s_page_write_seq;
+static std::unique_ptr<std::atomic<bool>[]> s_page_watched;
+static std::atomic_flag s_watch_lock = ATOMIC_FLAG_INIT;
+
+// Page of a physical or effective address, or -1 if it is not in RAM/EXRAM
+static int GetWatchPage(u32 address)
+{
+	const u32 offset = address & 0x0FFFFFFF;
+	switch (address >> 28)
+	{
+	case 0x0:
+	case 0x8:
+	case 0xC:
+		if (offset < RAM_SIZE)
+			return offset >> WATCH_PAGE_SHIFT;
+		return -1;
+	case 0x1:
+	case 0x9:
+	case 0xD:
+		if (offset < EXRAM_SIZE && SConfig::GetInstance().m_LocalCoreStartupParameter.bWii)
+			return WATCH_RAM_PAGES + (offset >> WATCH_PAGE_SHIFT);
+		return -1;
+	default:
+		return -1;
+	}
+}
+
+static bool GetWatchPages(u32 address, u32 size, int* first, int* last)
+{
+	if (size == 0)
+		return false;
+	*first = GetWatchPage(address);
+	*last = GetWatchPage(address + size - 1);
+	// Ranges crossing from RAM into something else are not tracked
+	return *first >= 0 && *last >= *first &&
+	       (*first < (int)WATCH_RAM_PAGES) == (*last < (int)WATCH_RAM_PAGES);
+}
+
+// Only the mirrors the CPU writes through are protected. The physical view
+// stays writable, so DMA, DVD reads and HLE syscalls never fault and report
+// their writes with MarkWritten instead.
+static void ProtectWatchPage(u32 page, bool protect)
+{
+	u8* mirrors[2];
+	if (page < WATCH_RAM_PAGES)
+	{
+		mirrors[0] = m_pVirtualCachedRAM + (page << WATCH_PAGE_SHIFT);
+		mirrors[1] = m_pVirtualUncachedRAM + (page << WATCH_PAGE_SHIFT);
+	}
+	else
+	{
+		mirrors[0] = m_pVirtualCachedEXRAM + ((page - WATCH_RAM_PAGES) << WATCH_PAGE_SHIFT);
+		mirrors[1] = m_pVirtualUncachedEXRAM + ((page - WATCH_RAM_PAGES) << WATCH_PAGE_SHIFT);
+	}
+
+	for (u8* mirror : mirrors)
+	{
+		if (protect)
+			WriteProtectMemory(mirror, WATCH_PAGE_SIZE);
+		else
+			UnWriteProtectMemory(mirror, WATCH_PAGE_SIZE);
+	}
+}
+
+static void LockWatch()
+{
+	while (s_watch_lock.test_and_set(std::memory_order_acquire)) {}
+}
+
+static void UnlockWatch()
+{
+	s_watch_lock.clear(std::memory_order_release);
+}
+
+void SetWriteWatch(bool enable)
+{
+#if _M_X86_64
+	// Needs the fastmem fault handler to see the CPU's writes
+	enable = enable && m_IsInitialized && SConfig::GetInstance().m_LocalCoreStartupParameter.bFastmem;
+#else
+	enable = false;
+#endif
+	if (enable == bWriteWatch)
+		return;
+
+	if (enable)
+	{
+		if (!s_page_write_seq)
+		{
+			s_page_write_seq.reset(new std::atomic<u64>[WATCH_PAGES]);
+			s_page_watched.reset(new std::atomic<bool>[WATCH_PAGES]);
+		}
+		for (u32 i = 0; i < WATCH_PAGES; ++i)
+		{
+			s_page_write_seq[i] = 0;
+			s_page_watched[i] = false;
+		}
+		// Sequence number 0 means "never watched"
+		s_write_seq = 1;
+		bWriteWatch = true;
+	}
+	else
+	{
+		// Unprotect first, a store to a page that is still protected needs the
+		// fault handler to see the watch enabled
+		LockWatch();
+		for (u32 i = 0; i < WATCH_PAGES; ++i)
+		{
+			if (s_page_watched[i])
+			{
+				s_page_watched[i] = false;
+				ProtectWatchPage(i, false);
+			}
+		}
+		UnlockWatch();
+		bWriteWatch = false;
+	}
+}
+
+bool IsWriteWatchEnabled()
+{
+	return bWriteWatch;
+}
+
+u64 WatchRange(u32 address, u32 size)
+{
+	int first, last;
+	if (!bWriteWatch || !GetWatchPages(address, size, &first, &last))
+		return 0;
+
+	// Read the sequence number first, so a write racing with us always ends
+	// up newer than what the caller gets back
+	const u64 seq = s_write_seq;
+	LockWatch();
+	for (int i = first; i <= last; ++i)
+	{
+		if (!s_page_watched[i])
+		{
+			s_page_watched[i] = true;
+			ProtectWatchPage(i, true);
+		}
+	}
+	UnlockWatch();
+	return seq;
+}
+
+bool IsRangeUnchanged(u32 address, u32 size, u64 seq)
+{
+	int first, last;
+	if (!bWriteWatch || seq == 0 || !GetWatchPages(address, size, &first, &last))
+		return false;
+
+	for (int i = first; i <= last; ++i)
+	{
+		if (!s_page_watched[i] || s_page_write_seq[i] > seq)
+			return false;
+	}
+	return true;
+}
+
+void MarkWritten(u32 address, u32 size)
+{
+	int first, last;
+	if (!bWriteWatch || !GetWatchPages(address, size, &first, &last))
+		return;
+
+	const u64 seq = ++s_write_seq;
+	for (int i = first; i <= last; ++i)
+		s_page_write_seq[i] = seq;
+}
+
+bool HandleWriteWatchFault(uintptr_t fault_address)
+{
+	if (!bWriteWatch)
+		return false;
+
+	const struct
+	{
+		u8* mirror;
+		u32 size;
+		u32 first_page;
+	} mirrors[] = {
+		{ m_pVirtualCachedRAM, RAM_SIZE, 0 },
+		{ m_pVirtualUncachedRAM, RAM_SIZE, 0 },
+		{ m_pVirtualCachedEXRAM, EXRAM_SIZE, WATCH_RAM_PAGES },
+		{ m_pVirtualUncachedEXRAM, EXRAM_SIZE, WATCH_RAM_PAGES },
+	};
+	for (const auto& m : mirrors)
+	{
+		const uintptr_t start = (uintptr_t)m.mirror;
+		if (!m.mirror || fault_address < start || fault_address - start >= m.size)
+			continue;
+
+		const u32 page = m.first_page + (u32)((fault_address - start) >> WATCH_PAGE_SHIFT);
+		LockWatch();
+		s_page_write_seq[page] = ++s_write_seq;
+		if (s_page_watched[page])
+		{
+			s_page_watched[page] = false;
+			ProtectWatchPage(page, false);
+		}
+		UnlockWatch();
+		// The faulting store is simply executed again
+		return true;
+	}
+	return false;
+}
+
 void Clear()
 {
 	if (m_pRAM)
@@ -219,6 +572,7 @@ u32 Read_Instruction(const u32 em_address)
 void WriteBigEData(const u8 *_pData, const u32 _Address, const size_t _iSize)
 {
 	memcpy(GetPointer(_Address), _pData, _iSize);
+	MarkWritten(_Address, (u32)_iSize);
 }
 
 void Memset(const u32 _Address, const u8 _iValue, const u32 _iLength)
@@ -227,6 +581,7 @@ void Memset(const u32 _Address, const u8 _iValue, const u32 _iLength)
 	if (ptr != nullptr)
 	{
 		memset(ptr,_iValue,_iLength);
+		MarkWritten(_Address, _iLength);
 	}
 	else
 	{
@@ -243,6 +598,7 @@ void DMA_LCToMemory(const u32 _MemAddr, const u32 _CacheAddr, const u32 _iNumBlo
 	if ((dst != nullptr) && (src != nullptr) && (_MemAddr & 3) == 0 && (_CacheAddr & 3) == 0)
 	{
 		memcpy(dst, src, 32 * _iNumBlocks);
+		MarkWritten(_MemAddr, 32 * _iNumBlocks);
 	}
 	else
 	{
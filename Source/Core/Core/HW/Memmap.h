@@ -83,6 +83,31 @@ void Init();
 void Shutdown();
 void DoState(PointerWrap &p);
 
+// Incremental savestates, see State::SaveIncrementalToBuffer.
+// While enabled, DoState only stores the pages that changed since the base.
+void SetStateDelta(bool delta);
+void ResetStateDeltaBase();
+bool HasStateDeltaBase();
+
+// Write watch, used by the texture cache to skip rehashing textures nobody
+// wrote to. Watched pages are write protected in the CPU's views of RAM
+// (0x80000000/0xC0000000 and their EXRAM counterparts), so JIT stores to
+// them fault and get recorded by HandleWriteWatchFault. Everything else
+// writes through the physical view, which stays writable so that syscalls
+// can still read into emulated RAM, and has to call MarkWritten instead.
+// Needs the fastmem exception handler, so it only turns on with fastmem.
+void SetWriteWatch(bool enable);
+bool IsWriteWatchEnabled();
+// Starts watching the pages of a physical range. Returns a write sequence
+// number for IsRangeUnchanged, or 0 if the range can't be watched.
+u64 WatchRange(u32 address, u32 size);
+// True if nothing wrote to the range since WatchRange returned seq
+bool IsRangeUnchanged(u32 address, u32 size, u64 seq);
+// Records a write that didn't go through the CPU's views. Call it after the
+// data has been written.
+void MarkWritten(u32 address, u32 size);
+bool HandleWriteWatchFault(uintptr_t fault_address);
+
 void Clear();
 bool AreMemoryBreakpointsActivated();
 
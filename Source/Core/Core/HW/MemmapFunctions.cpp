@@ -15,6 +15,8 @@
 // Official Git repository and contact information can be found at
 // http://code.google.com/p/dolphin-emu/
 
+#include <atomic>
+
 #include "Common/Atomic.h"
 #include "Common/Common.h"
 
@@ -61,6 +63,7 @@ extern u8 *m_pEFB;
 // Init
 extern bool m_IsInitialized;
 extern bool bFakeVMEM;
+extern std::atomic<bool> bWriteWatch;
 
 // Overloaded byteswap functions, for use within the templated functions below.
 inline u8 bswap(u8 val)   {return val;}
@@ -188,6 +191,8 @@ inline void WriteToHardware(u32 em_address, const T data, u32 effective_address,
 		((em_address & 0xF0000000) == 0x00000000))
 	{
 		*(T*)&m_pRAM[em_address & RAM_MASK] = bswap(data);
+		if (bWriteWatch)
+			MarkWritten(em_address, sizeof(T));
 		return;
 	}
 	else if (((em_address & 0xF0000000) == 0x90000000) ||
@@ -195,6 +200,8 @@ inline void WriteToHardware(u32 em_address, const T data, u32 effective_address,
 		((em_address & 0xF0000000) == 0x10000000))
 	{
 		*(T*)&m_pEXRAM[em_address & EXRAM_MASK] = bswap(data);
+		if (bWriteWatch)
+			MarkWritten(em_address, sizeof(T));
 		return;
 	}
 	else if ((em_address >= 0xE0000000) && (em_address < (0xE0000000+L1_CACHE_SIZE)))
@@ -222,6 +229,8 @@ inline void WriteToHardware(u32 em_address, const T data, u32 effective_address,
 		else
 		{
 			*(T*)&m_pRAM[tlb_addr & RAM_MASK] = bswap(data);
+			if (bWriteWatch)
+				MarkWritten(tlb_addr, sizeof(T));
 		}
 	}
 }
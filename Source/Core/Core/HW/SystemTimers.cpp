@@ -158,6 +158,7 @@ void AudioDMACallback(u64 userdata, int cyclesLate)
 	int fields = VideoInterface::GetNumFields();
 	int period = CPU_CORE_CLOCK / (AudioInterface::GetAIDSampleRate() * 4 / 32 * fields);
 	DSP::UpdateAudioDMA();  // Push audio to speakers.
+	AudioInterface::UpdateStreaming();
 	CoreTiming::ScheduleEvent(period - cyclesLate, et_AudioDMA);
 }
 
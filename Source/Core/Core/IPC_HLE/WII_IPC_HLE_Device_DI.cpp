@@ -182,6 +182,7 @@ u32 CWII_IPC_HLE_Device_di::ExecuteCommand(u32 _BufferIn, u32 _BufferInSize, u32
 	case DVDLowReadDiskID:
 		{
 			VolumeHandler::RAWReadToPtr(Memory::GetPointer(_BufferOut), 0, _BufferOutSize);
+			Memory::MarkWritten(_BufferOut, _BufferOutSize);
 
 			INFO_LOG(WII_IPC_DVD, "DVDLowReadDiskID %s",
 				ArrayToString(Memory::GetPointer(_BufferOut), _BufferOutSize, _BufferOutSize).c_str());
@@ -225,6 +226,7 @@ u32 CWII_IPC_HLE_Device_di::ExecuteCommand(u32 _BufferIn, u32 _BufferInSize, u32
 			{
 				PanicAlertT("DVDLowRead - Fatal Error: failed to read from volume");
 			}
+			Memory::MarkWritten(_BufferOut, Size);
 		}
 		break;
 
@@ -318,6 +320,7 @@ u32 CWII_IPC_HLE_Device_di::ExecuteCommand(u32 _BufferIn, u32 _BufferInSize, u32
 			{
 				PanicAlertT("DVDLowUnencryptedRead - Fatal Error: failed to read from volume");
 			}
+			Memory::MarkWritten(_BufferOut, Size);
 		}
 		break;
 
@@ -332,8 +332,10 @@ void Interpreter::srawx(UGeckoInstruction _inst)
 		}
 		else
 		{
-			m_GPR[_inst.RA] = (u32)((s32)m_GPR[_inst.RS] >> amount);
-			if (m_GPR[_inst.RS] & 0x80000000)
+			s32 rrs = m_GPR[_inst.RS];
+			m_GPR[_inst.RA] = rrs >> amount;
+
+			if ((rrs < 0) && (rrs << (32 - amount)))
 				SetCarry(1);
 			else
 				SetCarry(0);
@@ -437,7 +439,8 @@ void Interpreter::addmex(UGeckoInstruction _inst)
 	int carry = GetCarry();
 	int a = m_GPR[_inst.RA];
 	m_GPR[_inst.RD] = a + carry - 1;
-	SetCarry(Helper_Carry(a, carry - 1));
+	// a + carry + 0xFFFFFFFF only stays below 2^32 if both are zero
+	SetCarry(a != 0 || carry);
 
 	if (_inst.OE) PanicAlert("OE: addmex");
 	if (_inst.Rc) Helper_UpdateCR0(m_GPR[_inst.RD]);
@@ -569,7 +572,7 @@ void Interpreter::subfmex(UGeckoInstruction _inst)
 	u32 a = m_GPR[_inst.RA];
 	int carry = GetCarry();
 	m_GPR[_inst.RD] = (~a) + carry - 1;
-	SetCarry(Helper_Carry(~a, carry - 1));
+	SetCarry(~a != 0 || carry);
 
 	if (_inst.OE) PanicAlert("OE: subfmex");
 	if (_inst.Rc) Helper_UpdateCR0(m_GPR[_inst.RD]);
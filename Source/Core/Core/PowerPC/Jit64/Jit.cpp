@@ -171,6 +171,11 @@ void Jit64::Init()
 	jo.optimizeGatherPipe = true;
 	jo.fastInterrupts = false;
 	jo.accurateSinglePrecision = true;
+#if _M_X86_64
+	jo.carryRegisters = jo.enableBlocklink && Core::g_CoreStartupParameter.bJITCarryRegisters;
+#else
+	jo.carryRegisters = false;
+#endif
 	js.memcheck = Core::g_CoreStartupParameter.bMMU;
 
 	gpr.SetEmitter(this);
@@ -180,12 +185,22 @@ void Jit64::Init()
 	AllocCodeSpace(CODE_SIZE);
 
 	blocks.Init();
+	PPCTables::ResetFallbackCounts();
 	asm_routines.Init();
 
 	code_block.m_stats = &js.st;
 	code_block.m_gpa = &js.gpa;
 	code_block.m_fpa = &js.fpa;
 	analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_CONDITIONAL_CONTINUE);
+
+	// Compile functions as regions: small leaf functions get inlined at their
+	// bl and forward branches stay inside the block.
+	if (Core::g_CoreStartupParameter.bJITRegions && !Core::g_CoreStartupParameter.bEnableDebugging &&
+	    !Core::g_CoreStartupParameter.bMMU)
+	{
+		analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_LEAF_INLINE);
+		analyzer.SetOption(PPCAnalyst::PPCAnalyzer::OPTION_FORWARD_JUMP);
+	}
 }
 
 void Jit64::ClearCache()
@@ -197,6 +212,14 @@ void Jit64::ClearCache()
 
 void Jit64::Shutdown()
 {
+	std::string fallbacks = PPCTables::GetFallbackReport();
+	NOTICE_LOG(DYNA_REC, "%s", fallbacks.c_str());
+	if (jo.carryRegisters)
+	{
+		NOTICE_LOG(DYNA_REC, "Carried registers on %u linked exits, saving %u loads and %u stores per pass",
+		           blocks.GetCarriedLinks(), blocks.GetCarriedLoads(), blocks.GetCarriedStores());
+	}
+
 	FreeCodeSpace();
 
 	blocks.Shutdown();
@@ -225,6 +248,18 @@ void Jit64::unknown_instruction(UGeckoInstruction inst)
 
 void Jit64::FallBackToInterpreter(UGeckoInstruction _inst)
 {
+	GekkoOPInfo *info = GetOpInfo(_inst);
+	if (info)
+	{
+		// A single fallback in a hot loop matters more than lots of them in code
+		// that runs once, so count the calls as well when profiling.
+		info->fallbackCompileCount++;
+		if (Profiler::g_ProfileBlocks)
+		{
+			ADD(32, M(&info->fallbackRunCount), Imm8(1));
+			ADC(32, M((u8*)&info->fallbackRunCount + 4), Imm8(0));
+		}
+	}
 	WriteCallInterpreter(_inst.hex);
 }
 
@@ -269,6 +304,39 @@ static void ImHere()
 	been_here[PC] = 1;
 }
 
+// The registers a block without a hint from its predecessors keeps in host
+// registers across linked exits: the most used ones it touches at least twice.
+static u32 ChooseCarriedRegisters(PPCAnalyst::BlockRegStats &stats, int max)
+{
+	u32 carried = 0;
+	for (int n = 0; n < max; n++)
+	{
+		int best = -1;
+		for (int i = 0; i < 32; i++)
+		{
+			if (!(carried & (1u << i)) && stats.GetTotalNumAccesses(i) >= 2 &&
+			    (best < 0 || stats.GetTotalNumAccesses(i) > stats.GetTotalNumAccesses(best)))
+				best = i;
+		}
+		if (best < 0)
+			break;
+		carried |= 1u << best;
+	}
+	return carried;
+}
+
+// After this many mismatches a block stops assuming constant GQRs.
+static const int MAX_GQR_GUARD_FAILURES = 2;
+
+// Called when a block is entered with a GQR that differs from the one it was
+// compiled for. Drops the block so the dispatcher compiles it again.
+static void GQRGuardFailed(u32 address)
+{
+	int failures = ++jit->js.gqrGuardFailures[address];
+	DEBUG_LOG(DYNA_REC, "GQR changed since block %08x was compiled (%d times)", address, failures);
+	jit->GetBlockCache()->InvalidateICache(address, 4);
+}
+
 void Jit64::Cleanup()
 {
 	if (jo.optimizeGatherPipe && js.fifoBytesThisBlock > 0)
@@ -281,8 +349,17 @@ void Jit64::Cleanup()
 		ABI_CallFunctionCCC((void *)&PowerPC::UpdatePerformanceMonitor, js.downcountAmount, jit->js.numLoadStoreInst, jit->js.numFloatingPointInst);
 }
 
+// After a FLUSH_KEEP_CARRIED flush the carried registers are still in host
+// registers. If the destination block carries the same ones, the exit jumps
+// straight to its linked entry and they stay there. Every other path writes
+// them back first. Exits that have to call a function always write them back,
+// Cleanup() doesn't preserve anything.
 void Jit64::WriteExit(u32 destination)
 {
+	bool carry = gpr.CanCarry() && !(jo.optimizeGatherPipe && js.fifoBytesThisBlock > 0) && !MMCR0.Hex && !MMCR1.Hex;
+	if (!carry)
+		gpr.WriteBackCarried();
+
 	Cleanup();
 
 	SUB(32, M(&CoreTiming::downcount), js.downcountAmount > 127 ? Imm32(js.downcountAmount) : Imm8(js.downcountAmount));
@@ -291,12 +368,34 @@ void Jit64::WriteExit(u32 destination)
 	JitBlock *b = js.curBlock;
 	JitBlock::LinkData linkData;
 	linkData.exitAddress = destination;
-	linkData.exitPtrs = GetWritableCodePtr();
 	linkData.linkStatus = false;
 
+	int block = jo.enableBlocklink ? blocks.GetBlockNumberFromStartAddress(destination) : -1;
+	if (carry)
+	{
+		// The linked entry checks the flags of the SUB above.
+		const JitBlock *dest = block >= 0 ? blocks.GetBlock(block) : nullptr;
+		linkData.carriedStores = gpr.NumDirtyCarried();
+		linkData.carryPtr = GetWritableCodePtr();
+		linkData.carryUnlinked = linkData.carryPtr + 5;
+		if (dest && dest->linkedEntry && dest->carriedRegs == gpr.GetCarried())
+		{
+			JMP(dest->linkedEntry, true);
+			linkData.linkStatus = true;
+			blocks.CountCarriedLink(*b, *dest, linkData);
+		}
+		else
+		{
+			JMP(linkData.carryUnlinked, true);
+		}
+		gpr.WriteBackCarried();
+		js.carryHints.insert(std::make_pair(destination, gpr.GetCarried()));
+	}
+
+	linkData.exitPtrs = GetWritableCodePtr();
+
 	// Link opportunity!
-	int block;
-	if (jo.enableBlocklink && (block = blocks.GetBlockNumberFromStartAddress(destination)) >= 0)
+	if (block >= 0 && !linkData.linkStatus)
 	{
 		// It exists! Joy of joy!
 		JMP(blocks.GetBlock(block)->checkedEntry, true);
@@ -313,6 +412,7 @@ void Jit64::WriteExit(u32 destination)
 
 void Jit64::WriteExitDestInEAX()
 {
+	gpr.WriteBackCarried();
 	MOV(32, M(&PC), R(EAX));
 	Cleanup();
 	SUB(32, M(&CoreTiming::downcount), js.downcountAmount > 127 ? Imm32(js.downcountAmount) : Imm8(js.downcountAmount));
@@ -321,6 +421,7 @@ void Jit64::WriteExitDestInEAX()
 
 void Jit64::WriteRfiExitDestInEAX()
 {
+	gpr.WriteBackCarried();
 	MOV(32, M(&PC), R(EAX));
 	MOV(32, M(&NPC), R(EAX));
 	Cleanup();
@@ -331,6 +432,7 @@ void Jit64::WriteRfiExitDestInEAX()
 
 void Jit64::WriteExceptionExit()
 {
+	gpr.WriteBackCarried();
 	Cleanup();
 	MOV(32, R(EAX), M(&PC));
 	MOV(32, M(&NPC), R(EAX));
@@ -339,8 +441,40 @@ void Jit64::WriteExceptionExit()
 	JMP(asm_routines.dispatcher, true);
 }
 
+void Jit64::WriteIdleExit(u32 destination)
+{
+	PowerPC::RegisterIdleLoop(destination);
+
+	// Skip straight to the next event instead of spinning through the loop,
+	// then restart the loop in case that event didn't end the wait.
+	ABI_CallFunctionC((void *)&PowerPC::OnIdleLoop, destination);
+	MOV(32, M(&PC), Imm32(destination));
+	WriteExceptionExit();
+}
+
+// Callers flush everything before testing their condition, the target op
+// expects all registers in memory.
+void Jit64::WriteForwardJump()
+{
+	forward_jumps.push_back(std::make_pair(js.op->branchToIndex, J(true)));
+}
+
+bool Jit64::CanMergeNextInstructions(int count) const
+{
+	if (js.instructionNumber + count >= js.blockSize)
+		return false;
+	// Jumps within the block would skip the merged part
+	for (int i = 1; i <= count; i++)
+	{
+		if (js.op[i].isBranchTarget)
+			return false;
+	}
+	return true;
+}
+
 void Jit64::WriteExternalExceptionExit()
 {
+	gpr.WriteBackCarried();
 	Cleanup();
 	MOV(32, R(EAX), M(&PC));
 	MOV(32, M(&NPC), R(EAX));
@@ -454,6 +588,60 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 
 	PPCAnalyst::CodeOp *ops = code_buf->codebuffer;
 
+	// Quantized loads and stores are compiled for the GQR values seen now, as long
+	// as the block doesn't change them itself. Blocks that keep being entered
+	// with different values go back to looking the GQR up at runtime.
+	js.constantGqr = 0;
+	const u8 *gqrFailure = nullptr;
+	if (!memory_exception && !js.memcheck && !Core::g_CoreStartupParameter.bJITOff &&
+	    !Core::g_CoreStartupParameter.bJITLoadStorePairedOff)
+	{
+		auto failures = js.gqrGuardFailures.find(em_address);
+		if (failures == js.gqrGuardFailures.end() || failures->second < MAX_GQR_GUARD_FAILURES)
+			js.constantGqr = code_block.m_gqr_used & ~code_block.m_gqr_modified;
+	}
+	if (js.constantGqr)
+	{
+		gqrFailure = AlignCode4();
+		MOV(32, M(&PC), Imm32(js.blockStart));
+		ABI_CallFunctionC((void *)&GQRGuardFailed, js.blockStart);
+		JMP(asm_routines.dispatcher, true);
+	}
+
+	// Hot registers stay in host registers across linked exits. The first
+	// block exiting to an address decides which ones, so that loops spanning
+	// several blocks agree on them.
+	u32 carried = 0;
+	if (jo.carryRegisters && !memory_exception && !js.constantGqr && !Profiler::g_ProfileBlocks && !ImHereDebug)
+	{
+		auto hint = js.carryHints.find(em_address);
+		if (hint != js.carryHints.end())
+			carried = hint->second;
+		else
+			carried = ChooseCarriedRegisters(js.gpa, gpr.GetMaxCarried());
+	}
+	gpr.SetCarried(carried);
+	carried = gpr.GetCarried();
+
+	FixupBranch linkedBody;
+	if (carried)
+	{
+		// Entered from blocks carrying the same registers, with the flags of
+		// their downcount update. Before timing they have to be written back.
+		b->linkedEntry = AlignCode4();
+		b->carriedRegs = carried;
+		FixupBranch linkedSkip = J_CC(CC_NBE);
+		for (int i = 0; i < 32; i++)
+		{
+			if (carried & (1u << i))
+				MOV(32, M(&PowerPC::ppcState.gpr[i]), R(gpr.GetCarriedXReg(i)));
+		}
+		MOV(32, M(&PC), Imm32(js.blockStart));
+		JMP(asm_routines.doTiming, true);
+		SetJumpTarget(linkedSkip);
+		linkedBody = J(true);
+	}
+
 	const u8 *start = AlignCode4(); // TODO: Test if this or AlignCode16 make a difference from GetCodePtr
 	b->checkedEntry = start;
 	b->runCount = 0;
@@ -470,6 +658,15 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 	if (ImHereDebug)
 		ABI_CallFunction((void *)&ImHere); //Used to get a trace of the last few blocks before a crash, sometimes VERY useful
 
+	for (int gqr = 0; gqr < 8; gqr++)
+	{
+		if (js.constantGqr & (1 << gqr))
+		{
+			CMP(32, M(&PowerPC::ppcState.spr[SPR_GQR0 + gqr]), Imm32(PowerPC::ppcState.spr[SPR_GQR0 + gqr]));
+			J_CC(CC_NZ, gqrFailure, true);
+		}
+	}
+
 	// Conditionally add profiling code.
 	if (Profiler::g_ProfileBlocks) {
 		ADD(32, M(&b->runCount), Imm8(1));
@@ -493,6 +690,17 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 	gpr.Start(js.gpa);
 	fpr.Start(js.fpa);
 
+	if (carried)
+	{
+		// Dirty, since a block jumping to the linked entry may have changed them.
+		for (int i = 0; i < 32; i++)
+		{
+			if (carried & (1u << i))
+				gpr.BindToRegister(i, true, true);
+		}
+		SetJumpTarget(linkedBody);
+	}
+
 	js.downcountAmount = 0;
 	if (!Core::g_CoreStartupParameter.bEnableDebugging)
 		js.downcountAmount += PatchEngine::GetSpeedhackCycles(code_block.m_address);
@@ -500,9 +708,31 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 	js.skipnext = false;
 	js.blockSize = code_block.m_num_instructions;
 	js.compilerPC = nextPC;
+	forward_jumps.clear();
 	// Translate instructions
 	for (u32 i = 0; i < code_block.m_num_instructions; i++)
 	{
+		if (ops[i].isBranchTarget)
+		{
+			// Both the fall through and the jumps arrive with everything flushed
+			gpr.Flush(FLUSH_ALL);
+			fpr.Flush(FLUSH_ALL);
+			for (auto it = forward_jumps.begin(); it != forward_jumps.end();)
+			{
+				if (it->first == (int)i)
+				{
+					SetJumpTarget(it->second);
+					it = forward_jumps.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+			// The jumps may have skipped the FP enabled check
+			js.firstFPInstructionFound = false;
+		}
+
 		js.compilerPC = ops[i].address;
 		js.op = &ops[i];
 		js.instructionNumber = i;
@@ -556,6 +786,15 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 						MOV(32, R(EAX), M(&NPC));
 						js.downcountAmount += js.st.numCycles;
 						WriteExitDestInEAX();
+
+						// Jumps to ops past the hook leave the block as well,
+						// HLEFunction flushed everything.
+						for (auto& jump : forward_jumps)
+						{
+							SetJumpTarget(jump.second);
+							WriteExit(ops[jump.first].address);
+						}
+						forward_jumps.clear();
 						break;
 					}
 				}
@@ -698,7 +937,7 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 
 	if (code_block.m_broken)
 	{
-		gpr.Flush(FLUSH_ALL);
+		gpr.Flush(FLUSH_KEEP_CARRIED);
 		fpr.Flush(FLUSH_ALL);
 		WriteExit(nextPC);
 	}
@@ -706,6 +945,20 @@ const u8* Jit64::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 	b->flags = js.block_flags;
 	b->codeSize = (u32)(GetCodePtr() - normalEntry);
 	b->originalSize = code_block.m_num_instructions;
+	_assert_msg_(DYNA_REC, forward_jumps.empty(), "Unresolved jump within block %08x", em_address);
+
+	// Inlined functions are outside of the range the block cache knows about
+	const u32 end = em_address + 4 * code_block.m_num_instructions;
+	for (u32 i = 0; i < code_block.m_num_instructions; i++)
+	{
+		const u32 address = ops[i].address;
+		if (address >= em_address && address < end)
+			continue;
+		if (!b->inlinedRanges.empty() && b->inlinedRanges.back().first + b->inlinedRanges.back().second == address)
+			b->inlinedRanges.back().second += 4;
+		else
+			b->inlinedRanges.push_back(std::make_pair(address, 4u));
+	}
 
 #ifdef JIT_LOG_X86
 	LogGeneratedX86(code_block.m_num_instructions, code_buf, normalEntry, b);
@@ -48,6 +48,10 @@ private:
 	PPCAnalyst::CodeBuffer code_buffer;
 	Jit64AsmRoutineManager asm_routines;
 
+	// Jumps to an op later in the block (PPCAnalyst::CodeOp::branchToIndex),
+	// resolved when DoJit gets there.
+	std::vector<std::pair<int, Gen::FixupBranch>> forward_jumps;
+
 public:
 	Jit64() : code_buffer(32000) {}
 	~Jit64() {}
@@ -92,9 +96,15 @@ public:
 	void WriteExit(u32 destination);
 	void WriteExitDestInEAX();
 	void WriteExceptionExit();
+	// Exit for a branch the analyzer marked as a busy wait loop.
+	void WriteIdleExit(u32 destination);
 	void WriteExternalExceptionExit();
 	void WriteRfiExitDestInEAX();
 	void WriteCallInterpreter(UGeckoInstruction _inst);
+	// Jumps to the op the current branch resolves to within the block.
+	void WriteForwardJump();
+	// Whether the next count instructions can be merged into the current one.
+	bool CanMergeNextInstructions(int count) const;
 	void Cleanup();
 
 	void GenerateConstantOverflow(bool overflow);
@@ -105,11 +115,17 @@ public:
 	void GenerateCarry();
 	void GenerateRC();
 	void ComputeRC(const Gen::OpArg & arg);
+	void SetCR1FromFPSCR();
 
 	void tri_op(int d, int a, int b, bool reversible, void (XEmitter::*op)(Gen::X64Reg, Gen::OpArg));
 	typedef u32 (*Operation)(u32 a, u32 b);
 	void regimmop(int d, int a, bool binary, u32 value, Operation doop, void (XEmitter::*op)(int, const Gen::OpArg&, const Gen::OpArg&), bool Rc = false, bool carry = false);
 	void fp_tri_op(int d, int a, int b, bool reversible, bool single, void (XEmitter::*op)(Gen::X64Reg, Gen::OpArg));
+	void FloatCompare(UGeckoInstruction inst, bool upper);
+
+	// Leaves the effective address of a D-form or indexed psq_l/psq_st in ECX
+	// and writes it back to RA for the update forms.
+	void ComputePairedAddress(UGeckoInstruction inst, bool indexed, bool update);
 
 	// OPCODES
 	void unknown_instruction(UGeckoInstruction _inst);
@@ -171,6 +187,7 @@ public:
 	void ps_recip(UGeckoInstruction inst);
 	void ps_sum(UGeckoInstruction inst);
 	void ps_muls(UGeckoInstruction inst);
+	void ps_cmpXX(UGeckoInstruction inst);
 
 	void fp_arith(UGeckoInstruction inst);
 	void frsqrtex(UGeckoInstruction inst);
@@ -9,7 +9,7 @@
 using namespace Gen;
 using namespace PowerPC;
 
-RegCache::RegCache() : emit(nullptr)
+RegCache::RegCache() : carried(0), emit(nullptr)
 {
 	memset(locks, 0, sizeof(locks));
 	memset(xlocks, 0, sizeof(xlocks));
@@ -19,6 +19,7 @@ RegCache::RegCache() : emit(nullptr)
 	memset(xregs, 0, sizeof(xregs));
 	memset(saved_regs, 0, sizeof(saved_regs));
 	memset(saved_xregs, 0, sizeof(saved_xregs));
+	memset(carriedXRegs, 0, sizeof(carriedXRegs));
 }
 
 void RegCache::Start(PPCAnalyst::BlockRegStats &stats)
@@ -117,6 +118,75 @@ X64Reg RegCache::GetFreeXReg()
 	return (X64Reg) -1;
 }
 
+// Carried registers go to their own host register, evicting whatever is
+// there unless it is locked.
+X64Reg RegCache::GetFreeXRegFor(int preg)
+{
+	if (carried & (1u << preg))
+	{
+		X64Reg xr = carriedXRegs[preg];
+		if (!xlocks[xr])
+		{
+			if (xregs[xr].free)
+				return xr;
+			if (!locks[xregs[xr].ppcReg])
+			{
+				StoreFromRegister(xregs[xr].ppcReg);
+				return xr;
+			}
+		}
+	}
+	return GetFreeXReg();
+}
+
+void RegCache::SetCarried(u32 preferred)
+{
+	int count;
+	const int *order = GetCarryOrder(count);
+	carried = 0;
+	for (int i = 0, n = 0; i < 32 && n < count; i++)
+	{
+		if (preferred & (1u << i))
+		{
+			carried |= 1u << i;
+			carriedXRegs[i] = (X64Reg)order[n++];
+		}
+	}
+}
+
+bool RegCache::CanCarry() const
+{
+	if (!carried)
+		return false;
+	for (int i = 0; i < 32; i++)
+	{
+		bool inPlace = IsBound(i) && RX(i) == carriedXRegs[i];
+		if ((carried & (1u << i)) ? !inPlace : regs[i].away)
+			return false;
+	}
+	return true;
+}
+
+int RegCache::NumDirtyCarried() const
+{
+	int count = 0;
+	for (int i = 0; i < 32; i++)
+	{
+		if ((carried & (1u << i)) && IsBound(i) && xregs[RX(i)].dirty)
+			count++;
+	}
+	return count;
+}
+
+void RegCache::WriteBackCarried()
+{
+	for (int i = 0; i < 32; i++)
+	{
+		if ((carried & (1u << i)) && IsBound(i) && xregs[RX(i)].dirty)
+			emit->MOV(32, GetDefaultLocation(i), regs[i].location);
+	}
+}
+
 void RegCache::SaveState()
 {
 	memcpy(saved_locks, locks, sizeof(locks));
@@ -214,6 +284,23 @@ const int *GPRRegCache::GetAllocationOrder(int &count)
 	return allocationOrder;
 }
 
+const int *GPRRegCache::GetCarryOrder(int &count)
+{
+	// Callee saved, so they survive the calls an exit may make.
+	static const int carryOrder[] =
+	{
+#if _M_X86_64
+#ifdef _WIN32
+		RSI, RDI, R13, R14,
+#else
+		RBP, R13, R14, R12,
+#endif
+#endif
+	};
+	count = sizeof(carryOrder) / sizeof(const int);
+	return carryOrder;
+}
+
 const int *FPURegCache::GetAllocationOrder(int &count)
 {
 	static const int allocationOrder[] =
@@ -256,7 +343,7 @@ void GPRRegCache::BindToRegister(int i, bool doLoad, bool makeDirty)
 
 	if (!regs[i].away || (regs[i].away && regs[i].location.IsImm()))
 	{
-		X64Reg xr = GetFreeXReg();
+		X64Reg xr = GetFreeXRegFor(i);
 		if (xregs[xr].dirty) PanicAlert("Xreg already dirty");
 		if (xlocks[xr]) PanicAlert("GetFreeXReg returned locked register");
 		xregs[xr].free = false;
@@ -378,7 +465,12 @@ void RegCache::Flush(FlushMode mode)
 		}
 		if (regs[i].away)
 		{
-			if (regs[i].location.IsSimpleReg())
+			if (mode == FLUSH_KEEP_CARRIED && (carried & (1u << i)) &&
+			    (regs[i].location.IsImm() || RX(i) == carriedXRegs[i]))
+			{
+				continue;
+			}
+			else if (regs[i].location.IsSimpleReg())
 			{
 				X64Reg xr = RX(i);
 				StoreFromRegister(i);
@@ -394,4 +486,13 @@ void RegCache::Flush(FlushMode mode)
 			}
 		}
 	}
+
+	if (mode == FLUSH_KEEP_CARRIED)
+	{
+		for (int i = 0; i < 32; i++)
+		{
+			if ((carried & (1u << i)) && !IsBound(i))
+				BindToRegister(i, true, false);
+		}
+	}
 }
@@ -9,7 +9,10 @@
 using namespace Gen;
 enum FlushMode
 {
-	FLUSH_ALL
+	FLUSH_ALL,
+	// Like FLUSH_ALL, but carried registers end up in their host register
+	// instead of memory. Only for block exits, see Jit64::WriteExit.
+	FLUSH_KEEP_CARRIED,
 };
 
 enum GrabMode
@@ -56,7 +59,16 @@ protected:
 	PPCCachedReg saved_regs[32];
 	X64CachedReg saved_xregs[NUMXREGS];
 
+	// Guest registers that linked blocks pass to each other in a fixed host
+	// register. The i-th carried register always lives in the i-th register of
+	// the carry order, so two blocks agree if their masks are the same.
+	u32 carried;
+	X64Reg carriedXRegs[32];
+
 	virtual const int *GetAllocationOrder(int &count) = 0;
+	virtual const int *GetCarryOrder(int &count) { count = 0; return nullptr; }
+
+	X64Reg GetFreeXRegFor(int preg);
 
 	XEmitter *emit;
 
@@ -118,6 +130,20 @@ public:
 
 	X64Reg GetFreeXReg();
 
+	// Not reset by Start(), set it before compiling a block.
+	void SetCarried(u32 preferred);
+	u32 GetCarried() const { return carried; }
+	X64Reg GetCarriedXReg(int preg) const { return carriedXRegs[preg]; }
+	int GetMaxCarried() { int count; GetCarryOrder(count); return count; }
+
+	// True if every carried register is in its host register and nothing else
+	// is cached, which is what FLUSH_KEEP_CARRIED leaves behind.
+	bool CanCarry() const;
+	int NumDirtyCarried() const;
+	// Stores the dirty carried registers without changing the cache state, for
+	// the paths of an exit that don't go to a block expecting them.
+	void WriteBackCarried();
+
 	void SaveState();
 	void LoadState();
 };
@@ -130,6 +156,7 @@ public:
 	void StoreFromRegister(int preg) override;
 	OpArg GetDefaultLocation(int reg) const override;
 	const int *GetAllocationOrder(int &count) override;
+	const int *GetCarryOrder(int &count) override;
 	void SetImmediate32(int preg, u32 immValue);
 };
 
@@ -4,6 +4,7 @@
 
 #include "Common/Common.h"
 
+#include "Core/ConfigManager.h"
 #include "Core/PowerPC/Jit64/Jit.h"
 #include "Core/PowerPC/Jit64/JitAsm.h"
 #include "Core/PowerPC/Jit64/JitRegCache.h"
@@ -64,6 +65,14 @@ void Jit64::bx(UGeckoInstruction inst)
 	if (inst.LK)
 		MOV(32, M(&LR), Imm32(js.compilerPC + 4));
 
+	if (js.op->branchToIndex >= 0)
+	{
+		gpr.Flush(FLUSH_ALL);
+		fpr.Flush(FLUSH_ALL);
+		WriteForwardJump();
+		return;
+	}
+
 	// If this is not the last instruction of a block,
 	// we will skip the rest process.
 	// Because PPCAnalyst::Flatten() merged the blocks.
@@ -71,7 +80,7 @@ void Jit64::bx(UGeckoInstruction inst)
 		return;
 	}
 
-	gpr.Flush(FLUSH_ALL);
+	gpr.Flush(FLUSH_KEEP_CARRIED);
 	fpr.Flush(FLUSH_ALL);
 
 	u32 destination;
@@ -83,6 +92,11 @@ void Jit64::bx(UGeckoInstruction inst)
 	if (inst.LK)
 		AND(32, M(&PowerPC::ppcState.cr), Imm32(~(0xFF000000)));
 #endif
+	if (js.op->branchIsIdleLoop && SConfig::GetInstance().m_LocalCoreStartupParameter.bSkipIdle)
+	{
+		WriteIdleExit(destination);
+		return;
+	}
 	if (destination == js.compilerPC)
 	{
 		//PanicAlert("Idle loop detected at %08x", destination);
@@ -104,7 +118,8 @@ void Jit64::bcx(UGeckoInstruction inst)
 
 	// USES_CR
 
-	gpr.Flush(FLUSH_ALL);
+	// A jump within the block leaves the carried registers behind as well
+	gpr.Flush(js.op->branchToIndex >= 0 ? FLUSH_ALL : FLUSH_KEEP_CARRIED);
 	fpr.Flush(FLUSH_ALL);
 
 	FixupBranch pCTRDontBranch;
@@ -135,7 +150,12 @@ void Jit64::bcx(UGeckoInstruction inst)
 		destination = SignExt16(inst.BD << 2);
 	else
 		destination = js.compilerPC + SignExt16(inst.BD << 2);
-	WriteExit(destination);
+	if (js.op->branchIsIdleLoop && SConfig::GetInstance().m_LocalCoreStartupParameter.bSkipIdle)
+		WriteIdleExit(destination);
+	else if (js.op->branchToIndex >= 0)
+		WriteForwardJump();
+	else
+		WriteExit(destination);
 
 	if ((inst.BO & BO_DONT_CHECK_CONDITION) == 0)
 		SetJumpTarget( pConditionDontBranch );
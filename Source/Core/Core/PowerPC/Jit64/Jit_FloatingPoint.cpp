@@ -39,6 +39,9 @@ void Jit64::fp_tri_op(int d, int a, int b, bool reversible, bool single, void (X
 		{
 			MOVSD(XMM0, fpr.R(b));
 			fpr.BindToRegister(d, !single);
+			// MOVSD from memory would clear ps1
+			if (!single)
+				fpr.BindToRegister(a, true, false);
 			MOVSD(fpr.RX(d), fpr.R(a));
 			(this->*op)(fpr.RX(d), Gen::R(XMM0));
 		}
@@ -49,6 +52,7 @@ void Jit64::fp_tri_op(int d, int a, int b, bool reversible, bool single, void (X
 		fpr.BindToRegister(d, !single);
 		if (!single)
 		{
+			fpr.BindToRegister(a, true, false);
 			fpr.BindToRegister(b, true, false);
 		}
 		MOVSD(fpr.RX(d), fpr.R(a));
@@ -164,7 +168,8 @@ void Jit64::fmaddXX(UGeckoInstruction inst)
 		PXOR(XMM0, M((void*)&psSignBits2));
 		break;
 	}
-	fpr.BindToRegister(d, false);
+	// The double precision forms leave ps1 alone, so it has to be loaded
+	fpr.BindToRegister(d, !single_precision);
 	//YES it is necessary to dupe the result :(
 	//TODO : analysis - does the top reg get used? If so, dupe, if not, don't.
 	if (single_precision) {
@@ -233,11 +238,28 @@ void Jit64::fmrx(UGeckoInstruction inst)
 	fpr.UnlockAll();
 }
 
+// Rc for floating point instructions copies FX, FEX, VX and OX into CR1. Like
+// everywhere else in the JIT, the FPSCR exception bits themselves are not updated.
+void Jit64::SetCR1FromFPSCR()
+{
+	gpr.FlushLockX(EAX);
+	MOV(32, R(EAX), M(&PowerPC::ppcState.fpscr));
+	SHR(32, R(EAX), Imm8(28));
+	MOV(8, M(&PowerPC::ppcState.cr_fast[1]), R(AL));
+	gpr.UnlockAllX();
+}
+
 void Jit64::fcmpx(UGeckoInstruction inst)
 {
 	INSTRUCTION_START
 	JITDISABLE(bJITFloatingPointOff)
 
+	FloatCompare(inst, false);
+}
+
+// Shared by fcmpo/fcmpu and the ps_cmp family, upper compares ps1 instead of ps0.
+void Jit64::FloatCompare(UGeckoInstruction inst, bool upper)
+{
 	if (jo.fpAccurateFcmp)
 	{
 		FallBackToInterpreter(inst); // turn off from debugger
@@ -250,10 +272,21 @@ void Jit64::fcmpx(UGeckoInstruction inst)
 	int crf = inst.CRFD;
 
 	fpr.Lock(a,b);
-	fpr.BindToRegister(b, true);
 
 	// Are we masking sNaN invalid floating point exceptions? If not this could crash if we don't handle the exception?
-	UCOMISD(fpr.R(b).GetSimpleReg(), fpr.R(a));
+	if (upper)
+	{
+		MOVAPD(XMM0, fpr.R(b));
+		UNPCKHPD(XMM0, R(XMM0));
+		MOVAPD(XMM1, fpr.R(a));
+		UNPCKHPD(XMM1, R(XMM1));
+		UCOMISD(XMM0, R(XMM1));
+	}
+	else
+	{
+		fpr.BindToRegister(b, true);
+		UCOMISD(fpr.R(b).GetSimpleReg(), fpr.R(a));
+	}
 
 	FixupBranch pNaN, pLesser, pGreater;
 	FixupBranch continue1, continue2, continue3;
@@ -257,7 +257,7 @@ void Jit64::reg_imm(UGeckoInstruction inst)
 		if (a == 0) // lis
 		{
 			// Merge with next instruction if loading a 32-bits immediate value (lis + addi, lis + ori)
-			if (!js.isLastInstruction && !Core::g_CoreStartupParameter.bEnableDebugging)
+			if (CanMergeNextInstructions(1) && !Core::g_CoreStartupParameter.bEnableDebugging)
 			{
 				if ((js.next_inst.OPCD == 14) && (js.next_inst.RD == d) && (js.next_inst.RA == d)) // addi
 				{
@@ -313,11 +313,15 @@ void Jit64::cmpXX(UGeckoInstruction inst)
 	bool merge_branch = false;
 	int test_crf = js.next_inst.BI >> 2;
 	// Check if the next instruction is a branch - if it is, merge the two.
-	if (((js.next_inst.OPCD == 16 /* bcx */) ||
+	// Branches to an op inside the block are left to bcx, which jumps there
+	// instead of exiting.
+	if (CanMergeNextInstructions(1) &&
+		((js.next_inst.OPCD == 16 /* bcx */) ||
 		((js.next_inst.OPCD == 19) && (js.next_inst.SUBOP10 == 528) /* bcctrx */) ||
 		((js.next_inst.OPCD == 19) && (js.next_inst.SUBOP10 == 16) /* bclrx */)) &&
 		(js.next_inst.BO & BO_DONT_DECREMENT_FLAG) &&
-		!(js.next_inst.BO & BO_DONT_CHECK_CONDITION)) {
+		!(js.next_inst.BO & BO_DONT_CHECK_CONDITION) &&
+		js.op[1].branchToIndex < 0) {
 			// Looks like a decent conditional branch that we can merge with.
 			// It only test CR, not CTR.
 			if (test_crf == crf) {
@@ -384,7 +388,7 @@ void Jit64::cmpXX(UGeckoInstruction inst)
 		{
 			js.downcountAmount++;
 
-			gpr.Flush(FLUSH_ALL);
+			gpr.Flush(FLUSH_KEEP_CARRIED);
 			fpr.Flush(FLUSH_ALL);
 
 			int test_bit = 8 >> (js.next_inst.BI & 3);
@@ -483,7 +487,7 @@ void Jit64::cmpXX(UGeckoInstruction inst)
 			// if (rand() & 1)
 			//     std::swap(destination1, destination2), condition = !condition;
 
-			gpr.Flush(FLUSH_ALL);
+			gpr.Flush(FLUSH_KEEP_CARRIED);
 			fpr.Flush(FLUSH_ALL);
 			FixupBranch pLesser  = J_CC(less_than);
 			FixupBranch pGreater = J_CC(greater_than);
@@ -12,43 +12,96 @@
 #include "Core/PowerPC/Jit64/JitAsm.h"
 #include "Core/PowerPC/Jit64/JitRegCache.h"
 
-// The big problem is likely instructions that set the quantizers in the same block.
-// We will have to break block after quantizers are written to.
+void Jit64::ComputePairedAddress(UGeckoInstruction inst, bool indexed, bool update)
+{
+	int a = inst.RA;
+	int offset = indexed ? 0 : (int)inst.SIMM_12;
+
+	if (update)
+		gpr.BindToRegister(a, true, true);
+
+	if (indexed)
+	{
+		// EA = (RA|0) + RB
+		MOV(32, R(ECX), gpr.R(inst.RB));
+		if (a)
+			ADD(32, R(ECX), gpr.R(a));
+	}
+	else if (a)
+	{
+		// EA = RA + d
+		if (offset && gpr.R(a).IsSimpleReg())
+			LEA(32, ECX, MDisp(gpr.RX(a), offset));
+		else
+		{
+			MOV(32, R(ECX), gpr.R(a));
+			if (offset)
+				ADD(32, R(ECX), Imm32((u32)offset));
+		}
+	}
+	else
+	{
+		// EA = d
+		MOV(32, R(ECX), Imm32((u32)offset));
+	}
+
+	// psq_stu/psq_lu with a zero offset leave RA as it is
+	if (update && (indexed || offset))
+		MOV(32, gpr.R(a), R(ECX));
+}
+
+// Blocks are compiled for the GQR values at compile time unless they write the
+// GQR themselves, see js.constantGqr. In that case the exact quantize sequence
+// is inlined, otherwise the asm routine for the type is looked up at runtime.
+static bool IsConstantQuantizeType(int type)
+{
+	return type == QUANTIZE_FLOAT || type >= QUANTIZE_U8;
+}
+
 void Jit64::psq_st(UGeckoInstruction inst)
 {
 	INSTRUCTION_START
 	JITDISABLE(bJITLoadStorePairedOff)
 
-	if (js.memcheck)
-	{
-		FallBackToInterpreter(inst);
-		return;
-	}
+	// psq_st, psq_stu, psq_stx and psq_stux
+	bool indexed = inst.OPCD == 4;
+	bool update = indexed ? (inst.SUBOP10 & 32) != 0 : inst.OPCD == 61;
 
-	if (!inst.RA)
+	// Update forms with RA = 0 are invalid, let the interpreter deal with them.
+	if (js.memcheck || (update && !inst.RA))
 	{
-		// TODO: Support these cases if it becomes necessary.
 		FallBackToInterpreter(inst);
 		return;
 	}
 
-	bool update = inst.OPCD == 61;
-
-	int offset = inst.SIMM_12;
-	int a = inst.RA;
 	int s = inst.RS; // Fp numbers
+	int gqr = indexed ? inst.Ix : inst.I;
+	bool single = indexed ? inst.Wx : inst.W;
 
 	gpr.FlushLockX(EAX, EDX);
 	gpr.FlushLockX(ECX);
-	if (update)
-		gpr.BindToRegister(inst.RA, true, true);
-	fpr.BindToRegister(inst.RS, true, false);
-	MOV(32, R(ECX), gpr.R(inst.RA));
-	if (offset)
-		ADD(32, R(ECX), Imm32((u32)offset));
-	if (update && offset)
-		MOV(32, gpr.R(a), R(ECX));
-	MOVZX(32, 16, EAX, M(&PowerPC::ppcState.spr[SPR_GQR0 + inst.I]));
+	if (indexed)
+		gpr.Lock(inst.RA, inst.RB);
+	else
+		gpr.Lock(inst.RA);
+	fpr.BindToRegister(s, true, false);
+	ComputePairedAddress(inst, indexed, update);
+
+	const UGQR gqr_value(PowerPC::ppcState.spr[SPR_GQR0 + gqr]);
+	if ((js.constantGqr & (1 << gqr)) && IsConstantQuantizeType(gqr_value.ST_TYPE))
+	{
+		if (single)
+			CVTSD2SS(XMM0, fpr.R(s));
+		else
+			CVTPD2PS(XMM0, fpr.R(s));
+		u32 registersInUse = RegistersInUse() & ~((1 << EAX) | (1 << ECX) | (1 << EDX));
+		GenQuantizedStore(single, (EQuantizeType)gqr_value.ST_TYPE, gqr_value.ST_SCALE, registersInUse, SAFE_LOADSTORE_NO_FASTMEM);
+		gpr.UnlockAll();
+		gpr.UnlockAllX();
+		return;
+	}
+
+	MOVZX(32, 16, EAX, M(&PowerPC::ppcState.spr[SPR_GQR0 + gqr]));
 	MOVZX(32, 8, EDX, R(AL));
 	// FIXME: Fix ModR/M encoding to allow [EDX*4+disp32] without a base register!
 #if _M_X86_32
@@ -56,7 +109,7 @@ void Jit64::psq_st(UGeckoInstruction inst)
 #else
 	int addr_scale = SCALE_8;
 #endif
-	if (inst.W) {
+	if (single) {
 		// One value
 		PXOR(XMM0, R(XMM0));  // TODO: See if we can get rid of this cheaply by tweaking the code in the singleStore* functions.
 		CVTSD2SS(XMM0, fpr.R(s));
@@ -75,34 +128,41 @@ void Jit64::psq_l(UGeckoInstruction inst)
 	INSTRUCTION_START
 	JITDISABLE(bJITLoadStorePairedOff)
 
-	if (js.memcheck)
-	{
-		FallBackToInterpreter(inst);
-		return;
-	}
+	// psq_l, psq_lu, psq_lx and psq_lux
+	bool indexed = inst.OPCD == 4;
+	bool update = indexed ? (inst.SUBOP10 & 32) != 0 : inst.OPCD == 57;
 
-	if (!inst.RA)
+	if (js.memcheck || (update && !inst.RA))
 	{
 		FallBackToInterpreter(inst);
 		return;
 	}
 
-	bool update = inst.OPCD == 57;
-	int offset = inst.SIMM_12;
+	int gqr = indexed ? inst.Ix : inst.I;
+	bool single = indexed ? inst.Wx : inst.W;
 
 	gpr.FlushLockX(EAX, EDX);
 	gpr.FlushLockX(ECX);
-	gpr.BindToRegister(inst.RA, true, update && offset);
-	fpr.BindToRegister(inst.RS, false, true);
-	if (offset)
-		LEA(32, ECX, MDisp(gpr.RX(inst.RA), offset));
+	if (indexed)
+		gpr.Lock(inst.RA, inst.RB);
 	else
-		MOV(32, R(ECX), gpr.R(inst.RA));
-	if (update && offset)
-		MOV(32, gpr.R(inst.RA), R(ECX));
-	MOVZX(32, 16, EAX, M(((char *)&GQR(inst.I)) + 2));
+		gpr.Lock(inst.RA);
+	ComputePairedAddress(inst, indexed, update);
+	fpr.BindToRegister(inst.RS, false, true);
+
+	const UGQR gqr_value(PowerPC::ppcState.spr[SPR_GQR0 + gqr]);
+	if ((js.constantGqr & (1 << gqr)) && IsConstantQuantizeType(gqr_value.LD_TYPE))
+	{
+		GenQuantizedLoad(single, (EQuantizeType)gqr_value.LD_TYPE, gqr_value.LD_SCALE);
+		CVTPS2PD(fpr.RX(inst.RS), R(XMM0));
+		gpr.UnlockAll();
+		gpr.UnlockAllX();
+		return;
+	}
+
+	MOVZX(32, 16, EAX, M(((char *)&GQR(gqr)) + 2));
 	MOVZX(32, 8, EDX, R(AL));
-	if (inst.W)
+	if (single)
 		OR(32, R(EDX), Imm8(8));
 #if _M_X86_32
 	int addr_scale = SCALE_4;
@@ -23,19 +23,16 @@ void Jit64::ps_mr(UGeckoInstruction inst)
 	INSTRUCTION_START
 	JITDISABLE(bJITPairedOff)
 
-	if (inst.Rc)
-	{
-		FallBackToInterpreter(inst);
-		return;
-	}
-
 	int d = inst.FD;
 	int b = inst.FB;
-	if (d == b)
-		return;
+	if (d != b)
+	{
+		fpr.BindToRegister(d, false);
+		MOVAPD(fpr.RX(d), fpr.R(b));
+	}
 
-	fpr.BindToRegister(d, false);
-	MOVAPD(fpr.RX(d), fpr.R(b));
+	if (inst.Rc)
+		SetCR1FromFPSCR();
 }
 
 void Jit64::ps_sel(UGeckoInstruction inst)
@@ -46,12 +43,6 @@ void Jit64::ps_sel(UGeckoInstruction inst)
 	INSTRUCTION_START
 	JITDISABLE(bJITPairedOff)
 
-	if (inst.Rc)
-	{
-		FallBackToInterpreter(inst);
-		return;
-	}
-
 	int d = inst.FD;
 	int a = inst.FA;
 	int b = inst.FB;
@@ -69,6 +60,9 @@ void Jit64::ps_sel(UGeckoInstruction inst)
 	fpr.BindToRegister(d, false);
 	MOVAPD(fpr.RX(d), R(XMM0));
 	fpr.UnlockAll();
+
+	if (inst.Rc)
+		SetCR1FromFPSCR();
 }
 
 void Jit64::ps_sign(UGeckoInstruction inst)
@@ -76,12 +70,6 @@ void Jit64::ps_sign(UGeckoInstruction inst)
 	INSTRUCTION_START
 	JITDISABLE(bJITPairedOff)
 
-	if (inst.Rc)
-	{
-		FallBackToInterpreter(inst);
-		return;
-	}
-
 	int d = inst.FD;
 	int b = inst.FB;
 
@@ -110,6 +98,9 @@ void Jit64::ps_sign(UGeckoInstruction inst)
 	}
 
 	fpr.UnlockAll();
+
+	if (inst.Rc)
+		SetCR1FromFPSCR();
 }
 
 // ps_res and ps_rsqrte
@@ -118,12 +109,6 @@ void Jit64::ps_recip(UGeckoInstruction inst)
 	INSTRUCTION_START
 	JITDISABLE(bJITPairedOff)
 
-	if (inst.Rc)
-	{
-		FallBackToInterpreter(inst);
-		return;
-	}
-
 	OpArg divisor;
 	int d = inst.FD;
 	int b = inst.FB;
@@ -145,6 +130,9 @@ void Jit64::ps_recip(UGeckoInstruction inst)
 	DIVPD(XMM1, divisor);
 	MOVAPD(fpr.R(d), XMM1);
 	fpr.UnlockAll();
+
+	if (inst.Rc)
+		SetCR1FromFPSCR();
 }
 
 //add a, b, c
@@ -202,12 +190,6 @@ void Jit64::ps_arith(UGeckoInstruction inst)
 	INSTRUCTION_START
 	JITDISABLE(bJITPairedOff)
 
-	if (inst.Rc)
-	{
-		FallBackToInterpreter(inst);
-		return;
-	}
-
 	switch (inst.SUBOP5)
 	{
 	case 18: tri_op(inst.FD, inst.FA, inst.FB, false, &XEmitter::DIVPD); break; //div
@@ -217,6 +199,9 @@ void Jit64::ps_arith(UGeckoInstruction inst)
 	default:
 		_assert_msg_(DYNA_REC, 0, "ps_arith WTF!!!");
 	}
+
+	if (inst.Rc)
+		SetCR1FromFPSCR();
 }
 
 void Jit64::ps_sum(UGeckoInstruction inst)
@@ -224,13 +209,6 @@ void Jit64::ps_sum(UGeckoInstruction inst)
 	INSTRUCTION_START
 	JITDISABLE(bJITPairedOff)
 
-	// TODO: (inst.SUBOP5 == 10) breaks Sonic Colours (black screen)
-	if (inst.Rc || (inst.SUBOP5 == 10))
-	{
-		FallBackToInterpreter(inst);
-		return;
-	}
-
 	int d = inst.FD;
 	int a = inst.FA;
 	int b = inst.FB;
@@ -240,12 +218,13 @@ void Jit64::ps_sum(UGeckoInstruction inst)
 	switch (inst.SUBOP5)
 	{
 	case 10:
-		// Do the sum in upper subregisters, merge uppers
-		MOVDDUP(XMM0, fpr.R(a));
-		MOVAPD(XMM1, fpr.R(b));
-		ADDPD(XMM0, R(XMM1));
-		UNPCKHPD(XMM0, fpr.R(c)); //merge
-		MOVAPD(fpr.R(d), XMM0);
+		// ps0 = a.ps0 + b.ps1 as a scalar add, keep the upper half of c
+		MOVAPD(XMM0, fpr.R(b));
+		UNPCKHPD(XMM0, R(XMM0));
+		ADDSD(XMM0, fpr.R(a));
+		MOVAPD(XMM1, fpr.R(c));
+		MOVSD(XMM1, R(XMM0)); // merge
+		MOVAPD(fpr.R(d), XMM1);
 		break;
 	case 11:
 		// Do the sum in lower subregisters, merge lowers
@@ -262,6 +241,9 @@ void Jit64::ps_sum(UGeckoInstruction inst)
 	}
 	ForceSinglePrecisionP(fpr.RX(d));
 	fpr.UnlockAll();
+
+	if (inst.Rc)
+		SetCR1FromFPSCR();
 }
 
 
@@ -270,12 +252,6 @@ void Jit64::ps_muls(UGeckoInstruction inst)
 	INSTRUCTION_START
 	JITDISABLE(bJITPairedOff)
 
-	if (inst.Rc)
-	{
-		FallBackToInterpreter(inst);
-		return;
-	}
-
 	int d = inst.FD;
 	int a = inst.FA;
 	int c = inst.FC;
@@ -304,6 +280,9 @@ void Jit64::ps_muls(UGeckoInstruction inst)
 	}
 	ForceSinglePrecisionP(fpr.RX(d));
 	fpr.UnlockAll();
+
+	if (inst.Rc)
+		SetCR1FromFPSCR();
 }
 
 
@@ -313,12 +292,6 @@ void Jit64::ps_mergeXX(UGeckoInstruction inst)
 	INSTRUCTION_START
 	JITDISABLE(bJITPairedOff)
 
-	if (inst.Rc)
-	{
-		FallBackToInterpreter(inst);
-		return;
-	}
-
 	int d = inst.FD;
 	int a = inst.FA;
 	int b = inst.FB;
@@ -345,6 +318,9 @@ void Jit64::ps_mergeXX(UGeckoInstruction inst)
 	fpr.BindToRegister(d, false);
 	MOVAPD(fpr.RX(d), Gen::R(XMM0));
 	fpr.UnlockAll();
+
+	if (inst.Rc)
+		SetCR1FromFPSCR();
 }
 
 
@@ -354,12 +330,6 @@ void Jit64::ps_maddXX(UGeckoInstruction inst)
 	INSTRUCTION_START
 	JITDISABLE(bJITPairedOff)
 
-	if (inst.Rc)
-	{
-		FallBackToInterpreter(inst);
-		return;
-	}
-
 	int a = inst.FA;
 	int b = inst.FB;
 	int c = inst.FC;
@@ -408,4 +378,16 @@ void Jit64::ps_maddXX(UGeckoInstruction inst)
 	MOVAPD(fpr.RX(d), Gen::R(XMM0));
 	ForceSinglePrecisionP(fpr.RX(d));
 	fpr.UnlockAll();
+
+	if (inst.Rc)
+		SetCR1FromFPSCR();
+}
+
+// ps_cmpu0, ps_cmpo0, ps_cmpu1 and ps_cmpo1
+void Jit64::ps_cmpXX(UGeckoInstruction inst)
+{
+	INSTRUCTION_START
+	JITDISABLE(bJITPairedOff)
+
+	FloatCompare(inst, (inst.SUBOP10 & 64) != 0);
 }
@@ -290,6 +290,14 @@ void JitIL::Shutdown()
 		JitILProfiler::Shutdown();
 	}
 
+	const IREmitter::OptimizerStats& stats = ibuild.GetStats();
+	if (stats.blocks)
+	{
+		NOTICE_LOG(DYNA_REC, "JitIL: %" PRIu64 " blocks, %" PRIu64 " IR instructions, "
+		           "folded %" PRIu64 " register loads, numbered %" PRIu64 " values, removed %" PRIu64 " dead stores",
+		           stats.blocks, stats.instructions, stats.foldedLoads, stats.numberedValues, stats.deadStores);
+	}
+
 	FreeCodeSpace();
 
 	blocks.Shutdown();
@@ -694,6 +702,8 @@ const u8* JitIL::DoJit(u32 em_address, PPCAnalyst::CodeBuffer *code_buf, JitBloc
 		ibuild.EmitISIException(ibuild.EmitIntConst(em_address));
 	}
 
+	ibuild.EliminateDeadStores();
+
 	// Perform actual code generation
 	WriteCode(nextPC);
 
@@ -132,118 +132,140 @@ static void WriteDual32(u32 address)
 	Memory::Write_U64(*(u64 *) psTemp, address);
 }
 
-// See comment in header for in/outs.
-void CommonAsmRoutines::GenQuantizedStores()
+// Scale factor for the quantizer: the constant entry when the GQR is known,
+// otherwise the entry indexed by the scale field of the GQR half in EAX.
+// Scale 0 multiplies by 1.0, which can be skipped.
+void QuantizedMemoryRoutines::LoadQuantizeScale(const float* table, int quantize, bool mask)
 {
-	const u8* storePairedIllegal = AlignCode4();
-	UD2();
-	const u8* storePairedFloat = AlignCode4();
+	if (quantize < 0)
+	{
+		SHR(32, R(EAX), Imm8(6));
+		if (mask)
+			AND(32, R(EAX), Imm32(0xFC));
+		MOVSS(XMM1, MDisp(EAX, (u32)(u64)table));
+	}
+	else
+	{
+		MOVSS(XMM1, M((void *)&table[quantize]));
+	}
+}
+
+void QuantizedMemoryRoutines::GenQuantizedStore(bool single, EQuantizeType type, int quantize, u32 registersInUse, int flags)
+{
+	if (single)
+	{
+		if (type == QUANTIZE_FLOAT)
+		{
+			// Easy!
+			SafeWriteFloatToReg(XMM0, ECX, registersInUse, flags);
+			return;
+		}
+
+		if (quantize != 0)
+		{
+			LoadQuantizeScale(m_quantizeTableS, quantize, false);
+			MULSS(XMM0, R(XMM1));
+		}
+		switch (type)
+		{
+		case QUANTIZE_U8:  // Used by MKWii
+			PXOR(XMM1, R(XMM1));
+			MAXSS(XMM0, R(XMM1));
+			MINSS(XMM0, M((void *)&m_255));
+			break;
+		case QUANTIZE_S8:
+			MAXSS(XMM0, M((void *)&m_m128));
+			MINSS(XMM0, M((void *)&m_127));
+			break;
+		case QUANTIZE_U16:  // Used by MKWii
+			PXOR(XMM1, R(XMM1));
+			MAXSS(XMM0, R(XMM1));
+			MINSS(XMM0, M((void *)&m_65535));
+			break;
+		case QUANTIZE_S16:
+			MAXSS(XMM0, M((void *)&m_m32768));
+			MINSS(XMM0, M((void *)&m_32767));
+			break;
+		default:
+			break;
+		}
+		CVTTSS2SI(EAX, R(XMM0));
+		if (type == QUANTIZE_U8 || type == QUANTIZE_S8)
+			SafeWriteRegToReg(AL, ECX, 8, 0, registersInUse, flags);
+		else
+			SafeWriteRegToReg(EAX, ECX, 16, 0, registersInUse, flags);
+		return;
+	}
 
+	if (type == QUANTIZE_FLOAT)
+	{
+		bool noProlog = (flags & SAFE_LOADSTORE_NO_PROLOG) != 0;
 #if _M_X86_64
-	SHUFPS(XMM0, R(XMM0), 1);
-	MOVQ_xmm(M(&psTemp[0]), XMM0);
-	TEST(32, R(ECX), Imm32(0x0C000000));
-	FixupBranch too_complex = J_CC(CC_NZ, true);
-	MOV(64, R(RAX), M(&psTemp[0]));
-	SwapAndStore(64, MComplex(RBX, RCX, SCALE_1, 0), RAX);
-	FixupBranch skip_complex = J(true);
-	SetJumpTarget(too_complex);
-	ABI_PushRegistersAndAdjustStack(QUANTIZED_REGS_TO_SAVE, true);
-	ABI_CallFunctionR((void *)&WriteDual32, RCX);
-	ABI_PopRegistersAndAdjustStack(QUANTIZED_REGS_TO_SAVE, true);
-	SetJumpTarget(skip_complex);
-	RET();
+		SHUFPS(XMM0, R(XMM0), 1);
+		MOVQ_xmm(M(&psTemp[0]), XMM0);
+		TEST(32, R(ECX), Imm32(0x0C000000));
+		FixupBranch too_complex = J_CC(CC_NZ, true);
+		MOV(64, R(RAX), M(&psTemp[0]));
+		SwapAndStore(64, MComplex(RBX, RCX, SCALE_1, 0), RAX);
+		FixupBranch skip_complex = J(true);
+		SetJumpTarget(too_complex);
+		ABI_PushRegistersAndAdjustStack(registersInUse, noProlog);
+		ABI_CallFunctionR((void *)&WriteDual32, RCX);
+		ABI_PopRegistersAndAdjustStack(registersInUse, noProlog);
+		SetJumpTarget(skip_complex);
 #else
-	TEST(32, R(ECX), Imm32(0x0C000000));
-	FixupBranch argh = J_CC(CC_NZ, true);
-	MOVQ_xmm(M(&psTemp[0]), XMM0);
-	MOV(32, R(EAX), M(&psTemp));
-	BSWAP(32, EAX);
-	AND(32, R(ECX), Imm32(Memory::MEMVIEW32_MASK));
-	MOV(32, MDisp(ECX, (u32)Memory::base), R(EAX));
-	MOV(32, R(EAX), M(((char*)&psTemp) + 4));
-	BSWAP(32, EAX);
-	MOV(32, MDisp(ECX, 4+(u32)Memory::base), R(EAX));
-	FixupBranch arg2 = J(true);
-	SetJumpTarget(argh);
-	SHUFPS(XMM0, R(XMM0), 1);
-	MOVQ_xmm(M(&psTemp[0]), XMM0);
-	ABI_PushRegistersAndAdjustStack(QUANTIZED_REGS_TO_SAVE, true);
-	ABI_CallFunctionR((void *)&WriteDual32, ECX);
-	ABI_PopRegistersAndAdjustStack(QUANTIZED_REGS_TO_SAVE, true);
-	SetJumpTarget(arg2);
-	RET();
-#endif
-
-	const u8* storePairedU8 = AlignCode4();
-	SHR(32, R(EAX), Imm8(6));
-	MOVSS(XMM1, MDisp(EAX, (u32)(u64)m_quantizeTableS));
-	PUNPCKLDQ(XMM1, R(XMM1));
-	MULPS(XMM0, R(XMM1));
-#ifdef QUANTIZE_OVERFLOW_SAFE
-	MOVSS(XMM1, M((void *)&m_65535));
-	PUNPCKLDQ(XMM1, R(XMM1));
-	MINPS(XMM0, R(XMM1));
-#endif
-	CVTTPS2DQ(XMM0, R(XMM0));
-	PACKSSDW(XMM0, R(XMM0));
-	PACKUSWB(XMM0, R(XMM0));
-	MOVD_xmm(R(EAX), XMM0);
-	SafeWriteRegToReg(AX, ECX, 16, 0, QUANTIZED_REGS_TO_SAVE, SAFE_LOADSTORE_NO_SWAP | SAFE_LOADSTORE_NO_PROLOG | SAFE_LOADSTORE_NO_FASTMEM);
-
-	RET();
-
-	const u8* storePairedS8 = AlignCode4();
-	SHR(32, R(EAX), Imm8(6));
-	MOVSS(XMM1, MDisp(EAX, (u32)(u64)m_quantizeTableS));
-	PUNPCKLDQ(XMM1, R(XMM1));
-	MULPS(XMM0, R(XMM1));
-#ifdef QUANTIZE_OVERFLOW_SAFE
-	MOVSS(XMM1, M((void *)&m_65535));
-	PUNPCKLDQ(XMM1, R(XMM1));
-	MINPS(XMM0, R(XMM1));
+		TEST(32, R(ECX), Imm32(0x0C000000));
+		FixupBranch argh = J_CC(CC_NZ, true);
+		MOVQ_xmm(M(&psTemp[0]), XMM0);
+		MOV(32, R(EAX), M(&psTemp));
+		BSWAP(32, EAX);
+		AND(32, R(ECX), Imm32(Memory::MEMVIEW32_MASK));
+		MOV(32, MDisp(ECX, (u32)Memory::base), R(EAX));
+		MOV(32, R(EAX), M(((char*)&psTemp) + 4));
+		BSWAP(32, EAX);
+		MOV(32, MDisp(ECX, 4+(u32)Memory::base), R(EAX));
+		FixupBranch arg2 = J(true);
+		SetJumpTarget(argh);
+		SHUFPS(XMM0, R(XMM0), 1);
+		MOVQ_xmm(M(&psTemp[0]), XMM0);
+		ABI_PushRegistersAndAdjustStack(registersInUse, noProlog);
+		ABI_CallFunctionR((void *)&WriteDual32, ECX);
+		ABI_PopRegistersAndAdjustStack(registersInUse, noProlog);
+		SetJumpTarget(arg2);
 #endif
-	CVTTPS2DQ(XMM0, R(XMM0));
-	PACKSSDW(XMM0, R(XMM0));
-	PACKSSWB(XMM0, R(XMM0));
-	MOVD_xmm(R(EAX), XMM0);
-
-	SafeWriteRegToReg(AX, ECX, 16, 0, QUANTIZED_REGS_TO_SAVE, SAFE_LOADSTORE_NO_SWAP | SAFE_LOADSTORE_NO_PROLOG | SAFE_LOADSTORE_NO_FASTMEM);
-
-	RET();
-
-	const u8* storePairedU16 = AlignCode4();
-	SHR(32, R(EAX), Imm8(6));
-	MOVSS(XMM1, MDisp(EAX, (u32)(u64)m_quantizeTableS));
-	PUNPCKLDQ(XMM1, R(XMM1));
-	MULPS(XMM0, R(XMM1));
-
-	// PACKUSDW is available only in SSE4
-	PXOR(XMM1, R(XMM1));
-	MAXPS(XMM0, R(XMM1));
-	MOVSS(XMM1, M((void *)&m_65535));
-	PUNPCKLDQ(XMM1, R(XMM1));
-	MINPS(XMM0, R(XMM1));
+		return;
+	}
 
-	CVTTPS2DQ(XMM0, R(XMM0));
-	MOVQ_xmm(M(psTemp), XMM0);
-	// place ps[0] into the higher word, ps[1] into the lower
-	// so no need in ROL after BSWAP
-	MOVZX(32, 16, EAX, M((char*)psTemp + 0));
-	SHL(32, R(EAX), Imm8(16));
-	MOV(16, R(AX), M((char*)psTemp + 4));
+	if (quantize != 0)
+	{
+		LoadQuantizeScale(m_quantizeTableS, quantize, false);
+		// SHUFPS or UNPCKLPS might be a better choice here. The last one might just be an alias though.
+		PUNPCKLDQ(XMM1, R(XMM1));
+		MULPS(XMM0, R(XMM1));
+	}
 
-	BSWAP(32, EAX);
-	SafeWriteRegToReg(EAX, ECX, 32, 0, QUANTIZED_REGS_TO_SAVE, SAFE_LOADSTORE_NO_SWAP | SAFE_LOADSTORE_NO_PROLOG | SAFE_LOADSTORE_NO_FASTMEM);
+	if (type == QUANTIZE_U16)
+	{
+		// PACKUSDW is available only in SSE4
+		PXOR(XMM1, R(XMM1));
+		MAXPS(XMM0, R(XMM1));
+		MOVSS(XMM1, M((void *)&m_65535));
+		PUNPCKLDQ(XMM1, R(XMM1));
+		MINPS(XMM0, R(XMM1));
+
+		CVTTPS2DQ(XMM0, R(XMM0));
+		MOVQ_xmm(M(psTemp), XMM0);
+		// place ps[0] into the higher word, ps[1] into the lower
+		// so no need in ROL after BSWAP
+		MOVZX(32, 16, EAX, M((char*)psTemp + 0));
+		SHL(32, R(EAX), Imm8(16));
+		MOV(16, R(AX), M((char*)psTemp + 4));
 
-	RET();
+		BSWAP(32, EAX);
+		SafeWriteRegToReg(EAX, ECX, 32, 0, registersInUse, flags | SAFE_LOADSTORE_NO_SWAP);
+		return;
+	}
 
-	const u8* storePairedS16 = AlignCode4();
-	SHR(32, R(EAX), Imm8(6));
-	MOVSS(XMM1, MDisp(EAX, (u32)(u64)m_quantizeTableS));
-	// SHUFPS or UNPCKLPS might be a better choice here. The last one might just be an alias though.
-	PUNPCKLDQ(XMM1, R(XMM1));
-	MULPS(XMM0, R(XMM1));
 #ifdef QUANTIZE_OVERFLOW_SAFE
 	MOVSS(XMM1, M((void *)&m_65535));
 	PUNPCKLDQ(XMM1, R(XMM1));
@@ -251,288 +273,246 @@ void CommonAsmRoutines::GenQuantizedStores()
 #endif
 	CVTTPS2DQ(XMM0, R(XMM0));
 	PACKSSDW(XMM0, R(XMM0));
-	MOVD_xmm(R(EAX), XMM0);
-	BSWAP(32, EAX);
-	ROL(32, R(EAX), Imm8(16));
-	SafeWriteRegToReg(EAX, ECX, 32, 0, QUANTIZED_REGS_TO_SAVE, SAFE_LOADSTORE_NO_SWAP | SAFE_LOADSTORE_NO_PROLOG | SAFE_LOADSTORE_NO_FASTMEM);
-
-	RET();
-
-	pairedStoreQuantized = reinterpret_cast<const u8**>(const_cast<u8*>(AlignCode16()));
-	ReserveCodeSpace(8 * sizeof(u8*));
-
-	pairedStoreQuantized[0] = storePairedFloat;
-	pairedStoreQuantized[1] = storePairedIllegal;
-	pairedStoreQuantized[2] = storePairedIllegal;
-	pairedStoreQuantized[3] = storePairedIllegal;
-	pairedStoreQuantized[4] = storePairedU8;
-	pairedStoreQuantized[5] = storePairedU16;
-	pairedStoreQuantized[6] = storePairedS8;
-	pairedStoreQuantized[7] = storePairedS16;
-}
-
-// See comment in header for in/outs.
-void CommonAsmRoutines::GenQuantizedSingleStores()
-{
-	const u8* storeSingleIllegal = AlignCode4();
-	UD2();
-
-	// Easy!
-	const u8* storeSingleFloat = AlignCode4();
-	SafeWriteFloatToReg(XMM0, ECX, QUANTIZED_REGS_TO_SAVE, SAFE_LOADSTORE_NO_PROLOG | SAFE_LOADSTORE_NO_FASTMEM);
-	RET();
-	/*
-	if (cpu_info.bSSSE3) {
-		PSHUFB(XMM0, M((void *)pbswapShuffle2x4));
-		// TODO: SafeWriteFloat
-		MOVSS(M(&psTemp[0]), XMM0);
-		MOV(32, R(EAX), M(&psTemp[0]));
-		SafeWriteRegToReg(EAX, ECX, 32, 0, SAFE_LOADSTORE_NO_SWAP | SAFE_LOADSTORE_NO_PROLOG | SAFE_LOADSTORE_NO_FASTMEM);
-	} else {
-		MOVSS(M(&psTemp[0]), XMM0);
-		MOV(32, R(EAX), M(&psTemp[0]));
-		SafeWriteRegToReg(EAX, ECX, 32, 0, SAFE_LOADSTORE_NO_PROLOG | SAFE_LOADSTORE_NO_FASTMEM);
-	}*/
-
-	const u8* storeSingleU8 = AlignCode4();  // Used by MKWii
-	SHR(32, R(EAX), Imm8(6));
-	MOVSS(XMM1, MDisp(EAX, (u32)(u64)m_quantizeTableS));
-	MULSS(XMM0, R(XMM1));
-	PXOR(XMM1, R(XMM1));
-	MAXSS(XMM0, R(XMM1));
-	MINSS(XMM0, M((void *)&m_255));
-	CVTTSS2SI(EAX, R(XMM0));
-	SafeWriteRegToReg(AL, ECX, 8, 0, QUANTIZED_REGS_TO_SAVE, SAFE_LOADSTORE_NO_PROLOG | SAFE_LOADSTORE_NO_FASTMEM);
-	RET();
-
-	const u8* storeSingleS8 = AlignCode4();
-	SHR(32, R(EAX), Imm8(6));
-	MOVSS(XMM1, MDisp(EAX, (u32)(u64)m_quantizeTableS));
-	MULSS(XMM0, R(XMM1));
-	MAXSS(XMM0, M((void *)&m_m128));
-	MINSS(XMM0, M((void *)&m_127));
-	CVTTSS2SI(EAX, R(XMM0));
-	SafeWriteRegToReg(AL, ECX, 8, 0, QUANTIZED_REGS_TO_SAVE, SAFE_LOADSTORE_NO_PROLOG | SAFE_LOADSTORE_NO_FASTMEM);
-	RET();
-
-	const u8* storeSingleU16 = AlignCode4();  // Used by MKWii
-	SHR(32, R(EAX), Imm8(6));
-	MOVSS(XMM1, MDisp(EAX, (u32)(u64)m_quantizeTableS));
-	MULSS(XMM0, R(XMM1));
-	PXOR(XMM1, R(XMM1));
-	MAXSS(XMM0, R(XMM1));
-	MINSS(XMM0, M((void *)&m_65535));
-	CVTTSS2SI(EAX, R(XMM0));
-	SafeWriteRegToReg(EAX, ECX, 16, 0, QUANTIZED_REGS_TO_SAVE, SAFE_LOADSTORE_NO_PROLOG | SAFE_LOADSTORE_NO_FASTMEM);
-	RET();
-
-	const u8* storeSingleS16 = AlignCode4();
-	SHR(32, R(EAX), Imm8(6));
-	MOVSS(XMM1, MDisp(EAX, (u32)(u64)m_quantizeTableS));
-	MULSS(XMM0, R(XMM1));
-	MAXSS(XMM0, M((void *)&m_m32768));
-	MINSS(XMM0, M((void *)&m_32767));
-	CVTTSS2SI(EAX, R(XMM0));
-	SafeWriteRegToReg(EAX, ECX, 16, 0, QUANTIZED_REGS_TO_SAVE, SAFE_LOADSTORE_NO_PROLOG | SAFE_LOADSTORE_NO_FASTMEM);
-	RET();
-
-	singleStoreQuantized = reinterpret_cast<const u8**>(const_cast<u8*>(AlignCode16()));
-	ReserveCodeSpace(8 * sizeof(u8*));
-
-	singleStoreQuantized[0] = storeSingleFloat;
-	singleStoreQuantized[1] = storeSingleIllegal;
-	singleStoreQuantized[2] = storeSingleIllegal;
-	singleStoreQuantized[3] = storeSingleIllegal;
-	singleStoreQuantized[4] = storeSingleU8;
-	singleStoreQuantized[5] = storeSingleU16;
-	singleStoreQuantized[6] = storeSingleS8;
-	singleStoreQuantized[7] = storeSingleS16;
+	switch (type)
+	{
+	case QUANTIZE_U8:
+		PACKUSWB(XMM0, R(XMM0));
+		MOVD_xmm(R(EAX), XMM0);
+		SafeWriteRegToReg(AX, ECX, 16, 0, registersInUse, flags | SAFE_LOADSTORE_NO_SWAP);
+		break;
+	case QUANTIZE_S8:
+		PACKSSWB(XMM0, R(XMM0));
+		MOVD_xmm(R(EAX), XMM0);
+		SafeWriteRegToReg(AX, ECX, 16, 0, registersInUse, flags | SAFE_LOADSTORE_NO_SWAP);
+		break;
+	case QUANTIZE_S16:
+		MOVD_xmm(R(EAX), XMM0);
+		BSWAP(32, EAX);
+		ROL(32, R(EAX), Imm8(16));
+		SafeWriteRegToReg(EAX, ECX, 32, 0, registersInUse, flags | SAFE_LOADSTORE_NO_SWAP);
+		break;
+	default:
+		break;
+	}
 }
 
-void CommonAsmRoutines::GenQuantizedLoads()
+void QuantizedMemoryRoutines::GenQuantizedLoad(bool single, EQuantizeType type, int quantize)
 {
-	const u8* loadPairedIllegal = AlignCode4();
-	UD2();
-
-	const u8* loadPairedFloatTwo = AlignCode4();
-	if (cpu_info.bSSSE3) {
+	switch (type)
+	{
+	case QUANTIZE_FLOAT:
+		if (single)
+		{
+			if (cpu_info.bSSSE3) {
 #if _M_X86_64
-		MOVQ_xmm(XMM0, MComplex(RBX, RCX, 1, 0));
+				MOVD_xmm(XMM0, MComplex(RBX, RCX, 1, 0));
 #else
-		AND(32, R(ECX), Imm32(Memory::MEMVIEW32_MASK));
-		MOVQ_xmm(XMM0, MDisp(ECX, (u32)Memory::base));
+				AND(32, R(ECX), Imm32(Memory::MEMVIEW32_MASK));
+				MOVD_xmm(XMM0, MDisp(ECX, (u32)Memory::base));
 #endif
-		PSHUFB(XMM0, M((void *)pbswapShuffle2x4));
-	} else {
+				PSHUFB(XMM0, M((void *)pbswapShuffle1x4));
+				UNPCKLPS(XMM0, M((void*)m_one));
+			} else {
 #if _M_X86_64
-		LoadAndSwap(64, RCX, MComplex(RBX, RCX, 1, 0));
-		ROL(64, R(RCX), Imm8(32));
-		MOVQ_xmm(XMM0, R(RCX));
+				LoadAndSwap(32, RCX, MComplex(RBX, RCX, 1, 0));
+				MOVD_xmm(XMM0, R(RCX));
+				UNPCKLPS(XMM0, M((void*)m_one));
 #else
-#if 0
-		AND(32, R(ECX), Imm32(Memory::MEMVIEW32_MASK));
-		MOVQ_xmm(XMM0, MDisp(ECX, (u32)Memory::base));
-		PXOR(XMM1, R(XMM1));
-		PSHUFLW(XMM0, R(XMM0), 0xB1);
-		MOVAPD(XMM1, R(XMM0));
-		PSRLW(XMM0, 8);
-		PSLLW(XMM1, 8);
-		POR(XMM0, R(XMM1));
-#else
-		AND(32, R(ECX), Imm32(Memory::MEMVIEW32_MASK));
-		MOV(32, R(EAX), MDisp(ECX, (u32)Memory::base));
-		BSWAP(32, EAX);
-		MOV(32, M(&psTemp[0]), R(RAX));
-		MOV(32, R(EAX), MDisp(ECX, (u32)Memory::base + 4));
-		BSWAP(32, EAX);
-		MOV(32, M(((float *)&psTemp[0]) + 1), R(RAX));
-		MOVQ_xmm(XMM0, M(&psTemp[0]));
+				AND(32, R(ECX), Imm32(Memory::MEMVIEW32_MASK));
+				MOV(32, R(EAX), MDisp(ECX, (u32)Memory::base));
+				BSWAP(32, EAX);
+				MOVD_xmm(XMM0, R(EAX));
+				UNPCKLPS(XMM0, M((void*)m_one));
 #endif
-#endif
-	}
-	RET();
-
-	const u8* loadPairedFloatOne = AlignCode4();
-	if (cpu_info.bSSSE3) {
+			}
+		}
+		else
+		{
+			if (cpu_info.bSSSE3) {
 #if _M_X86_64
-		MOVD_xmm(XMM0, MComplex(RBX, RCX, 1, 0));
+				MOVQ_xmm(XMM0, MComplex(RBX, RCX, 1, 0));
 #else
-		AND(32, R(ECX), Imm32(Memory::MEMVIEW32_MASK));
-		MOVD_xmm(XMM0, MDisp(ECX, (u32)Memory::base));
+				AND(32, R(ECX), Imm32(Memory::MEMVIEW32_MASK));
+				MOVQ_xmm(XMM0, MDisp(ECX, (u32)Memory::base));
 #endif
-		PSHUFB(XMM0, M((void *)pbswapShuffle1x4));
-		UNPCKLPS(XMM0, M((void*)m_one));
-	} else {
+				PSHUFB(XMM0, M((void *)pbswapShuffle2x4));
+			} else {
 #if _M_X86_64
-		LoadAndSwap(32, RCX, MComplex(RBX, RCX, 1, 0));
-		MOVD_xmm(XMM0, R(RCX));
-		UNPCKLPS(XMM0, M((void*)m_one));
+				LoadAndSwap(64, RCX, MComplex(RBX, RCX, 1, 0));
+				ROL(64, R(RCX), Imm8(32));
+				MOVQ_xmm(XMM0, R(RCX));
 #else
-		AND(32, R(ECX), Imm32(Memory::MEMVIEW32_MASK));
-		MOV(32, R(EAX), MDisp(ECX, (u32)Memory::base));
-		BSWAP(32, EAX);
-		MOVD_xmm(XMM0, R(EAX));
-		UNPCKLPS(XMM0, M((void*)m_one));
+				AND(32, R(ECX), Imm32(Memory::MEMVIEW32_MASK));
+				MOV(32, R(EAX), MDisp(ECX, (u32)Memory::base));
+				BSWAP(32, EAX);
+				MOV(32, M(&psTemp[0]), R(RAX));
+				MOV(32, R(EAX), MDisp(ECX, (u32)Memory::base + 4));
+				BSWAP(32, EAX);
+				MOV(32, M(((float *)&psTemp[0]) + 1), R(RAX));
+				MOVQ_xmm(XMM0, M(&psTemp[0]));
 #endif
+			}
+		}
+		return;
+
+	case QUANTIZE_U8:
+		if (single)
+		{
+			UnsafeLoadRegToRegNoSwap(ECX, ECX, 8, 0); // ECX = 0x000000xx
+			MOVD_xmm(XMM0, R(ECX));
+		}
+		else
+		{
+			UnsafeLoadRegToRegNoSwap(ECX, ECX, 16, 0);
+			MOVD_xmm(XMM0, R(ECX));
+			PXOR(XMM1, R(XMM1));
+			PUNPCKLBW(XMM0, R(XMM1));
+			PUNPCKLWD(XMM0, R(XMM1));
+		}
+		break;
+
+	case QUANTIZE_S8:
+		if (single)
+		{
+			UnsafeLoadRegToRegNoSwap(ECX, ECX, 8, 0);
+			SHL(32, R(ECX), Imm8(24));
+			SAR(32, R(ECX), Imm8(24));
+			MOVD_xmm(XMM0, R(ECX));
+		}
+		else
+		{
+			UnsafeLoadRegToRegNoSwap(ECX, ECX, 16, 0);
+			MOVD_xmm(XMM0, R(ECX));
+			PUNPCKLBW(XMM0, R(XMM0));
+			PUNPCKLWD(XMM0, R(XMM0));
+			PSRAD(XMM0, 24);
+		}
+		break;
+
+	case QUANTIZE_U16:
+		UnsafeLoadRegToReg(ECX, ECX, 32, 0, false);
+		if (single)
+		{
+			SHR(32, R(ECX), Imm8(16));
+			MOVD_xmm(XMM0, R(ECX));
+		}
+		else
+		{
+			ROL(32, R(ECX), Imm8(16));
+			MOVD_xmm(XMM0, R(ECX));
+			PXOR(XMM1, R(XMM1));
+			PUNPCKLWD(XMM0, R(XMM1));
+		}
+		break;
+
+	case QUANTIZE_S16:
+		UnsafeLoadRegToReg(ECX, ECX, 32, 0, false);
+		if (single)
+		{
+			SAR(32, R(ECX), Imm8(16));
+			MOVD_xmm(XMM0, R(ECX));
+		}
+		else
+		{
+			ROL(32, R(ECX), Imm8(16));
+			MOVD_xmm(XMM0, R(ECX));
+			PUNPCKLWD(XMM0, R(XMM0));
+			PSRAD(XMM0, 16);
+		}
+		break;
+
+	default:
+		return;
 	}
-	RET();
-
-	const u8* loadPairedU8Two = AlignCode4();
-	UnsafeLoadRegToRegNoSwap(ECX, ECX, 16, 0);
-	MOVD_xmm(XMM0, R(ECX));
-	PXOR(XMM1, R(XMM1));
-	PUNPCKLBW(XMM0, R(XMM1));
-	PUNPCKLWD(XMM0, R(XMM1));
-	CVTDQ2PS(XMM0, R(XMM0));
-	SHR(32, R(EAX), Imm8(6));
-	MOVSS(XMM1, MDisp(EAX, (u32)(u64)m_dequantizeTableS));
-	PUNPCKLDQ(XMM1, R(XMM1));
-	MULPS(XMM0, R(XMM1));
-	RET();
 
-	const u8* loadPairedU8One = AlignCode4();
-	UnsafeLoadRegToRegNoSwap(ECX, ECX, 8, 0); // ECX = 0x000000xx
-	MOVD_xmm(XMM0, R(ECX));
 	CVTDQ2PS(XMM0, R(XMM0)); // Is CVTSI2SS better?
-	SHR(32, R(EAX), Imm8(6));
-	MOVSS(XMM1, MDisp(EAX, (u32)(u64)m_dequantizeTableS));
-	MULSS(XMM0, R(XMM1));
-	UNPCKLPS(XMM0, M((void*)m_one));
-	RET();
+	if (quantize != 0)
+	{
+		LoadQuantizeScale(m_dequantizeTableS, quantize, type == QUANTIZE_S16);
+		if (single)
+		{
+			MULSS(XMM0, R(XMM1));
+		}
+		else
+		{
+			PUNPCKLDQ(XMM1, R(XMM1));
+			MULPS(XMM0, R(XMM1));
+		}
+	}
+	if (single)
+		UNPCKLPS(XMM0, M((void*)m_one));
+}
 
-	const u8* loadPairedS8Two = AlignCode4();
-	UnsafeLoadRegToRegNoSwap(ECX, ECX, 16, 0);
-	MOVD_xmm(XMM0, R(ECX));
-	PUNPCKLBW(XMM0, R(XMM0));
-	PUNPCKLWD(XMM0, R(XMM0));
-	PSRAD(XMM0, 24);
-	CVTDQ2PS(XMM0, R(XMM0));
-	SHR(32, R(EAX), Imm8(6));
-	MOVSS(XMM1, MDisp(EAX, (u32)(u64)m_dequantizeTableS));
-	PUNPCKLDQ(XMM1, R(XMM1));
-	MULPS(XMM0, R(XMM1));
-	RET();
+static bool IsLegalQuantizeType(int type)
+{
+	return type == QUANTIZE_FLOAT || type >= QUANTIZE_U8;
+}
 
-	const u8* loadPairedS8One = AlignCode4();
-	UnsafeLoadRegToRegNoSwap(ECX, ECX, 8, 0);
-	SHL(32, R(ECX), Imm8(24));
-	SAR(32, R(ECX), Imm8(24));
-	MOVD_xmm(XMM0, R(ECX));
-	CVTDQ2PS(XMM0, R(XMM0));
-	SHR(32, R(EAX), Imm8(6));
-	MOVSS(XMM1, MDisp(EAX, (u32)(u64)m_dequantizeTableS));
-	MULSS(XMM0, R(XMM1));
-	UNPCKLPS(XMM0, M((void*)m_one));
-	RET();
+// See comment in header for in/outs.
+void CommonAsmRoutines::GenQuantizedStores()
+{
+	const u8* storePairedIllegal = AlignCode4();
+	UD2();
 
-	const u8* loadPairedU16Two = AlignCode4();
-	UnsafeLoadRegToReg(ECX, ECX, 32, 0, false);
-	ROL(32, R(ECX), Imm8(16));
-	MOVD_xmm(XMM0, R(ECX));
-	PXOR(XMM1, R(XMM1));
-	PUNPCKLWD(XMM0, R(XMM1));
-	CVTDQ2PS(XMM0, R(XMM0));
-	SHR(32, R(EAX), Imm8(6));
-	MOVSS(XMM1, MDisp(EAX, (u32)(u64)m_dequantizeTableS));
-	PUNPCKLDQ(XMM1, R(XMM1));
-	MULPS(XMM0, R(XMM1));
-	RET();
+	pairedStoreQuantized = reinterpret_cast<const u8**>(const_cast<u8*>(AlignCode16()));
+	ReserveCodeSpace(8 * sizeof(u8*));
 
-	const u8* loadPairedU16One = AlignCode4();
-	UnsafeLoadRegToReg(ECX, ECX, 32, 0, false);
-	SHR(32, R(ECX), Imm8(16));
-	MOVD_xmm(XMM0, R(ECX));
-	CVTDQ2PS(XMM0, R(XMM0));
-	SHR(32, R(EAX), Imm8(6));
-	MOVSS(XMM1, MDisp(EAX, (u32)(u64)m_dequantizeTableS));
-	MULSS(XMM0, R(XMM1));
-	UNPCKLPS(XMM0, M((void*)m_one));
-	RET();
+	for (int type = 0; type < 8; type++)
+	{
+		if (!IsLegalQuantizeType(type))
+		{
+			pairedStoreQuantized[type] = storePairedIllegal;
+			continue;
+		}
+		pairedStoreQuantized[type] = AlignCode4();
+		GenQuantizedStore(false, (EQuantizeType)type, -1, QUANTIZED_REGS_TO_SAVE,
+		                  SAFE_LOADSTORE_NO_PROLOG | SAFE_LOADSTORE_NO_FASTMEM);
+		RET();
+	}
+}
 
-	const u8* loadPairedS16Two = AlignCode4();
-	UnsafeLoadRegToReg(ECX, ECX, 32, 0, false);
-	ROL(32, R(ECX), Imm8(16));
-	MOVD_xmm(XMM0, R(ECX));
-	PUNPCKLWD(XMM0, R(XMM0));
-	PSRAD(XMM0, 16);
-	CVTDQ2PS(XMM0, R(XMM0));
-	SHR(32, R(EAX), Imm8(6));
-	AND(32, R(EAX), Imm32(0xFC));
-	MOVSS(XMM1, MDisp(EAX, (u32)(u64)m_dequantizeTableS));
-	PUNPCKLDQ(XMM1, R(XMM1));
-	MULPS(XMM0, R(XMM1));
-	RET();
+// See comment in header for in/outs.
+void CommonAsmRoutines::GenQuantizedSingleStores()
+{
+	const u8* storeSingleIllegal = AlignCode4();
+	UD2();
 
-	const u8* loadPairedS16One = AlignCode4();
-	UnsafeLoadRegToReg(ECX, ECX, 32, 0, false);
-	SAR(32, R(ECX), Imm8(16));
-	MOVD_xmm(XMM0, R(ECX));
-	CVTDQ2PS(XMM0, R(XMM0));
-	SHR(32, R(EAX), Imm8(6));
-	AND(32, R(EAX), Imm32(0xFC));
-	MOVSS(XMM1, MDisp(EAX, (u32)(u64)m_dequantizeTableS));
-	MULSS(XMM0, R(XMM1));
-	UNPCKLPS(XMM0, M((void*)m_one));
-	RET();
+	singleStoreQuantized = reinterpret_cast<const u8**>(const_cast<u8*>(AlignCode16()));
+	ReserveCodeSpace(8 * sizeof(u8*));
+
+	for (int type = 0; type < 8; type++)
+	{
+		if (!IsLegalQuantizeType(type))
+		{
+			singleStoreQuantized[type] = storeSingleIllegal;
+			continue;
+		}
+		singleStoreQuantized[type] = AlignCode4();
+		GenQuantizedStore(true, (EQuantizeType)type, -1, QUANTIZED_REGS_TO_SAVE,
+		                  SAFE_LOADSTORE_NO_PROLOG | SAFE_LOADSTORE_NO_FASTMEM);
+		RET();
+	}
+}
+
+void CommonAsmRoutines::GenQuantizedLoads()
+{
+	const u8* loadPairedIllegal = AlignCode4();
+	UD2();
 
 	pairedLoadQuantized = reinterpret_cast<const u8**>(const_cast<u8*>(AlignCode16()));
 	ReserveCodeSpace(16 * sizeof(u8*));
 
-	pairedLoadQuantized[0] = loadPairedFloatTwo;
-	pairedLoadQuantized[1] = loadPairedIllegal;
-	pairedLoadQuantized[2] = loadPairedIllegal;
-	pairedLoadQuantized[3] = loadPairedIllegal;
-	pairedLoadQuantized[4] = loadPairedU8Two;
-	pairedLoadQuantized[5] = loadPairedU16Two;
-	pairedLoadQuantized[6] = loadPairedS8Two;
-	pairedLoadQuantized[7] = loadPairedS16Two;
-
-	pairedLoadQuantized[8] = loadPairedFloatOne;
-	pairedLoadQuantized[9] = loadPairedIllegal;
-	pairedLoadQuantized[10] = loadPairedIllegal;
-	pairedLoadQuantized[11] = loadPairedIllegal;
-	pairedLoadQuantized[12] = loadPairedU8One;
-	pairedLoadQuantized[13] = loadPairedU16One;
-	pairedLoadQuantized[14] = loadPairedS8One;
-	pairedLoadQuantized[15] = loadPairedS16One;
+	// Pairs first, then single values
+	for (int i = 0; i < 16; i++)
+	{
+		int type = i & 7;
+		if (!IsLegalQuantizeType(type))
+		{
+			pairedLoadQuantized[i] = loadPairedIllegal;
+			continue;
+		}
+		pairedLoadQuantized[i] = AlignCode4();
+		GenQuantizedLoad(i >= 8, (EQuantizeType)type, -1);
+		RET();
+	}
 }
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "Core/PowerPC/Gekko.h"
 #include "Core/PowerPC/JitCommon/Jit_Util.h"
 
 class CommonAsmRoutinesBase
@@ -52,7 +53,30 @@ public:
 
 };
 
-class CommonAsmRoutines : public CommonAsmRoutinesBase, public EmuCodeBlock
+// The quantized load and store sequences, shared by the asm routines, which
+// read the type and scale from the GQR at runtime, and by blocks that were
+// compiled for a known GQR value.
+class QuantizedMemoryRoutines : public EmuCodeBlock
+{
+public:
+	// In: ECX: Address to read from.
+	// In: EAX: Upper half of the GQR, only if quantize is -1.
+	// Out: XMM0: Bottom two 32-bit slots hold the read value, the second one
+	//            is 1.0 for single loads.
+	// Trashes: EAX ECX XMM1
+	void GenQuantizedLoad(bool single, EQuantizeType type, int quantize);
+
+	// In: ECX: Address to write to.
+	// In: EAX: Lower half of the GQR, only if quantize is -1.
+	// In: XMM0: The float, or the pair of floats, to write.
+	// Trashes: EAX ECX EDX XMM0 XMM1
+	void GenQuantizedStore(bool single, EQuantizeType type, int quantize, u32 registersInUse, int flags);
+
+private:
+	void LoadQuantizeScale(const float* table, int quantize, bool mask);
+};
+
+class CommonAsmRoutines : public CommonAsmRoutinesBase, public QuantizedMemoryRoutines
 {
 protected:
 	void GenQuantizedLoads();
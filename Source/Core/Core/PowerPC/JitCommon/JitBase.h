@@ -8,6 +8,7 @@
 //#define JIT_LOG_GPR     // Enables logging of the PPC general purpose regs
 //#define JIT_LOG_FPR     // Enables logging of the PPC floating point regs
 
+#include <unordered_map>
 #include <unordered_set>
 
 #include "Common/x64ABI.h"
@@ -48,6 +49,7 @@ protected:
 		bool optimizeGatherPipe;
 		bool fastInterrupts;
 		bool accurateSinglePrecision;
+		bool carryRegisters;
 	};
 	struct JitState
 	{
@@ -72,6 +74,9 @@ protected:
 
 		int fifoBytesThisBlock;
 
+		// GQRs whose current value the block was compiled for, checked on entry.
+		u8 constantGqr;
+
 		PPCAnalyst::BlockStats st;
 		PPCAnalyst::BlockRegStats gpa;
 		PPCAnalyst::BlockRegStats fpa;
@@ -81,6 +86,12 @@ protected:
 		JitBlock *curBlock;
 
 		std::unordered_set<u32> fifoWriteAddresses;
+		// Blocks that were entered with a different GQR than they were compiled
+		// for, and how often that happened.
+		std::unordered_map<u32, int> gqrGuardFailures;
+		// Registers the first block exiting to an address carried, so the block
+		// there gets compiled to expect the same ones.
+		std::unordered_map<u32, u32> carryHints;
 	};
 
 	PPCAnalyst::CodeBlock code_block;
@@ -102,7 +113,7 @@ public:
 	virtual bool IsInCodeSpace(u8 *ptr) = 0;
 };
 
-class Jitx86Base : public JitBase, public EmuCodeBlock
+class Jitx86Base : public JitBase, public QuantizedMemoryRoutines
 {
 protected:
 	JitBlockCache blocks;
@@ -63,6 +63,8 @@ using namespace Gen;
 		memset(iCache, JIT_ICACHE_INVALID_BYTE, JIT_ICACHE_SIZE);
 		memset(iCacheEx, JIT_ICACHE_INVALID_BYTE, JIT_ICACHEEX_SIZE);
 		memset(iCacheVMEM, JIT_ICACHE_INVALID_BYTE, JIT_ICACHE_SIZE);
+		carried_links = carried_loads = carried_stores = 0;
+		counted_carried_links.clear();
 		Clear();
 	}
 
@@ -108,6 +110,8 @@ using namespace Gen;
 		}
 		links_to.clear();
 		block_map.clear();
+		inlined_map.clear();
+		max_inlined_size = 0;
 		valid_block.reset();
 		num_blocks = 0;
 		memset(blockCodePointers, 0, sizeof(u8*)*MAX_NUM_BLOCKS);
@@ -164,7 +168,10 @@ using namespace Gen;
 		JitBlock &b = blocks[num_blocks];
 		b.invalid = false;
 		b.originalAddress = em_address;
+		b.linkedEntry = nullptr;
+		b.carriedRegs = 0;
 		b.linkData.clear();
+		b.inlinedRanges.clear();
 		num_blocks++; //commit the current block
 		return num_blocks - 1;
 	}
@@ -183,6 +190,15 @@ using namespace Gen;
 			valid_block[pAddr / 32 + i] = true;
 
 		block_map[std::make_pair(pAddr + 4 * b.originalSize - 1, pAddr)] = block_num;
+
+		for (const auto& range : b.inlinedRanges)
+		{
+			u32 start = range.first & 0x1FFFFFFF;
+			for (u32 line = start / 32; line <= (start + range.second - 1) / 32; ++line)
+				valid_block[line] = true;
+			inlined_map.insert(std::make_pair(start, block_num));
+			max_inlined_size = std::max(max_inlined_size, range.second);
+		}
 		if (block_link)
 		{
 			for (const auto& e : b.linkData)
@@ -273,13 +289,34 @@ using namespace Gen;
 				int destinationBlock = GetBlockNumberFromStartAddress(e.exitAddress);
 				if (destinationBlock != -1)
 				{
-					WriteLinkBlock(e.exitPtrs, blocks[destinationBlock].checkedEntry);
+					const JitBlock &destination = blocks[destinationBlock];
+					if (e.carryPtr && destination.linkedEntry && destination.carriedRegs == b.carriedRegs)
+					{
+						WriteLinkBlock(e.carryPtr, destination.linkedEntry);
+						CountCarriedLink(b, destination, e);
+					}
+					else
+						WriteLinkBlock(e.exitPtrs, destination.checkedEntry);
 					e.linkStatus = true;
 				}
 			}
 		}
 	}
 
+	void JitBaseBlockCache::CountCarriedLink(const JitBlock &source, const JitBlock &destination, const JitBlock::LinkData &link)
+	{
+		if (!counted_carried_links.insert(std::make_pair(source.originalAddress, link.exitAddress)).second)
+			return;
+
+		carried_links++;
+		for (int i = 0; i < 32; i++)
+		{
+			if (destination.carriedRegs & (1u << i))
+				carried_loads++;
+		}
+		carried_stores += link.carriedStores;
+	}
+
 	using namespace std;
 
 	void JitBaseBlockCache::LinkBlock(int i)
@@ -310,7 +347,13 @@ using namespace Gen;
 			for (auto& e : sourceBlock.linkData)
 			{
 				if (e.exitAddress == b.originalAddress)
+				{
+					// The checked entry gets overwritten when the block is
+					// destroyed, the linked entry doesn't.
+					if (e.carryPtr && e.linkStatus)
+						WriteLinkBlock(e.carryPtr, e.carryUnlinked);
 					e.linkStatus = false;
+				}
 			}
 		}
 		links_to.erase(b.originalAddress);
@@ -333,6 +376,19 @@ using namespace Gen;
 		b.invalid = true;
 		*GetICachePtr(b.originalAddress) = JIT_ICACHE_INVALID_WORD;
 
+		for (const auto& range : b.inlinedRanges)
+		{
+			auto entries = inlined_map.equal_range(range.first & 0x1FFFFFFF);
+			for (auto it = entries.first; it != entries.second; ++it)
+			{
+				if (it->second == block_num)
+				{
+					inlined_map.erase(it);
+					break;
+				}
+			}
+		}
+
 		UnlinkBlock(block_num);
 
 		// Send anyone who tries to run this block back to the dispatcher.
@@ -372,6 +428,33 @@ using namespace Gen;
 			{
 				block_map.erase(it1, it2);
 			}
+
+			// Blocks that inlined a function from the range. Collect them first,
+			// destroying a block removes its entries from inlined_map.
+			std::vector<int> inlined_blocks;
+			auto it = inlined_map.lower_bound(pAddr > max_inlined_size ? pAddr - max_inlined_size : 0);
+			for (; it != inlined_map.end() && it->first < pAddr + length; ++it)
+			{
+				for (const auto& range : blocks[it->second].inlinedRanges)
+				{
+					if ((range.first & 0x1FFFFFFF) == it->first && it->first + range.second > pAddr)
+					{
+						inlined_blocks.push_back(it->second);
+						break;
+					}
+				}
+			}
+			for (int block_num : inlined_blocks)
+			{
+				JitBlock &b = blocks[block_num];
+				if (b.invalid)
+					continue;
+				u32 start = b.originalAddress & 0x1FFFFFFF;
+				auto own = block_map.find(std::make_pair(start + 4 * b.originalSize - 1, start));
+				if (own != block_map.end() && own->second == (u32)block_num)
+					block_map.erase(own);
+				DestroyBlock(block_num, true);
+			}
 		}
 
 		// invalidate iCache.
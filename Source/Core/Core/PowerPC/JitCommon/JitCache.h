@@ -6,6 +6,7 @@
 
 #include <bitset>
 #include <map>
+#include <set>
 #include <vector>
 
 #include "Core/PowerPC/Gekko.h"
@@ -42,10 +43,25 @@ struct JitBlock
 
 	bool invalid;
 
+	// Blocks compiled with carried registers (see Jit64::WriteExit) can be
+	// entered here with those registers already loaded. Only exits of blocks
+	// carrying the same registers jump here.
+	const u8 *linkedEntry;
+	u32 carriedRegs;
+
+	// Code of inlined functions outside the block's own range, as (address,
+	// size in bytes). Writes there have to invalidate the block too.
+	std::vector<std::pair<u32, u32>> inlinedRanges;
+
 	struct LinkData {
 		u8 *exitPtrs;    // to be able to rewrite the exit jum
+		u8 *carryPtr;    // jump to the linked entry, if the exit carries registers
+		const u8 *carryUnlinked; // where carryPtr jumps while not linked
+		u32 carriedStores; // dirty carried registers left in place by the carry jump
 		u32 exitAddress;
 		bool linkStatus; // is it already linked?
+
+		LinkData() : exitPtrs(nullptr), carryPtr(nullptr), carryUnlinked(nullptr), carriedStores(0), exitAddress(0), linkStatus(false) {}
 	};
 	std::vector<LinkData> linkData;
 
@@ -72,7 +88,12 @@ class JitBaseBlockCache
 	int num_blocks;
 	std::multimap<u32, int> links_to;
 	std::map<std::pair<u32,u32>, u32> block_map; // (end_addr, start_addr) -> number
+	std::multimap<u32, int> inlined_map; // start_addr of inlined code -> number
+	u32 max_inlined_size;
 	std::bitset<0x20000000 / 32> valid_block;
+	u32 carried_links, carried_loads, carried_stores;
+	// (source block, exit address) of every carried link counted so far
+	std::set<std::pair<u32, u32>> counted_carried_links;
 	enum
 	{
 		MAX_NUM_BLOCKS = 65536*2
@@ -89,8 +110,8 @@ class JitBaseBlockCache
 
 public:
 	JitBaseBlockCache() :
-		blockCodePointers(nullptr), blocks(nullptr), num_blocks(0),
-		iCache(nullptr), iCacheEx(nullptr), iCacheVMEM(nullptr) {}
+		blockCodePointers(nullptr), blocks(nullptr), num_blocks(0), max_inlined_size(0),
+		carried_links(0), carried_loads(0), carried_stores(0), iCache(nullptr), iCacheEx(nullptr), iCacheVMEM(nullptr) {}
 	int AllocateBlock(u32 em_address);
 	void FinalizeBlock(int block_num, bool block_link, const u8 *code_ptr);
 
@@ -118,8 +139,15 @@ public:
 	u32 GetOriginalFirstOp(int block_num);
 	CompiledCode GetCompiledCodeFromBlock(int block_num);
 
-	// DOES NOT WORK CORRECTLY WITH INLINING
 	void InvalidateICache(u32 address, const u32 length);
+
+	// Exits linked to a linked entry, and the loads and stores those links save
+	// each time they are taken. Counted when linking, not while running, and
+	// only the first time, relinking after an invalidation doesn't count again.
+	void CountCarriedLink(const JitBlock &source, const JitBlock &destination, const JitBlock::LinkData &link);
+	u32 GetCarriedLinks() const { return carried_links; }
+	u32 GetCarriedLoads() const { return carried_loads; }
+	u32 GetCarriedStores() const { return carried_stores; }
 	void DestroyBlock(int block_num, bool invalidate);
 
 	// Not currently used
@@ -143,6 +143,10 @@ InstLoc IRBuilder::EmitZeroOp(unsigned Opcode, unsigned extra = 0) {
 }
 
 InstLoc IRBuilder::EmitUOp(unsigned Opcode, InstLoc Op1, unsigned extra) {
+	ValueKey key;
+	if (InstLoc known = FindValue(Opcode, Op1, nullptr, &key))
+		return known;
+
 	InstLoc curIndex = InstList.data() + InstList.size();
 	unsigned backOp1 = (s32)(curIndex - 1 - Op1);
 	if (backOp1 >= 256) {
@@ -153,10 +157,16 @@ InstLoc IRBuilder::EmitUOp(unsigned Opcode, InstLoc Op1, unsigned extra) {
 	}
 	InstList.push_back(Opcode | (backOp1 << 8) | (extra << 16));
 	MarkUsed.push_back(false);
+	if (std::get<0>(key) != Nop)
+		ValueTable[key] = curIndex;
 	return curIndex;
 }
 
 InstLoc IRBuilder::EmitBiOp(unsigned Opcode, InstLoc Op1, InstLoc Op2, unsigned extra) {
+	ValueKey key;
+	if (InstLoc known = FindValue(Opcode, Op1, Op2, &key))
+		return known;
+
 	InstLoc curIndex = InstList.data() + InstList.size();
 	unsigned backOp1 = (s32)(curIndex - 1 - Op1);
 	if (backOp1 >= 255) {
@@ -175,6 +185,8 @@ InstLoc IRBuilder::EmitBiOp(unsigned Opcode, InstLoc Op1, InstLoc Op2, unsigned
 	}
 	InstList.push_back(Opcode | (backOp1 << 8) | (backOp2 << 16) | (extra << 24));
 	MarkUsed.push_back(false);
+	if (std::get<0>(key) != Nop)
+		ValueTable[key] = curIndex;
 	return curIndex;
 }
 
@@ -245,88 +257,66 @@ unsigned IRBuilder::ComputeKnownZeroBits(InstLoc I) const {
 	}
 }
 
+// Reg load folding: if we already loaded or stored the value,
+// use it again
+InstLoc IRBuilder::FoldRegLoad(InstLoc& cache, unsigned Opcode, unsigned extra) {
+	if (cache)
+		Stats.foldedLoads++;
+	else
+		cache = EmitZeroOp(Opcode, extra);
+	return cache;
+}
+
 InstLoc IRBuilder::FoldZeroOp(unsigned Opcode, unsigned extra) {
-	if (Opcode == LoadGReg) {
-		// Reg load folding: if we already loaded the value,
-		// load it again
-		if (!GRegCache[extra])
-			GRegCache[extra] = EmitZeroOp(LoadGReg, extra);
-		return GRegCache[extra];
-	}
-	if (Opcode == LoadFReg) {
-		// Reg load folding: if we already loaded the value,
-		// load it again
-		if (!FRegCache[extra])
-			FRegCache[extra] = EmitZeroOp(LoadFReg, extra);
-		return FRegCache[extra];
-	}
+	if (Opcode == LoadGReg)
+		return FoldRegLoad(GRegCache[extra], Opcode, extra);
+	if (Opcode == LoadFReg)
+		return FoldRegLoad(FRegCache[extra], Opcode, extra);
 	if (Opcode == LoadFRegDENToZero) {
-		FRegCacheStore[extra] = nullptr; // prevent previous store operation from zapping
 		FRegCache[extra] = EmitZeroOp(LoadFRegDENToZero, extra);
 		return FRegCache[extra];
 	}
-	if (Opcode == LoadCarry) {
-		if (!CarryCache)
-			CarryCache = EmitZeroOp(LoadCarry, extra);
-		return CarryCache;
-	}
-	if (Opcode == LoadCR) {
-		if (!CRCache[extra])
-			CRCache[extra] = EmitZeroOp(LoadCR, extra);
-		return CRCache[extra];
-	}
-	if (Opcode == LoadCTR) {
-		if (!CTRCache)
-			CTRCache = EmitZeroOp(LoadCTR, extra);
-		return CTRCache;
-	}
+	if (Opcode == LoadCarry)
+		return FoldRegLoad(CarryCache, Opcode, extra);
+	if (Opcode == LoadCR)
+		return FoldRegLoad(CRCache[extra], Opcode, extra);
+	if (Opcode == LoadCTR)
+		return FoldRegLoad(CTRCache, Opcode, extra);
+	if (Opcode == LoadLink)
+		return FoldRegLoad(LinkCache, Opcode, extra);
 
 	return EmitZeroOp(Opcode, extra);
 }
 
-InstLoc IRBuilder::FoldUOp(unsigned Opcode, InstLoc Op1, unsigned extra) {
-	if (Opcode == StoreGReg) {
-		// Reg store folding: save the value for load folding.
-		// If there's a previous store, zap it because it's dead.
-		GRegCache[extra] = Op1;
-		if (GRegCacheStore[extra]) {
-			*GRegCacheStore[extra] = 0;
-		}
-		GRegCacheStore[extra] = EmitUOp(StoreGReg, Op1, extra);
-		return GRegCacheStore[extra];
+// Reg store folding: save the value for load folding. Storing the value
+// the register already holds is dropped right away; stores that get
+// overwritten are left to EliminateDeadStores, which knows about exits.
+InstLoc IRBuilder::FoldRegStore(InstLoc& cache, unsigned Opcode, InstLoc Op1, unsigned extra) {
+	if (cache == Op1) {
+		Stats.deadStores++;
+		return nullptr;
 	}
+	cache = Op1;
+	return EmitUOp(Opcode, Op1, extra);
+}
+
+InstLoc IRBuilder::FoldUOp(unsigned Opcode, InstLoc Op1, unsigned extra) {
+	if (Opcode == StoreGReg)
+		return FoldRegStore(GRegCache[extra], Opcode, Op1, extra);
 	if (Opcode == StoreFReg) {
+		// The cached value may be a LoadFRegDENToZero, which isn't what
+		// the register holds
 		FRegCache[extra] = Op1;
-		if (FRegCacheStore[extra]) {
-			*FRegCacheStore[extra] = 0;
-		}
-		FRegCacheStore[extra] = EmitUOp(StoreFReg, Op1, extra);
-		return FRegCacheStore[extra];
-	}
-	if (Opcode == StoreCarry) {
-		CarryCache = Op1;
-		if (CarryCacheStore) {
-			*CarryCacheStore = 0;
-		}
-		CarryCacheStore = EmitUOp(StoreCarry, Op1, extra);
-		return CarryCacheStore;
-	}
-	if (Opcode == StoreCR) {
-		CRCache[extra] = Op1;
-		if (CRCacheStore[extra]) {
-			*CRCacheStore[extra] = 0;
-		}
-		CRCacheStore[extra] = EmitUOp(StoreCR, Op1, extra);
-		return CRCacheStore[extra];
-	}
-	if (Opcode == StoreCTR) {
-		CTRCache = Op1;
-		if (CTRCacheStore) {
-			*CTRCacheStore = 0;
-		}
-		CTRCacheStore = EmitUOp(StoreCTR, Op1, extra);
-		return CTRCacheStore;
-	}
+		return EmitUOp(StoreFReg, Op1, extra);
+	}
+	if (Opcode == StoreCarry)
+		return FoldRegStore(CarryCache, Opcode, Op1, extra);
+	if (Opcode == StoreCR)
+		return FoldRegStore(CRCache[extra], Opcode, Op1, extra);
+	if (Opcode == StoreCTR)
+		return FoldRegStore(CTRCache, Opcode, Op1, extra);
+	if (Opcode == StoreLink)
+		return FoldRegStore(LinkCache, Opcode, Op1, extra);
 	if (Opcode == CompactMRegToPacked) {
 		if (getOpcode(*Op1) == ExpandPackedToMReg)
 			return getOp1(Op1);
@@ -638,11 +628,12 @@ InstLoc IRBuilder::FoldMulHighUnsigned(InstLoc Op1, InstLoc Op2) {
 		const unsigned imm = GetImmValue(Op2);
 
 		// (x * 0) >> 32 => 0
-		if (imm == 0) {
+		// (x * 1) >> 32 => 0, a shift by 32 would leave x alone
+		if (imm == 0 || imm == 1) {
 			return EmitIntConst(0);
 		}
 
-		for (unsigned i0 = 0; i0 < 30; ++i0) {
+		for (unsigned i0 = 1; i0 < 30; ++i0) {
 			// (x * (1 << i0)) => x >> (32 - i0)
 			// One "shl" is faster than one "imul".
 			if (imm == (1U << i0)) {
@@ -998,20 +989,7 @@ InstLoc IRBuilder::FoldICmpCRUnsigned(InstLoc Op1, InstLoc Op2) {
 }
 
 InstLoc IRBuilder::FoldFallBackToInterpreter(InstLoc Op1, InstLoc Op2) {
-	for (unsigned i = 0; i < 32; i++) {
-		GRegCache[i] = nullptr;
-		GRegCacheStore[i] = nullptr;
-		FRegCache[i] = nullptr;
-		FRegCacheStore[i] = nullptr;
-	}
-	CarryCache = nullptr;
-	CarryCacheStore = nullptr;
-	for (unsigned i = 0; i < 8; i++) {
-		CRCache[i] = nullptr;
-		CRCacheStore[i] = nullptr;
-	}
-	CTRCache = nullptr;
-	CTRCacheStore = nullptr;
+	ClearRegCaches();
 	return EmitBiOp(FallBackToInterpreter, Op1, Op2);
 }
 
@@ -1053,6 +1031,141 @@ InstLoc IRBuilder::FoldBiOp(unsigned Opcode, InstLoc Op1, InstLoc Op2, unsigned
 	}
 }
 
+void IRBuilder::ClearRegCaches() {
+	for (unsigned i = 0; i < 32; i++) {
+		GRegCache[i] = nullptr;
+		FRegCache[i] = nullptr;
+	}
+	CarryCache = nullptr;
+	for (unsigned i = 0; i < 8; i++) {
+		CRCache[i] = nullptr;
+	}
+	CTRCache = nullptr;
+	LinkCache = nullptr;
+}
+
+u64 IRBuilder::getValueKey(InstLoc I) const {
+	if (!I)
+		return 0;
+	if (isImm(*I))
+		return (1ULL << 63) | GetImmValue(I);
+	return (u64)(I - InstList.data()) + 1;
+}
+
+// Integer operations only depend on their operands. Loads, stores and
+// floating point (which depends on the rounding mode) are not numbered.
+InstLoc IRBuilder::FindValue(unsigned Opcode, InstLoc Op1, InstLoc Op2, ValueKey* key) {
+	switch (Opcode) {
+	case SExt8: case SExt16: case BSwap32: case BSwap16: case Cntlzw: case Not:
+	case Add: case Mul: case And: case Or: case Xor:
+	case MulHighUnsigned: case Sub: case Shl: case Shrl: case Sarl: case Rol:
+	case ICmpCRSigned: case ICmpCRUnsigned:
+	case ICmpEq: case ICmpNe:
+	case ICmpUgt: case ICmpUlt: case ICmpUge: case ICmpUle:
+	case ICmpSgt: case ICmpSlt: case ICmpSge: case ICmpSle:
+		break;
+	default:
+		*key = ValueKey(Nop, 0, 0);
+		return nullptr;
+	}
+
+	u64 key1 = getValueKey(Op1), key2 = getValueKey(Op2);
+	switch (Opcode) {
+	case Add: case Mul: case And: case Or: case Xor: case ICmpEq: case ICmpNe:
+		if (key1 > key2)
+			std::swap(key1, key2);
+		break;
+	}
+	*key = ValueKey(Opcode, key1, key2);
+	auto it = ValueTable.find(*key);
+	if (it == ValueTable.end())
+		return nullptr;
+	Stats.numberedValues++;
+	return it->second;
+}
+
+// Backwards over the block, tracking which registers are certain to be
+// overwritten before they are read again. Anything that can leave the block
+// or run interpreter code may read every register.
+void IRBuilder::EliminateDeadStores() {
+	enum {
+		LOC_GREG = 0,
+		LOC_FREG = LOC_GREG + 32,
+		LOC_CR = LOC_FREG + 32,
+		LOC_CARRY = LOC_CR + 8,
+		LOC_CTR,
+		LOC_LINK,
+		NUM_LOCS
+	};
+	bool overwritten[NUM_LOCS] = {};
+
+	Stats.blocks++;
+	Stats.instructions += InstList.size();
+
+	for (InstLoc I = InstList.data() + InstList.size(); I != InstList.data();) {
+		--I;
+		int loc = -1;
+		bool store = false;
+		switch (getOpcode(*I)) {
+		case StoreGReg: store = true; // fall through
+		case LoadGReg:
+			loc = LOC_GREG + ((*I >> (store ? 16 : 8)) & 31);
+			break;
+		case StoreFReg: store = true; // fall through
+		case LoadFReg:
+		case LoadFRegDENToZero:
+			loc = LOC_FREG + ((*I >> (store ? 16 : 8)) & 31);
+			break;
+		case StoreCR: store = true; // fall through
+		case LoadCR:
+			loc = LOC_CR + ((*I >> (store ? 16 : 8)) & 7);
+			break;
+		case StoreCarry: store = true; // fall through
+		case LoadCarry:
+			loc = LOC_CARRY;
+			break;
+		case StoreCTR: store = true; // fall through
+		case LoadCTR:
+			loc = LOC_CTR;
+			break;
+		case StoreLink: store = true; // fall through
+		case LoadLink:
+			loc = LOC_LINK;
+			break;
+		case FallBackToInterpreter:
+		case BranchUncond:
+		case BranchCond:
+		case IdleBranch:
+		case ShortIdleLoop:
+		case SystemCall:
+		case RFIExit:
+		case InterpreterBranch:
+		case StoreMSR:
+		case FPExceptionCheck:
+		case DSIExceptionCheck:
+		case ISIException:
+		case ExtExceptionCheck:
+		case BreakPointCheck:
+		case Int3:
+			std::fill_n(overwritten, (int)NUM_LOCS, false);
+			break;
+		default:
+			break;
+		}
+
+		if (loc < 0)
+			continue;
+		if (!store) {
+			overwritten[loc] = false;
+		} else if (overwritten[loc]) {
+			*I = Nop;
+			Stats.deadStores++;
+		} else {
+			overwritten[loc] = true;
+		}
+	}
+}
+
 InstLoc IRBuilder::EmitIntConst(unsigned value) {
 	InstLoc curIndex = InstList.data() + InstList.size();
 	InstList.push_back(CInt32 | ((unsigned int)ConstList.size() << 8));
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <map>
+#include <tuple>
 #include <vector>
 
 #include "Common/x64Emitter.h"
@@ -202,6 +204,17 @@ InstLoc inline getOp2(InstLoc i) {
 	return i;
 }
 
+// What the optimizations did, summed over all blocks. Register load folding
+// and value numbering happen while the IR is built, dead store elimination is
+// a pass over the finished block.
+struct OptimizerStats {
+	u64 blocks;
+	u64 instructions;   // IR instructions in the blocks, before dead stores were removed
+	u64 foldedLoads;    // register loads served by an earlier load or store
+	u64 numberedValues; // computations that reused an identical earlier one
+	u64 deadStores;     // register stores nothing could observe
+};
+
 class IRBuilder {
 private:
 	InstLoc EmitZeroOp(unsigned Opcode, unsigned extra);
@@ -237,6 +250,9 @@ private:
 
 	unsigned ComputeKnownZeroBits(InstLoc I) const;
 
+	InstLoc FoldRegLoad(InstLoc& cache, unsigned Opcode, unsigned extra);
+	InstLoc FoldRegStore(InstLoc& cache, unsigned Opcode, InstLoc Op1, unsigned extra);
+
 public:
 	InstLoc EmitIntConst(unsigned value);
 	InstLoc EmitStoreLink(InstLoc val) {
@@ -541,28 +557,23 @@ public:
 	bool IsMarkUsed(InstLoc I) const;
 	void WriteToFile(u64 codeHash);
 
+	// Turns stores to PPC registers that are overwritten before anything
+	// reads them, or the block can be left, into Nops. Call once the block
+	// is complete.
+	void EliminateDeadStores();
+	const OptimizerStats& GetStats() const { return Stats; }
+	void ResetStats() { Stats = OptimizerStats(); }
+
 	void Reset() {
 		InstList.clear();
 		InstList.reserve(100000);
 		MarkUsed.clear();
 		MarkUsed.reserve(100000);
-		for (unsigned i = 0; i < 32; i++) {
-			GRegCache[i] = nullptr;
-			GRegCacheStore[i] = nullptr;
-			FRegCache[i] = nullptr;
-			FRegCacheStore[i] = nullptr;
-		}
-		CarryCache = nullptr;
-		CarryCacheStore = nullptr;
-		for (unsigned i = 0; i < 8; i++) {
-			CRCache[i] = nullptr;
-			CRCacheStore[i] = nullptr;
-		}
-		CTRCache = nullptr;
-		CTRCacheStore = nullptr;
-	}
-
-	IRBuilder() { Reset(); }
+		ValueTable.clear();
+		ClearRegCaches();
+	}
+
+	IRBuilder() : Stats() { Reset(); }
 
 private:
 	IRBuilder(IRBuilder&); // DO NOT IMPLEMENT
@@ -572,21 +583,26 @@ private:
 	void simplifyCommutative(unsigned Opcode, InstLoc& Op1, InstLoc& Op2);
 	bool maskedValueIsZero(InstLoc Op1, InstLoc Op2) const;
 	InstLoc isNeg(InstLoc I) const;
+	void ClearRegCaches();
+
+	// Value numbering of pure integer operations: (opcode, operand, operand),
+	// where constants are keyed by their value.
+	typedef std::tuple<unsigned, u64, u64> ValueKey;
+	u64 getValueKey(InstLoc I) const;
+	InstLoc FindValue(unsigned Opcode, InstLoc Op1, InstLoc Op2, ValueKey* key);
 
 	std::vector<Inst> InstList; // FIXME: We must ensure this is continuous!
 	std::vector<bool> MarkUsed; // Used for IRWriter
 	std::vector<unsigned> ConstList;
 	InstLoc curReadPtr;
 	InstLoc GRegCache[32];
-	InstLoc GRegCacheStore[32];
 	InstLoc FRegCache[32];
-	InstLoc FRegCacheStore[32];
 	InstLoc CarryCache;
-	InstLoc CarryCacheStore;
 	InstLoc CTRCache;
-	InstLoc CTRCacheStore;
+	InstLoc LinkCache;
 	InstLoc CRCache[8];
-	InstLoc CRCacheStore[8];
+	std::map<ValueKey, InstLoc> ValueTable;
+	OptimizerStats Stats;
 };
 
 };
@@ -478,21 +478,21 @@ void JitILBase::srawx(UGeckoInstruction inst)
 	INSTRUCTION_START
 	JITDISABLE(bJITIntegerOff)
 	// FIXME: We can do a lot better on 64-bit
-	IREmitter::InstLoc val, samt, mask, mask2, test;
-	val = ibuild.EmitLoadGReg(inst.RS);
+	IREmitter::InstLoc input, val, samt, big, mask, test;
+	input = ibuild.EmitLoadGReg(inst.RS);
 	samt = ibuild.EmitLoadGReg(inst.RB);
-	mask = ibuild.EmitIntConst(-1);
-	val = ibuild.EmitSarl(val, samt);
-	mask = ibuild.EmitShl(mask, samt);
-	samt = ibuild.EmitShl(samt, ibuild.EmitIntConst(26));
-	samt = ibuild.EmitSarl(samt, ibuild.EmitIntConst(31));
-	samt = ibuild.EmitAnd(samt, ibuild.EmitIntConst(31));
-	val = ibuild.EmitSarl(val, samt);
+	// All ones if the shift amount is 32 or more
+	big = ibuild.EmitShl(samt, ibuild.EmitIntConst(26));
+	big = ibuild.EmitSarl(big, ibuild.EmitIntConst(31));
+	val = ibuild.EmitSarl(input, samt);
+	val = ibuild.EmitSarl(val, ibuild.EmitAnd(big, ibuild.EmitIntConst(31)));
 	ibuild.EmitStoreGReg(val, inst.RA);
-	mask = ibuild.EmitShl(mask, samt);
-	mask2 = ibuild.EmitAnd(mask, ibuild.EmitIntConst(0x7FFFFFFF));
-	test = ibuild.EmitOr(val, mask2);
-	test = ibuild.EmitICmpUgt(test, mask);
+	// Carry is set if the input is negative and any one bits got shifted out
+	mask = ibuild.EmitShl(ibuild.EmitIntConst(-1), samt);
+	mask = ibuild.EmitAnd(mask, ibuild.EmitNot(big));
+	test = ibuild.EmitAnd(input, ibuild.EmitNot(mask));
+	test = ibuild.EmitAnd(test, ibuild.EmitSarl(input, ibuild.EmitIntConst(31)));
+	test = ibuild.EmitICmpNe(test, ibuild.EmitIntConst(0));
 	ibuild.EmitStoreCarry(test);
 
 	if (inst.Rc)
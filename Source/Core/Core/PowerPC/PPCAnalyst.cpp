@@ -9,6 +9,7 @@
 
 #include "Core/ConfigManager.h"
 #include "Core/GeckoCode.h"
+#include "Core/HLE/HLE.h"
 #include "Core/HW/Memmap.h"
 #include "Core/PowerPC/JitInterface.h"
 #include "Core/PowerPC/PPCAnalyst.h"
@@ -35,6 +36,10 @@ using namespace std;
 static const int CODEBUFFER_SIZE = 32000;
 // 0 does not perform block merging
 static const int FUNCTION_FOLLOWING_THRESHOLD = 16;
+// Largest function, in bytes, that gets inlined
+static const u32 INLINE_SIZE_THRESHOLD = 32 * 4;
+// Farthest an unconditional forward branch may jump within the block, in bytes
+static const u32 FORWARD_JUMP_THRESHOLD = 32 * 4;
 
 CodeBuffer::CodeBuffer(int size)
 {
@@ -502,6 +507,20 @@ void PPCAnalyzer::SetInstructionStats(CodeBlock *block, CodeOp *code, GekkoOPInf
 		code->fregsIn[j] = -1;
 	code->fregOut = -1;
 
+	// psq_l, psq_lu, psq_st, psq_stu
+	if (code->inst.OPCD == 56 || code->inst.OPCD == 57 || code->inst.OPCD == 60 || code->inst.OPCD == 61)
+		block->m_gqr_used |= 1 << code->inst.I;
+	// psq_lx, psq_stx, psq_lux, psq_stux
+	else if (code->inst.OPCD == 4 && ((code->inst.SUBOP10 & 0x1F) == 6 || (code->inst.SUBOP10 & 0x1F) == 7))
+		block->m_gqr_used |= 1 << code->inst.Ix;
+	// mtspr
+	else if (code->inst.OPCD == 31 && code->inst.SUBOP10 == 467)
+	{
+		u32 spr = (code->inst.SPRU << 5) | (code->inst.SPRL & 0x1F);
+		if (spr >= SPR_GQR0 && spr < SPR_GQR0 + 8)
+			block->m_gqr_modified |= 1 << (spr - SPR_GQR0);
+	}
+
 	switch (opinfo->type)
 	{
 	case OPTYPE_INTEGER:
@@ -526,6 +545,118 @@ void PPCAnalyzer::SetInstructionStats(CodeBlock *block, CodeOp *code, GekkoOPInf
 	}
 }
 
+bool PPCAnalyzer::IsBusyWaitLoop(CodeBlock *block, CodeOp *code, u32 branch_index)
+{
+	// A busy wait loop branches back to the start of the block and
+	//   * contains no other branches,
+	//   * only does integer math and loads, so it stores nothing,
+	//   * never writes a register it read before writing it within the loop.
+	// Every iteration then computes the same result from the same memory, which
+	// can only change once an interrupt or a scheduled event happens.
+	u32 written = 0;
+	u32 write_disallowed = 0;
+	for (u32 i = 0; i < branch_index; i++)
+	{
+		const GekkoOPInfo *opinfo = code[i].opinfo;
+		if (opinfo->type != OPTYPE_INTEGER && opinfo->type != OPTYPE_LOAD)
+			return false;
+		// Evil ops (lswi, lwarx, ...) touch state the register stats don't track.
+		if (opinfo->flags & (FL_EVIL | FL_READ_CA))
+			return false;
+
+		for (int j = 0; j < 3; j++)
+		{
+			if (code[i].regsIn[j] >= 0 && !(written & (1u << code[i].regsIn[j])))
+				write_disallowed |= 1u << code[i].regsIn[j];
+		}
+		for (int j = 0; j < 2; j++)
+		{
+			if (code[i].regsOut[j] < 0)
+				continue;
+			if (write_disallowed & (1u << code[i].regsOut[j]))
+				return false;
+			written |= 1u << code[i].regsOut[j];
+		}
+	}
+
+	const UGeckoInstruction inst = code[branch_index].inst;
+	if (inst.LK)
+		return false;
+	if (inst.OPCD == 18)
+		return true;
+	// A loop counting down CTR isn't waiting on anything.
+	return inst.OPCD == 16 && (inst.BO & BO_DONT_DECREMENT_FLAG);
+}
+
+// Callees come from the symbol map when it knows them, so the boundaries match
+// what the debugger shows. Unknown functions get a quick scan of their own
+// rather than being added to the database from the CPU thread.
+static bool GetInlineCandidate(u32 address, u32 *size)
+{
+	if (HLE::GetFunctionIndex(address))
+		return false;
+
+	u32 flags;
+	const Symbol *known = g_symbolDB.GetSymbolFromAddr(address);
+	if (known && known->address == address && known->analyzed)
+	{
+		flags = known->flags;
+		*size = known->size;
+	}
+	else
+	{
+		Symbol func;
+		if (!AnalyzeFunction(address, func, INLINE_SIZE_THRESHOLD))
+			return false;
+		flags = func.flags;
+		*size = func.size;
+	}
+
+	return (flags & FFLAG_LEAF) && !(flags & (FFLAG_EVIL | FFLAG_RFI)) && *size <= INLINE_SIZE_THRESHOLD;
+}
+
+// A forward branch becomes a jump within the block if the block runs from the
+// branch to its target through consecutive addresses, so that there is exactly
+// one place for the label. An unconditional b that can't be resolved has to
+// end the block. Returns the new number of instructions.
+static u32 ResolveForwardJumps(CodeOp *code, u32 num_inst)
+{
+	bool truncated = true;
+	while (truncated)
+	{
+		truncated = false;
+		for (u32 i = 0; i < num_inst; i++)
+		{
+			code[i].branchToIndex = -1;
+			if (code[i].branchTo == (u32)-1)
+				continue;
+
+			for (u32 j = i + 1; j < num_inst && code[j].address == code[j - 1].address + 4; j++)
+			{
+				if (code[j].address == code[i].branchTo)
+				{
+					code[i].branchToIndex = j;
+					break;
+				}
+			}
+
+			if (code[i].branchToIndex < 0 && code[i].inst.OPCD == 18)
+			{
+				num_inst = i + 1;
+				truncated = true;
+				break;
+			}
+		}
+	}
+
+	for (u32 i = 0; i < num_inst; i++)
+	{
+		if (code[i].branchToIndex >= 0)
+			code[code[i].branchToIndex].isBranchTarget = true;
+	}
+	return num_inst;
+}
+
 u32 PPCAnalyzer::Analyze(u32 address, CodeBlock *block, CodeBuffer *buffer, u32 blockSize)
 {
 	// Clear block stats
@@ -544,11 +675,14 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock *block, CodeBuffer *buffer, u32
 	// Reset our block state
 	block->m_broken = false;
 	block->m_num_instructions = 0;
+	block->m_gqr_used = 0;
+	block->m_gqr_modified = 0;
 
 	CodeOp *code = buffer->codebuffer;
 
 	bool found_exit = false;
 	u32 return_address = 0;
+	u32 function_end = 0;
 	u32 numFollows = 0;
 	u32 num_inst = 0;
 
@@ -577,30 +711,43 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock *block, CodeBuffer *buffer, u32
 
 			bool conditional_continue = false;
 
+			if ((inst.OPCD == 18 || inst.OPCD == 16) && !inst.AA)
+			{
+				u32 target = inst.OPCD == 18 ? address + SignExt26(inst.LI << 2) : address + SignExt16(inst.BD << 2);
+				if (target == block->m_address)
+					code[i].branchIsIdleLoop = IsBusyWaitLoop(block, code, i);
+			}
+
 			// Do we inline leaf functions?
 			if (HasOption(OPTION_LEAF_INLINE))
 			{
-				if (inst.OPCD == 18 && blockSize > 1)
+				if (inst.OPCD == 18 && inst.LK && !inst.AA && return_address == 0 && blockSize > 1)
 				{
-					//Is bx - should we inline? yes!
-					if (inst.AA)
-						destination = SignExt26(inst.LI << 2);
-					else
-						destination = address + SignExt26(inst.LI << 2);
-					if (destination != block->m_address)
+					// TODO: Find the optimal value for FUNCTION_FOLLOWING_THRESHOLD.
+					//       If it is small, the performance will be down.
+					//       If it is big, the size of generated code will be big and
+					//       cache clearning will happen many times.
+					// TODO: Investivate the reason why
+					//       "0" is fastest in some games, MP2 for example.
+					destination = address + SignExt26(inst.LI << 2);
+					u32 size;
+					if (destination != block->m_address && numFollows < FUNCTION_FOLLOWING_THRESHOLD &&
+					    GetInlineCandidate(destination, &size))
+					{
 						follow = true;
+						return_address = address + 4;
+						function_end = destination + size;
+					}
 				}
-				else if (inst.OPCD == 19 && inst.SUBOP10 == 16 &&
-					(inst.BO & (1 << 4)) && (inst.BO & (1 << 2)) &&
+				else if (inst.OPCD == 19 && inst.SUBOP10 == 16 && !inst.LK &&
+					(inst.BO & BO_DONT_DECREMENT_FLAG) && (inst.BO & BO_DONT_CHECK_CONDITION) &&
 					return_address != 0)
 				{
-					// bclrx with unconditional branch = return
+					// blr of the inlined function, LR already holds the return address
 					follow = true;
 					destination = return_address;
 					return_address = 0;
-
-					if (inst.LK)
-						return_address = address + 4;
+					code[i].skip = true;
 				}
 				else if (inst.OPCD == 31 && inst.SUBOP10 == 467)
 				{
@@ -612,15 +759,6 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock *block, CodeBuffer *buffer, u32
 						return_address = 0;
 					}
 				}
-
-				// TODO: Find the optimal value for FUNCTION_FOLLOWING_THRESHOLD.
-				//       If it is small, the performance will be down.
-				//       If it is big, the size of generated code will be big and
-				//       cache clearning will happen many times.
-				// TODO: Investivate the reason why
-				//       "0" is fastest in some games, MP2 for example.
-				if (numFollows > FUNCTION_FOLLOWING_THRESHOLD)
-					follow = false;
 			}
 
 			if (HasOption(OPTION_CONDITIONAL_CONTINUE))
@@ -652,6 +790,32 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock *block, CodeBuffer *buffer, u32
 				}
 			}
 
+			if (HasOption(OPTION_FORWARD_JUMP) && !inst.AA && !inst.LK)
+			{
+				if (inst.OPCD == 16 && conditional_continue)
+				{
+					u32 target = address + SignExt16(inst.BD << 2);
+					if (target > address)
+						code[i].branchTo = target;
+				}
+				else if (inst.OPCD == 18)
+				{
+					// Skipping over the else part of an if, keep going within the function
+					u32 target = address + SignExt26(inst.LI << 2);
+					u32 end = function_end;
+					if (return_address == 0)
+					{
+						const Symbol *func = g_symbolDB.GetSymbolFromAddr(address);
+						end = func ? func->address + func->size : 0;
+					}
+					if (target > address && target - address <= FORWARD_JUMP_THRESHOLD && target < end)
+					{
+						code[i].branchTo = target;
+						conditional_continue = true;
+					}
+				}
+			}
+
 			if (!follow)
 			{
 				if (!conditional_continue && opinfo->flags & FL_ENDBLOCK) //right now we stop early
@@ -661,18 +825,15 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock *block, CodeBuffer *buffer, u32
 				}
 				address += 4;
 			}
-			// XXX: We don't support inlining yet.
-#if 0
 			else
 			{
-				numFollows++;
-				// We don't "code[i].skip = true" here
+				// We don't "code[i].skip = true" on the bl
 				// because bx may store a certain value to the link register.
 				// Instead, we skip a part of bx in Jit**::bx().
+				if (return_address != 0)
+					numFollows++;
 				address = destination;
-				merged_addresses[size_of_merged_addresses++] = address;
 			}
-#endif
 		}
 		else
 		{
@@ -685,6 +846,18 @@ u32 PPCAnalyzer::Analyze(u32 address, CodeBlock *block, CodeBuffer *buffer, u32
 	if (block->m_num_instructions > 1)
 		ReorderInstructions(block->m_num_instructions, code);
 
+	if (HasOption(OPTION_FORWARD_JUMP))
+	{
+		u32 resolved = ResolveForwardJumps(code, num_inst);
+		if (resolved < num_inst)
+		{
+			// Ends on an unconditional branch now
+			num_inst = resolved;
+			found_exit = true;
+			address = code[num_inst - 1].address + 4;
+		}
+	}
+
 	if ((!found_exit && num_inst > 0) || blockSize == 1)
 	{
 		// We couldn't find an exit
@@ -24,8 +24,8 @@ struct CodeOp //16B
 	UGeckoInstruction inst;
 	GekkoOPInfo * opinfo;
 	u32 address;
-	u32 branchTo; //if 0, not a branch
-	int branchToIndex; //index of target block
+	u32 branchTo; // forward branch target, -1 if none
+	int branchToIndex; // index of the target op within the block, -1 if it isn't in it
 	s8 regsOut[2];
 	s8 regsIn[3];
 	s8 fregOut;
@@ -38,6 +38,7 @@ struct CodeOp //16B
 	bool outputCR1;
 	bool outputPS1;
 	bool skip;  // followed BL-s for example
+	bool branchIsIdleLoop; // branch back to the block start which only waits for an event
 };
 
 struct BlockStats
@@ -124,6 +125,10 @@ struct CodeBlock
 
 	// Are we a broken block?
 	bool m_broken;
+
+	// GQRs read by quantized loads and stores, and GQRs written by mtspr.
+	u8 m_gqr_used;
+	u8 m_gqr_modified;
 };
 
 class PPCAnalyzer
@@ -132,6 +137,7 @@ private:
 
 	void ReorderInstructions(u32 instructions, CodeOp *code);
 	void SetInstructionStats(CodeBlock *block, CodeOp *code, GekkoOPInfo *opinfo, u32 index);
+	bool IsBusyWaitLoop(CodeBlock *block, CodeOp *code, u32 branch_index);
 
 	// Options
 	u32 m_options;
@@ -145,10 +151,9 @@ public:
 		// Requires JIT support to be enabled.
 		OPTION_CONDITIONAL_CONTINUE = (1 << 0),
 
-		// If there is a unconditional branch that jumps to a leaf function then inline it.
-		// Might require JIT intervention to support it correctly.
-		// Requires JITBLock support for inlined code
-		// XXX: NOT COMPLETE
+		// If there is a bl to a small leaf function then inline it.
+		// The bl stays in the block to set LR, the final blr is marked as skipped.
+		// Requires the JIT to invalidate the block when the callee changes.
 		OPTION_LEAF_INLINE = (1 << 1),
 
 		// Complex blocks support jumping backwards on to themselves.
@@ -159,8 +164,9 @@ public:
 
 		// Similar to complex blocks.
 		// Instead of jumping backwards, this jumps forwards within the block.
-		// Requires JIT support to work.
-		// XXX: NOT COMPLETE
+		// Conditional branches whose target ends up in the block get branchToIndex,
+		// an unconditional b within the current function doesn't end the block.
+		// Requires the JIT to emit jumps to ops flagged isBranchTarget.
 		OPTION_FORWARD_JUMP = (1 << 3),
 	};
 
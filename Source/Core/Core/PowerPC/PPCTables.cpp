@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cinttypes>
+#include <string>
 #include <vector>
 
 #include "Common/Common.h"
@@ -239,7 +240,47 @@ void LogCompiledInstructions()
 	}
 #endif
 
+	f.Open(StringFromFormat("%sinst_fallback%i.txt", File::GetUserPath(D_LOGS_IDX).c_str(), time), "w");
+	fprintf(f.GetHandle(), "%s\n", GetFallbackReport().c_str());
+
 	++time;
 }
 
+void ResetFallbackCounts()
+{
+	for (int i = 0; i < m_numInstructions; i++)
+	{
+		m_allInstructions[i]->fallbackCompileCount = 0;
+		m_allInstructions[i]->fallbackRunCount = 0;
+	}
+}
+
+std::string GetFallbackReport()
+{
+	std::vector<GekkoOPInfo*> fallbacks;
+	for (int i = 0; i < m_numInstructions; i++)
+	{
+		if (m_allInstructions[i]->fallbackCompileCount > 0)
+			fallbacks.push_back(m_allInstructions[i]);
+	}
+	std::sort(fallbacks.begin(), fallbacks.end(),
+		[](const GekkoOPInfo *a, const GekkoOPInfo *b)
+		{
+			if (a->fallbackRunCount != b->fallbackRunCount)
+				return a->fallbackRunCount > b->fallbackRunCount;
+			return a->fallbackCompileCount > b->fallbackCompileCount;
+		});
+
+	u64 total = 0;
+	std::string report;
+	for (const GekkoOPInfo *info : fallbacks)
+	{
+		total += info->fallbackRunCount;
+		report += StringFromFormat("\n  %-12s %12" PRIu64 " calls, compiled %i times",
+			info->opname, info->fallbackRunCount, info->fallbackCompileCount);
+	}
+	return StringFromFormat("Interpreter fallbacks: %u instructions, %" PRIu64 " calls",
+		(u32)fallbacks.size(), total) + report;
+}
+
 }  // namespace
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <string>
+
 #include "Core/PowerPC/Gekko.h"
 #include "Core/PowerPC/Interpreter/Interpreter.h"
 
@@ -82,6 +84,10 @@ struct GekkoOPInfo
 	u64 runCount;
 	int compileCount;
 	u32 lastUse;
+	// How often the JIT compiled this instruction as an interpreter call, and
+	// how often those calls actually ran (only counted with block profiling).
+	int fallbackCompileCount;
+	u64 fallbackRunCount;
 };
 extern GekkoOPInfo *m_infoTable[64];
 extern GekkoOPInfo *m_infoTable4[1024];
@@ -109,6 +115,9 @@ bool UsesFPU(UGeckoInstruction _inst);
 void CountInstruction(UGeckoInstruction _inst);
 void PrintInstructionRunCounts();
 void LogCompiledInstructions();
+void ResetFallbackCounts();
+// Instructions the JIT handed to the interpreter, most executed first.
+std::string GetFallbackReport();
 const char *GetInstructionName(UGeckoInstruction _inst);
 
 }  // namespace
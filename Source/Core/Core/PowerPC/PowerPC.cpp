@@ -2,12 +2,18 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <cinttypes>
+#include <map>
+#include <string>
+
 #include "Common/Atomic.h"
 #include "Common/ChunkFile.h"
 #include "Common/Common.h"
 #include "Common/FPURoundMode.h"
 #include "Common/MathUtil.h"
+#include "Common/StringUtil.h"
 
+#include "Core/ConfigManager.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
 #include "Core/Host.h"
@@ -39,6 +45,15 @@ BreakPoints breakpoints;
 MemChecks memchecks;
 PPCDebugInterface debug_interface;
 
+struct IdleLoopStats
+{
+	u64 hits;
+	u64 skippedCycles;
+};
+
+// Only touched from the CPU thread.
+static std::map<u32, IdleLoopStats> s_idle_loops;
+
 void CompactCR()
 {
 	u32 new_cr = ppcState.cr_fast[0] << 28;
@@ -167,6 +182,12 @@ void Init(int cpu_core)
 
 void Shutdown()
 {
+	if (!s_idle_loops.empty())
+	{
+		NOTICE_LOG(POWERPC, "%s", GetIdleLoopReport().c_str());
+		s_idle_loops.clear();
+	}
+
 	JitInterface::Shutdown();
 	interpreter->Shutdown();
 	cpu_core_base = nullptr;
@@ -512,6 +533,42 @@ void OnIdleIL()
 	CoreTiming::Idle();
 }
 
+void RegisterIdleLoop(u32 address)
+{
+	if (s_idle_loops.find(address) == s_idle_loops.end())
+	{
+		INFO_LOG(POWERPC, "Idle loop detected at %08x", address);
+		s_idle_loops[address] = IdleLoopStats();
+	}
+}
+
+void OnIdleLoop(u32 address)
+{
+	u64 idle_ticks = CoreTiming::GetIdleTicks();
+	CoreTiming::Idle();
+
+	IdleLoopStats& stats = s_idle_loops[address];
+	stats.hits++;
+	stats.skippedCycles += CoreTiming::GetIdleTicks() - idle_ticks;
+}
+
+std::string GetIdleLoopReport()
+{
+	std::string text = StringFromFormat("Idle loops for %s\n",
+		SConfig::GetInstance().m_LocalCoreStartupParameter.GetUniqueID().c_str());
+
+	u64 total_cycles = 0;
+	for (const auto& loop : s_idle_loops)
+	{
+		text += StringFromFormat("%08x: %" PRIu64 " hits, %" PRIu64 " cycles skipped\n",
+			loop.first, loop.second.hits, loop.second.skippedCycles);
+		total_cycles += loop.second.skippedCycles;
+	}
+	text += StringFromFormat("%u loops, %" PRIu64 " cycles skipped in total",
+		(u32)s_idle_loops.size(), total_cycles);
+	return text;
+}
+
 }  // namespace
 
 
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <string>
+
 #include "Common/BreakPoints.h"
 #include "Common/Common.h"
 
@@ -107,6 +109,13 @@ void ExpandCR();
 void OnIdle(u32 _uThreadAddr);
 void OnIdleIL();
 
+// Busy wait loops found by PPCAnalyst. The JIT registers every loop it compiles
+// and calls OnIdleLoop instead of spinning through it.
+void RegisterIdleLoop(u32 address);
+void OnIdleLoop(u32 address);
+// Lists the detected loops with how often they were hit and how many cycles got skipped.
+std::string GetIdleLoopReport();
+
 void UpdatePerformanceMonitor(u32 cycles, u32 num_load_stores, u32 num_fp_inst);
 
 // Easy register access macros.
@@ -0,0 +1,342 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <lzo/lzo1x.h>
+
+#include "Common/Common.h"
+#include "Common/StringUtil.h"
+#include "Common/Timer.h"
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/Movie.h"
+#include "Core/Rewind.h"
+#include "Core/State.h"
+
+namespace Rewind
+{
+
+struct Snapshot
+{
+	// LZO compressed XOR of this state and the next newer one, see XorStates
+	std::vector<u8> data;
+	size_t raw_size;
+	u64 field;
+	// Layout of the uncompressed state
+	std::vector<State::SectionInfo> sections;
+};
+
+static std::mutex s_lock;
+static std::thread s_compress_thread;
+
+// Oldest first
+static std::deque<Snapshot> s_history;
+static size_t s_history_bytes;
+
+static std::vector<u8> s_head;
+static std::vector<State::SectionInfo> s_head_sections;
+static u64 s_head_field;
+// Every snapshot depends on the memory base, it can only be replaced while
+// the history is empty
+static bool s_reset_base;
+static u64 s_field;
+
+// Per-snapshot cost, measured on the CPU thread (capture) and on the
+// compression thread (delta + compress)
+static u64 s_captures;
+static u64 s_capture_us_total, s_capture_us_max;
+static u64 s_compress_us_total;
+static u64 s_raw_bytes_total, s_compressed_bytes_total;
+
+static lzo_align_t s_wrkmem[(LZO1X_1_MEM_COMPRESS + sizeof(lzo_align_t) - 1) / sizeof(lzo_align_t)];
+
+static size_t GetBudget()
+{
+	return (size_t)std::max(SConfig::GetInstance().m_LocalCoreStartupParameter.iRewindBudget, 1) << 20;
+}
+
+static void XorBytes(u8* target, const u8* other, size_t count)
+{
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		u64 a, b;
+		memcpy(&a, target + i, 8);
+		memcpy(&b, other + i, 8);
+		a ^= b;
+		memcpy(target + i, &a, 8);
+	}
+	for (; i < count; i++)
+		target[i] ^= other[i];
+}
+
+static std::vector<size_t> GetChunkEnds(const std::vector<u8>& state, const std::vector<State::SectionInfo>& sections)
+{
+	std::vector<size_t> ends;
+	for (const auto& section : sections)
+		ends.push_back(std::min<size_t>((size_t)section.offset + section.size, state.size()));
+	std::sort(ends.begin(), ends.end());
+	ends.push_back(state.size());
+	return ends;
+}
+
+// XORs every section (with the header in front of it) with the same section
+// of the other state. The memory section changes its length from one state to
+// the next, lining up the bytes by position would misalign everything after
+// it. Bytes past the end of the other state's section are left as they are.
+// Applying it twice with the same layouts gives back the original.
+static void XorStates(std::vector<u8>& target, const std::vector<State::SectionInfo>& target_sections,
+                      const std::vector<u8>& other, const std::vector<State::SectionInfo>& other_sections)
+{
+	std::vector<size_t> target_ends = GetChunkEnds(target, target_sections);
+	std::vector<size_t> other_ends = GetChunkEnds(other, other_sections);
+	if (target_ends.size() != other_ends.size())
+	{
+		target_ends.assign(1, target.size());
+		other_ends.assign(1, other.size());
+	}
+
+	size_t target_start = 0, other_start = 0;
+	for (size_t i = 0; i < target_ends.size(); i++)
+	{
+		const size_t target_end = std::max(target_ends[i], target_start);
+		const size_t other_end = std::max(other_ends[i], other_start);
+		const size_t count = std::min(target_end - target_start, other_end - other_start);
+		if (count)
+			XorBytes(&target[target_start], &other[other_start], count);
+		target_start = target_end;
+		other_start = other_end;
+	}
+}
+
+// Runs on s_compress_thread. s_head is not touched by anyone else until the
+// thread has been joined.
+static void CompressSnapshot(std::vector<u8> older, std::vector<State::SectionInfo> sections, u64 field)
+{
+	u64 start = Common::Timer::GetTimeUs();
+
+	XorStates(older, sections, s_head, s_head_sections);
+
+	Snapshot snapshot;
+	snapshot.raw_size = older.size();
+	snapshot.field = field;
+	snapshot.sections = std::move(sections);
+	snapshot.data.resize(older.size() + older.size() / 16 + 64 + 3);
+
+	lzo_uint out_len = 0;
+	if (lzo1x_1_compress(&older[0], older.size(), &snapshot.data[0], &out_len, s_wrkmem) != LZO_E_OK)
+	{
+		ERROR_LOG(COMMON, "Rewind: failed to compress snapshot of field %" PRIu64, field);
+		return;
+	}
+	snapshot.data.resize(out_len);
+	snapshot.data.shrink_to_fit();
+
+	u64 compress_us = Common::Timer::GetTimeUs() - start;
+	DEBUG_LOG(COMMON, "Rewind: field %" PRIu64 ", %u -> %u bytes in %" PRIu64 " us",
+	          field, (u32)snapshot.raw_size, (u32)out_len, compress_us);
+
+	std::lock_guard<std::mutex> lk(s_lock);
+	s_compress_us_total += compress_us;
+	s_raw_bytes_total += snapshot.raw_size;
+	s_compressed_bytes_total += out_len;
+
+	s_history_bytes += out_len;
+	s_history.push_back(std::move(snapshot));
+
+	const size_t budget = GetBudget();
+	while (!s_history.empty() && s_history_bytes + s_head.size() > budget)
+	{
+		s_history_bytes -= s_history.front().data.size();
+		s_history.pop_front();
+	}
+}
+
+static void Flush()
+{
+	if (s_compress_thread.joinable())
+		s_compress_thread.join();
+}
+
+static void Clear()
+{
+	std::lock_guard<std::mutex> lk(s_lock);
+	std::deque<Snapshot>().swap(s_history);
+	std::vector<u8>().swap(s_head);
+	s_head_sections.clear();
+	s_reset_base = true;
+	s_history_bytes = 0;
+	s_head_field = 0;
+	s_field = 0;
+}
+
+void Init()
+{
+	Clear();
+	s_captures = 0;
+	s_capture_us_total = s_capture_us_max = 0;
+	s_compress_us_total = 0;
+	s_raw_bytes_total = s_compressed_bytes_total = 0;
+}
+
+void Shutdown()
+{
+	Flush();
+	if (s_captures)
+		NOTICE_LOG(COMMON, "Rewind: %s", GetStats().c_str());
+	Clear();
+}
+
+void FrameUpdate()
+{
+	const int interval = SConfig::GetInstance().m_LocalCoreStartupParameter.iRewindInterval;
+	if (interval <= 0)
+	{
+		if (!s_head.empty())
+		{
+			Flush();
+			Clear();
+		}
+		return;
+	}
+
+	s_field++;
+	if (!s_head.empty() && s_field - s_head_field < (u64)interval)
+		return;
+
+	// Rewinding would desync the input log, don't pay for snapshots nobody can use
+	if (Movie::IsRecordingInput() || Movie::IsPlayingInput())
+		return;
+
+	// Nothing refers to the old base anymore, start over from the current memory
+	if (s_reset_base)
+	{
+		State::ResetIncrementalBase();
+		s_reset_base = false;
+	}
+
+	u64 start = Common::Timer::GetTimeUs();
+	std::vector<u8> state;
+	std::vector<State::SectionInfo> sections;
+	State::SaveIncrementalToBuffer(state, sections);
+	u64 capture_us = Common::Timer::GetTimeUs() - start;
+
+	// The previous snapshot has to be stored before its successor replaces s_head
+	Flush();
+
+	std::lock_guard<std::mutex> lk(s_lock);
+	s_captures++;
+	s_capture_us_total += capture_us;
+	s_capture_us_max = std::max(s_capture_us_max, capture_us);
+
+	std::vector<u8> older;
+	older.swap(s_head);
+	std::vector<State::SectionInfo> older_sections;
+	older_sections.swap(s_head_sections);
+	u64 older_field = s_head_field;
+
+	s_head.swap(state);
+	s_head_sections.swap(sections);
+	s_head_field = s_field;
+
+	if (!older.empty())
+		s_compress_thread = std::thread(CompressSnapshot, std::move(older), std::move(older_sections), older_field);
+}
+
+bool StepBack()
+{
+	if (SConfig::GetInstance().m_LocalCoreStartupParameter.iRewindInterval <= 0)
+		return false;
+
+	if (Movie::IsRecordingInput() || Movie::IsPlayingInput())
+	{
+		Core::DisplayMessage("Rewind is not available during movie recording or playback", 3000);
+		return false;
+	}
+
+	// Stop the CPU thread first, it takes s_lock in FrameUpdate
+	bool wasUnpaused = Core::PauseAndLock(true);
+	Flush();
+
+	bool success = false;
+	{
+		std::lock_guard<std::mutex> lk(s_lock);
+
+		const u64 interval = SConfig::GetInstance().m_LocalCoreStartupParameter.iRewindInterval;
+		if (s_head.empty())
+		{
+			Core::DisplayMessage("Nothing to rewind to", 2000);
+		}
+		else if (s_field - s_head_field > interval / 2 || s_history.empty())
+		{
+			success = true;
+		}
+		else
+		{
+			Snapshot& snapshot = s_history.back();
+			std::vector<u8> older(snapshot.raw_size);
+			lzo_uint new_len = older.size();
+			if (lzo1x_decompress_safe(&snapshot.data[0], snapshot.data.size(), &older[0], &new_len, nullptr) != LZO_E_OK ||
+			    new_len != snapshot.raw_size)
+			{
+				PanicAlert("Rewind: snapshot of field %" PRIu64 " is corrupted", snapshot.field);
+				s_history_bytes = 0;
+				s_history.clear();
+			}
+			else
+			{
+				XorStates(older, snapshot.sections, s_head, s_head_sections);
+				s_head.swap(older);
+				s_head_sections.swap(snapshot.sections);
+				s_head_field = snapshot.field;
+				s_history_bytes -= snapshot.data.size();
+				s_history.pop_back();
+				success = true;
+			}
+		}
+
+		if (success)
+		{
+			State::LoadFromBuffer(s_head);
+			s_field = s_head_field;
+			Core::DisplayMessage(StringFromFormat("Rewound to field %" PRIu64 ", %u older snapshots left",
+			                                      s_head_field, (u32)s_history.size()), 2000);
+		}
+	}
+
+	Core::PauseAndLock(false, wasUnpaused);
+	return success;
+}
+
+size_t GetSnapshotCount()
+{
+	std::lock_guard<std::mutex> lk(s_lock);
+	return s_history.size() + (s_head.empty() ? 0 : 1);
+}
+
+std::string GetStats()
+{
+	std::lock_guard<std::mutex> lk(s_lock);
+
+	const u64 captures = std::max<u64>(s_captures, 1);
+	const u64 compressed = std::max<u64>(s_captures, 2) - 1;
+	return StringFromFormat(
+		"%u snapshots in %.1f of %.0f MB, capture avg %.2f ms max %.2f ms, "
+		"compression avg %.2f ms, deltas at %.1f%% of the full state",
+		(u32)(s_history.size() + (s_head.empty() ? 0 : 1)),
+		(s_history_bytes + s_head.size()) / 1048576.0, GetBudget() / 1048576.0,
+		s_capture_us_total / 1000.0 / captures, s_capture_us_max / 1000.0,
+		s_compress_us_total / 1000.0 / compressed,
+		s_raw_bytes_total ? s_compressed_bytes_total * 100.0 / s_raw_bytes_total : 0.0);
+}
+
+}
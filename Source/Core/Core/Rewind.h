@@ -0,0 +1,38 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// In-memory rewind history built on State::SaveIncrementalToBuffer.
+//
+// Every RewindInterval fields the state is captured, with emulated memory
+// reduced to the pages that differ from a base copy taken when the history
+// starts. Only the newest snapshot is kept uncompressed; every older one is
+// stored as the XOR of itself and its successor, LZO compressed. Consecutive
+// states mostly differ in a few pages, so the deltas compress extremely well.
+// The oldest snapshots are dropped once the history exceeds RewindBudget
+// megabytes. The base copy of memory is not counted against the budget.
+
+#pragma once
+
+#include <string>
+
+namespace Rewind
+{
+
+void Init();
+void Shutdown();
+
+// Called from the CPU thread once per emulated field.
+void FrameUpdate();
+
+// Restores the newest snapshot, or the one before it if the newest one was
+// taken less than half an interval ago. Can be repeated to step further back.
+bool StepBack();
+
+// Number of snapshots currently held, including the uncompressed newest one.
+size_t GetSnapshotCount();
+
+// Memory usage and the average and worst per-snapshot capture cost.
+std::string GetStats();
+
+}
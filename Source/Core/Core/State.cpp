@@ -2,8 +2,11 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+
 #include <lzo/lzo1x.h>
 
+#include "Common/ChunkFile.h"
 #include "Common/Common.h"
 #include "Common/Event.h"
 #include "Common/StdMutex.h"
@@ -30,22 +33,19 @@
 namespace State
 {
 
-#if defined(__LZO_STRICT_16BIT)
-static const u32 IN_LEN = 8 * 1024u;
-#elif defined(LZO_ARCH_I086) && !defined(LZO_HAVE_MM_HUGE_ARRAY)
-static const u32 IN_LEN = 60 * 1024u;
-#else
-static const u32 IN_LEN = 128 * 1024u;
-#endif
-
-static const u32 OUT_LEN = IN_LEN + (IN_LEN / 16) + 64 + 3;
-
-static unsigned char __LZO_MMODEL out[OUT_LEN];
-
-#define HEAP_ALLOC(var, size) \
-	lzo_align_t __LZO_MMODEL var[((size) + (sizeof(lzo_align_t) - 1)) / sizeof(lzo_align_t)]
+struct StatePiece
+{
+	u32 offset;
+	u32 raw_size;
+	u32 stored_offset;
+	u32 stored_size;
+};
 
-static HEAP_ALLOC(wrkmem, LZO1X_1_MEM_COMPRESS);
+// Compressed state files store every section as its own LZO stream, listed
+// in a table after this magic, so they can be (de)compressed in parallel.
+static const u32 COMPRESSED_SECTIONS_MAGIC = 0x54434553; // "SECT"
+// Pieces smaller than this are not worth a thread
+static const u32 PARALLEL_PIECE_SIZE = 256 * 1024;
 
 static std::string g_last_filename;
 
@@ -54,16 +54,27 @@ static CallbackFunc g_onAfterLoadCb = nullptr;
 // Temporary undo state buffer
 static std::vector<u8> g_undo_load_buffer;
 static std::vector<u8> g_current_buffer;
+static PointerWrap::SectionTable g_current_sections;
 static int g_loadDepth = 0;
 
 static std::mutex g_cs_undo_load_buffer;
 static std::mutex g_cs_current_buffer;
+static std::mutex g_cs_save_arena;
+static ChunkedBuffer g_save_arena;
+// Time spent in each DoState section during the last save, in microseconds
+static PointerWrap::MarkerTimes g_save_profile;
+// Where the sections of the last save are in g_save_arena
+static PointerWrap::SectionTable g_save_sections;
 static Common::Event g_compressAndDumpStateSyncEvent;
 
 static std::thread g_save_thread;
 
 // Don't forget to increase this after doing changes on the savestate system
-static const u32 STATE_VERSION = 22;
+static const u32 STATE_VERSION = 24;
+
+static const u32 COOKIE_BASE = 0xBAADBABE;
+// Version cookie and marker, the sections follow
+static const size_t PROLOGUE_SIZE = 2 * sizeof(u32);
 
 enum
 {
@@ -83,7 +94,6 @@ void DoState(PointerWrap &p)
 {
 	u32 version = STATE_VERSION;
 	{
-		static const u32 COOKIE_BASE = 0xBAADBABE;
 		u32 cookie = version + COOKIE_BASE;
 		p.Do(cookie);
 		version = cookie - COOKIE_BASE;
@@ -100,22 +110,18 @@ void DoState(PointerWrap &p)
 
 	p.DoMarker("Version");
 
+	// Everything after the version is a sequence of sections, see ReadSections
+
 	// Begin with video backend, so that it gets a chance to clear it's caches and writeback modified things to RAM
-	g_video_backend->DoState(p);
-	p.DoMarker("video_backend");
+	p.DoSection("video_backend", [](PointerWrap& section) { g_video_backend->DoState(section); });
 
 	if (Core::g_CoreStartupParameter.bWii)
-		Wiimote::DoState(p.GetPPtr(), p.GetMode());
-	p.DoMarker("Wiimote");
+		p.DoSection("Wiimote", Wiimote::DoState);
 
-	PowerPC::DoState(p);
-	p.DoMarker("PowerPC");
+	p.DoSection("PowerPC", PowerPC::DoState);
 	HW::DoState(p);
-	p.DoMarker("HW");
-	CoreTiming::DoState(p);
-	p.DoMarker("CoreTiming");
-	Movie::DoState(p);
-	p.DoMarker("Movie");
+	p.DoSection("CoreTiming", CoreTiming::DoState);
+	p.DoSection("Movie", Movie::DoState);
 }
 
 void LoadFromBuffer(std::vector<u8>& buffer)
@@ -123,26 +129,88 @@ void LoadFromBuffer(std::vector<u8>& buffer)
 	bool wasUnpaused = Core::PauseAndLock(true);
 
 	u8* ptr = &buffer[0];
-	PointerWrap p(&ptr, PointerWrap::MODE_READ);
+	PointerWrap p(&ptr, PointerWrap::MODE_READ, ptr + buffer.size());
 	DoState(p);
 
 	Core::PauseAndLock(false, wasUnpaused);
 }
 
+// Serializes the state in a single pass into g_save_arena, which keeps its
+// memory between saves. Returns false if some DoState aborted the save.
+static bool DoSaveToArena()
+{
+	g_save_arena.Clear();
+	g_save_profile.clear();
+	g_save_sections.clear();
+
+	PointerWrap p(&g_save_arena);
+	p.SetMarkerTimes(&g_save_profile);
+	p.SetSectionTable(&g_save_sections);
+	DoState(p);
+
+	return p.GetMode() == PointerWrap::MODE_WRITE;
+}
+
+static std::string GetSaveProfileString()
+{
+	u64 total = 0;
+	for (const auto& section : g_save_profile)
+		total += section.second;
+
+	std::string profile = StringFromFormat("%.2f ms", total / 1000.0);
+	for (const auto& section : g_save_profile)
+	{
+		if (section.second >= 100)
+			profile += StringFromFormat(", %s %.2f", section.first.c_str(), section.second / 1000.0);
+	}
+	return profile;
+}
+
+static void DoSaveToBuffer(std::vector<u8>& buffer)
+{
+	std::lock_guard<std::mutex> lk(g_cs_save_arena);
+
+	DoSaveToArena();
+	g_save_arena.CopyTo(buffer);
+}
+
 void SaveToBuffer(std::vector<u8>& buffer)
 {
 	bool wasUnpaused = Core::PauseAndLock(true);
 
-	u8* ptr = nullptr;
-	PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
+	DoSaveToBuffer(buffer);
 
-	DoState(p);
-	const size_t buffer_size = reinterpret_cast<size_t>(ptr);
-	buffer.resize(buffer_size);
+	Core::PauseAndLock(false, wasUnpaused);
+}
 
-	ptr = &buffer[0];
-	p.SetMode(PointerWrap::MODE_WRITE);
-	DoState(p);
+void SaveIncrementalToBuffer(std::vector<u8>& buffer, std::vector<SectionInfo>& sections)
+{
+	bool wasUnpaused = Core::PauseAndLock(true);
+
+	if (!Memory::HasStateDeltaBase())
+		Memory::ResetStateDeltaBase();
+
+	{
+		std::lock_guard<std::mutex> lk(g_cs_save_arena);
+
+		Memory::SetStateDelta(true);
+		DoSaveToArena();
+		Memory::SetStateDelta(false);
+		g_save_arena.CopyTo(buffer);
+
+		sections.clear();
+		for (const auto& written : g_save_sections)
+			sections.push_back({ std::string(), written.offset, written.size, true });
+	}
+
+	Core::PauseAndLock(false, wasUnpaused);
+}
+
+void ResetIncrementalBase()
+{
+	bool wasUnpaused = Core::PauseAndLock(true);
+
+	Memory::ResetStateDeltaBase();
 
 	Core::PauseAndLock(false, wasUnpaused);
 }
@@ -152,12 +220,97 @@ void VerifyBuffer(std::vector<u8>& buffer)
 	bool wasUnpaused = Core::PauseAndLock(true);
 
 	u8* ptr = &buffer[0];
-	PointerWrap p(&ptr, PointerWrap::MODE_VERIFY);
+	PointerWrap p(&ptr, PointerWrap::MODE_VERIFY, ptr + buffer.size());
 	DoState(p);
 
 	Core::PauseAndLock(false, wasUnpaused);
 }
 
+bool ReadSections(const std::vector<u8>& buffer, std::vector<SectionInfo>& sections)
+{
+	sections.clear();
+
+	u32 cookie = 0;
+	if (buffer.size() < PROLOGUE_SIZE)
+		return false;
+	memcpy(&cookie, &buffer[0], sizeof(u32));
+	if (cookie != STATE_VERSION + COOKIE_BASE)
+		return false;
+
+	size_t pos = PROLOGUE_SIZE;
+	while (pos < buffer.size())
+	{
+		u32 name_length;
+		if (buffer.size() - pos < sizeof(u32))
+			return false;
+		memcpy(&name_length, &buffer[pos], sizeof(u32));
+		pos += sizeof(u32);
+
+		if (name_length > PointerWrap::MAX_SECTION_NAME || buffer.size() - pos < name_length + 2 * sizeof(u32))
+			return false;
+
+		SectionInfo section;
+		section.name.assign(reinterpret_cast<const char*>(&buffer[pos]), name_length);
+		pos += name_length;
+
+		u32 checksum;
+		memcpy(&section.size, &buffer[pos], sizeof(u32));
+		memcpy(&checksum, &buffer[pos + sizeof(u32)], sizeof(u32));
+		pos += 2 * sizeof(u32);
+
+		if (buffer.size() - pos < section.size)
+			return false;
+
+		section.offset = (u32)pos;
+		section.valid = PointerWrap::GetChecksum(&buffer[pos], section.size) == checksum;
+		sections.push_back(section);
+		pos += section.size;
+	}
+
+	return true;
+}
+
+// The part of the state buffer in front of each section goes along with it.
+// The sections are the ones DoSaveToArena recorded while writing the buffer.
+static void GetPieces(size_t buffer_size, const PointerWrap::SectionTable& sections, std::vector<StatePiece>& pieces)
+{
+	pieces.clear();
+	u32 offset = 0;
+	for (const PointerWrap::WrittenSection& section : sections)
+	{
+		StatePiece piece;
+		piece.offset = offset;
+		piece.raw_size = section.offset + section.size - offset;
+		pieces.push_back(piece);
+		offset += piece.raw_size;
+	}
+
+	if (offset < buffer_size)
+	{
+		StatePiece piece;
+		piece.offset = offset;
+		piece.raw_size = (u32)buffer_size - offset;
+		pieces.push_back(piece);
+	}
+}
+
+// Runs f(index) for every piece, giving the large ones their own thread
+template <typename F>
+static void ForEachPiece(const std::vector<StatePiece>& pieces, F f)
+{
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < pieces.size(); i++)
+	{
+		if (pieces[i].raw_size >= PARALLEL_PIECE_SIZE)
+			threads.emplace_back(f, i);
+		else
+			f(i);
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
 // return state number not in map
 int GetEmptySlot(std::map<double, int> m)
 {
@@ -204,6 +357,7 @@ std::map<double, int> GetSavedStates()
 struct CompressAndDumpState_args
 {
 	std::vector<u8>* buffer_vector;
+	const PointerWrap::SectionTable* sections;
 	std::mutex* buffer_mutex;
 	std::string filename;
 	bool wait;
@@ -259,33 +413,36 @@ void CompressAndDumpState(CompressAndDumpState_args save_args)
 
 	if (header.size != 0) // non-zero header size means the state is compressed
 	{
-		lzo_uint i = 0;
-		while (true)
-		{
-			lzo_uint32 cur_len = 0;
-			lzo_uint out_len = 0;
-
-			if ((i + IN_LEN) >= buffer_size)
-			{
-				cur_len = (lzo_uint32)(buffer_size - i);
-			}
-			else
-			{
-				cur_len = IN_LEN;
-			}
-
-			if (lzo1x_1_compress(buffer_data + i, cur_len, out, &out_len, wrkmem) != LZO_E_OK)
-				PanicAlertT("Internal LZO Error - compression failed");
-
-			// The size of the data to write is 'out_len'
-			f.WriteArray((lzo_uint32*)&out_len, 1);
-			f.WriteBytes(out, out_len);
+		std::vector<StatePiece> pieces;
+		GetPieces(buffer_size, *save_args.sections, pieces);
 
-			if (cur_len != IN_LEN)
-				break;
+		std::vector<std::vector<u8>> compressed(pieces.size());
+		std::vector<u8> failed(pieces.size());
+		ForEachPiece(pieces, [&](size_t i) {
+			std::vector<lzo_align_t> wrkmem((LZO1X_1_MEM_COMPRESS + sizeof(lzo_align_t) - 1) / sizeof(lzo_align_t));
+			const u32 size = pieces[i].raw_size;
+			compressed[i].resize(size + size / 16 + 64 + 3);
 
-			i += cur_len;
+			lzo_uint out_len = 0;
+			if (lzo1x_1_compress(buffer_data + pieces[i].offset, size, &compressed[i][0], &out_len, &wrkmem[0]) != LZO_E_OK)
+				failed[i] = true;
+			compressed[i].resize(out_len);
+			pieces[i].stored_size = (u32)out_len;
+		});
+
+		if (std::count(failed.begin(), failed.end(), true))
+			PanicAlertT("Internal LZO Error - compression failed");
+
+		const u32 count = (u32)pieces.size();
+		f.WriteArray(&COMPRESSED_SECTIONS_MAGIC, 1);
+		f.WriteArray(&count, 1);
+		for (const StatePiece& piece : pieces)
+		{
+			f.WriteArray(&piece.raw_size, 1);
+			f.WriteArray(&piece.stored_size, 1);
 		}
+		for (const std::vector<u8>& data : compressed)
+			f.WriteBytes(&data[0], data.size());
 	}
 	else // uncompressed
 	{
@@ -301,27 +458,27 @@ void SaveAs(const std::string& filename, bool wait)
 	// Pause the core while we save the state
 	bool wasUnpaused = Core::PauseAndLock(true);
 
-	// Measure the size of the buffer.
-	u8 *ptr = nullptr;
-	PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
-	DoState(p);
-	const size_t buffer_size = reinterpret_cast<size_t>(ptr);
-
-	// Then actually do the write.
+	bool success;
 	{
-		std::lock_guard<std::mutex> lk(g_cs_current_buffer);
-		g_current_buffer.resize(buffer_size);
-		ptr = &g_current_buffer[0];
-		p.SetMode(PointerWrap::MODE_WRITE);
-		DoState(p);
+		std::lock_guard<std::mutex> lk(g_cs_save_arena);
+		success = DoSaveToArena();
+		if (success)
+		{
+			INFO_LOG(COMMON, "Savestate serialized in %s", GetSaveProfileString().c_str());
+
+			std::lock_guard<std::mutex> lk_buffer(g_cs_current_buffer);
+			g_save_arena.CopyTo(g_current_buffer);
+			g_current_sections = g_save_sections;
+		}
 	}
 
-	if (p.GetMode() == PointerWrap::MODE_WRITE)
+	if (success)
 	{
 		Core::DisplayMessage("Saving State...", 1000);
 
 		CompressAndDumpState_args save_args;
 		save_args.buffer_vector = &g_current_buffer;
+		save_args.sections = &g_current_sections;
 		save_args.buffer_mutex = &g_cs_current_buffer;
 		save_args.filename = filename;
 		save_args.wait = wait;
@@ -356,24 +513,24 @@ bool ReadHeader(const std::string& filename, StateHeader& header)
 	return true;
 }
 
-void LoadFileStateData(const std::string& filename, std::vector<u8>& ret_data)
+static bool ReadStateFile(const std::string& filename, bool check_game, std::vector<u8>& ret_data)
 {
 	Flush();
 	File::IOFile f(filename, "rb");
 	if (!f)
 	{
 		Core::DisplayMessage("State not found", 2000);
-		return;
+		return false;
 	}
 
 	StateHeader header;
 	f.ReadArray(&header, 1);
 
-	if (memcmp(SConfig::GetInstance().m_LocalCoreStartupParameter.GetUniqueID().c_str(), header.gameID, 6))
+	if (check_game && memcmp(SConfig::GetInstance().m_LocalCoreStartupParameter.GetUniqueID().c_str(), header.gameID, 6))
 	{
 		Core::DisplayMessage(StringFromFormat("State belongs to a different game (ID %.*s)",
 			6, header.gameID), 2000);
-		return;
+		return false;
 	}
 
 	std::vector<u8> buffer;
@@ -382,28 +539,52 @@ void LoadFileStateData(const std::string& filename, std::vector<u8>& ret_data)
 	{
 		Core::DisplayMessage("Decompressing State...", 500);
 
-		buffer.resize(header.size);
+		u32 magic = 0, count = 0;
+		f.ReadArray(&magic, 1);
+		f.ReadArray(&count, 1);
+		if (magic != COMPRESSED_SECTIONS_MAGIC || count > 256)
+		{
+			Core::DisplayMessage("Unable to Load : Can't load state from other revisions !", 4000);
+			return false;
+		}
 
-		lzo_uint i = 0;
-		while (true)
+		std::vector<StatePiece> pieces(count);
+		u32 raw_offset = 0, stored_offset = 0;
+		for (StatePiece& piece : pieces)
 		{
-			lzo_uint32 cur_len = 0;  // number of bytes to read
-			lzo_uint new_len = 0;  // number of bytes to write
+			f.ReadArray(&piece.raw_size, 1);
+			f.ReadArray(&piece.stored_size, 1);
+			piece.offset = raw_offset;
+			piece.stored_offset = stored_offset;
+			raw_offset += piece.raw_size;
+			stored_offset += piece.stored_size;
+		}
 
-			if (!f.ReadArray(&cur_len, 1))
-				break;
+		std::vector<u8> stored(stored_offset);
+		if (raw_offset != header.size || (stored_offset && !f.ReadBytes(&stored[0], stored_offset)))
+		{
+			Core::DisplayMessage("Unable to Load : The state file is truncated", 4000);
+			return false;
+		}
 
-			f.ReadBytes(out, cur_len);
-			const int res = lzo1x_decompress(out, cur_len, &buffer[i], &new_len, nullptr);
-			if (res != LZO_E_OK)
+		buffer.resize(header.size);
+		std::vector<u8> failed(pieces.size());
+		ForEachPiece(pieces, [&](size_t i) {
+			const StatePiece& piece = pieces[i];
+			lzo_uint new_len = piece.raw_size;
+			if (lzo1x_decompress_safe(&stored[piece.stored_offset], piece.stored_size,
+			                          &buffer[piece.offset], &new_len, nullptr) != LZO_E_OK ||
+			    new_len != piece.raw_size)
 			{
-				// This doesn't seem to happen anymore.
-				PanicAlertT("Internal LZO Error - decompression failed (%d) (%li, %li) \n"
-					"Try loading the state again", res, i, new_len);
-				return;
+				failed[i] = true;
 			}
+		});
 
-			i += new_len;
+		if (std::count(failed.begin(), failed.end(), true))
+		{
+			PanicAlertT("Internal LZO Error - decompression failed\n"
+				"Try loading the state again");
+			return false;
 		}
 	}
 	else // uncompressed
@@ -414,12 +595,13 @@ void LoadFileStateData(const std::string& filename, std::vector<u8>& ret_data)
 		if (!f.ReadBytes(&buffer[0], size))
 		{
 			PanicAlert("wtf? reading bytes: %i", (int)size);
-			return;
+			return false;
 		}
 	}
 
 	// all good
 	ret_data.swap(buffer);
+	return true;
 }
 
 void LoadAs(const std::string& filename)
@@ -456,12 +638,33 @@ void LoadAs(const std::string& filename)
 	// brackets here are so buffer gets freed ASAP
 	{
 		std::vector<u8> buffer;
-		LoadFileStateData(filename, buffer);
+		ReadStateFile(filename, true, buffer);
+
+		// Check the sections up front, so a broken state doesn't get half loaded
+		std::vector<SectionInfo> sections;
+		if (!buffer.empty() && ReadSections(buffer, sections))
+		{
+			for (const SectionInfo& section : sections)
+			{
+				if (!section.valid)
+				{
+					Core::DisplayMessage(StringFromFormat("Unable to Load : Section %s of the state is corrupted",
+						section.name.c_str()), 4000);
+					buffer.clear();
+					break;
+				}
+			}
+		}
+		else if (!buffer.empty())
+		{
+			Core::DisplayMessage("Unable to Load : Can't load state from other revisions !", 4000);
+			buffer.clear();
+		}
 
 		if (!buffer.empty())
 		{
 			u8 *ptr = &buffer[0];
-			PointerWrap p(&ptr, PointerWrap::MODE_READ);
+			PointerWrap p(&ptr, PointerWrap::MODE_READ, ptr + buffer.size());
 			DoState(p);
 			loaded = true;
 			loadedSuccessfully = (p.GetMode() == PointerWrap::MODE_READ);
@@ -504,6 +707,12 @@ void LoadAs(const std::string& filename)
 	Core::PauseAndLock(false, wasUnpaused);
 }
 
+bool ReadSectionsFromFile(const std::string& filename, std::vector<SectionInfo>& sections)
+{
+	std::vector<u8> buffer;
+	return ReadStateFile(filename, false, buffer) && ReadSections(buffer, sections);
+}
+
 void SetOnAfterLoadCallback(CallbackFunc callback)
 {
 	g_onAfterLoadCb = callback;
@@ -514,12 +723,12 @@ void VerifyAt(const std::string& filename)
 	bool wasUnpaused = Core::PauseAndLock(true);
 
 	std::vector<u8> buffer;
-	LoadFileStateData(filename, buffer);
+	ReadStateFile(filename, true, buffer);
 
 	if (!buffer.empty())
 	{
 		u8 *ptr = &buffer[0];
-		PointerWrap p(&ptr, PointerWrap::MODE_VERIFY);
+		PointerWrap p(&ptr, PointerWrap::MODE_VERIFY, ptr + buffer.size());
 		DoState(p);
 
 		if (p.GetMode() == PointerWrap::MODE_VERIFY)
@@ -547,12 +756,19 @@ void Shutdown()
 	{
 		std::lock_guard<std::mutex> lk(g_cs_current_buffer);
 		std::vector<u8>().swap(g_current_buffer);
+		g_current_sections.clear();
 	}
 
 	{
 		std::lock_guard<std::mutex> lk(g_cs_undo_load_buffer);
 		std::vector<u8>().swap(g_undo_load_buffer);
 	}
+
+	{
+		std::lock_guard<std::mutex> lk(g_cs_save_arena);
+		g_save_arena.Free();
+		PointerWrap::MarkerTimes().swap(g_save_profile);
+	}
 }
 
 static std::string MakeStateFilename(int number)
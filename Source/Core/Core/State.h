@@ -44,10 +44,33 @@ void SaveAs(const std::string &filename, bool wait = false);
 void LoadAs(const std::string &filename);
 void VerifyAt(const std::string &filename);
 
+struct SectionInfo
+{
+	std::string name;
+	// Position of the section data within the state buffer
+	u32 offset;
+	u32 size;
+	// Whether the data matches its checksum
+	bool valid;
+};
+
+// Lists the sections of a state (one per subsystem) without loading it.
+// Returns false if the state comes from another revision or is truncated.
+bool ReadSections(const std::vector<u8>& buffer, std::vector<SectionInfo>& sections);
+bool ReadSectionsFromFile(const std::string& filename, std::vector<SectionInfo>& sections);
+
 void SaveToBuffer(std::vector<u8>& buffer);
 void LoadFromBuffer(std::vector<u8>& buffer);
 void VerifyBuffer(std::vector<u8>& buffer);
 
+// Like SaveToBuffer, but emulated memory only holds the pages which differ from
+// the base state, taken on the first call or by ResetIncrementalBase().
+// Much cheaper to keep around, but the result can only be loaded (with
+// LoadFromBuffer) while that base is around, so not across sessions.
+// The sections are filled in without names.
+void SaveIncrementalToBuffer(std::vector<u8>& buffer, std::vector<SectionInfo>& sections);
+void ResetIncrementalBase();
+
 void LoadLastSaved(int i = 1);
 void SaveFirstSaved();
 void UndoSaveState();
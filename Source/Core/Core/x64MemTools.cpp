@@ -43,6 +43,10 @@ void print_trace(const char * msg)
 
 bool DoFault(u64 bad_address, SContext *ctx)
 {
+	// A store to a page the texture cache is watching, from JIT code or not
+	if (Memory::HandleWriteWatchFault((uintptr_t)bad_address))
+		return true;
+
 	if (!JitInterface::IsInCodeSpace((u8*) ctx->CTX_PC))
 	{
 		// Let's not prevent debugging.
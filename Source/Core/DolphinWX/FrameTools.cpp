@@ -59,6 +59,7 @@ Core::GetWindowHandle().
 #include "Core/CoreParameter.h"
 #include "Core/Host.h"
 #include "Core/Movie.h"
+#include "Core/Rewind.h"
 #include "Core/State.h"
 #include "Core/HW/CPU.h"
 #include "Core/HW/DVDInterface.h"
@@ -197,6 +198,7 @@ void CFrame::CreateMenu()
 	loadMenu->Append(IDM_LOADSTATEFILE,  GetMenuLabel(HK_LOAD_STATE_FILE));
 
 	loadMenu->Append(IDM_UNDOLOADSTATE, GetMenuLabel(HK_UNDO_LOAD_STATE));
+	loadMenu->Append(IDM_REWIND, GetMenuLabel(HK_REWIND));
 	loadMenu->AppendSeparator();
 
 	for (unsigned int i = 1; i <= State::NUM_STATES; i++)
@@ -458,6 +460,7 @@ wxString CFrame::GetMenuLabel(int Id)
 		case HK_SAVE_FIRST_STATE: Label = wxString("Save Oldest State"); break;
 		case HK_UNDO_LOAD_STATE: Label = wxString("Undo Load State"); break;
 		case HK_UNDO_SAVE_STATE: Label = wxString("Undo Save State"); break;
+		case HK_REWIND: Label = _("Rewind"); break;
 
 		default:
 			Label = wxString::Format(_("Undefined %i"), Id);
@@ -1561,6 +1564,12 @@ void CFrame::OnUndoSaveState(wxCommandEvent& WXUNUSED (event))
 		State::UndoSaveState();
 }
 
+void CFrame::OnRewind(wxCommandEvent& WXUNUSED (event))
+{
+	if (Core::IsRunningAndStarted())
+		Rewind::StepBack();
+}
+
 
 void CFrame::OnLoadState(wxCommandEvent& event)
 {
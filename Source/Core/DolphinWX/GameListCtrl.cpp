@@ -77,6 +77,7 @@
 #include "DolphinWX/resources/Platform_Wad.xpm"
 #include "DolphinWX/resources/Platform_Wii.xpm"
 #include "DolphinWX/resources/rating_gamelist.h"
+#include "VideoCommon/HiresTextures.h"
 
 size_t CGameListCtrl::m_currentItem = 0;
 size_t CGameListCtrl::m_numberItem = 0;
@@ -202,6 +203,7 @@ BEGIN_EVENT_TABLE(CGameListCtrl, wxListCtrl)
 	EVT_MENU(IDM_OPENCONTAININGFOLDER, CGameListCtrl::OnOpenContainingFolder)
 	EVT_MENU(IDM_OPENSAVEFOLDER, CGameListCtrl::OnOpenSaveFolder)
 	EVT_MENU(IDM_EXPORTSAVE, CGameListCtrl::OnExportSave)
+	EVT_MENU(IDM_BUILDTEXTUREPACK, CGameListCtrl::OnBuildTexturePack)
 	EVT_MENU(IDM_SETDEFAULTGCM, CGameListCtrl::OnSetDefaultGCM)
 	EVT_MENU(IDM_COMPRESSGCM, CGameListCtrl::OnCompressGCM)
 	EVT_MENU(IDM_MULTICOMPRESSGCM, CGameListCtrl::OnMultiCompressGCM)
@@ -871,6 +873,7 @@ void CGameListCtrl::OnRightClick(wxMouseEvent& event)
 				popupMenu->Append(IDM_EXPORTSAVE, _("Export Wii save (Experimental)"));
 			}
 			popupMenu->Append(IDM_OPENCONTAININGFOLDER, _("Open &containing folder"));
+			popupMenu->Append(IDM_BUILDTEXTUREPACK, _("Build custom texture pack"));
 			popupMenu->AppendCheckItem(IDM_SETDEFAULTGCM, _("Set as &default ISO"));
 
 			// First we have to decide a starting value when we append it
@@ -978,6 +981,25 @@ void CGameListCtrl::OnExportSave(wxCommandEvent& WXUNUSED (event))
 	}
 }
 
+// Packs the game's custom textures, already decoded, into a single file
+void CGameListCtrl::OnBuildTexturePack(wxCommandEvent& WXUNUSED (event))
+{
+	const GameListItem *iso = GetSelectedISO();
+	if (!iso)
+		return;
+
+	bool success;
+	{
+		wxBusyCursor wait;
+		success = HiresTextures::WriteTexturePack(iso->GetUniqueID());
+	}
+
+	if (success)
+		wxMessageBox(_("The custom texture pack was written."), _("Build custom texture pack"), wxOK | wxICON_INFORMATION, this);
+	else
+		wxMessageBox(_("The custom texture pack could not be written. See the log for details."), _("Build custom texture pack"), wxOK | wxICON_ERROR, this);
+}
+
 // Save this file as the default file
 void CGameListCtrl::OnSetDefaultGCM(wxCommandEvent& event)
 {
@@ -97,6 +97,7 @@ private:
 	void OnOpenContainingFolder(wxCommandEvent& event);
 	void OnOpenSaveFolder(wxCommandEvent& event);
 	void OnExportSave(wxCommandEvent& event);
+	void OnBuildTexturePack(wxCommandEvent& event);
 	void OnSetDefaultGCM(wxCommandEvent& event);
 	void OnDeleteGCM(wxCommandEvent& event);
 	void OnCompressGCM(wxCommandEvent& event);
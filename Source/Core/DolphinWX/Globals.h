@@ -29,6 +29,7 @@ enum
 	IDM_UNDOSAVESTATE,
 	IDM_LOADSTATEFILE,
 	IDM_SAVESTATEFILE,
+	IDM_REWIND,
 	IDM_SAVESLOT1,
 	IDM_SAVESLOT2,
 	IDM_SAVESLOT3,
@@ -229,6 +230,7 @@ enum
 	IDM_EXPORTSAVE,
 	IDM_IMPORTSAVE,
 	IDM_EXPORTALLSAVE,
+	IDM_BUILDTEXTUREPACK,
 	IDM_SETDEFAULTGCM,
 	IDM_DELETEGCM,
 	IDM_COMPRESSGCM,
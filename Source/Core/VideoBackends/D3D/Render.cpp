@@ -690,24 +690,26 @@ bool Renderer::SaveScreenshot(const std::string &filename, const TargetRectangle
 	D3D::context->CopySubresourceRegion(s_screenshot_texture, 0, 0, 0, 0, (ID3D11Resource*)D3D::GetBackBuffer()->GetTex(), 0, &box);
 
 	D3D11_MAPPED_SUBRESOURCE map;
-	D3D::context->Map(s_screenshot_texture, 0, D3D11_MAP_READ_WRITE, 0, &map);
-
-	bool saved_png = TextureToPng((u8*)map.pData, map.RowPitch, filename, rc.GetWidth(), rc.GetHeight(), false);
-
-	D3D::context->Unmap(s_screenshot_texture, 0);
-
-
-	if (saved_png)
-	{
-		OSD::AddMessage(StringFromFormat("Saved %i x %i %s", rc.GetWidth(),
-		                                 rc.GetHeight(), filename.c_str()));
-	}
-	else
+	HRESULT hr = D3D::context->Map(s_screenshot_texture, 0, D3D11_MAP_READ_WRITE, 0, &map);
+	if (FAILED(hr))
 	{
 		OSD::AddMessage(StringFromFormat("Error saving %s", filename.c_str()));
+		return false;
 	}
 
-	return saved_png;
+	// Written in the background, the message comes once the file is done
+	const int width = rc.GetWidth();
+	const int height = rc.GetHeight();
+	TextureToPngAsync((u8*)map.pData, map.RowPitch, filename, width, height, false, [filename, width, height](bool success) {
+		if (success)
+			OSD::AddMessage(StringFromFormat("Saved %i x %i %s", width, height, filename.c_str()));
+		else
+			OSD::AddMessage(StringFromFormat("Error saving %s", filename.c_str()));
+	});
+
+	D3D::context->Unmap(s_screenshot_texture, 0);
+
+	return true;
 }
 
 void formatBufferDump(const u8* in, u8* out, int w, int h, int p)
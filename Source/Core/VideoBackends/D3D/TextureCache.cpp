@@ -64,7 +64,8 @@ bool TextureCache::TCacheEntry::Save(const std::string& filename, unsigned int l
 		HRESULT hr = D3D::context->Map(pNewTexture, 0, D3D11_MAP_READ_WRITE, 0, &map);
 		if (SUCCEEDED(hr))
 		{
-			saved_png = TextureToPng((u8*)map.pData, map.RowPitch, filename, desc.Width, desc.Height);
+			TextureToPngAsync((u8*)map.pData, map.RowPitch, filename, desc.Width, desc.Height);
+			saved_png = true;
 			D3D::context->Unmap(pNewTexture, 0);
 		}
 		SAFE_RELEASE(pNewTexture);
@@ -1867,10 +1867,16 @@ bool Renderer::SaveScreenshot(const std::string &filename, const TargetRectangle
 
 	// Turn image upside down
 	FlipImageData(data, W, H, 4);
-	bool success = TextureToPng(data, W*4, filename, W, H, false);
+	// Written in the background, the message comes once the file is done
+	TextureToPngAsync(data, W*4, filename, W, H, false, [filename, W, H](bool success) {
+		if (success)
+			OSD::AddMessage(StringFromFormat("Saved %i x %i %s", W, H, filename.c_str()));
+		else
+			OSD::AddMessage(StringFromFormat("Error saving %s", filename.c_str()));
+	});
 	delete[] data;
 
-	return success;
+	return true;
 
 }
 
@@ -74,9 +74,9 @@ bool SaveTexture(const std::string& filename, u32 textarget, u32 tex, int virtua
 		delete[] data;
 		return false;
 	}
-	bool success = TextureToPng(data, width * 4, filename, width, height, true);
+	TextureToPngAsync(data, width * 4, filename, width, height, true);
 	delete[] data;
-	return success;
+	return true;
 }
 
 TextureCache::TCacheEntry::~TCacheEntry()
@@ -10,6 +10,7 @@
 #include "VideoBackends/Software/EfbInterface.h"
 #include "VideoBackends/Software/Rasterizer.h"
 #include "VideoBackends/Software/Tev.h"
+#include "VideoBackends/Software/TextureSampler.h"
 
 #include "VideoCommon/PixelEngine.h"
 #include "VideoCommon/TextureDecoder.h"
@@ -99,7 +100,10 @@ void SWBPWritten(int address, int newvalue)
 				ptr = Memory::GetPointer((bpmem.tmem_config.tlut_src & 0xFFFFF) << 5);
 
 			if (ptr)
+			{
 				memcpy_gc(texMem + tlutTMemAddr, ptr, tlutXferCount);
+				TextureSampler::InvalidateRange(texMem + tlutTMemAddr, tlutXferCount);
+			}
 			else
 				PanicAlert("Invalid palette pointer %08x %08x %08x", bpmem.tmem_config.tlut_src, bpmem.tmem_config.tlut_src << 5, (bpmem.tmem_config.tlut_src & 0xFFFFF)<< 5);
 			break;
@@ -122,12 +126,16 @@ void SWBPWritten(int address, int newvalue)
 					size = TMEM_SIZE - tmem_addr_even;
 
 				memcpy(texMem + tmem_addr_even, src_ptr, size);
+				TextureSampler::InvalidateRange(texMem + tmem_addr_even, size);
 			}
 			else // RGBA8 tiles (and CI14, but that might just be stupid libogc!)
 			{
 				// AR and GB tiles are stored in separate TMEM banks => can't use a single memcpy for everything
 				u32 tmem_addr_odd = tmem_cfg.preload_tmem_odd * TMEM_LINE_SIZE;
 
+				TextureSampler::InvalidateRange(texMem + tmem_addr_even, size);
+				TextureSampler::InvalidateRange(texMem + tmem_addr_odd, size);
+
 				for (unsigned int i = 0; i < tmem_cfg.preload_tile_info.count; ++i)
 				{
 					if (tmem_addr_even + TMEM_LINE_SIZE > TMEM_SIZE ||
@@ -14,6 +14,7 @@
 #include "VideoBackends/Software/SWStatistics.h"
 #include "VideoBackends/Software/SWVideoConfig.h"
 #include "VideoBackends/Software/TextureEncoder.h"
+#include "VideoBackends/Software/TextureSampler.h"
 
 static const float s_gammaLUT[] =
 {
@@ -68,6 +69,13 @@ namespace EfbCopy
 			u8 *dest_ptr = Memory::GetPointer(bpmem.copyTexDest << 5);
 
 			TextureEncoder::Encode(dest_ptr);
+
+			// Conservative size of the encoded texture, blocks are at least 4 rows high
+			u32 height = bpmem.copyTexSrcWH.y + 1;
+			if (bpmem.triggerEFBCopy.half_scale)
+				height /= 2;
+			u32 size = bpmem.copyMipMapStrideChannels * 32 * ((height >> 2) + 1);
+			TextureSampler::InvalidateRange(dest_ptr, size);
 		}
 	}
 
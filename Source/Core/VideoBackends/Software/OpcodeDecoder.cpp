@@ -12,6 +12,7 @@
 #include "VideoBackends/Software/SWStatistics.h"
 #include "VideoBackends/Software/SWVertexLoader.h"
 #include "VideoBackends/Software/SWVideoConfig.h"
+#include "VideoBackends/Software/TextureSampler.h"
 #include "VideoBackends/Software/XFMemLoader.h"
 #include "VideoCommon/DataReader.h"
 
@@ -122,6 +123,11 @@ void DecodeStandard(u32 bufferSize)
 
 	if (Cmd == GX_NOP)
 		return;
+
+	// textures may have changed since the last draw, look them up again
+	if (Cmd & 0x80)
+		TextureSampler::InvalidateBindings();
+
 	// Causes a SIGBUS error on Android
 	// XXX: Investigate
 #ifndef ANDROID
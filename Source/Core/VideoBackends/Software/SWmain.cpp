@@ -28,6 +28,7 @@
 #include "VideoBackends/Software/SWStatistics.h"
 #include "VideoBackends/Software/SWVertexLoader.h"
 #include "VideoBackends/Software/SWVideoConfig.h"
+#include "VideoBackends/Software/TextureSampler.h"
 #include "VideoBackends/Software/VideoBackend.h"
 #include "VideoBackends/Software/XFMemLoader.h"
 
@@ -168,6 +169,7 @@ void VideoSoftware::Shutdown()
 	HwRasterizer::Shutdown();
 	SWRenderer::Shutdown();
 	DebugUtil::Shutdown();
+	TextureSampler::Shutdown();
 
 	// Do our OSD callbacks
 	OSD::DoCallbacks(OSD::OSD_SHUTDOWN);
@@ -3,7 +3,10 @@
 // Refer to the license.txt file included.
 
 #include <cmath>
+#include <map>
+#include <vector>
 
+#include "Common/Hash.h"
 #include "Core/HW/Memmap.h"
 #include "VideoBackends/Software/BPMemLoader.h"
 #include "VideoBackends/Software/TextureSampler.h"
@@ -11,14 +14,221 @@
 
 #define ALLOW_MIPMAP 1
 
+// Upper bound for the memory held by decoded texture levels
+#define TEXTURE_CACHE_SIZE (32 * 1024 * 1024)
+
 namespace TextureSampler
 {
 
+enum { MAX_BOUND_MIPS = 16 };
+
+struct CacheKey
+{
+	const u8 *src;
+	const u8 *srcOdd;
+	u32 width;
+	u32 height;
+	u32 format;
+	u32 tlutAddress;
+	u32 tlutFormat;
+	u64 hash;
+
+	bool operator<(const CacheKey &other) const
+	{
+		if (src != other.src) return src < other.src;
+		if (srcOdd != other.srcOdd) return srcOdd < other.srcOdd;
+		if (width != other.width) return width < other.width;
+		if (height != other.height) return height < other.height;
+		if (format != other.format) return format < other.format;
+		if (tlutAddress != other.tlutAddress) return tlutAddress < other.tlutAddress;
+		if (tlutFormat != other.tlutFormat) return tlutFormat < other.tlutFormat;
+		return hash < other.hash;
+	}
+};
+
+struct CacheEntry
+{
+	std::vector<u8> texels; // RGBA8, (width * height) texels
+	u32 width;
+	u32 srcSize;
+	u32 paletteSize;
+	u32 lastUsed;
+};
+
+struct Binding
+{
+	const CacheEntry *entry;
+	u32 generation;
+};
+
+typedef std::map<CacheKey, CacheEntry> TextureCache;
+
+static TextureCache s_cache;
+static u32 s_cacheBytes = 0;
+static u32 s_generation = 1;
+static Binding s_bindings[8][MAX_BOUND_MIPS];
+
+void InvalidateBindings()
+{
+	++s_generation;
+}
+
+static bool Overlaps(const u8 *start, u32 size, const u8 *ptr, u32 ptrSize)
+{
+	return start && start < ptr + ptrSize && ptr < start + size;
+}
+
+void InvalidateRange(const u8 *ptr, u32 size)
+{
+	const u8 *palette = texMem;
+
+	for (TextureCache::iterator it = s_cache.begin(); it != s_cache.end();)
+	{
+		const CacheKey &key = it->first;
+		const CacheEntry &entry = it->second;
+
+		if (Overlaps(key.src, entry.srcSize, ptr, size) ||
+		    Overlaps(key.srcOdd, entry.srcSize, ptr, size) ||
+		    (entry.paletteSize && Overlaps(palette + key.tlutAddress, entry.paletteSize, ptr, size)))
+		{
+			s_cacheBytes -= (u32)entry.texels.size();
+			s_cache.erase(it++);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	InvalidateBindings();
+}
+
+void Shutdown()
+{
+	s_cache.clear();
+	s_cacheBytes = 0;
+	InvalidateBindings();
+}
+
+// Evicts the least recently used levels which aren't bound by the current draw
+static void EvictEntries(u32 neededBytes)
+{
+	while (s_cacheBytes + neededBytes > TEXTURE_CACHE_SIZE)
+	{
+		TextureCache::iterator oldest = s_cache.end();
+		for (TextureCache::iterator it = s_cache.begin(); it != s_cache.end(); ++it)
+		{
+			if (it->second.lastUsed != s_generation &&
+			    (oldest == s_cache.end() || it->second.lastUsed < oldest->second.lastUsed))
+				oldest = it;
+		}
+
+		if (oldest == s_cache.end())
+			break;
+
+		s_cacheBytes -= (u32)oldest->second.texels.size();
+		s_cache.erase(oldest);
+	}
+}
+
+// Returns the fully decoded texture level for the given texmap/mip.
+// imageWidth and imageHeight are the largest valid texel coordinates, as passed to the texel decoders.
+static const CacheEntry *GetDecodedLevel(u8 texmap, s32 mip, const u8 *imageSrc, const u8 *imageSrcOdd,
+                                         int imageWidth, int imageHeight, u32 format, u32 tlutAddress, u32 tlutFormat)
+{
+	Binding *binding = nullptr;
+	if (mip >= 0 && mip < MAX_BOUND_MIPS)
+	{
+		binding = &s_bindings[texmap & 7][mip];
+		if (binding->generation == s_generation)
+			return binding->entry;
+	}
+
+	const CacheEntry *entry = nullptr;
+
+	if (imageSrc)
+	{
+		u32 width = imageWidth + 1;
+		u32 height = imageHeight + 1;
+
+		// hash the whole blocks which are touched by the decoder
+		u32 blockWidth = TexDecoder_GetBlockWidthInTexels(format);
+		u32 blockHeight = TexDecoder_GetBlockHeightInTexels(format);
+		u32 expandedWidth = (width + blockWidth - 1) & ~(blockWidth - 1);
+		u32 expandedHeight = (height + blockHeight - 1) & ~(blockHeight - 1);
+		u32 srcSize = TexDecoder_GetTextureSizeInBytes(expandedWidth, expandedHeight, format);
+		if (imageSrcOdd)
+			srcSize /= 2;
+
+		u32 paletteSize = TexDecoder_GetPaletteSize(format);
+
+		CacheKey key;
+		key.src = imageSrc;
+		key.srcOdd = imageSrcOdd;
+		key.width = width;
+		key.height = height;
+		key.format = format;
+		key.tlutAddress = paletteSize ? tlutAddress : 0;
+		key.tlutFormat = paletteSize ? tlutFormat : 0;
+		key.hash = GetHash64(imageSrc, srcSize, 0);
+		if (imageSrcOdd)
+			key.hash ^= GetHash64(imageSrcOdd, srcSize, 0) * 31;
+		if (paletteSize)
+			key.hash ^= GetHash64(texMem + tlutAddress, paletteSize, 0);
+
+		TextureCache::iterator it = s_cache.find(key);
+		if (it == s_cache.end())
+		{
+			u32 bytes = width * height * 4;
+			EvictEntries(bytes);
+
+			CacheEntry &newEntry = s_cache[key];
+			newEntry.width = width;
+			newEntry.srcSize = srcSize;
+			newEntry.paletteSize = paletteSize;
+			newEntry.texels.resize(bytes);
+
+			u8 *dst = &newEntry.texels[0];
+			for (int t = 0; t <= imageHeight; t++)
+			{
+				for (int s = 0; s <= imageWidth; s++)
+				{
+					if (imageSrcOdd)
+						TexDecoder_DecodeTexelRGBA8FromTmem(dst, imageSrc, imageSrcOdd, s, t, imageWidth);
+					else
+						TexDecoder_DecodeTexel(dst, imageSrc, s, t, imageWidth, format, tlutAddress, tlutFormat);
+					dst += 4;
+				}
+			}
+
+			s_cacheBytes += bytes;
+			it = s_cache.find(key);
+		}
+
+		it->second.lastUsed = s_generation;
+		entry = &it->second;
+	}
+
+	if (binding)
+	{
+		binding->entry = entry;
+		binding->generation = s_generation;
+	}
+
+	return entry;
+}
+
+static inline const u8 *GetTexel(const CacheEntry *entry, int s, int t)
+{
+	return &entry->texels[(t * entry->width + s) * 4];
+}
+
 inline void WrapCoord(int &coord, int wrapMode, int imageSize)
 {
 	switch (wrapMode)
 	{
 		case 0: // clamp
+		default:
 			coord = (coord>imageSize)?imageSize:(coord<0)?0:coord;
 			break;
 		case 1: // wrap
@@ -37,7 +247,7 @@ inline void WrapCoord(int &coord, int wrapMode, int imageSize)
 	}
 }
 
-inline void SetTexel(u8 *inTexel, u32 *outTexel, u32 fract)
+inline void SetTexel(const u8 *inTexel, u32 *outTexel, u32 fract)
 {
 	outTexel[0] = inTexel[0] * fract;
 	outTexel[1] = inTexel[1] * fract;
@@ -45,7 +255,7 @@ inline void SetTexel(u8 *inTexel, u32 *outTexel, u32 fract)
 	outTexel[3] = inTexel[3] * fract;
 }
 
-inline void AddTexel(u8 *inTexel, u32 *outTexel, u32 fract)
+inline void AddTexel(const u8 *inTexel, u32 *outTexel, u32 fract)
 {
 	outTexel[0] += inTexel[0] * fract;
 	outTexel[1] += inTexel[1] * fract;
@@ -123,6 +333,7 @@ void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample)
 	int imageHeight = ti0.height;
 
 	int tlutAddress = texTlut.tmem_offset << 9;
+	s32 mipLevel = mip;
 
 	// reduce sample location and texture size to mip level
 	// move texture pointer to mip location
@@ -153,6 +364,14 @@ void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample)
 		}
 	}
 
+	const CacheEntry *level = GetDecodedLevel(texmap, mipLevel, imageSrc, imageSrcOdd, imageWidth, imageHeight,
+	                                          ti0.format, tlutAddress, texTlut.tlut_format);
+	if (!level)
+	{
+		memset(sample, 0, 4);
+		return;
+	}
+
 	if (linear)
 	{
 		// offset linear sampling
@@ -170,7 +389,6 @@ void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample)
 		int imageTPlus1 = imageT + 1;
 		int fractT = t & 0x7f;
 
-		u8 sampledTex[4];
 		u32 texel[4];
 
 		WrapCoord(imageS, tm0.wrap_s, imageWidth);
@@ -178,34 +396,10 @@ void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample)
 		WrapCoord(imageSPlus1, tm0.wrap_s, imageWidth);
 		WrapCoord(imageTPlus1, tm0.wrap_t, imageHeight);
 
-		if (!(ti0.format == GX_TF_RGBA8 && texUnit.texImage1[subTexmap].image_type))
-		{
-			TexDecoder_DecodeTexel(sampledTex, imageSrc, imageS, imageT, imageWidth, ti0.format, tlutAddress, texTlut.tlut_format);
-			SetTexel(sampledTex, texel, (128 - fractS) * (128 - fractT));
-
-			TexDecoder_DecodeTexel(sampledTex, imageSrc, imageSPlus1, imageT, imageWidth, ti0.format, tlutAddress, texTlut.tlut_format);
-			AddTexel(sampledTex, texel, (fractS) * (128 - fractT));
-
-			TexDecoder_DecodeTexel(sampledTex, imageSrc, imageS, imageTPlus1, imageWidth, ti0.format, tlutAddress, texTlut.tlut_format);
-			AddTexel(sampledTex, texel, (128 - fractS) * (fractT));
-
-			TexDecoder_DecodeTexel(sampledTex, imageSrc, imageSPlus1, imageTPlus1, imageWidth, ti0.format, tlutAddress, texTlut.tlut_format);
-			AddTexel(sampledTex, texel, (fractS) * (fractT));
-		}
-		else
-		{
-			TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageS, imageT, imageWidth);
-			SetTexel(sampledTex, texel, (128 - fractS) * (128 - fractT));
-
-			TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageSPlus1, imageT, imageWidth);
-			AddTexel(sampledTex, texel, (fractS) * (128 - fractT));
-
-			TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageS, imageTPlus1, imageWidth);
-			AddTexel(sampledTex, texel, (128 - fractS) * (fractT));
-
-			TexDecoder_DecodeTexelRGBA8FromTmem(sampledTex, imageSrc, imageSrcOdd, imageSPlus1, imageTPlus1, imageWidth);
-			AddTexel(sampledTex, texel, (fractS) * (fractT));
-		}
+		SetTexel(GetTexel(level, imageS, imageT), texel, (128 - fractS) * (128 - fractT));
+		AddTexel(GetTexel(level, imageSPlus1, imageT), texel, (fractS) * (128 - fractT));
+		AddTexel(GetTexel(level, imageS, imageTPlus1), texel, (128 - fractS) * (fractT));
+		AddTexel(GetTexel(level, imageSPlus1, imageTPlus1), texel, (fractS) * (fractT));
 
 		sample[0] = (u8)(texel[0] >> 14);
 		sample[1] = (u8)(texel[1] >> 14);
@@ -222,10 +416,7 @@ void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample)
 		WrapCoord(imageS, tm0.wrap_s, imageWidth);
 		WrapCoord(imageT, tm0.wrap_t, imageHeight);
 
-		if (!(ti0.format == GX_TF_RGBA8 && texUnit.texImage1[subTexmap].image_type))
-			TexDecoder_DecodeTexel(sample, imageSrc, imageS, imageT, imageWidth, ti0.format, tlutAddress, texTlut.tlut_format);
-		else
-			TexDecoder_DecodeTexelRGBA8FromTmem(sample, imageSrc, imageSrcOdd, imageS, imageT, imageWidth);
+		*(u32*)sample = *(const u32*)GetTexel(level, imageS, imageT);
 	}
 }
 
@@ -12,5 +12,15 @@ namespace TextureSampler
 
 	void SampleMip(s32 s, s32 t, s32 mip, bool linear, u8 texmap, u8 *sample);
 
+	// Decoded texture levels are looked up (and rehashed) once per draw.
+	// Call this whenever the texture state or memory may have changed.
+	void InvalidateBindings();
+
+	// Drops cached levels whose texel or palette data overlaps the given range.
+	// Used for TMEM loads and EFB copies to RAM.
+	void InvalidateRange(const u8 *ptr, u32 size);
+
+	void Shutdown();
+
 	enum { RED_SMP, GRN_SMP, BLU_SMP, ALP_SMP };
 }
@@ -204,9 +204,13 @@ bool AVIDump::SetVideoFormat()
 
 #else
 
+#include <memory>
+
 #include "Common/FileUtil.h"
 #include "Common/Log.h"
 #include "Common/StringUtil.h"
+#include "VideoCommon/FrameDumpQueue.h"
+#include "VideoCommon/Statistics.h"
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -217,13 +221,18 @@ extern "C" {
 
 AVFormatContext *s_FormatContext = nullptr;
 AVStream *s_Stream = nullptr;
-AVFrame *s_BGRFrame = nullptr, *s_YUVFrame = nullptr;
-uint8_t *s_YUVBuffer = nullptr;
+AVFrame *s_YUVFrame = nullptr;
 uint8_t *s_OutBuffer = nullptr;
 int s_width;
 int s_height;
 int s_size;
 
+// Scales and converts the frames on one thread, encodes and writes them on
+// another
+static std::unique_ptr<FrameDumpPipeline> s_pipeline;
+// Only used on the conversion thread
+static SwsContext *s_SwsContext = nullptr;
+
 static void InitAVCodec()
 {
 	static bool first_run = true;
@@ -234,13 +243,65 @@ static void InitAVCodec()
 	}
 }
 
+static void ConvertFrame(const FrameDumpQueue::Frame& in, FrameDumpQueue::Frame& out)
+{
+	// Convert image from BGR24 to desired pixel format, and scale to initial
+	// width and height
+	s_SwsContext = sws_getCachedContext(s_SwsContext, in.width, in.height, PIX_FMT_BGR24,
+			s_width, s_height, s_Stream->codec->pix_fmt, SWS_BICUBIC, nullptr, nullptr, nullptr);
+	if (s_SwsContext)
+	{
+		AVPicture src, dst;
+		avpicture_fill(&src, const_cast<u8*>(in.data.data()), PIX_FMT_BGR24, in.width, in.height);
+		avpicture_fill(&dst, out.data.data(), s_Stream->codec->pix_fmt, s_width, s_height);
+		sws_scale(s_SwsContext, src.data, src.linesize, 0, in.height, dst.data, dst.linesize);
+	}
+}
+
+static void EncodeFrame(FrameDumpQueue::Frame& frame)
+{
+	avpicture_fill((AVPicture *)s_YUVFrame, frame.data.data(), s_Stream->codec->pix_fmt, s_width, s_height);
+	// Dropped frames leave a gap in the numbers, so the video keeps its length
+	s_YUVFrame->pts = frame.number;
+
+	// Encode and write the image
+	int outsize = avcodec_encode_video(s_Stream->codec, s_OutBuffer, s_size, s_YUVFrame);
+	while (outsize > 0)
+	{
+		AVPacket pkt;
+		av_init_packet(&pkt);
+
+		// Compare all 64 bits, truncated to 32 AV_NOPTS_VALUE would be 0 and
+		// the first frame would lose its timestamp
+		if (s_Stream->codec->coded_frame->pts != AV_NOPTS_VALUE)
+			pkt.pts = av_rescale_q(s_Stream->codec->coded_frame->pts,
+					s_Stream->codec->time_base, s_Stream->time_base);
+		if (s_Stream->codec->coded_frame->key_frame)
+			pkt.flags |= AV_PKT_FLAG_KEY;
+		pkt.stream_index = s_Stream->index;
+		pkt.data = s_OutBuffer;
+		pkt.size = outsize;
+
+		// Write the compressed frame in the media file
+		av_interleaved_write_frame(s_FormatContext, &pkt);
+
+		// Encode delayed frames
+		outsize = avcodec_encode_video(s_Stream->codec, s_OutBuffer, s_size, nullptr);
+	}
+}
+
 bool AVIDump::Start(int w, int h)
 {
 	s_width = w;
 	s_height = h;
 
 	InitAVCodec();
-	return CreateFile();
+	if (!CreateFile())
+		return false;
+
+	s_pipeline.reset(new FrameDumpPipeline(g_Config.iFrameDumpQueueSize, g_Config.bFrameDumpDropFrames,
+			s_width, s_height, s_size, ConvertFrame, EncodeFrame));
+	return true;
 }
 
 bool AVIDump::CreateFile()
@@ -276,14 +337,11 @@ bool AVIDump::CreateFile()
 		return false;
 	}
 
-	s_BGRFrame = avcodec_alloc_frame();
+	// The picture data itself lives in the frames of the encode queue
 	s_YUVFrame = avcodec_alloc_frame();
 
 	s_size = avpicture_get_size(s_Stream->codec->pix_fmt, s_width, s_height);
 
-	s_YUVBuffer = new uint8_t[s_size];
-	avpicture_fill((AVPicture *)s_YUVFrame, s_YUVBuffer, s_Stream->codec->pix_fmt, s_width, s_height);
-
 	s_OutBuffer = new uint8_t[s_size];
 
 	NOTICE_LOG(VIDEO, "Opening file %s for dumping", s_FormatContext->filename);
@@ -301,45 +359,23 @@ bool AVIDump::CreateFile()
 
 void AVIDump::AddFrame(const u8* data, int width, int height)
 {
-	avpicture_fill((AVPicture *)s_BGRFrame, const_cast<u8*>(data), PIX_FMT_BGR24, width, height);
+	// Only copied here, the conversion and encoding happen on their threads
+	s_pipeline->AddFrame(data, width, height);
+	s_pipeline->ReportStats(stats);
+}
 
-	// Convert image from BGR24 to desired pixel format, and scale to initial
-	// width and height
-	struct SwsContext *s_SwsContext;
-	if ((s_SwsContext = sws_getContext(width, height, PIX_FMT_BGR24, s_width, s_height,
-					s_Stream->codec->pix_fmt, SWS_BICUBIC, nullptr, nullptr, nullptr)))
+void AVIDump::Stop()
+{
+	// Dumps the frames that are still queued, in order
+	s_pipeline.reset();
+	// Otherwise the overlay keeps showing the frame dump lines
+	FrameDumpPipeline::ClearStats(stats);
+	if (s_SwsContext)
 	{
-		sws_scale(s_SwsContext, s_BGRFrame->data, s_BGRFrame->linesize, 0,
-				height, s_YUVFrame->data, s_YUVFrame->linesize);
 		sws_freeContext(s_SwsContext);
+		s_SwsContext = nullptr;
 	}
 
-	// Encode and write the image
-	int outsize = avcodec_encode_video(s_Stream->codec, s_OutBuffer, s_size, s_YUVFrame);
-	while (outsize > 0)
-	{
-		AVPacket pkt;
-		av_init_packet(&pkt);
-
-		if (s_Stream->codec->coded_frame->pts != (unsigned int)AV_NOPTS_VALUE)
-			pkt.pts = av_rescale_q(s_Stream->codec->coded_frame->pts,
-					s_Stream->codec->time_base, s_Stream->time_base);
-		if (s_Stream->codec->coded_frame->key_frame)
-			pkt.flags |= AV_PKT_FLAG_KEY;
-		pkt.stream_index = s_Stream->index;
-		pkt.data = s_OutBuffer;
-		pkt.size = outsize;
-
-		// Write the compressed frame in the media file
-		av_interleaved_write_frame(s_FormatContext, &pkt);
-
-		// Encode delayed frames
-		outsize = avcodec_encode_video(s_Stream->codec, s_OutBuffer, s_size, nullptr);
-	}
-}
-
-void AVIDump::Stop()
-{
 	av_write_trailer(s_FormatContext);
 	CloseFile();
 	NOTICE_LOG(VIDEO, "Stopping frame dump");
@@ -355,18 +391,10 @@ void AVIDump::CloseFile()
 		s_Stream = nullptr;
 	}
 
-	if (s_YUVBuffer)
-		delete[] s_YUVBuffer;
-	s_YUVBuffer = nullptr;
-
 	if (s_OutBuffer)
 		delete[] s_OutBuffer;
 	s_OutBuffer = nullptr;
 
-	if (s_BGRFrame)
-		av_free(s_BGRFrame);
-	s_BGRFrame = nullptr;
-
 	if (s_YUVFrame)
 		av_free(s_YUVFrame);
 	s_YUVFrame = nullptr;
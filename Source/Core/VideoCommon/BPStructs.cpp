@@ -252,6 +252,8 @@ void BPWritten(const BPCmd& bp)
 									 bpmem.copyMipMapStrideChannels << 4,
 									 (u32)xfbLines,
 									 s_gammaLUT[PE_copy.gamma]);
+				// Two bytes per pixel, conservatively assuming the copy reached RAM
+				Memory::MarkWritten(bpmem.copyTexDest << 5, (bpmem.copyMipMapStrideChannels << 4) * (u32)xfbLines * 2);
 			}
 
 			// Clear the rectangular region after copying it.
@@ -0,0 +1,182 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstring>
+
+#include "Common/Log.h"
+#include "VideoCommon/FrameDumpQueue.h"
+#include "VideoCommon/Statistics.h"
+
+FrameDumpQueue::FrameDumpQueue(int capacity, bool drop_when_full, const ProcessFunction& process)
+	: m_capacity(capacity > 0 ? capacity : 1), m_drop_when_full(drop_when_full), m_process(process),
+	  m_busy(false), m_quit(false), m_next_number(0)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_thread = std::thread(&FrameDumpQueue::ThreadLoop, this);
+}
+
+FrameDumpQueue::~FrameDumpQueue()
+{
+	{
+		std::lock_guard<std::mutex> lk(m_lock);
+		m_quit = true;
+	}
+	m_frame_queued.notify_one();
+	m_thread.join();
+}
+
+FrameDumpQueue::Frame* FrameDumpQueue::Acquire(int width, int height, size_t size)
+{
+	std::unique_lock<std::mutex> lk(m_lock);
+	const u64 number = m_next_number++;
+
+	if (m_free.empty() && (int)m_frames.size() < m_capacity)
+	{
+		m_frames.emplace_back(new Frame);
+		m_free.push_back(m_frames.back().get());
+	}
+
+	if (m_free.empty())
+	{
+		if (m_drop_when_full)
+		{
+			++m_stats.frames_dropped;
+			return nullptr;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		m_frame_done.wait(lk, [this] { return !m_free.empty(); });
+		auto end = std::chrono::steady_clock::now();
+		m_stats.wait_us += std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+	}
+
+	Frame* frame = m_free.back();
+	m_free.pop_back();
+
+	m_stats.depth = (int)(m_frames.size() - m_free.size());
+	if (m_stats.depth > m_stats.max_depth)
+		m_stats.max_depth = m_stats.depth;
+	lk.unlock();
+
+	// Only ever grows, so a warm pool doesn't allocate
+	frame->data.resize(size);
+	frame->width = width;
+	frame->height = height;
+	frame->number = number;
+	return frame;
+}
+
+void FrameDumpQueue::Submit(Frame* frame)
+{
+	{
+		std::lock_guard<std::mutex> lk(m_lock);
+		m_queued.push_back(frame);
+		++m_stats.frames_submitted;
+	}
+	m_frame_queued.notify_one();
+}
+
+void FrameDumpQueue::Flush()
+{
+	std::unique_lock<std::mutex> lk(m_lock);
+	m_frame_done.wait(lk, [this] { return m_queued.empty() && !m_busy; });
+}
+
+FrameDumpQueue::Stats FrameDumpQueue::GetStats()
+{
+	std::lock_guard<std::mutex> lk(m_lock);
+	return m_stats;
+}
+
+void FrameDumpQueue::ThreadLoop()
+{
+	std::unique_lock<std::mutex> lk(m_lock);
+	while (true)
+	{
+		m_frame_queued.wait(lk, [this] { return m_quit || !m_queued.empty(); });
+		// Everything queued still gets dumped when stopping
+		if (m_queued.empty())
+			return;
+
+		Frame* frame = m_queued.front();
+		m_queued.pop_front();
+		m_busy = true;
+		lk.unlock();
+
+		m_process(*frame);
+
+		lk.lock();
+		m_busy = false;
+		m_free.push_back(frame);
+		++m_stats.frames_processed;
+		m_stats.depth = (int)(m_frames.size() - m_free.size());
+		m_frame_done.notify_all();
+	}
+}
+
+FrameDumpPipeline::FrameDumpPipeline(int capacity, bool drop_frames, int width, int height, size_t converted_size,
+                                     const ConvertFunction& convert, const FrameDumpQueue::ProcessFunction& encode)
+	: m_width(width), m_height(height), m_converted_size(converted_size), m_convert(convert)
+{
+	m_encode_queue.reset(new FrameDumpQueue(capacity, false, encode));
+	m_convert_queue.reset(new FrameDumpQueue(capacity, drop_frames,
+		[this](FrameDumpQueue::Frame& frame) { ConvertFrame(frame); }));
+}
+
+FrameDumpPipeline::~FrameDumpPipeline()
+{
+	FrameDumpQueue::Stats convert = m_convert_queue->GetStats();
+	FrameDumpQueue::Stats encode = m_encode_queue->GetStats();
+	NOTICE_LOG(VIDEO, "Frame dump: %u frames, %u dropped, queue depth up to %i+%i, waited %u ms",
+			(u32)convert.frames_submitted, (u32)convert.frames_dropped, convert.max_depth,
+			encode.max_depth, (u32)(convert.wait_us / 1000));
+
+	// The conversion still feeds the encoder while it finishes
+	m_convert_queue.reset();
+	m_encode_queue.reset();
+}
+
+void FrameDumpPipeline::AddFrame(const u8* data, int width, int height)
+{
+	const size_t size = 3 * width * height;
+	FrameDumpQueue::Frame* frame = m_convert_queue->Acquire(width, height, size);
+	if (frame)
+	{
+		memcpy(frame->data.data(), data, size);
+		m_convert_queue->Submit(frame);
+	}
+}
+
+void FrameDumpPipeline::Flush()
+{
+	m_convert_queue->Flush();
+	m_encode_queue->Flush();
+}
+
+void FrameDumpPipeline::ConvertFrame(FrameDumpQueue::Frame& frame)
+{
+	FrameDumpQueue::Frame* out = m_encode_queue->Acquire(m_width, m_height, m_converted_size);
+	// Dropped frames leave a gap, so the video keeps its length
+	out->number = frame.number;
+	m_convert(frame, *out);
+	m_encode_queue->Submit(out);
+}
+
+void FrameDumpPipeline::ReportStats(Statistics& out)
+{
+	FrameDumpQueue::Stats convert = m_convert_queue->GetStats();
+	FrameDumpQueue::Stats encode = m_encode_queue->GetStats();
+	out.numFrameDumpQueued = convert.depth + encode.depth;
+	out.numFrameDumpQueuedMax = convert.max_depth + encode.max_depth;
+	out.numFrameDumpDropped = (int)convert.frames_dropped;
+}
+
+void FrameDumpPipeline::ClearStats(Statistics& out)
+{
+	// The overlay only shows the frame dump lines while numFrameDumpQueuedMax is set
+	out.numFrameDumpQueued = 0;
+	out.numFrameDumpQueuedMax = 0;
+	out.numFrameDumpDropped = 0;
+}
@@ -0,0 +1,124 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#pragma once
+
+// A bounded queue of frames between the video thread and a thread that dumps
+// them, so that converting and encoding a frame doesn't hold up emulation.
+//
+// The frame buffers are pooled: once capacity frames were in flight, nothing
+// gets allocated per frame anymore. When all of them are in use, Acquire
+// either waits for the dump thread (backpressure) or drops the frame.
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+struct Statistics;
+
+class FrameDumpQueue
+{
+public:
+	struct Frame
+	{
+		std::vector<u8> data;
+		int width;
+		int height;
+		// Counts every frame passed to Acquire, dropped ones included, so
+		// dropped frames leave gaps in the timestamps. Callers forwarding a
+		// frame from another queue may overwrite it.
+		u64 number;
+	};
+
+	struct Stats
+	{
+		u64 frames_submitted;
+		u64 frames_dropped;
+		u64 frames_processed;
+		// Frames acquired but not processed yet
+		int depth;
+		int max_depth;
+		// Time Acquire spent waiting for a free frame
+		u64 wait_us;
+	};
+
+	typedef std::function<void(Frame& frame)> ProcessFunction;
+
+	FrameDumpQueue(int capacity, bool drop_when_full, const ProcessFunction& process);
+	// Processes the frames still queued before returning
+	~FrameDumpQueue();
+
+	// Returns a free frame with room for size bytes of data, or nullptr if the
+	// frame is dropped. Has to be given back with Submit.
+	Frame* Acquire(int width, int height, size_t size);
+	// Hands a frame from Acquire to the dump thread
+	void Submit(Frame* frame);
+
+	// Waits until every submitted frame is processed
+	void Flush();
+
+	Stats GetStats();
+
+private:
+	void ThreadLoop();
+
+	const int m_capacity;
+	const bool m_drop_when_full;
+	const ProcessFunction m_process;
+
+	std::vector<std::unique_ptr<Frame>> m_frames;
+	std::vector<Frame*> m_free;
+	std::deque<Frame*> m_queued;
+	bool m_busy;
+	bool m_quit;
+	u64 m_next_number;
+	Stats m_stats;
+
+	std::mutex m_lock;
+	std::condition_variable m_frame_queued;
+	std::condition_variable m_frame_done;
+
+	std::thread m_thread;
+};
+
+// The two stages of a frame dump. Frames from AddFrame get converted to the
+// codec's format on one thread and encoded and written on another. Only the
+// conversion queue drops frames, the encoder always waits for the conversion.
+class FrameDumpPipeline
+{
+public:
+	// Converts in, a BGR24 frame from AddFrame, into out, which has the
+	// converted size given to the constructor
+	typedef std::function<void(const FrameDumpQueue::Frame& in, FrameDumpQueue::Frame& out)> ConvertFunction;
+
+	FrameDumpPipeline(int capacity, bool drop_frames, int width, int height, size_t converted_size,
+	                  const ConvertFunction& convert, const FrameDumpQueue::ProcessFunction& encode);
+	// Converts and encodes the frames still queued, in order, before returning
+	~FrameDumpPipeline();
+
+	// Copies a BGR24 frame, the rest happens on the dump threads
+	void AddFrame(const u8* data, int width, int height);
+	// Waits until every frame added so far is encoded
+	void Flush();
+
+	// The frame dump lines of the statistics overlay
+	void ReportStats(Statistics& out);
+	static void ClearStats(Statistics& out);
+
+private:
+	void ConvertFrame(FrameDumpQueue::Frame& frame);
+
+	const int m_width;
+	const int m_height;
+	const size_t m_converted_size;
+	const ConvertFunction m_convert;
+	std::unique_ptr<FrameDumpQueue> m_encode_queue;
+	std::unique_ptr<FrameDumpQueue> m_convert_queue;
+};
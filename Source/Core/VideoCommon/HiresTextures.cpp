@@ -3,27 +3,344 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 #include <SOIL/SOIL.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #include "Common/CommonPaths.h"
 #include "Common/FileSearch.h"
 #include "Common/FileUtil.h"
 #include "Common/StringUtil.h"
+#include "Common/WorkerPool.h"
 
 #include "VideoCommon/HiresTextures.h"
+#include "VideoCommon/VideoConfig.h"
 
 namespace HiresTextures
 {
 
+namespace
+{
+
+// Texture pack layout: a PackHeader, num_entries PackEntries, then the RGBA8
+// pixels of every entry at 16 byte aligned offsets from the start of the file.
+const u32 PACK_MAGIC = 0x50544844; // "DHTP"
+const u32 PACK_VERSION = 1;
+const char PACK_EXTENSION[] = ".htp";
+
+struct PackHeader
+{
+	u32 magic;
+	u32 version;
+	u32 num_entries;
+	u32 reserved;
+};
+
+struct PackEntry
+{
+	char name[56];
+	u32 width;
+	u32 height;
+	u64 offset;
+};
+static_assert(sizeof(PackEntry) == 72, "PackEntry is part of the file format");
+
+// A decoded custom texture. Loose files own their pixels, pack entries point
+// into the mapped pack.
+struct Texture
+{
+	u32 width;
+	u32 height;
+	const u8* data;
+	std::vector<u8> storage;
+};
+
+// Read only mapping of a whole file
+class MappedFile
+{
+public:
+	MappedFile() : m_data(nullptr), m_size(0) {}
+	~MappedFile() { Unmap(); }
+
+	bool Map(const std::string& path);
+	void Unmap();
+
+	const u8* GetData() const { return m_data; }
+	size_t GetSize() const { return m_size; }
+
+private:
+	const u8* m_data;
+	size_t m_size;
+};
+
+#ifdef _WIN32
+bool MappedFile::Map(const std::string& path)
+{
+	HANDLE file = CreateFile(UTF8ToTStr(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	HANDLE mapping = nullptr;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+		mapping = CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping)
+		return false;
+
+	m_data = (const u8*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!m_data)
+		return false;
+
+	m_size = (size_t)size.QuadPart;
+	return true;
+}
+
+void MappedFile::Unmap()
+{
+	if (m_data)
+		UnmapViewOfFile(m_data);
+	m_data = nullptr;
+	m_size = 0;
+}
+#else
+bool MappedFile::Map(const std::string& path)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	void* data = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+		data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return false;
+
+	m_data = (const u8*)data;
+	m_size = st.st_size;
+	return true;
+}
+
+void MappedFile::Unmap()
+{
+	if (m_data)
+		munmap((void*)m_data, m_size);
+	m_data = nullptr;
+	m_size = 0;
+}
+#endif
+
 std::map<std::string, std::string> textureMap;
 
-void Init(const std::string& gameCode)
+MappedFile s_pack;
+std::string s_pack_path;
+std::map<std::string, const PackEntry*> s_pack_index;
+
+// Textures decoded ahead of time. s_loading holds the ones a prefetch thread
+// is working on right now, so that GetHiresTex can wait for them instead of
+// decoding the same file a second time.
+std::mutex s_cache_lock;
+std::condition_variable s_cache_loaded;
+std::map<std::string, std::shared_ptr<Texture>> s_cache;
+std::set<std::string> s_loading;
+size_t s_cache_bytes;
+
+std::thread s_prefetch_thread;
+std::atomic<bool> s_prefetch_abort;
+
+std::shared_ptr<Texture> LoadFromDisk(const std::string& path)
 {
-	textureMap.clear();
+	int width;
+	int height;
+	int channels;
+
+	u8 *temp = SOIL_load_image(path.c_str(), &width, &height, &channels, SOIL_LOAD_RGBA);
+	if (temp == nullptr)
+	{
+		ERROR_LOG(VIDEO, "Custom texture %s failed to load", path.c_str());
+		return nullptr;
+	}
+
+	std::shared_ptr<Texture> texture = std::make_shared<Texture>();
+	texture->width = width;
+	texture->height = height;
+	texture->storage.assign(temp, temp + width * height * 4);
+	texture->data = texture->storage.data();
+	SOIL_free_image_data(temp);
+	return texture;
+}
+
+void LoadPack(const std::string& path, const std::string& code)
+{
+	if (!s_pack.Map(path))
+	{
+		ERROR_LOG(VIDEO, "Failed to map texture pack %s", path.c_str());
+		return;
+	}
+
+	const u8* data = s_pack.GetData();
+	const size_t size = s_pack.GetSize();
+	const PackHeader* header = (const PackHeader*)data;
+	if (size < sizeof(PackHeader) || header->magic != PACK_MAGIC || header->version != PACK_VERSION ||
+	    header->num_entries > (size - sizeof(PackHeader)) / sizeof(PackEntry))
+	{
+		ERROR_LOG(VIDEO, "%s is not a valid texture pack", path.c_str());
+		s_pack.Unmap();
+		return;
+	}
+
+	const PackEntry* entries = (const PackEntry*)(data + sizeof(PackHeader));
+	for (u32 i = 0; i < header->num_entries; ++i)
+	{
+		const PackEntry& entry = entries[i];
+		const u64 bytes = (u64)entry.width * entry.height * 4;
+		if (entry.name[sizeof(entry.name) - 1] != '\0' || entry.offset > size || bytes > size - entry.offset)
+		{
+			ERROR_LOG(VIDEO, "Texture pack %s is damaged", path.c_str());
+			s_pack_index.clear();
+			s_pack.Unmap();
+			return;
+		}
+
+		std::string name = entry.name;
+		if (name.compare(0, code.length(), code) == 0)
+			s_pack_index.insert(std::make_pair(name, &entry));
+	}
+
+	s_pack_path = path;
+	INFO_LOG(VIDEO, "Mapped %u custom textures from %s", (u32)s_pack_index.size(), path.c_str());
+}
 
+void Prefetch(std::vector<std::pair<std::string, std::string>> files, size_t budget)
+{
+	// Leave some of the cores to the CPU and GPU threads
+	const int num_threads = std::max<int>(std::thread::hardware_concurrency() / 2, 1);
+	Common::WorkerPool workers(num_threads - 1);
+	std::atomic<bool> budget_exceeded(false);
+
+	workers.ParallelFor((int)files.size(), [&](int i) {
+		if (s_prefetch_abort || budget_exceeded)
+			return;
+
+		const std::string& name = files[i].first;
+		{
+			std::lock_guard<std::mutex> lk(s_cache_lock);
+			if (s_cache.count(name) || !s_loading.insert(name).second)
+				return;
+		}
+
+		std::shared_ptr<Texture> texture = LoadFromDisk(files[i].second);
+
+		{
+			std::lock_guard<std::mutex> lk(s_cache_lock);
+			s_loading.erase(name);
+			if (texture && s_cache_bytes + texture->storage.size() <= budget)
+			{
+				s_cache_bytes += texture->storage.size();
+				s_cache.insert(std::make_pair(name, texture));
+			}
+			else if (texture)
+			{
+				budget_exceeded = true;
+			}
+		}
+		s_cache_loaded.notify_all();
+	});
+
+	size_t count;
+	size_t bytes;
+	GetCacheStats(&count, &bytes);
+	if (budget_exceeded)
+		WARN_LOG(VIDEO, "Custom texture cache is full, only %u of %u textures (%u MiB) were preloaded", (u32)count, (u32)files.size(), (u32)(bytes >> 20));
+	else
+		INFO_LOG(VIDEO, "Preloaded %u custom textures (%u MiB)", (u32)count, (u32)(bytes >> 20));
+}
+
+// Modification time of a file, 0 if it can't be read
+s64 GetModificationTime(const std::string& path)
+{
+	struct stat64 file_info;
+#ifdef _WIN32
+	if (_tstat64(UTF8ToTStr(path).c_str(), &file_info) != 0)
+#else
+	if (stat64(path.c_str(), &file_info) != 0)
+#endif
+		return 0;
+	return file_info.st_mtime;
+}
+
+// Loose files changed after the pack was built win over their pack entries,
+// so that editing a texture doesn't need a new pack
+void PreferNewerFiles(const std::string& pack_path)
+{
+	const s64 pack_time = GetModificationTime(pack_path);
+	u32 newer = 0;
+	for (auto& file : textureMap)
+	{
+		auto entry = s_pack_index.find(file.first);
+		if (entry != s_pack_index.end() && GetModificationTime(file.second) > pack_time)
+		{
+			s_pack_index.erase(entry);
+			++newer;
+		}
+	}
+
+	if (newer)
+		NOTICE_LOG(VIDEO, "%u custom textures are newer than %s, loading them from their files instead", newer, pack_path.c_str());
+}
+
+std::shared_ptr<Texture> FindTexture(const std::string& filename)
+{
+	auto pack_entry = s_pack_index.find(filename);
+	if (pack_entry != s_pack_index.end())
+	{
+		const PackEntry& entry = *pack_entry->second;
+		std::shared_ptr<Texture> texture = std::make_shared<Texture>();
+		texture->width = entry.width;
+		texture->height = entry.height;
+		texture->data = s_pack.GetData() + entry.offset;
+		return texture;
+	}
+
+	auto file = textureMap.find(filename);
+	if (file == textureMap.end())
+		return nullptr;
+
+	{
+		std::unique_lock<std::mutex> lk(s_cache_lock);
+		s_cache_loaded.wait(lk, [&] { return s_loading.count(filename) == 0; });
+		auto cached = s_cache.find(filename);
+		if (cached != s_cache.end())
+			return cached->second;
+	}
+
+	return LoadFromDisk(file->second);
+}
+
+// Finds the loose custom texture files of a game, by texture name
+std::map<std::string, std::string> FindTextureFiles(const std::string& gameCode)
+{
+	std::map<std::string, std::string> files;
 	CFileSearch::XStringVector Directories;
 
 	std::string szDir = StringFromFormat("%s%s", File::GetUserPath(D_HIRESTEXTURES_IDX).c_str(), gameCode.c_str());
@@ -74,32 +391,84 @@ void Init(const std::string& gameCode)
 			std::string FileName;
 			SplitPath(rFilename, nullptr, &FileName, nullptr);
 
-			if (FileName.substr(0, code.length()).compare(code) == 0 && textureMap.find(FileName) == textureMap.end())
-				textureMap.insert(std::map<std::string, std::string>::value_type(FileName, rFilename));
+			if (FileName.substr(0, code.length()).compare(code) == 0 && files.find(FileName) == files.end())
+				files.insert(std::map<std::string, std::string>::value_type(FileName, rFilename));
 		}
 	}
+
+	return files;
 }
 
-bool HiresTexExists(const std::string& filename)
+std::string GetPackPath(const std::string& gameCode)
 {
-	return textureMap.find(filename) != textureMap.end();
+	return File::GetUserPath(D_HIRESTEXTURES_IDX) + gameCode + PACK_EXTENSION;
 }
 
-PC_TexFormat GetHiresTex(const std::string& filename, unsigned int* pWidth, unsigned int* pHeight, unsigned int* required_size, int texformat, unsigned int data_size, u8* data)
+}
+
+void Init(const std::string& gameCode)
 {
-	if (textureMap.find(filename) == textureMap.end())
-		return PC_TEX_FMT_NONE;
+	Shutdown();
 
-	int width;
-	int height;
-	int channels;
+	textureMap = FindTextureFiles(gameCode);
 
-	u8 *temp = SOIL_load_image(textureMap[filename].c_str(), &width, &height, &channels, SOIL_LOAD_RGBA);
-	if (temp == nullptr)
+	const std::string code = StringFromFormat("%s_", gameCode.c_str());
+	const std::string pack_path = GetPackPath(gameCode);
+	if (File::Exists(pack_path))
 	{
-		ERROR_LOG(VIDEO, "Custom texture %s failed to load", textureMap[filename].c_str());
-		return PC_TEX_FMT_NONE;
+		LoadPack(pack_path, code);
+		PreferNewerFiles(pack_path);
+	}
+
+	if (g_ActiveConfig.bCacheHiresTextures)
+	{
+		// Textures in the pack are already decoded
+		std::vector<std::pair<std::string, std::string>> files;
+		for (auto& entry : textureMap)
+		{
+			if (s_pack_index.find(entry.first) == s_pack_index.end())
+				files.push_back(entry);
+		}
+
+		const size_t budget = (size_t)std::max(g_ActiveConfig.iCacheHiresTexturesSize, 0) << 20;
+		s_prefetch_thread = std::thread(Prefetch, std::move(files), budget);
+	}
+}
+
+void Shutdown()
+{
+	if (s_prefetch_thread.joinable())
+	{
+		s_prefetch_abort = true;
+		s_prefetch_thread.join();
 	}
+	s_prefetch_abort = false;
+
+	s_cache.clear();
+	s_loading.clear();
+	s_cache_bytes = 0;
+
+	s_pack_index.clear();
+	s_pack.Unmap();
+	s_pack_path.clear();
+
+	textureMap.clear();
+}
+
+bool HiresTexExists(const std::string& filename)
+{
+	return textureMap.find(filename) != textureMap.end() || s_pack_index.find(filename) != s_pack_index.end();
+}
+
+PC_TexFormat GetHiresTex(const std::string& filename, unsigned int* pWidth, unsigned int* pHeight, unsigned int* required_size, int texformat, unsigned int data_size, u8* data)
+{
+	std::shared_ptr<Texture> texture = FindTexture(filename);
+	if (!texture)
+		return PC_TEX_FMT_NONE;
+
+	const u8* temp = texture->data;
+	int width = texture->width;
+	int height = texture->height;
 
 	*pWidth = width;
 	*pHeight = height;
@@ -120,7 +489,7 @@ PC_TexFormat GetHiresTex(const std::string& filename, unsigned int* pWidth, unsi
 	case GX_TF_IA8:
 		*required_size = width * height * 8;
 		if (data_size < *required_size)
-			goto cleanup;
+			return PC_TEX_FMT_NONE;
 
 		for (int i = 0; i < width * height * 4; i += 4)
 		{
@@ -135,17 +504,96 @@ PC_TexFormat GetHiresTex(const std::string& filename, unsigned int* pWidth, unsi
 	default:
 		*required_size = width * height * 4;
 		if (data_size < *required_size)
-			goto cleanup;
+			return PC_TEX_FMT_NONE;
 
 		memcpy(data, temp, width * height * 4);
 		returnTex = PC_TEX_FMT_RGBA32;
 		break;
 	}
 
-	INFO_LOG(VIDEO, "Loading custom texture from %s", textureMap[filename].c_str());
-cleanup:
-	SOIL_free_image_data(temp);
+	if (texture->storage.empty())
+		INFO_LOG(VIDEO, "Loading custom texture %s from %s", filename.c_str(), s_pack_path.c_str());
+	else
+		INFO_LOG(VIDEO, "Loading custom texture %s", filename.c_str());
 	return returnTex;
 }
 
+bool WriteTexturePack(const std::string& gameCode)
+{
+	const std::map<std::string, std::string> files = FindTextureFiles(gameCode);
+	const std::string path = GetPackPath(gameCode);
+	if (files.empty())
+	{
+		ERROR_LOG(VIDEO, "No custom textures to put into %s", path.c_str());
+		return false;
+	}
+
+	for (auto& file : files)
+	{
+		if (file.first.length() >= sizeof(PackEntry::name))
+		{
+			ERROR_LOG(VIDEO, "Custom texture name %s is too long for a texture pack", file.first.c_str());
+			return false;
+		}
+	}
+
+	// Write to a temporary file first, the current pack may still be mapped
+	const std::string temp_path = File::GetTempFilenameForAtomicWrite(path);
+	File::IOFile file(temp_path, "wb");
+	if (!file)
+		return false;
+
+	PackHeader header = {};
+	header.magic = PACK_MAGIC;
+	header.version = PACK_VERSION;
+	std::vector<PackEntry> entries(files.size());
+
+	// A texture that fails to decode or write fails the whole pack, rather
+	// than leaving it out without anyone noticing
+	u64 offset = sizeof(PackHeader) + entries.size() * sizeof(PackEntry);
+	bool good = file.Seek(offset, SEEK_SET);
+	for (auto it = files.begin(); good && it != files.end(); ++it)
+	{
+		std::shared_ptr<Texture> texture = LoadFromDisk(it->second);
+		if (!texture)
+		{
+			good = false;
+			break;
+		}
+
+		const u64 aligned = (offset + 15) & ~15ULL;
+		const u8 padding[16] = {};
+		const size_t bytes = texture->storage.size();
+		good = file.WriteBytes(padding, (size_t)(aligned - offset)) && file.WriteBytes(texture->data, bytes);
+
+		PackEntry& entry = entries[header.num_entries++];
+		strncpy(entry.name, it->first.c_str(), sizeof(entry.name));
+		entry.width = texture->width;
+		entry.height = texture->height;
+		entry.offset = aligned;
+		offset = aligned + bytes;
+	}
+
+	good = good && file.Seek(0, SEEK_SET) &&
+	       file.WriteBytes(&header, sizeof(header)) &&
+	       file.WriteArray(entries.data(), entries.size());
+	good = file.Close() && good;
+	if (!good || !File::RenameSync(temp_path, path))
+	{
+		File::Delete(temp_path);
+		ERROR_LOG(VIDEO, "Failed to write texture pack %s", path.c_str());
+		return false;
+	}
+
+	INFO_LOG(VIDEO, "Wrote %u custom textures to %s", header.num_entries, path.c_str());
+	return true;
+}
+
+void GetCacheStats(size_t* count, size_t* bytes)
+{
+	std::lock_guard<std::mutex> lk(s_cache_lock);
+	*count = s_cache.size();
+	*bytes = s_cache_bytes;
+}
+
 }
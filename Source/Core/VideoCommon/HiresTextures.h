@@ -11,8 +11,25 @@
 
 namespace HiresTextures
 {
+// Indexes the custom textures of a game: loose image files below
+// User/Load/Textures/<game_id>/ and, if there is one, the texture pack
+// User/Load/Textures/<game_id>.htp. With bCacheHiresTextures set, the
+// loose files also start decoding on background threads, until
+// iCacheHiresTexturesSize megabytes are in memory.
 void Init(const std::string& gameCode);
+// Stops the background decoding and releases all cached textures.
+void Shutdown();
 bool HiresTexExists(const std::string& filename);
 PC_TexFormat GetHiresTex(const std::string& fileName, unsigned int* pWidth, unsigned int* pHeight, unsigned int* required_size, int texformat, unsigned int data_size, u8* data);
 
+// Decodes the loose files of a game into User/Load/Textures/<gameCode>.htp,
+// which Init maps into memory instead of decoding the files again. Replaces
+// any pack that is there already. Doesn't touch the current index, so this
+// works without the game running. Fails without writing anything if any
+// texture can't be decoded or written.
+bool WriteTexturePack(const std::string& gameCode);
+
+// Number of textures and bytes decoded ahead of time so far
+void GetCacheStats(size_t* count, size_t* bytes);
+
 };
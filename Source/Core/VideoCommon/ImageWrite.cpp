@@ -2,12 +2,23 @@
 // Licensed under GPLv2
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
 #include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 
 #include "png.h"
 #include "Common/FileUtil.h"
+#include "Common/StringUtil.h"
+#include "Common/WorkerPool.h"
 #include "VideoCommon/ImageWrite.h"
+#include "VideoCommon/VideoConfig.h"
 
 bool SaveData(const char* filename, const char* data)
 {
@@ -20,13 +31,16 @@ bool SaveData(const char* filename, const char* data)
 
 
 /*
-TextureToPng
+WritePng
 
 Inputs:
 data      : This is an array of RGBA with 8 bits per channel. 4 bytes for each pixel.
 row_stride: Determines the amount of bytes per row of pixels.
+error     : Set to what went wrong when returning false with data given.
+
+Doesn't show any alerts, so the PNG writer threads can use it.
 */
-bool TextureToPng(u8* data, int row_stride, const std::string& filename, int width, int height, bool saveAlpha)
+static bool WritePng(u8* data, int row_stride, const std::string& filename, int width, int height, bool saveAlpha, int compression_level, std::string* error)
 {
 	bool success = false;
 
@@ -41,32 +55,33 @@ bool TextureToPng(u8* data, int row_stride, const std::string& filename, int wid
 	// Open file for writing (binary mode)
 	File::IOFile fp(filename, "wb");
 	if (!fp.IsOpen()) {
-		PanicAlert("Screenshot failed: Could not open file %s %d\n", filename.c_str(), errno);
+		*error = StringFromFormat("Could not open file %s %d", filename.c_str(), errno);
 		goto finalise;
 	}
 
 	// Initialize write structure
 	png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
 	if (png_ptr == nullptr) {
-		PanicAlert("Screenshot failed: Could not allocate write struct\n");
+		*error = "Could not allocate write struct";
 		goto finalise;
-
 	}
 
 	// Initialize info structure
 	info_ptr = png_create_info_struct(png_ptr);
 	if (info_ptr == nullptr) {
-		PanicAlert("Screenshot failed: Could not allocate info struct\n");
+		*error = "Could not allocate info struct";
 		goto finalise;
 	}
 
 	// Setup Exception handling
 	if (setjmp(png_jmpbuf(png_ptr))) {
-		PanicAlert("Screenshot failed: Error during png creation\n");
+		*error = "Error during png creation";
 		goto finalise;
 	}
 
 	png_init_io(png_ptr, fp.GetHandle());
+	if (compression_level >= 0 && compression_level <= 9)
+		png_set_compression_level(png_ptr, compression_level);
 
 	// Write header (8 bit colour depth)
 	png_set_IHDR(png_ptr, info_ptr, width, height,
@@ -106,3 +121,166 @@ finalise:
 
 	return success;
 }
+
+bool TextureToPng(u8* data, int row_stride, const std::string& filename, int width, int height, bool saveAlpha, int compression_level)
+{
+	std::string error;
+	if (WritePng(data, row_stride, filename, width, height, saveAlpha, compression_level, &error))
+		return true;
+
+	if (!error.empty())
+		PanicAlert("Screenshot failed: %s\n", error.c_str());
+	return false;
+}
+
+namespace
+{
+
+// More than this and TextureToPngAsync waits for the writer
+const size_t MAX_PENDING_BYTES = 256 << 20;
+
+struct PngJob
+{
+	std::vector<u8> data;
+	std::string filename;
+	int width;
+	int height;
+	bool save_alpha;
+	int compression_level;
+	std::function<void(bool)> on_written;
+};
+
+std::mutex s_png_lock;
+std::condition_variable s_png_queued;
+std::condition_variable s_png_written;
+std::vector<std::unique_ptr<PngJob>> s_png_jobs;
+size_t s_png_pending_bytes;
+bool s_png_writer_quit;
+std::thread s_png_writer;
+// Every file queued or found on disk so far
+std::unordered_set<std::string> s_png_dumped;
+
+// Takes everything queued so far and compresses it on the worker pool
+void PngWriterThread()
+{
+	// Leave some of the cores to the CPU and GPU threads
+	const int num_threads = std::max<int>(std::thread::hardware_concurrency() / 2, 1);
+	Common::WorkerPool workers(num_threads - 1);
+
+	std::unique_lock<std::mutex> lk(s_png_lock);
+	while (true)
+	{
+		s_png_queued.wait(lk, [] { return s_png_writer_quit || !s_png_jobs.empty(); });
+		if (s_png_jobs.empty())
+			return;
+
+		std::vector<std::unique_ptr<PngJob>> jobs;
+		jobs.swap(s_png_jobs);
+		lk.unlock();
+
+		workers.ParallelFor((int)jobs.size(), [&](int i) {
+			PngJob& job = *jobs[i];
+			// Alerts from here would block a pool thread, the caller reports the result
+			std::string error;
+			const bool success = WritePng(job.data.data(), job.width * 4, job.filename, job.width, job.height, job.save_alpha, job.compression_level, &error);
+			if (!success)
+				ERROR_LOG(VIDEO, "Writing %s failed: %s", job.filename.c_str(), error.c_str());
+			if (job.on_written)
+				job.on_written(success);
+
+			std::lock_guard<std::mutex> job_lk(s_png_lock);
+			s_png_pending_bytes -= job.data.size();
+			s_png_written.notify_all();
+		});
+
+		lk.lock();
+	}
+}
+
+}
+
+void TextureToPngAsync(const u8* data, int row_stride, const std::string& filename, int width, int height, bool saveAlpha,
+                       std::function<void(bool)> on_written)
+{
+	if (!data)
+		return;
+
+	// Packed rows, TextureToPng changes the alpha channel in place
+	std::unique_ptr<PngJob> job(new PngJob);
+	job->data.resize(width * height * 4);
+	for (int y = 0; y < height; ++y)
+		memcpy(&job->data[y * width * 4], data + y * row_stride, width * 4);
+	job->filename = filename;
+	job->width = width;
+	job->height = height;
+	job->save_alpha = saveAlpha;
+	job->compression_level = g_ActiveConfig.iPNGCompressionLevel;
+	job->on_written = std::move(on_written);
+
+	{
+		std::unique_lock<std::mutex> lk(s_png_lock);
+		s_png_written.wait(lk, [] { return s_png_pending_bytes < MAX_PENDING_BYTES; });
+
+		if (!s_png_writer.joinable())
+		{
+			s_png_writer_quit = false;
+			s_png_writer = std::thread(PngWriterThread);
+		}
+
+		s_png_dumped.insert(filename);
+		s_png_pending_bytes += job->data.size();
+		s_png_jobs.push_back(std::move(job));
+	}
+	s_png_queued.notify_one();
+}
+
+bool IsPngDumped(const std::string& filename)
+{
+	{
+		std::lock_guard<std::mutex> lk(s_png_lock);
+		if (s_png_dumped.count(filename))
+			return true;
+	}
+
+	// Not under the lock, the writer threads shouldn't wait for the disk
+	if (!File::Exists(filename))
+		return false;
+
+	std::lock_guard<std::mutex> lk(s_png_lock);
+	s_png_dumped.insert(filename);
+	return true;
+}
+
+void FlushPngWrites()
+{
+	std::unique_lock<std::mutex> lk(s_png_lock);
+	s_png_written.wait(lk, [] { return s_png_pending_bytes == 0; });
+}
+
+void ShutdownPngWriter()
+{
+	{
+		std::lock_guard<std::mutex> lk(s_png_lock);
+		if (!s_png_writer.joinable())
+			return;
+		s_png_writer_quit = true;
+	}
+	s_png_queued.notify_one();
+	// Writes everything still queued first
+	s_png_writer.join();
+
+	std::lock_guard<std::mutex> lk(s_png_lock);
+	s_png_dumped.clear();
+}
+
+size_t GetPendingPngBytes()
+{
+	std::lock_guard<std::mutex> lk(s_png_lock);
+	return s_png_pending_bytes;
+}
+
+// Writes what is left if the renderer never shut the writer down
+static struct PngWriterGuard
+{
+	~PngWriterGuard() { ShutdownPngWriter(); }
+} s_png_writer_guard;
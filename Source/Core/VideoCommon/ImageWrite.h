@@ -4,7 +4,27 @@
 
 #pragma once
 
+#include <functional>
+#include <string>
+
 #include "Common/Common.h"
 
 bool SaveData(const char* filename, const char* pdata);
-bool TextureToPng(u8* data, int row_stride, const std::string& filename, int width, int height, bool saveAlpha = true);
+// compression_level is the zlib level, 0-9, or -1 for the zlib default
+bool TextureToPng(u8* data, int row_stride, const std::string& filename, int width, int height, bool saveAlpha = true, int compression_level = -1);
+
+// Copies the image and leaves compressing and writing it to a pool of
+// threads, at g_ActiveConfig.iPNGCompressionLevel. Waits first if too much
+// image data is pending already. on_written gets whether the file was
+// written, on one of the writer threads.
+void TextureToPngAsync(const u8* data, int row_stride, const std::string& filename, int width, int height, bool saveAlpha = true,
+                       std::function<void(bool)> on_written = nullptr);
+// Whether filename was queued by TextureToPngAsync or exists on disk. Only
+// looks at the disk once per file, so texture dumping can call it per load.
+bool IsPngDumped(const std::string& filename);
+// Waits until everything queued is written
+void FlushPngWrites();
+// Flushes and stops the threads, they start again with the next write
+void ShutdownPngWriter();
+// Bytes of image data queued and not written yet
+size_t GetPendingPngBytes();
@@ -4,6 +4,7 @@
 
 #include <list>
 #include <map>
+#include <mutex>
 #include <string>
 
 #include "Common/Common.h"
@@ -29,9 +30,12 @@ struct Message
 
 static std::multimap<CallbackType, Callback> s_callbacks;
 static std::list<Message> s_msgList;
+// Messages come from other threads too, e.g. the PNG writer
+static std::mutex s_msgListLock;
 
 void AddMessage(const std::string& str, u32 ms)
 {
+	std::lock_guard<std::mutex> lk(s_msgListLock);
 	s_msgList.push_back(Message(str, Common::Timer::GetTimeMs() + ms));
 }
 
@@ -40,6 +44,7 @@ void DrawMessages()
 	if (!SConfig::GetInstance().m_LocalCoreStartupParameter.bOnScreenDisplayMessages)
 		return;
 
+	std::lock_guard<std::mutex> lk(s_msgListLock);
 	int left = 25, top = 15;
 	auto it = s_msgList.begin();
 	while (it != s_msgList.end())
@@ -69,6 +74,7 @@ void DrawMessages()
 
 void ClearMessages()
 {
+	std::lock_guard<std::mutex> lk(s_msgListLock);
 	s_msgList.clear();
 }
 
@@ -30,6 +30,7 @@
 #include "VideoCommon/Debugger.h"
 #include "VideoCommon/Fifo.h"
 #include "VideoCommon/FramebufferManagerBase.h"
+#include "VideoCommon/ImageWrite.h"
 #include "VideoCommon/MainBase.h"
 #include "VideoCommon/OpcodeDecoding.h"
 #include "VideoCommon/RenderBase.h"
@@ -93,6 +94,8 @@ Renderer::~Renderer()
 
 	efb_scale_numeratorX = efb_scale_numeratorY = efb_scale_denominatorX = efb_scale_denominatorY = 1;
 
+	ShutdownPngWriter();
+
 #if defined _WIN32 || defined HAVE_LIBAV
 	if (g_ActiveConfig.bDumpFrames && bLastFrameDumped && bAVIDumping)
 		AVIDump::Stop();
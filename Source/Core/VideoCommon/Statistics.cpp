@@ -5,6 +5,7 @@
 #include <string.h>
 #include <utility>
 
+#include "VideoCommon/ImageWrite.h"
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/VertexLoaderManager.h"
 
@@ -52,6 +53,14 @@ char *Statistics::ToString(char *ptr)
 	ptr+=sprintf(ptr,"Index streamed: %i kB\n",stats.thisFrame.bytesIndexStreamed/1024);
 	ptr+=sprintf(ptr,"Uniform streamed: %i kB\n",stats.thisFrame.bytesUniformStreamed/1024);
 	ptr+=sprintf(ptr,"Vertex Loaders: %i\n",stats.numVertexLoaders);
+	if (stats.numFrameDumpQueuedMax)
+	{
+		ptr+=sprintf(ptr,"Frame dump queue: %i (max %i)\n",stats.numFrameDumpQueued,stats.numFrameDumpQueuedMax);
+		ptr+=sprintf(ptr,"Frame dump dropped: %i\n",stats.numFrameDumpDropped);
+	}
+	const size_t png_bytes = GetPendingPngBytes();
+	if (png_bytes)
+		ptr+=sprintf(ptr,"PNG writes pending: %u kB\n",(u32)(png_bytes/1024));
 
 	std::string text1;
 	VertexLoaderManager::AppendListToString(&text1);
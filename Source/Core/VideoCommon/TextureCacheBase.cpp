@@ -10,6 +10,7 @@
 
 #include "VideoCommon/Debugger.h"
 #include "VideoCommon/HiresTextures.h"
+#include "VideoCommon/ImageWrite.h"
 #include "VideoCommon/RenderBase.h"
 #include "VideoCommon/Statistics.h"
 #include "VideoCommon/TextureCacheBase.h"
@@ -50,6 +51,7 @@ TextureCache::TextureCache()
 		HiresTextures::Init(SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID);
 
 	SetHash64Function(g_ActiveConfig.bHiresTextures || g_ActiveConfig.bDumpTextures);
+	Memory::SetWriteWatch(g_ActiveConfig.bTrackTextureWrites);
 
 	invalidate_texture_cache_requested = false;
 }
@@ -70,6 +72,8 @@ void TextureCache::Invalidate()
 
 TextureCache::~TextureCache()
 {
+	HiresTextures::Shutdown();
+	Memory::SetWriteWatch(false);
 	Invalidate();
 	FreeAlignedMemory(temp);
 	temp = nullptr;
@@ -84,14 +88,19 @@ void TextureCache::OnConfigChanged(VideoConfig& config)
 			config.bTexFmtOverlayEnable != backup_config.s_texfmt_overlay ||
 			config.bTexFmtOverlayCenter != backup_config.s_texfmt_overlay_center ||
 			config.bHiresTextures != backup_config.s_hires_textures ||
+			config.bCacheHiresTextures != backup_config.s_cache_hires_textures ||
+			config.bTrackTextureWrites != backup_config.s_track_texture_writes ||
 			invalidate_texture_cache_requested)
 		{
 			g_texture_cache->Invalidate();
 
 			if (g_ActiveConfig.bHiresTextures)
 				HiresTextures::Init(SConfig::GetInstance().m_LocalCoreStartupParameter.m_strUniqueID);
+			else
+				HiresTextures::Shutdown();
 
 			SetHash64Function(g_ActiveConfig.bHiresTextures || g_ActiveConfig.bDumpTextures);
+			Memory::SetWriteWatch(g_ActiveConfig.bTrackTextureWrites);
 			TexDecoder_SetTexFmtOverlayOptions(g_ActiveConfig.bTexFmtOverlayEnable, g_ActiveConfig.bTexFmtOverlayCenter);
 
 			invalidate_texture_cache_requested = false;
@@ -116,6 +125,8 @@ void TextureCache::OnConfigChanged(VideoConfig& config)
 	backup_config.s_texfmt_overlay = config.bTexFmtOverlayEnable;
 	backup_config.s_texfmt_overlay_center = config.bTexFmtOverlayCenter;
 	backup_config.s_hires_textures = config.bHiresTextures;
+	backup_config.s_cache_hires_textures = config.bCacheHiresTextures;
+	backup_config.s_track_texture_writes = config.bTrackTextureWrites;
 	backup_config.s_copy_cache_enable = config.bEFBCopyCacheEnable;
 }
 
@@ -308,7 +319,8 @@ void TextureCache::DumpTexture(TCacheEntryBase* entry, unsigned int level)
 				(u32) (entry->hash & 0x00000000FFFFFFFFLL), entry->format & 0xFFFF, level);
 	}
 
-	if (!File::Exists(filename))
+	// The PNGs are written in the background, which the file system can't tell
+	if (!IsPngDumped(filename))
 		entry->Save(filename, level);
 }
 
@@ -364,8 +376,6 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 	else
 		src_data = Memory::GetPointer(address);
 
-	// TODO: This doesn't hash GB tiles for preloaded RGBA8 textures (instead, it's hashing more data from the low tmem bank than it should)
-	tex_hash = GetHash64(src_data, texture_size, g_ActiveConfig.iSafeTextureCache_ColorSamples);
 	if (isPaletteTexture)
 	{
 		const u32 palette_size = TexDecoder_GetPaletteSize(texformat);
@@ -381,15 +391,38 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 		//
 		// TODO: Because texID isn't always the same as the address now, CopyRenderTargetToTexture might be broken now
 		texID ^= ((u32)tlut_hash) ^(u32)(tlut_hash >> 32);
-		tex_hash ^= tlut_hash;
 	}
 
+	TCacheEntryBase *entry = textures[texID];
+
+	// With write tracking, RAM data nothing wrote to since the entry was
+	// loaded still has the same hash
+	const bool track_writes = Memory::IsWriteWatchEnabled() && !from_tmem;
+	u64 data_write_seq = 0;
+	if (track_writes && entry && entry->addr == address && entry->size_in_bytes == texture_size &&
+	    Memory::IsRangeUnchanged(address, texture_size, entry->data_write_seq))
+	{
+		tex_hash = entry->data_hash;
+		data_write_seq = entry->data_write_seq;
+	}
+	else
+	{
+		// Start watching before hashing, so no write can slip in between
+		if (track_writes)
+			data_write_seq = Memory::WatchRange(address, texture_size);
+
+		// TODO: This doesn't hash GB tiles for preloaded RGBA8 textures (instead, it's hashing more data from the low tmem bank than it should)
+		tex_hash = GetHash64(src_data, texture_size, g_ActiveConfig.iSafeTextureCache_ColorSamples);
+	}
+	const u64 data_hash = tex_hash;
+	if (isPaletteTexture)
+		tex_hash ^= tlut_hash;
+
 	// D3D doesn't like when the specified mipmap count would require more than one 1x1-sized LOD in the mipmap chain
 	// e.g. 64x64 with 7 LODs would have the mipmap chain 64x64,32x32,16x16,8x8,4x4,2x2,1x1,1x1, so we limit the mipmap count to 6 there
 	while (g_ActiveConfig.backend_info.bUseMinimalMipCount && max(expandedWidth, expandedHeight) >> maxlevel == 0)
 		--maxlevel;
 
-	TCacheEntryBase *entry = textures[texID];
 	if (entry)
 	{
 		// 1. Calculate reference hash:
@@ -412,6 +445,7 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 		if (address == entry->addr && tex_hash == entry->hash && full_format == entry->format &&
 			entry->num_mipmaps > maxlevel && entry->native_width == nativeW && entry->native_height == nativeH)
 		{
+			entry->data_write_seq = data_write_seq;
 			return ReturnEntry(stage, entry);
 		}
 
@@ -509,6 +543,8 @@ TextureCache::TCacheEntryBase* TextureCache::Load(unsigned int const stage,
 	entry->SetGeneralParameters(address, texture_size, full_format, entry->num_mipmaps);
 	entry->SetDimensions(nativeW, nativeH, width, height);
 	entry->hash = tex_hash;
+	entry->data_hash = data_hash;
+	entry->data_write_seq = data_write_seq;
 
 	if (entry->IsEfbCopy() && !g_ActiveConfig.bCopyEFBToTexture)
 		entry->type = TCET_EC_DYNAMIC;
@@ -883,6 +919,10 @@ void TextureCache::CopyRenderTargetToTexture(u32 dstAddr, unsigned int dstFormat
 	}
 
 	entry->frameCount = frameCount;
+	entry->data_write_seq = 0;
 
 	entry->FromRenderTarget(dstAddr, dstFormat, srcFormat, srcRect, isIntensity, scaleByHalf, cbufid, colmat);
+
+	// Up to four bytes per texel, in blocks of at most 8x8 texels
+	Memory::MarkWritten(dstAddr, ROUND_UP(tex_w, 8) * ROUND_UP(tex_h, 8) * 4);
 }
@@ -34,6 +34,10 @@ public:
 		u32 size_in_bytes;
 		u64 hash;
 		//u32 pal_hash;
+		// Hash of the RAM data without the palette, and the Memory write
+		// sequence number it was taken at (0 if the range isn't watched)
+		u64 data_hash;
+		u64 data_write_seq;
 		u32 format;
 
 		enum TexCacheEntryType type;
@@ -134,6 +138,8 @@ private:
 		bool s_texfmt_overlay;
 		bool s_texfmt_overlay_center;
 		bool s_hires_textures;
+		bool s_cache_hires_textures;
+		bool s_track_texture_writes;
 		bool s_copy_cache_enable;
 	} backup_config;
 };
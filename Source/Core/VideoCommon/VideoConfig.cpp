@@ -60,10 +60,15 @@ void VideoConfig::Load(const std::string& ini_file)
 	iniFile.Get("Settings", "DLOptimize", &iCompileDLsLevel, 0);
 	iniFile.Get("Settings", "DumpTextures", &bDumpTextures, 0);
 	iniFile.Get("Settings", "HiresTextures", &bHiresTextures, 0);
+	iniFile.Get("Settings", "CacheHiresTextures", &bCacheHiresTextures, 0);
+	iniFile.Get("Settings", "CacheHiresTexturesSize", &iCacheHiresTexturesSize, 1024);
 	iniFile.Get("Settings", "DumpEFBTarget", &bDumpEFBTarget, 0);
 	iniFile.Get("Settings", "DumpFrames", &bDumpFrames, 0);
 	iniFile.Get("Settings", "FreeLook", &bFreeLook, 0);
 	iniFile.Get("Settings", "UseFFV1", &bUseFFV1, 0);
+	iniFile.Get("Settings", "FrameDumpQueueSize", &iFrameDumpQueueSize, 8);
+	iniFile.Get("Settings", "FrameDumpDropFrames", &bFrameDumpDropFrames, false);
+	iniFile.Get("Settings", "PNGCompressionLevel", &iPNGCompressionLevel, -1);
 	iniFile.Get("Settings", "AnaglyphStereo", &bAnaglyphStereo, false);
 	iniFile.Get("Settings", "AnaglyphStereoSeparation", &iAnaglyphStereoSeparation, 200);
 	iniFile.Get("Settings", "AnaglyphFocalAngle", &iAnaglyphFocalAngle, 0);
@@ -94,6 +99,7 @@ void VideoConfig::Load(const std::string& ini_file)
 	iniFile.Get("Hacks", "EFBToTextureEnable", &bCopyEFBToTexture, true);
 	iniFile.Get("Hacks", "EFBScaledCopy", &bCopyEFBScaled, true);
 	iniFile.Get("Hacks", "EFBCopyCacheEnable", &bEFBCopyCacheEnable, false);
+	iniFile.Get("Hacks", "TrackTextureWrites", &bTrackTextureWrites, false);
 	iniFile.Get("Hacks", "EFBEmulateFormatChanges", &bEFBEmulateFormatChanges, false);
 
 	iniFile.Get("Hardware", "Adapter", &iAdapter, 0);
@@ -145,6 +151,7 @@ void VideoConfig::GameIniLoad()
 	CHECK_SETTING("Video_Settings", "SafeTextureCacheColorSamples", iSafeTextureCache_ColorSamples);
 	CHECK_SETTING("Video_Settings", "DLOptimize", iCompileDLsLevel);
 	CHECK_SETTING("Video_Settings", "HiresTextures", bHiresTextures);
+	CHECK_SETTING("Video_Settings", "CacheHiresTextures", bCacheHiresTextures);
 	CHECK_SETTING("Video_Settings", "AnaglyphStereo", bAnaglyphStereo);
 	CHECK_SETTING("Video_Settings", "AnaglyphStereoSeparation", iAnaglyphStereoSeparation);
 	CHECK_SETTING("Video_Settings", "AnaglyphFocalAngle", iAnaglyphFocalAngle);
@@ -192,6 +199,7 @@ void VideoConfig::GameIniLoad()
 	CHECK_SETTING("Video_Hacks", "EFBToTextureEnable", bCopyEFBToTexture);
 	CHECK_SETTING("Video_Hacks", "EFBScaledCopy", bCopyEFBScaled);
 	CHECK_SETTING("Video_Hacks", "EFBCopyCacheEnable", bEFBCopyCacheEnable);
+	CHECK_SETTING("Video_Hacks", "TrackTextureWrites", bTrackTextureWrites);
 	CHECK_SETTING("Video_Hacks", "EFBEmulateFormatChanges", bEFBEmulateFormatChanges);
 
 	CHECK_SETTING("Video", "ProjectionHack", iPhackvalue[0]);
@@ -234,10 +242,15 @@ void VideoConfig::Save(const std::string& ini_file)
 	iniFile.Set("Settings", "Show", iCompileDLsLevel);
 	iniFile.Set("Settings", "DumpTextures", bDumpTextures);
 	iniFile.Set("Settings", "HiresTextures", bHiresTextures);
+	iniFile.Set("Settings", "CacheHiresTextures", bCacheHiresTextures);
+	iniFile.Set("Settings", "CacheHiresTexturesSize", iCacheHiresTexturesSize);
 	iniFile.Set("Settings", "DumpEFBTarget", bDumpEFBTarget);
 	iniFile.Set("Settings", "DumpFrames", bDumpFrames);
 	iniFile.Set("Settings", "FreeLook", bFreeLook);
 	iniFile.Set("Settings", "UseFFV1", bUseFFV1);
+	iniFile.Set("Settings", "FrameDumpQueueSize", iFrameDumpQueueSize);
+	iniFile.Set("Settings", "FrameDumpDropFrames", bFrameDumpDropFrames);
+	iniFile.Set("Settings", "PNGCompressionLevel", iPNGCompressionLevel);
 	iniFile.Set("Settings", "AnaglyphStereo", bAnaglyphStereo);
 	iniFile.Set("Settings", "AnaglyphStereoSeparation", iAnaglyphStereoSeparation);
 	iniFile.Set("Settings", "AnaglyphFocalAngle", iAnaglyphFocalAngle);
@@ -267,6 +280,7 @@ void VideoConfig::Save(const std::string& ini_file)
 	iniFile.Set("Hacks", "EFBToTextureEnable", bCopyEFBToTexture);
 	iniFile.Set("Hacks", "EFBScaledCopy", bCopyEFBScaled);
 	iniFile.Set("Hacks", "EFBCopyCacheEnable", bEFBCopyCacheEnable);
+	iniFile.Set("Hacks", "TrackTextureWrites", bTrackTextureWrites);
 	iniFile.Set("Hacks", "EFBEmulateFormatChanges", bEFBEmulateFormatChanges);
 
 	iniFile.Set("Hardware", "Adapter", iAdapter);
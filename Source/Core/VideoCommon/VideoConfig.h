@@ -95,9 +95,17 @@ struct VideoConfig final
 	// Utility
 	bool bDumpTextures;
 	bool bHiresTextures;
+	bool bCacheHiresTextures;
+	int iCacheHiresTexturesSize; // in MiB
 	bool bDumpEFBTarget;
 	bool bDumpFrames;
 	bool bUseFFV1;
+	// Frames in flight between the video thread and the frame dump threads,
+	// and whether to drop frames instead of waiting when they are all in use
+	int iFrameDumpQueueSize;
+	bool bFrameDumpDropFrames;
+	// zlib level of screenshots and dumped textures, -1 for the default
+	int iPNGCompressionLevel;
 	bool bFreeLook;
 	bool bAnaglyphStereo;
 	int iAnaglyphStereoSeparation;
@@ -114,6 +122,8 @@ struct VideoConfig final
 	bool bCopyEFBToTexture;
 	bool bCopyEFBScaled;
 	int iSafeTextureCache_ColorSamples;
+	// Skip rehashing textures no write touched since they were last loaded
+	bool bTrackTextureWrites;
 	int iPhackvalue[3];
 	std::string sPhackvalue[2];
 	float fAspectRatioHackW, fAspectRatioHackH;
@@ -0,0 +1,354 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/ChunkFile.h"
+#include "Common/CommonTypes.h"
+
+namespace
+{
+
+struct TestState
+{
+	u32 value;
+	std::vector<u16> list;
+	std::string name;
+	std::map<u32, u64> table;
+	u8 array[3000];
+
+	void DoState(PointerWrap& p)
+	{
+		p.Do(value);
+		p.Do(list);
+		p.Do(name);
+		p.DoMarker("Fields");
+		p.Do(table);
+		p.DoArray(array, sizeof(array));
+		p.DoMarker("Array");
+	}
+};
+
+void FillTestState(TestState& state)
+{
+	state.value = 0x12345678;
+	for (u16 i = 0; i < 100; i++)
+		state.list.push_back(i * 3);
+	state.name = "Dolphin";
+	for (u32 i = 0; i < 50; i++)
+		state.table[i * 7] = (u64)i << 40;
+	for (u32 i = 0; i < sizeof(state.array); i++)
+		state.array[i] = (u8)(i * 13);
+}
+
+template <typename T>
+std::vector<u8> SaveTwoPass(T& state)
+{
+	u8* ptr = nullptr;
+	PointerWrap p(&ptr, PointerWrap::MODE_MEASURE);
+	state.DoState(p);
+	std::vector<u8> buffer((size_t)ptr);
+
+	ptr = &buffer[0];
+	p.SetMode(PointerWrap::MODE_WRITE);
+	state.DoState(p);
+	return buffer;
+}
+
+}
+
+TEST(ChunkedBuffer, AppendAcrossChunks)
+{
+	ChunkedBuffer buffer;
+	std::vector<u8> expected;
+
+	// Large enough to span a few chunks, with odd sizes so writes straddle them
+	for (u32 i = 0; expected.size() < 3500000; i++)
+	{
+		std::vector<u8> data(i * 977 % 100000 + 1, (u8)i);
+		buffer.Append(&data[0], data.size());
+		expected.insert(expected.end(), data.begin(), data.end());
+	}
+
+	std::vector<u8> result;
+	buffer.CopyTo(result);
+	EXPECT_EQ(expected.size(), buffer.GetSize());
+	EXPECT_TRUE(expected == result);
+
+	// Reuse keeps the contents consistent
+	buffer.Clear();
+	EXPECT_EQ(0u, buffer.GetSize());
+	u32 x = 0xdeadbeef;
+	buffer.Append(&x, sizeof(x));
+	buffer.CopyTo(result);
+	ASSERT_EQ(sizeof(x), result.size());
+	EXPECT_EQ(0xdeadbeef, *(u32*)&result[0]);
+}
+
+TEST(PointerWrap, ArenaMatchesTwoPass)
+{
+	TestState state;
+	FillTestState(state);
+
+	std::vector<u8> two_pass = SaveTwoPass(state);
+
+	ChunkedBuffer arena;
+	PointerWrap p(&arena);
+	state.DoState(p);
+	EXPECT_EQ(PointerWrap::MODE_WRITE, p.GetMode());
+
+	std::vector<u8> single_pass;
+	arena.CopyTo(single_pass);
+	EXPECT_TRUE(two_pass == single_pass);
+
+	TestState loaded;
+	u8* ptr = &single_pass[0];
+	PointerWrap read(&ptr, PointerWrap::MODE_READ);
+	loaded.DoState(read);
+	EXPECT_EQ(PointerWrap::MODE_READ, read.GetMode());
+	EXPECT_EQ(state.value, loaded.value);
+	EXPECT_TRUE(state.list == loaded.list);
+	EXPECT_EQ(state.name, loaded.name);
+	EXPECT_TRUE(state.table == loaded.table);
+	EXPECT_EQ(0, memcmp(state.array, loaded.array, sizeof(state.array)));
+}
+
+TEST(PointerWrap, MarkerTimes)
+{
+	TestState state;
+	FillTestState(state);
+
+	ChunkedBuffer arena;
+	PointerWrap p(&arena);
+	PointerWrap::MarkerTimes times;
+	p.SetMarkerTimes(&times);
+	state.DoState(p);
+
+	ASSERT_EQ(2u, times.size());
+	EXPECT_EQ("Fields", times[0].first);
+	EXPECT_EQ("Array", times[1].first);
+}
+
+TEST(StreamChecksum, SplitInvariant)
+{
+	std::vector<u8> data(1000);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = (u8)(i * 7 + 3);
+
+	const u32 whole = PointerWrap::GetChecksum(&data[0], data.size());
+	for (size_t split = 0; split < 20; split++)
+	{
+		StreamChecksum sum;
+		sum.Update(&data[0], split);
+		sum.Update(&data[split], 11);
+		sum.Update(&data[split + 11], data.size() - split - 11);
+		EXPECT_EQ(whole, sum.Finish());
+	}
+
+	data[500] ^= 1;
+	EXPECT_NE(whole, PointerWrap::GetChecksum(&data[0], data.size()));
+}
+
+namespace
+{
+
+struct SectionState
+{
+	TestState first, second;
+
+	void DoState(PointerWrap& p)
+	{
+		p.DoSection("first", [this](PointerWrap& section) { first.DoState(section); });
+		p.DoSection("second", [this](PointerWrap& section) { second.DoState(section); });
+	}
+};
+
+}
+
+TEST(PointerWrap, Sections)
+{
+	SectionState state;
+	FillTestState(state.first);
+	FillTestState(state.second);
+	state.second.value = 42;
+
+	std::vector<u8> two_pass = SaveTwoPass(state);
+
+	ChunkedBuffer arena;
+	PointerWrap p(&arena);
+	state.DoState(p);
+	std::vector<u8> single_pass;
+	arena.CopyTo(single_pass);
+	EXPECT_TRUE(two_pass == single_pass);
+
+	SectionState loaded;
+	u8* ptr = &single_pass[0];
+	PointerWrap read(&ptr, PointerWrap::MODE_READ);
+	loaded.DoState(read);
+	EXPECT_EQ(PointerWrap::MODE_READ, read.GetMode());
+	EXPECT_EQ(42u, loaded.second.value);
+	EXPECT_EQ(&single_pass[0] + single_pass.size(), ptr);
+
+	// A flipped bit in the second section is caught before it gets deserialized
+	single_pass[single_pass.size() - 10] ^= 0x10;
+	loaded.second.value = 0;
+	ptr = &single_pass[0];
+	PointerWrap corrupted(&ptr, PointerWrap::MODE_READ);
+	loaded.DoState(corrupted);
+	EXPECT_EQ(PointerWrap::MODE_MEASURE, corrupted.GetMode());
+	EXPECT_EQ(0u, loaded.second.value);
+}
+
+TEST(PointerWrap, SectionTable)
+{
+	SectionState state;
+	FillTestState(state.first);
+	FillTestState(state.second);
+
+	ChunkedBuffer arena;
+	PointerWrap p(&arena);
+	PointerWrap::SectionTable sections;
+	p.SetSectionTable(&sections);
+	state.DoState(p);
+	std::vector<u8> buffer;
+	arena.CopyTo(buffer);
+
+	// Each entry points right behind the size and checksum fields it matches,
+	// and the second section ends the buffer
+	ASSERT_EQ(2u, sections.size());
+	for (const PointerWrap::WrittenSection& section : sections)
+	{
+		u32 size, checksum;
+		memcpy(&size, &buffer[section.offset - 2 * sizeof(u32)], sizeof(u32));
+		memcpy(&checksum, &buffer[section.offset - sizeof(u32)], sizeof(u32));
+		EXPECT_EQ(size, section.size);
+		EXPECT_EQ(checksum, PointerWrap::GetChecksum(&buffer[section.offset], section.size));
+	}
+	EXPECT_LT(sections[0].offset + sections[0].size, sections[1].offset);
+	EXPECT_EQ(buffer.size(), sections[1].offset + sections[1].size);
+}
+
+TEST(PointerWrap, TruncatedSection)
+{
+	SectionState state;
+	FillTestState(state.first);
+	FillTestState(state.second);
+	state.second.value = 42;
+
+	ChunkedBuffer arena;
+	PointerWrap p(&arena);
+	state.DoState(p);
+	std::vector<u8> buffer;
+	arena.CopyTo(buffer);
+
+	// The second section's size now points past the end of the buffer
+	buffer.resize(buffer.size() - 100);
+	buffer.shrink_to_fit();
+
+	SectionState loaded;
+	loaded.second.value = 0;
+	u8* ptr = &buffer[0];
+	PointerWrap read(&ptr, PointerWrap::MODE_READ, ptr + buffer.size());
+	loaded.DoState(read);
+	EXPECT_EQ(PointerWrap::MODE_MEASURE, read.GetMode());
+	EXPECT_EQ(0x12345678u, loaded.first.value);
+	EXPECT_EQ(0u, loaded.second.value);
+}
+
+namespace
+{
+
+// Roughly the shape of a GameCube savestate: a few large memory blocks and a
+// lot of small fields.
+struct BenchState
+{
+	std::vector<u8> ram, l1_cache, aram, fifo, tmem;
+	u32 registers[0x2000];
+	std::vector<std::vector<u32>> ipc_devices;
+
+	BenchState()
+		: ram(24 * 1024 * 1024, 0x11), l1_cache(256 * 1024, 0x22), aram(16 * 1024 * 1024, 0x33),
+		  fifo(2 * 1024 * 1024, 0x44), tmem(1024 * 1024, 0x55), ipc_devices(64, std::vector<u32>(32, 1))
+	{
+		memset(registers, 0x66, sizeof(registers));
+	}
+
+	void DoState(PointerWrap& p)
+	{
+		p.DoSection("video", [this](PointerWrap& p) {
+			p.DoArray(&tmem[0], (u32)tmem.size());
+			p.DoArray(registers, 0x800);
+		});
+		p.DoSection("Fifo", [this](PointerWrap& p) {
+			p.DoArray(&fifo[0], (u32)fifo.size());
+		});
+		p.DoSection("Memory", [this](PointerWrap& p) {
+			p.DoArray(&ram[0], (u32)ram.size());
+			p.DoArray(&l1_cache[0], (u32)l1_cache.size());
+		});
+		p.DoSection("DSP", [this](PointerWrap& p) {
+			p.DoArray(&aram[0], (u32)aram.size());
+			p.DoArray(registers + 0x800, 0x800);
+		});
+		p.DoSection("HW", [this](PointerWrap& p) {
+			for (u32 i = 0x1000; i < 0x2000; i++)
+				p.Do(registers[i]);
+		});
+		p.DoSection("IPC_HLE", [this](PointerWrap& p) {
+			for (auto& device : ipc_devices)
+			{
+				for (u32& field : device)
+					p.Do(field);
+			}
+		});
+	}
+};
+
+double MillisecondsSince(std::chrono::high_resolution_clock::time_point start)
+{
+	auto end = std::chrono::high_resolution_clock::now();
+	return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+}
+
+TEST(PointerWrap, Benchmark)
+{
+	BenchState state;
+	const int iterations = 5;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	size_t two_pass_size = 0;
+	for (int i = 0; i < iterations; i++)
+		two_pass_size = SaveTwoPass(state).size();
+	double two_pass_ms = MillisecondsSince(start) / iterations;
+
+	ChunkedBuffer arena;
+	std::map<std::string, u64> sections;
+	start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < iterations; i++)
+	{
+		arena.Clear();
+		PointerWrap p(&arena);
+		PointerWrap::MarkerTimes times;
+		p.SetMarkerTimes(&times);
+		state.DoState(p);
+		for (const auto& section : times)
+			sections[section.first] += section.second;
+	}
+	double single_pass_ms = MillisecondsSince(start) / iterations;
+
+	printf("PointerWrap: %u bytes, measure + write %.2f ms, single pass into arena %.2f ms\n",
+	       (u32)arena.GetSize(), two_pass_ms, single_pass_ms);
+	for (const auto& section : sections)
+		printf("  %-8s %.2f ms\n", section.first.c_str(), section.second / 1000.0 / iterations);
+
+	EXPECT_EQ(two_pass_size, arena.GetSize());
+}
@@ -0,0 +1,175 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "Common/CPUDetect.h"
+#include "Common/Hash.h"
+
+namespace
+{
+
+// Plain version of the stripe hash, straight from its description
+u64 ReferenceStripeHash(const u8* src, int len, u32 samples)
+{
+	static const u64 key[8] = {
+		0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL, 0xdb979083e96dd4deULL, 0x1f67b3b7a4a44072ULL,
+		0x78e5c0cc4ee679cbULL, 0x2172ffcc7dd05a82ULL, 0x8e2443f7744608b8ULL, 0x4c263a81e69035e0ULL,
+	};
+
+	u64 acc[8];
+	for (int i = 0; i < 8; ++i)
+		acc[i] = key[7 - i];
+
+	auto accumulate = [&](const u8* p) {
+		for (int i = 0; i < 8; ++i)
+		{
+			u64 data;
+			memcpy(&data, p + i * 8, 8);
+			u64 k = data ^ key[i];
+			acc[i ^ 1] += data;
+			acc[i] += (k & 0xFFFFFFFF) * (k >> 32);
+		}
+	};
+
+	const int stripes = len / 64;
+	int step = 1;
+	if (samples)
+		step = std::max(stripes / (int)std::max(samples / 8, 1u), 1);
+
+	int count = 0;
+	for (int s = 0; s < stripes; s += step)
+	{
+		accumulate(src + s * 64);
+		if (++count % 16 == 0)
+		{
+			for (int i = 0; i < 8; ++i)
+				acc[i] = (acc[i] ^ (acc[i] >> 47) ^ key[i]) * 0x9E3779B1;
+		}
+	}
+
+	if (len % 64)
+	{
+		u8 last[64] = {};
+		if (len >= 64)
+			memcpy(last, src + len - 64, 64);
+		else
+			memcpy(last, src, len);
+		accumulate(last);
+	}
+
+	u64 h = (u64)len * 0x9E3779B185EBCA87ULL;
+	for (int i = 0; i < 8; ++i)
+	{
+		h ^= acc[i] + key[i];
+		h = (h ^ (h >> 29)) * 0x9E3779B185EBCA87ULL;
+	}
+	return h ^ (h >> 32);
+}
+
+std::vector<u8> RandomData(size_t size, u32 seed)
+{
+	std::mt19937 rng(seed);
+	std::vector<u8> data(size);
+	for (u8& byte : data)
+		byte = (u8)rng();
+	return data;
+}
+
+}
+
+TEST(Hash, StripeHashMatchesReference)
+{
+	const std::vector<u8> data = RandomData(1 << 20, 1);
+	const int lengths[] = { 0, 1, 7, 63, 64, 65, 127, 1000, 1024, 4096 + 24, 65536, 1 << 20 };
+	const u32 samples[] = { 0, 1, 8, 128, 1000 };
+
+	for (int len : lengths)
+	{
+		for (u32 sample_count : samples)
+		{
+			// Unaligned too
+			for (int offset = 0; offset < 2; ++offset)
+			{
+				const int n = std::min(len, (int)data.size() - offset);
+				const u64 expected = ReferenceStripeHash(&data[offset], n, sample_count);
+				EXPECT_EQ(expected, GetStripeHash(&data[offset], n, sample_count)) << n << " " << sample_count;
+				if (cpu_info.bAVX2)
+					EXPECT_EQ(expected, GetStripeHashAVX2(&data[offset], n, sample_count)) << n << " " << sample_count;
+			}
+		}
+	}
+}
+
+TEST(Hash, StripeHashSeesEveryBit)
+{
+	const int lengths[] = { 16, 64, 200, 4096 };
+	for (int len : lengths)
+	{
+		std::vector<u8> data = RandomData(len, len);
+		const u64 original = GetStripeHash(data.data(), len, 0);
+		for (int bit = 0; bit < len * 8; ++bit)
+		{
+			data[bit / 8] ^= 1 << (bit % 8);
+			EXPECT_NE(original, GetStripeHash(data.data(), len, 0)) << "length " << len << " bit " << bit;
+			data[bit / 8] ^= 1 << (bit % 8);
+		}
+	}
+}
+
+// Throughput of every texture hash, hashing all data (samples = 0) and the
+// default safe texture cache setting (samples = 128)
+TEST(Hash, Benchmark)
+{
+	struct HashFunction
+	{
+		const char* name;
+		u64 (*func)(const u8* src, int len, u32 samples);
+		bool available;
+	};
+	const HashFunction functions[] = {
+		{ "Murmur3", GetMurmurHash3, true },
+		{ "CRC32", GetCRC32, cpu_info.bSSE4_2 && GetCRC32((const u8*)"12345678", 8, 0) != 0 },
+		{ "HiresTexture", GetHashHiresTexture, true },
+		{ "Stripe", GetStripeHash, true },
+		{ "StripeAVX2", GetStripeHashAVX2, cpu_info.bAVX2 },
+	};
+	const int sizes[] = { 512, 4096, 32768, 262144, 1 << 20 };
+	const std::vector<u8> data = RandomData(1 << 20, 2);
+
+	for (u32 samples : { 0u, 128u })
+	{
+		printf("%-14s", samples ? "128 samples" : "all data");
+		for (int size : sizes)
+			printf("%10d B", size);
+		printf("\n");
+
+		for (const HashFunction& function : functions)
+		{
+			if (!function.available)
+				continue;
+
+			printf("%-14s", function.name);
+			for (int size : sizes)
+			{
+				const int iterations = std::max((64 << 20) / size, 16);
+				u64 result = 0;
+				auto start = std::chrono::high_resolution_clock::now();
+				for (int i = 0; i < iterations; ++i)
+					result += function.func(data.data(), size, samples);
+				auto end = std::chrono::high_resolution_clock::now();
+				double seconds = std::chrono::duration<double>(end - start).count();
+				// Keep the calls from being optimized out
+				EXPECT_NE(0u, result | 1);
+				printf("%8.0f MB/s", (double)size * iterations / seconds / 1e6);
+			}
+			printf("\n");
+		}
+	}
+}
@@ -0,0 +1,90 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "Common/MPSCQueue.h"
+
+TEST(MPSCQueue, Simple)
+{
+	Common::MPSCQueue<u32, 16> q;
+
+	EXPECT_TRUE(q.Empty());
+
+	u32 v;
+	EXPECT_FALSE(q.Pop(v));
+
+	// Test the FIFO order, wrapping around the buffer a few times.
+	for (u32 round = 0; round < 4; ++round)
+	{
+		for (u32 i = 0; i < 10; ++i)
+			EXPECT_TRUE(q.Push(i));
+		EXPECT_FALSE(q.Empty());
+		for (u32 i = 0; i < 10; ++i)
+		{
+			EXPECT_TRUE(q.Pop(v));
+			EXPECT_EQ(i, v);
+		}
+		EXPECT_TRUE(q.Empty());
+		EXPECT_FALSE(q.IsNextUnpublished());
+	}
+}
+
+TEST(MPSCQueue, Full)
+{
+	Common::MPSCQueue<u32, 8> q;
+
+	for (u32 i = 0; i < 8; ++i)
+		EXPECT_TRUE(q.Push(i));
+	EXPECT_FALSE(q.Push(8));
+
+	u32 v;
+	EXPECT_TRUE(q.Pop(v));
+	EXPECT_EQ(0u, v);
+	EXPECT_TRUE(q.Push(8));
+}
+
+TEST(MPSCQueue, MultiThreaded)
+{
+	const u32 num_writers = 4;
+	const u32 num_values = 100000;
+	Common::MPSCQueue<u32, 256> q;
+
+	auto inserter = [&q](u32 writer) {
+		for (u32 i = 0; i < num_values; ++i)
+		{
+			while (!q.Push((writer << 24) | i))
+				std::this_thread::yield();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (u32 i = 0; i < num_writers; ++i)
+		threads.emplace_back(inserter, i);
+
+	// Every writer's values must come out in the order they were pushed.
+	std::vector<u32> next(num_writers, 0);
+	for (u32 count = 0; count < num_writers * num_values;)
+	{
+		u32 v;
+		if (!q.Pop(v))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		u32 writer = v >> 24;
+		ASSERT_LT(writer, num_writers);
+		EXPECT_EQ(next[writer], v & 0xFFFFFF);
+		next[writer]++;
+		count++;
+	}
+
+	for (auto& thread : threads)
+		thread.join();
+
+	EXPECT_TRUE(q.Empty());
+}
@@ -0,0 +1,565 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Checks the batched AX voice kernels against straightforward per sample
+// versions, and the parallel PB list processing against the serial one.
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonPaths.h"
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Common/WorkerPool.h"
+#include "Core/HW/DSP.h"
+#include "Core/HW/Memmap.h"
+
+#define AX_GC
+#include "Core/HW/DSPHLE/UCodes/AXVoice.h"
+
+#include "CoreTestUtil.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace
+{
+
+// The resampler as it was written before, reading one sample at a time
+template <typename Input>
+u32 ReferenceResample(Input input, s16* output, u32 count, s16* last_samples,
+                      u32 curr_pos, u32 ratio, int srctype, const s16* coeffs = nullptr)
+{
+	if (srctype != SRCTYPE_LINEAR && srctype != SRCTYPE_POLYPHASE)
+	{
+		for (u32 i = 0; i < count; ++i)
+			output[i] = input();
+		memcpy(last_samples, output + count - 4, 4 * sizeof (s16));
+		return curr_pos;
+	}
+
+	s16 temp[4];
+	u32 idx = 0;
+	for (int i = 0; i < 4; ++i)
+		temp[idx++ & 3] = last_samples[i];
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		curr_pos += ratio;
+		while (curr_pos >= 0x10000)
+		{
+			temp[idx++ & 3] = input();
+			curr_pos -= 0x10000;
+		}
+
+		if (coeffs && srctype == SRCTYPE_POLYPHASE)
+		{
+			const s16* c = &coeffs[((curr_pos & 0xFFFF) >> 9) << 2];
+			s64 samp = 0;
+			for (int tap = 0; tap < 4; ++tap)
+				samp += (s64)temp[idx++ & 3] * c[tap];
+			samp >>= 15;
+			output[i] = (s16)std::max<s64>(-0x8000, std::min<s64>(0x7FFF, samp));
+			continue;
+		}
+
+		u16 curr_frac = curr_pos & 0xFFFF;
+		u16 inv_curr_frac = -curr_frac;
+		if (curr_frac)
+		{
+			s32 s0 = temp[idx++ & 3];
+			s32 s1 = temp[idx++ & 3];
+			output[i] = ((s0 * inv_curr_frac) + (s1 * curr_frac)) >> 16;
+			idx += 2;
+		}
+		else
+		{
+			output[i] = temp[idx++ & 3];
+			idx += 3;
+		}
+	}
+
+	for (int i = 3; i >= 0; --i)
+		last_samples[i] = temp[--idx & 3];
+	return curr_pos;
+}
+
+void ReferenceGetInputSamples(AXPB& pb, s16* samples, u16 count)
+{
+	u32 cur_addr = HILO_TO_32(pb.audio_addr.cur_addr);
+	AcceleratorState acc;
+	AcceleratorSetup(acc, &pb, &cur_addr);
+
+	pb.src.cur_addr_frac = ReferenceResample([&acc] { return (s16)AcceleratorGetSample(acc); },
+	                                         samples, count, pb.src.last_samples, pb.src.cur_addr_frac,
+	                                         HILO_TO_32(pb.src.ratio), pb.src_type);
+	pb.audio_addr.cur_addr_hi = (u16)(cur_addr >> 16);
+	pb.audio_addr.cur_addr_lo = (u16)(cur_addr & 0xFFFF);
+}
+
+const u32 PB_ADDRESS = 0x00200000;
+const u32 PB_SIZE = sizeof (AXPB);
+const u32 ARAM_SAMPLES_PER_VOICE = 0x8000;
+
+// A voice looping over its own stretch of random ADPCM data in ARAM
+AXPB MakeVoice(std::mt19937& rng, u32 index, u32 next_pb)
+{
+	AXPB pb;
+	memset(&pb, 0, sizeof (pb));
+	pb.next_pb_hi = next_pb >> 16;
+	pb.next_pb_lo = next_pb & 0xFFFF;
+	pb.src_type = index % 3 ? SRCTYPE_LINEAR : SRCTYPE_NEAREST;
+	pb.mixer_control = MIX_L | MIX_R | MIX_S | (index & 1 ? MIX_L_RAMP | MIX_AUXA_L | MIX_AUXA_R : 0);
+	pb.running = 1;
+
+	u16* volumes = (u16*)&pb.mixer;
+	for (u32 i = 0; i < sizeof (pb.mixer) / sizeof (u16); i += 2)
+	{
+		volumes[i] = rng() % 0x10000;
+		volumes[i + 1] = rng() % 16 - 8;
+	}
+	pb.vol_env.cur_volume = 0x4000 + rng() % 0x8000;
+	pb.vol_env.cur_volume_delta = rng() % 8 - 4;
+
+	u32 start = index * ARAM_SAMPLES_PER_VOICE * 2;
+	pb.audio_addr.looping = 1;
+	pb.audio_addr.sample_format = 0x00;
+	pb.audio_addr.loop_addr_hi = (start + 2) >> 16;
+	pb.audio_addr.loop_addr_lo = (start + 2) & 0xFFFF;
+	u32 end = start + ARAM_SAMPLES_PER_VOICE * 2 - 1 - rng() % 64;
+	pb.audio_addr.end_addr_hi = end >> 16;
+	pb.audio_addr.end_addr_lo = end & 0xFFFF;
+	pb.audio_addr.cur_addr_hi = start >> 16;
+	pb.audio_addr.cur_addr_lo = start & 0xFFFF;
+
+	for (s16& coef : pb.adpcm.coefs)
+		coef = rng() % 0x1000 - 0x800;
+
+	u32 ratio = 0x4000 + rng() % 0x30000;
+	pb.src.ratio_hi = ratio >> 16;
+	pb.src.ratio_lo = ratio & 0xFFFF;
+	return pb;
+}
+
+void FillARAM(std::mt19937& rng, u32 size)
+{
+	u8* aram = DSP::GetARAMPtr();
+	for (u32 i = 0; i < size; ++i)
+		aram[i] = (u8)rng();
+}
+
+// Same as AXUCode::ProcessPBList, minus the updates
+u32 ProcessPB(u32 addr, AXBuffers buffers)
+{
+	AXPB pb;
+	if (!ReadPB(addr, pb))
+		return 0;
+
+	for (int curr_ms = 0; curr_ms < 5; ++curr_ms)
+	{
+		ProcessVoice(pb, buffers, 32, (AXMixControl)pb.mixer_control, nullptr);
+		for (int*& ptr : buffers.ptrs)
+			ptr += 32;
+	}
+
+	WritePB(addr, pb);
+	return HILO_TO_32(pb.next_pb);
+}
+
+struct MixOutput
+{
+	int samples[9][32 * 5];
+
+	AXBuffers GetBuffers()
+	{
+		AXBuffers buffers;
+		for (int i = 0; i < 9; ++i)
+			buffers.ptrs[i] = samples[i];
+		return buffers;
+	}
+};
+
+}
+
+class AXVoiceTest : public testing::Test
+{
+protected:
+	static void SetUpTestCase()
+	{
+		CoreTestUtil::Init(false);
+		DSP::Init(true);
+	}
+
+	static void TearDownTestCase()
+	{
+		DSP::Shutdown();
+		CoreTestUtil::Shutdown();
+	}
+
+	// Writes a list of <count> voices and returns the address of the first
+	void WriteVoices(u32 count, u32 seed)
+	{
+		std::mt19937 rng(seed);
+		FillARAM(rng, count * ARAM_SAMPLES_PER_VOICE);
+		for (u32 i = 0; i < count; ++i)
+		{
+			u32 next = i + 1 < count ? PB_ADDRESS + (i + 1) * PB_SIZE : 0;
+			WritePB(PB_ADDRESS + i * PB_SIZE, MakeVoice(rng, i, next));
+		}
+	}
+
+	std::vector<u8> ReadPBMemory(u32 count)
+	{
+		const u8* ptr = Memory::GetPointer(PB_ADDRESS);
+		return std::vector<u8>(ptr, ptr + count * PB_SIZE);
+	}
+};
+
+TEST_F(AXVoiceTest, MixAddMatchesScalar)
+{
+	std::mt19937 rng(1);
+	for (u32 count = 1; count <= 40; ++count)
+	{
+		s16 input[40];
+		int expected[40], result[40];
+		for (u32 i = 0; i < count; ++i)
+		{
+			input[i] = (s16)rng();
+			expected[i] = result[i] = (int)(rng() % 0x20000) - 0x10000;
+		}
+
+		for (int ramp = 0; ramp < 2; ++ramp)
+		{
+			u16 vol[2] = { (u16)rng(), (u16)rng() };
+			u16 ref_volume = vol[0];
+			s16 ref_dpop = 0, dpop = 0;
+			for (u32 i = 0; i < count; ++i)
+			{
+				s16 sample = (s16)(((s64)input[i] * ref_volume) >> 15);
+				expected[i] += sample;
+				ref_volume += ramp ? vol[1] : 0;
+				ref_dpop = sample;
+			}
+
+			MixAdd(result, input, count, vol, &dpop, ramp != 0);
+			EXPECT_EQ(ref_volume, vol[0]);
+			EXPECT_EQ(ref_dpop, dpop);
+		}
+		EXPECT_EQ(0, memcmp(expected, result, count * sizeof (int))) << "count " << count;
+	}
+}
+
+TEST_F(AXVoiceTest, VolumeRampMatchesScalar)
+{
+	std::mt19937 rng(2);
+	for (u32 count = 1; count <= 40; ++count)
+	{
+		s16 expected[40], result[40];
+		for (u32 i = 0; i < count; ++i)
+			expected[i] = result[i] = (s16)rng();
+
+		u16 volume = (u16)rng(), ref_volume = volume;
+		s16 delta = (s16)rng();
+		for (u32 i = 0; i < count; ++i)
+		{
+			expected[i] = ((s32)expected[i] * ref_volume) >> 15;
+			ref_volume += delta;
+		}
+
+		ApplyVolumeRamp(result, count, &volume, delta);
+		EXPECT_EQ(ref_volume, volume);
+		EXPECT_EQ(0, memcmp(expected, result, count * sizeof (s16))) << "count " << count;
+	}
+}
+
+TEST_F(AXVoiceTest, ResampleMatchesScalar)
+{
+	std::mt19937 rng(3);
+	const u32 ratios[] = { 0x100, 0x8000, 0x10000, 0x10001, 0x1A000, 0x55555, 0x3FFFF };
+	std::vector<s16> coeffs(0x200);
+	for (s16& coef : coeffs)
+		coef = rng() % 0xFFFF - 0x7FFF;
+
+	for (u32 ratio : ratios)
+	{
+		for (int srctype = SRCTYPE_POLYPHASE; srctype <= SRCTYPE_NEAREST; ++srctype)
+		{
+			const s16* table = srctype == SRCTYPE_POLYPHASE && ratio & 0x100 ? &coeffs[0] : nullptr;
+			for (u32 count = 5; count <= 32; count += 9)
+			{
+				u32 curr_pos = rng() % 0x10000;
+				u32 needed = srctype == SRCTYPE_NEAREST ? count : (u32)((curr_pos + (u64)count * ratio) >> 16);
+				std::vector<s16> input(4 + needed);
+				for (s16& sample : input)
+					sample = (s16)rng();
+
+				s16 ref_last[4], last[4];
+				memcpy(ref_last, &input[0], sizeof (ref_last));
+				memcpy(last, &input[0], sizeof (last));
+
+				s16 expected[32], result[32];
+				u32 read = 4;
+				u32 ref_pos = ReferenceResample([&] { return input[read++]; }, expected, count,
+				                                ref_last, curr_pos, ratio, srctype, table);
+				u32 pos = ResampleAudio(&input[0], result, count, last, curr_pos, ratio, srctype, table);
+
+				EXPECT_EQ(input.size(), read);
+				EXPECT_EQ(ref_pos, pos);
+				EXPECT_EQ(0, memcmp(ref_last, last, sizeof (last)));
+				EXPECT_EQ(0, memcmp(expected, result, count * sizeof (s16)))
+					<< "ratio " << ratio << " srctype " << srctype << " count " << count;
+			}
+		}
+	}
+}
+
+TEST_F(AXVoiceTest, PolyphaseSaturates)
+{
+	// Every phase has a gain of 4, which overshoots on anything loud
+	std::vector<s16> coeffs(0x200, 0x7FFF);
+	s16 input[4 + 32], last[4];
+	for (int i = 0; i < 4 + 32; ++i)
+		input[i] = i & 8 ? -0x7000 : 0x7000;
+	memcpy(last, input, sizeof (last));
+
+	s16 output[32];
+	ResampleAudio(input, output, 32, last, 0, 0x10000, SRCTYPE_POLYPHASE, &coeffs[0]);
+	for (int i = 0; i < 32; ++i)
+	{
+		int sum = input[i + 1] + input[i + 2] + input[i + 3] + input[i + 4];
+		s16 expected = sum > 0 ? 0x7FFF : sum < 0 ? -0x8000 : 0;
+		EXPECT_EQ(expected, output[i]) << i;
+	}
+}
+
+TEST_F(AXVoiceTest, RemoteResamplingReadsEverySample)
+{
+	// Old and new AXWii versions, and starting fractions on either side of
+	// where 0x55555 alone used to drop a sample
+	for (u32 count : { 6, 18 })
+	{
+		for (u32 start_pos : { 0x0, 0x3, 0x8000, 0xFFFF })
+		{
+			const u32 num_input = count * 16 / 3;
+			s16 last[4] = { 0, 0, 0, 0 };
+			u32 curr_pos = start_pos;
+			s16 next_sample = 0;
+			for (int frame = 0; frame < 64; ++frame)
+			{
+				s16 input[4 + 96], output[18];
+				memcpy(input, last, sizeof (last));
+				for (u32 i = 0; i < num_input; ++i)
+					input[4 + i] = next_sample++;
+
+				curr_pos = ResampleRemoteAudio(input, output, count, last, curr_pos, nullptr);
+				ASSERT_EQ(start_pos, curr_pos) << "count " << count << " frame " << frame;
+				ASSERT_EQ(0, memcmp(last, input + num_input, sizeof (last))) << "count " << count << " frame " << frame;
+			}
+		}
+	}
+}
+
+// DSP LLE output for the voice below, compared with what GetInputSamples
+// makes of it with the same coefficients. Both ROMs need to be in the user's
+// GC directory, next to ax_polyphase_lle.wav: the dspdump.wav written with
+// [DSP] DumpAudio while DSP LLE runs the AX ucode on a single voice playing
+// LLEReferenceSample(0 .. LLE_REFERENCE_LENGTH) as PCM16, with polyphase
+// resampling at LLE_REFERENCE_RATIO, coef_select 0, and main left and right
+// at volume 0x8000 without ramps. Skipped otherwise.
+namespace
+{
+
+const u32 LLE_REFERENCE_RATIO = 0x13333;
+const u32 LLE_REFERENCE_LENGTH = 0x10000;
+
+// Sweeps from DC to the input's Nyquist frequency, so every phase of every
+// set of coefficients gets used, some of them on full scale input
+s16 LLEReferenceSample(u32 n)
+{
+	const double amplitude = n < LLE_REFERENCE_LENGTH / 2 ? 0x4000 : 0x7FFF;
+	return (s16)(amplitude * sin(M_PI * n * (double)n / (2.0 * LLE_REFERENCE_LENGTH)));
+}
+
+}
+
+TEST_F(AXVoiceTest, PolyphaseMatchesLLE)
+{
+	const std::string dir = File::GetUserPath(D_GCUSER_IDX);
+	const std::string capture_path = dir + "ax_polyphase_lle.wav";
+	if (!File::Exists(dir + DSP_IROM) || !File::Exists(dir + DSP_COEF) || !File::Exists(capture_path))
+	{
+		printf("Skipped, needs %s, %s and ax_polyphase_lle.wav in %s\n", DSP_IROM, DSP_COEF, dir.c_str());
+		return;
+	}
+
+	std::vector<s16> coeffs(0x800);
+	File::IOFile coef_file(dir + DSP_COEF, "rb");
+	ASSERT_TRUE(coef_file.ReadArray(&coeffs[0], coeffs.size()));
+	for (s16& coef : coeffs)
+		coef = Common::swap16(coef);
+
+	// 44 bytes of header from WaveFileWriter, then left and right samples
+	File::IOFile capture_file(capture_path, "rb");
+	ASSERT_GT(capture_file.GetSize(), 44u);
+	std::vector<s16> capture((size_t)(capture_file.GetSize() - 44) / sizeof (s16));
+	capture_file.Seek(44, SEEK_SET);
+	ASSERT_TRUE(capture_file.ReadArray(&capture[0], capture.size()));
+	std::vector<s16> lle;
+	for (size_t i = 0; i + 1 < capture.size(); i += 2)
+		lle.push_back(capture[i]);
+
+	u8* aram = DSP::GetARAMPtr();
+	for (u32 n = 0; n < LLE_REFERENCE_LENGTH; ++n)
+	{
+		const s16 sample = LLEReferenceSample(n);
+		aram[2 * n] = (u8)(sample >> 8);
+		aram[2 * n + 1] = (u8)sample;
+	}
+
+	AXPB pb;
+	memset(&pb, 0, sizeof (pb));
+	pb.src_type = SRCTYPE_POLYPHASE;
+	pb.audio_addr.sample_format = 0x0A;
+	pb.audio_addr.end_addr_hi = (LLE_REFERENCE_LENGTH - 1) >> 16;
+	pb.audio_addr.end_addr_lo = (LLE_REFERENCE_LENGTH - 1) & 0xFFFF;
+	pb.src.ratio_hi = LLE_REFERENCE_RATIO >> 16;
+	pb.src.ratio_lo = LLE_REFERENCE_RATIO & 0xFFFF;
+
+	const u32 num_output = (u32)(((u64)LLE_REFERENCE_LENGTH << 16) / LLE_REFERENCE_RATIO) & ~31;
+	std::vector<s16> hle(num_output);
+	for (u32 i = 0; i < num_output; i += 32)
+		GetInputSamples(pb, &hle[i], 32, &coeffs[0]);
+
+	// The voice starts wherever the capture stops being silent, give or take
+	// the history samples
+	size_t start = 0;
+	while (start < lle.size() && lle[start] == 0)
+		++start;
+	start = start > 4 ? start - 4 : 0;
+
+	int best_error = INT_MAX;
+	size_t best_offset = 0;
+	for (size_t offset = start; offset < start + 8 && offset + num_output <= lle.size(); ++offset)
+	{
+		int error = 0;
+		for (u32 i = 0; i < num_output; ++i)
+			error = std::max(error, abs(lle[offset + i] - hle[i]));
+		if (error < best_error)
+		{
+			best_error = error;
+			best_offset = offset;
+		}
+	}
+	ASSERT_NE(INT_MAX, best_error) << "the capture is shorter than the voice";
+
+	// Volume 0x8000 passes the samples through unchanged, anything else
+	// would be a difference in the resampling
+	for (u32 i = 0; i < num_output; ++i)
+		ASSERT_EQ(lle[best_offset + i], hle[i]) << "sample " << i;
+}
+
+TEST_F(AXVoiceTest, InputSamplesMatchAccelerator)
+{
+	std::mt19937 rng(4);
+	FillARAM(rng, 0x10000);
+
+	// Includes ratios high enough to need more input than GetInputSamples
+	// decodes at once
+	const u32 ratios[] = { 0x2000, 0x10000, 0x1A000, 0x90000, 0x1230000 };
+	for (u32 ratio : ratios)
+	{
+		for (u32 voice = 0; voice < 8; ++voice)
+		{
+			AXPB pb = MakeVoice(rng, 0, 0);
+			pb.src_type = voice % 3;
+			pb.audio_addr.looping = voice & 1;
+			pb.audio_addr.sample_format = voice & 4 ? (voice & 2 ? 0x0A : 0x19) : 0x00;
+			pb.src.ratio_hi = ratio >> 16;
+			pb.src.ratio_lo = ratio & 0xFFFF;
+
+			// Short enough to loop a few times
+			u32 end = 0x1000 + voice * 3;
+			pb.audio_addr.end_addr_hi = end >> 16;
+			pb.audio_addr.end_addr_lo = end & 0xFFFF;
+
+			AXPB ref_pb = pb;
+			for (int frame = 0; frame < 16; ++frame)
+			{
+				s16 expected[32], result[32];
+				ReferenceGetInputSamples(ref_pb, expected, 32);
+				GetInputSamples(pb, result, 32, nullptr);
+				ASSERT_EQ(0, memcmp(expected, result, sizeof (result)))
+					<< "ratio " << ratio << " voice " << voice << " frame " << frame;
+				ASSERT_EQ(0, memcmp(&ref_pb, &pb, sizeof (pb)));
+			}
+		}
+	}
+}
+
+TEST_F(AXVoiceTest, ParallelMatchesSerial)
+{
+	const u32 num_voices = 64;
+	const int num_frames = 8;
+	Common::WorkerPool workers(3);
+	std::vector<int> scratch;
+
+	WriteVoices(num_voices, 5);
+	std::vector<u8> initial = ReadPBMemory(num_voices);
+
+	std::vector<MixOutput> serial(num_frames);
+	memset(&serial[0], 0, num_frames * sizeof (MixOutput));
+	for (MixOutput& output : serial)
+		MixPBList(PB_ADDRESS, output.GetBuffers(), nullptr, scratch, ProcessPB);
+	std::vector<u8> serial_pbs = ReadPBMemory(num_voices);
+
+	memcpy(Memory::GetPointer(PB_ADDRESS), &initial[0], initial.size());
+	std::vector<MixOutput> parallel(num_frames);
+	memset(&parallel[0], 0, num_frames * sizeof (MixOutput));
+	for (MixOutput& output : parallel)
+		MixPBList(PB_ADDRESS, output.GetBuffers(), &workers, scratch, ProcessPB);
+
+	EXPECT_TRUE(serial_pbs == ReadPBMemory(num_voices));
+	for (int frame = 0; frame < num_frames; ++frame)
+		EXPECT_EQ(0, memcmp(&serial[frame], &parallel[frame], sizeof (MixOutput))) << "frame " << frame;
+}
+
+// Replays a synthetic PB list of 64 looping ADPCM voices, serially and on
+// worker threads.
+TEST_F(AXVoiceTest, Benchmark)
+{
+	const u32 num_voices = 64;
+	const int num_frames = 200;
+
+	WriteVoices(num_voices, 6);
+	std::vector<u8> initial = ReadPBMemory(num_voices);
+	std::vector<int> scratch;
+	MixOutput output;
+
+	for (int threads = 0; threads <= 3; ++threads)
+	{
+		std::unique_ptr<Common::WorkerPool> workers;
+		if (threads)
+			workers.reset(new Common::WorkerPool(threads));
+
+		memcpy(Memory::GetPointer(PB_ADDRESS), &initial[0], initial.size());
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int frame = 0; frame < num_frames; ++frame)
+		{
+			memset(&output, 0, sizeof (output));
+			MixPBList(PB_ADDRESS, output.GetBuffers(), workers.get(), scratch, ProcessPB);
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		double us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / (double)num_frames;
+
+		printf("AX: %u voices, %d worker threads: %.1f us per 5 ms frame\n", num_voices, threads, us);
+	}
+}
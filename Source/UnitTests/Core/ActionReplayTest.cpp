@@ -0,0 +1,346 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/MsgHandler.h"
+#include "Core/ActionReplay.h"
+#include "Core/MemTools.h"
+#include "Core/HW/Memmap.h"
+
+#include "CoreTestUtil.h"
+
+using namespace ActionReplay;
+
+namespace
+{
+
+// Codes write to DATA, and write to pointer codes read their pointers from
+// POINTERS
+const u32 DATA = 0x00100000;
+const u32 DATA_SIZE = 0x10000;
+const u32 POINTERS = 0x00130000;
+const u32 NUM_POINTERS = 16;
+
+int s_alerts;
+
+bool CountAlert(const char* caption, const char* text, bool yes_no, int style)
+{
+	++s_alerts;
+	return true;
+}
+
+u32 Addr(u32 type, u32 subtype, u32 size, u32 gcaddr)
+{
+	return (subtype << 30) | (type << 27) | (size << 25) | (gcaddr & 0x01FFFFFF);
+}
+
+ARCode MakeCode(const std::vector<AREntry>& lines)
+{
+	ARCode code;
+	code.name = "Test";
+	code.ops = lines;
+	code.active = true;
+	code.user_defined = true;
+	return code;
+}
+
+// A code mixing every kind of line RunCode handles without errors
+ARCode RandomCode(std::mt19937& rng, int num_lines)
+{
+	auto rnd = [&](u32 n) { return (u32)(rng() % n); };
+	std::vector<AREntry> lines;
+	while ((int)lines.size() < num_lines)
+	{
+		const u32 size = rnd(4);
+		switch (rnd(10))
+		{
+		case 0:
+		case 1:
+		{
+			const u32 repeat = rnd(8);
+			const u32 data = size == 0 ? (repeat << 8) | rnd(0x100) : size == 1 ? (repeat << 16) | rnd(0x10000) : (u32)rng();
+			lines.emplace_back(Addr(0, 0, size, DATA + rnd(DATA_SIZE / 2)), data);
+			break;
+		}
+		case 2:
+		{
+			const u32 data = size == 0 ? (rnd(0x100) << 8) | rnd(0x100) : size == 1 ? (rnd(0x80) << 16) | rnd(0x10000) : (u32)rng();
+			lines.emplace_back(Addr(0, 1, size, POINTERS + rnd(NUM_POINTERS) * 4), data);
+			break;
+		}
+		case 3:
+			lines.emplace_back(Addr(0, 2, size, DATA + rnd(DATA_SIZE / 2)), rnd(0x1000));
+			break;
+		case 4:
+		case 5:
+			// Small values in a small range, so that some of them are true
+			lines.emplace_back(Addr(1 + rnd(7), rnd(4), size, DATA + rnd(16)), rnd(4));
+			break;
+		case 6:
+			lines.emplace_back(0, 0x40000000);
+			break;
+		case 7:
+			if (rnd(8) == 0)
+				lines.emplace_back(0, 0);
+			else
+				lines.emplace_back(0, 0x40000000 | rnd(0x1000));
+			break;
+		case 8:
+		{
+			// Fill and slide, with increments that can go backwards
+			const u32 count = rnd(32);
+			const u32 addr_incr = (u32)(rnd(17) - 8) & 0xFFFF;
+			const u32 val_incr = rnd(0x100);
+			lines.emplace_back(0, 0x80000000 | (rnd(3) << 25) | (DATA + 0x2000 + rnd(DATA_SIZE / 2)));
+			lines.emplace_back(1 + rnd(0xFF), (val_incr << 24) | (count << 16) | addr_incr);
+			break;
+		}
+		case 9:
+			// Memory copy
+			lines.emplace_back(0, 0x86000000 | (DATA + rnd(DATA_SIZE / 2)));
+			lines.emplace_back(DATA + rnd(DATA_SIZE / 2), rnd(0x100));
+			break;
+		}
+	}
+	return MakeCode(lines);
+}
+
+// What most cheats are made of: writes, with a few conditionals and adds
+ARCode TypicalCode(std::mt19937& rng, int num_lines)
+{
+	auto rnd = [&](u32 n) { return (u32)(rng() % n); };
+	std::vector<AREntry> lines;
+	while ((int)lines.size() < num_lines)
+	{
+		const u32 size = rnd(3);
+		const u32 addr = DATA + rnd(DATA_SIZE / 4) * 4;
+		switch (rnd(8))
+		{
+		case 0:
+			lines.emplace_back(Addr(1 + rnd(7), 0, size, addr), rnd(4));
+			break;
+		case 1:
+			lines.emplace_back(Addr(0, 2, size, addr), 1);
+			break;
+		default:
+			lines.emplace_back(Addr(0, 0, size, addr), size == 2 ? (u32)rng() : rnd(0x100));
+			break;
+		}
+	}
+	return MakeCode(lines);
+}
+
+void RandomizeMemory(std::mt19937& rng)
+{
+	u8* ram = Memory::GetMainRAMPtr();
+	for (u32 i = 0; i < DATA_SIZE; ++i)
+		ram[DATA + i] = rng() % 8 == 0 ? (u8)rng() : 0;
+	for (u32 i = 0; i < NUM_POINTERS; ++i)
+		Memory::Write_U32(0x80000000 | (DATA + rng() % DATA_SIZE), 0x80000000 | (POINTERS + i * 4));
+}
+
+// Runs a code for a few frames, as long as it stays active
+template <typename RunFunction>
+int RunFrames(int frames, RunFunction run)
+{
+	for (int i = 0; i < frames; ++i)
+	{
+		if (!run())
+			return i;
+	}
+	return frames;
+}
+
+}
+
+class ActionReplayTest : public testing::Test
+{
+protected:
+	static void SetUpTestCase()
+	{
+		CoreTestUtil::Init(true);
+		EMM::InstallExceptionHandler();
+		RegisterMsgAlertHandler(CountAlert);
+	}
+
+	static void TearDownTestCase()
+	{
+		CoreTestUtil::Shutdown();
+	}
+
+	void SetUp() override
+	{
+		memset(Memory::GetMainRAMPtr(), 0, Memory::REALRAM_SIZE);
+		s_alerts = 0;
+	}
+};
+
+TEST_F(ActionReplayTest, RandomCodesMatchRunCode)
+{
+	std::mt19937 rng(1234);
+	u8* ram = Memory::GetMainRAMPtr();
+	std::vector<u8> before(Memory::REALRAM_SIZE), after(Memory::REALRAM_SIZE);
+
+	for (int iteration = 0; iteration < 200; ++iteration)
+	{
+		const ARCode code = RandomCode(rng, 1 + iteration % 40);
+		RandomizeMemory(rng);
+		memcpy(before.data(), ram, before.size());
+
+		const int interpreted_frames = RunFrames(3, [&] { return RunCode(code); });
+		memcpy(after.data(), ram, after.size());
+
+		memcpy(ram, before.data(), before.size());
+		const ARCompiledCode compiled = CompileCode(code);
+		const int compiled_frames = RunFrames(3, [&] { return RunCompiledCode(compiled); });
+
+		ASSERT_EQ(interpreted_frames, compiled_frames) << iteration;
+		ASSERT_EQ(0, memcmp(after.data(), ram, after.size())) << iteration;
+	}
+	EXPECT_EQ(0, s_alerts);
+}
+
+TEST_F(ActionReplayTest, ConditionalsSkipLines)
+{
+	const u32 value = 0x80000000 | DATA;
+	const u32 result = 0x80000000 | (DATA + 0x100);
+	Memory::Write_U32(5, value);
+
+	const ARCompiledCode compiled = CompileCode(MakeCode({
+		// If equal to 5, run two lines
+		{ Addr(1, 1, 2, DATA), 5 },
+		{ Addr(0, 0, 0, DATA + 0x100), 0x11 },
+		{ Addr(0, 0, 0, DATA + 0x101), 0x22 },
+		// If greater than 7, run everything until the endif
+		{ Addr(6, 2, 2, DATA), 7 },
+		{ Addr(0, 0, 0, DATA + 0x102), 0x33 },
+		{ 0, 0x40000000 },
+		{ Addr(0, 0, 0, DATA + 0x103), 0x44 },
+		// If equal to 4, run one line
+		{ Addr(1, 0, 2, DATA), 4 },
+		{ Addr(0, 0, 0, DATA + 0x104), 0x55 },
+		// If not equal to 5, run the rest
+		{ Addr(2, 3, 2, DATA), 5 },
+		{ 0, 0 },
+		{ Addr(0, 0, 0, DATA + 0x105), 0x66 },
+	}));
+
+	EXPECT_TRUE(RunCompiledCode(compiled));
+	EXPECT_EQ(0x11220044u, Memory::Read_U32(result));
+	EXPECT_EQ(0u, Memory::Read_U16(result + 4));
+}
+
+TEST_F(ActionReplayTest, FillAndSlide)
+{
+	const ARCompiledCode compiled = CompileCode(MakeCode({
+		// 16 bit writes starting at 0x1000, three apart
+		{ 0, 0x80000000 | (1 << 25) | DATA },
+		{ 0x1000, (1 << 24) | (4 << 16) | 3 },
+	}));
+	ASSERT_NE(nullptr, compiled.ops[0].ptr);
+
+	EXPECT_TRUE(RunCompiledCode(compiled));
+	for (u32 i = 0; i < 4; ++i)
+		EXPECT_EQ(0x1000 + i, Memory::Read_U16(0x80000000 | (DATA + i * 6)));
+	EXPECT_EQ(0u, Memory::Read_U16(0x80000000 | (DATA + 24)));
+}
+
+TEST_F(ActionReplayTest, OutsideRAMUsesMemoryFunctions)
+{
+	// 0x81800000 is past the end of RAM
+	const ARCompiledCode compiled = CompileCode(MakeCode({
+		{ Addr(0, 0, 2, 0x01900000), 0x12345678 },
+		{ Addr(0, 0, 0, 0x017FFFFE), 0x0300AB },
+	}));
+	EXPECT_EQ(nullptr, compiled.ops[0].ptr);
+	EXPECT_EQ(nullptr, compiled.ops[1].ptr);
+
+	EXPECT_TRUE(RunCompiledCode(compiled));
+	EXPECT_EQ(0x12345678u, Memory::Read_U32(0x81900000));
+	EXPECT_EQ(0xABABu, Memory::Read_U16(0x817FFFFE));
+	EXPECT_EQ(0xABABu, Memory::Read_U16(0x81800000));
+}
+
+TEST_F(ActionReplayTest, ErrorsAreReportedByRunCode)
+{
+	const ARCode code = MakeCode({
+		{ Addr(0, 0, 0, DATA), 0x42 },
+		// Master code
+		{ Addr(0, 3, 0, DATA), 0 },
+		{ Addr(0, 0, 0, DATA + 1), 0x43 },
+	});
+
+	EXPECT_FALSE(RunCompiledCode(CompileCode(code)));
+	EXPECT_EQ(1, s_alerts);
+	EXPECT_EQ(0x42, Memory::Read_U8(0x80000000 | DATA));
+	EXPECT_EQ(0, Memory::Read_U8(0x80000000 | (DATA + 1)));
+
+	// Behind a false conditional nothing is reported
+	const ARCompiledCode skipped = CompileCode(MakeCode({
+		{ Addr(1, 0, 0, DATA + 2), 1 },
+		{ 0, 0x60000000 },
+	}));
+	EXPECT_TRUE(RunCompiledCode(skipped));
+	EXPECT_EQ(1, s_alerts);
+}
+
+TEST_F(ActionReplayTest, WritesAreMarked)
+{
+	Memory::SetWriteWatch(true);
+	ASSERT_TRUE(Memory::IsWriteWatchEnabled());
+
+	const u64 seq = Memory::WatchRange(0x80000000 | DATA, 0x1000);
+	const ARCompiledCode compiled = CompileCode(MakeCode({ { Addr(0, 2, 2, DATA + 0x800), 1 } }));
+	EXPECT_TRUE(RunCompiledCode(compiled));
+	EXPECT_FALSE(Memory::IsRangeUnchanged(0x80000000 | DATA, 0x1000, seq));
+
+	Memory::SetWriteWatch(false);
+}
+
+// Time a frame of a large code list, interpreted and compiled
+TEST_F(ActionReplayTest, Benchmark)
+{
+	const int NUM_CODES = 1000;
+	const int NUM_FRAMES = 100;
+
+	std::mt19937 rng(5678);
+	std::vector<ARCode> codes;
+	for (int i = 0; i < NUM_CODES; ++i)
+		codes.push_back(TypicalCode(rng, 16));
+	RandomizeMemory(rng);
+	std::vector<ARCompiledCode> compiled;
+	for (const ARCode& code : codes)
+		compiled.push_back(CompileCode(code));
+
+	// Once to get past RunCode's logging on its first run
+	RunCode(codes[0]);
+
+	auto start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < NUM_FRAMES; ++frame)
+	{
+		for (const ARCode& code : codes)
+			RunCode(code);
+	}
+	auto end = std::chrono::steady_clock::now();
+	const double interpreted_us = std::chrono::duration<double, std::micro>(end - start).count() / NUM_FRAMES;
+
+	start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < NUM_FRAMES; ++frame)
+	{
+		for (const ARCompiledCode& code : compiled)
+			RunCompiledCode(code);
+	}
+	end = std::chrono::steady_clock::now();
+	const double compiled_us = std::chrono::duration<double, std::micro>(end - start).count() / NUM_FRAMES;
+
+	printf("%i codes: %.0f us per frame with RunCode, %.0f us compiled\n", NUM_CODES, interpreted_us, compiled_us);
+	EXPECT_EQ(0, s_alerts);
+}
@@ -0,0 +1,49 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/EXI.h"
+#include "Core/HW/EXI_Device.h"
+#include "Core/HW/Memmap.h"
+#include "VideoCommon/VideoBackendBase.h"
+
+#include "CoreTestUtil.h"
+
+namespace CoreTestUtil
+{
+
+void Init(bool fastmem)
+{
+	SConfig::Init();
+	SCoreStartupParameter& params = SConfig::GetInstance().m_LocalCoreStartupParameter;
+	params.bWii = false;
+	params.bMMU = false;
+	params.bTLBHack = false;
+	params.bSkipIdle = false;
+	params.bEnableDebugging = false;
+	params.bFastmem = fastmem;
+	Core::g_CoreStartupParameter = params;
+
+	for (TEXIDevices& device : SConfig::GetInstance().m_EXIDevice)
+		device = EXIDEVICE_NONE;
+
+	// Memory::Init registers every MMIO handler, which needs a video
+	// backend and the EXI channels to exist
+	VideoBackend::PopulateList();
+	VideoBackend::ActivateBackend("Software Renderer");
+	CoreTiming::Init();
+	ExpansionInterface::Init();
+	Memory::Init();
+}
+
+void Shutdown()
+{
+	Memory::Shutdown();
+	CoreTiming::Shutdown();
+	SConfig::Shutdown();
+}
+
+}
@@ -0,0 +1,18 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Brings up the parts of Core that tests running the CPU or touching
+// emulated memory need, without a frontend (see StubHost.cpp).
+
+#pragma once
+
+namespace CoreTestUtil
+{
+
+// A GameCube without MMU or EXI devices, with the Software Renderer as video
+// backend. Leaves memory mapped and CoreTiming running.
+void Init(bool fastmem);
+void Shutdown();
+
+}
@@ -0,0 +1,258 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/ChunkFile.h"
+#include "Common/CommonTypes.h"
+#include "Common/MsgHandler.h"
+#include "Common/StringUtil.h"
+#include "Core/CoreTiming.h"
+
+class VideoBackend;
+
+// CoreTiming.cpp is built into this test directly, these stand in for the rest of Core.
+namespace Core
+{
+bool IsCPUThread() { return true; }
+}
+VideoBackend* g_video_backend = nullptr;
+
+static std::vector<u64> s_fired;
+
+static int s_alerts;
+
+static bool CountAlert(const char* caption, const char* text, bool yes_no, int style)
+{
+	++s_alerts;
+	return true;
+}
+
+static void RecordCallback(u64 userdata, int cyclesLate)
+{
+	s_fired.push_back(userdata);
+}
+
+// Pretends the CPU executed the given amount of cycles since the last Advance().
+static void AdvanceCycles(int cycles)
+{
+	CoreTiming::downcount = CoreTiming::slicelength - cycles;
+	CoreTiming::Advance();
+}
+
+class CoreTimingTest : public testing::Test
+{
+protected:
+	virtual void SetUp() override
+	{
+		s_fired.clear();
+		CoreTiming::Init();
+		m_event = CoreTiming::RegisterEvent("record", &RecordCallback);
+	}
+
+	virtual void TearDown() override
+	{
+		CoreTiming::ClearPendingEvents();
+		CoreTiming::Shutdown();
+	}
+
+	int m_event;
+};
+
+TEST_F(CoreTimingTest, RunsInTimeOrder)
+{
+	CoreTiming::ScheduleEvent(300, m_event, 3);
+	CoreTiming::ScheduleEvent(100, m_event, 1);
+	CoreTiming::ScheduleEvent(200, m_event, 2);
+
+	AdvanceCycles(150);
+	EXPECT_EQ(std::vector<u64>({ 1 }), s_fired);
+
+	AdvanceCycles(1000);
+	EXPECT_EQ(std::vector<u64>({ 1, 2, 3 }), s_fired);
+	EXPECT_FALSE(CoreTiming::IsScheduled(m_event));
+}
+
+TEST_F(CoreTimingTest, EqualTimesRunInScheduleOrder)
+{
+	for (u64 i = 0; i < 64; ++i)
+		CoreTiming::ScheduleEvent(100, m_event, i);
+
+	AdvanceCycles(100);
+	ASSERT_EQ(64u, s_fired.size());
+	for (u64 i = 0; i < 64; ++i)
+		EXPECT_EQ(i, s_fired[i]);
+}
+
+TEST_F(CoreTimingTest, CancelByHandle)
+{
+	CoreTiming::ScheduleEvent(100, m_event, 1);
+	CoreTiming::EventHandle handle = CoreTiming::ScheduleEvent(50, m_event, 2);
+	CoreTiming::ScheduleEvent(200, m_event, 3);
+
+	CoreTiming::CancelEvent(handle);
+	AdvanceCycles(1000);
+	EXPECT_EQ(std::vector<u64>({ 1, 3 }), s_fired);
+
+	// Handles of events which already ran must not affect new events reusing their slot.
+	s_fired.clear();
+	CoreTiming::ScheduleEvent(100, m_event, 4);
+	CoreTiming::CancelEvent(handle);
+	AdvanceCycles(1000);
+	EXPECT_EQ(std::vector<u64>({ 4 }), s_fired);
+}
+
+TEST_F(CoreTimingTest, CancelledEventsDontBlockUnregister)
+{
+	// Cancelled events stay in the heap until they would run
+	CoreTiming::CancelEvent(CoreTiming::ScheduleEvent(200, m_event, 1));
+	CoreTiming::CancelEvent(CoreTiming::ScheduleEvent(100, m_event, 2));
+
+	s_alerts = 0;
+	RegisterMsgAlertHandler(&CountAlert);
+	CoreTiming::UnregisterAllEvents();
+	EXPECT_EQ(0, s_alerts);
+	m_event = CoreTiming::RegisterEvent("record", &RecordCallback);
+
+	AdvanceCycles(1000);
+	EXPECT_TRUE(s_fired.empty());
+}
+
+TEST_F(CoreTimingTest, RemoveEventByType)
+{
+	int other = CoreTiming::RegisterEvent("other", &RecordCallback);
+
+	CoreTiming::ScheduleEvent(100, m_event, 1);
+	CoreTiming::ScheduleEvent(150, other, 2);
+	CoreTiming::ScheduleEvent(200, m_event, 3);
+
+	CoreTiming::RemoveEvent(m_event);
+	EXPECT_FALSE(CoreTiming::IsScheduled(m_event));
+	EXPECT_TRUE(CoreTiming::IsScheduled(other));
+
+	AdvanceCycles(1000);
+	EXPECT_EQ(std::vector<u64>({ 2 }), s_fired);
+}
+
+TEST_F(CoreTimingTest, DoStateKeepsOrder)
+{
+	CoreTiming::ScheduleEvent(200, m_event, 1);
+	CoreTiming::ScheduleEvent(100, m_event, 2);
+	CoreTiming::ScheduleEvent(200, m_event, 3);
+	CoreTiming::CancelEvent(CoreTiming::ScheduleEvent(150, m_event, 4));
+
+	u8* ptr = nullptr;
+	PointerWrap p_measure(&ptr, PointerWrap::MODE_MEASURE);
+	CoreTiming::DoState(p_measure);
+	size_t size = (size_t)ptr;
+
+	std::vector<u8> buffer(size);
+	ptr = &buffer[0];
+	PointerWrap p_write(&ptr, PointerWrap::MODE_WRITE);
+	CoreTiming::DoState(p_write);
+
+	CoreTiming::ClearPendingEvents();
+	EXPECT_FALSE(CoreTiming::IsScheduled(m_event));
+
+	ptr = &buffer[0];
+	PointerWrap p_read(&ptr, PointerWrap::MODE_READ);
+	CoreTiming::DoState(p_read);
+	EXPECT_EQ(size, (size_t)(ptr - &buffer[0]));
+
+	AdvanceCycles(1000);
+	EXPECT_EQ(std::vector<u64>({ 2, 1, 3 }), s_fired);
+}
+
+TEST_F(CoreTimingTest, ThreadsafeEventsKeepPerThreadOrder)
+{
+	// Enough events to overflow the lockless queue.
+	const u64 num_threads = 3;
+	const u64 num_events = 5000;
+
+	std::vector<std::thread> threads;
+	for (u64 t = 0; t < num_threads; ++t)
+	{
+		threads.emplace_back([this, t, num_events]() {
+			for (u64 i = 0; i < num_events; ++i)
+				CoreTiming::ScheduleEvent_Threadsafe(0, m_event, (t << 32) | i);
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+
+	AdvanceCycles(100);
+	ASSERT_EQ(num_threads * num_events, s_fired.size());
+
+	std::vector<u64> next(num_threads, 0);
+	for (u64 v : s_fired)
+	{
+		u64 t = v >> 32;
+		ASSERT_LT(t, num_threads);
+		EXPECT_EQ(next[t], v & 0xFFFFFFFF);
+		next[t]++;
+	}
+}
+
+// Rough simulation of the periodic events registered by SystemTimers plus the short lived
+// interrupt events the hardware modules schedule and remove. Prints the cost per event.
+static const int BENCH_PERIODS[] = {
+	15428,  // VI line
+	6000,   // DSP
+	121500, // AI DMA
+	128000, // SI poll
+	48600,  // CP
+	486000, // Throttle
+};
+static int s_bench_types[sizeof(BENCH_PERIODS) / sizeof(BENCH_PERIODS[0])];
+static int s_bench_oneshot;
+static u64 s_bench_count;
+
+static void BenchPeriodicCallback(u64 userdata, int cyclesLate)
+{
+	s_bench_count++;
+	CoreTiming::ScheduleEvent(BENCH_PERIODS[userdata] - cyclesLate, s_bench_types[userdata], userdata);
+
+	// Interrupt style events which get rescheduled before they fire.
+	CoreTiming::RemoveEvent(s_bench_oneshot);
+	CoreTiming::ScheduleEvent(BENCH_PERIODS[userdata] / 2, s_bench_oneshot);
+}
+
+static void BenchOneshotCallback(u64 userdata, int cyclesLate)
+{
+	s_bench_count++;
+}
+
+TEST_F(CoreTimingTest, Benchmark)
+{
+	const int num_types = sizeof(BENCH_PERIODS) / sizeof(BENCH_PERIODS[0]);
+	for (int i = 0; i < num_types; ++i)
+	{
+		s_bench_types[i] = CoreTiming::RegisterEvent(StringFromFormat("bench%d", i), &BenchPeriodicCallback);
+		CoreTiming::ScheduleEvent(BENCH_PERIODS[i], s_bench_types[i], i);
+	}
+	s_bench_oneshot = CoreTiming::RegisterEvent("bench_oneshot", &BenchOneshotCallback);
+	s_bench_count = 0;
+
+	// Ten seconds of emulated time on a GameCube.
+	const s64 total_cycles = 486000000LL * 10;
+	s64 cycles = 0;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	while (cycles < total_cycles)
+	{
+		cycles += CoreTiming::slicelength;
+		AdvanceCycles(CoreTiming::slicelength);
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+
+	double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	printf("CoreTiming: %llu events in %.2f ms, %.1f ns/event\n",
+	       (unsigned long long)s_bench_count, ns / 1000000.0, ns / s_bench_count);
+
+	EXPECT_GT(s_bench_count, 0u);
+}
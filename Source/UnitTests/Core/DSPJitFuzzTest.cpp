@@ -0,0 +1,436 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Runs random straight line DSP code under the DSP interpreter and the
+// DSPEmitter, starting from identical state, and compares the registers and
+// DRAM afterwards.
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/MemoryUtil.h"
+#include "Common/StringUtil.h"
+#include "Core/ConfigManager.h"
+#include "Core/DSP/DSPAnalyzer.h"
+#include "Core/DSP/DSPCodeUtil.h"
+#include "Core/DSP/DSPCore.h"
+#include "Core/DSP/DSPEmitter.h"
+#include "Core/DSP/DSPInterpreter.h"
+#include "Core/DSP/DSPTables.h"
+
+// After the emitter, which has an instruction called TEST
+#include <gtest/gtest.h>
+
+namespace
+{
+
+const u16 HALT = 0x0021;
+const int MAX_STREAM_LENGTH = 32;
+
+struct DSPState
+{
+	DSP_Regs r;
+	u16 dram[DSP_DRAM_SIZE];
+};
+
+struct DSPTestCase
+{
+	std::vector<u16> code;
+	DSPState initial;
+};
+
+// Decodes a register operand the same way the disassembler does
+int RegisterParam(const param2_t& param, u16 op1, u16 op2)
+{
+	u16 val = (param.loc >= 1) ? op2 : op1;
+	val &= param.mask;
+	if (param.lshift < 0)
+		val <<= -param.lshift;
+	else
+		val >>= param.lshift;
+	return val | (param.type & P_REGS_MASK) >> 8;
+}
+
+// The generated code never branches, never touches the stacks or the
+// hardware registers, and only moves the address registers by small steps,
+// so all of its memory accesses stay inside DRAM.
+bool IsSafe(const DSPOPCTemplate& op, u16 op1, u16 op2)
+{
+	if (op.branch || op.opcode == HALT)
+		return false;
+
+	const std::string name = op.name;
+	if (name == "CW" || name.find("LOOP") != std::string::npos ||
+	    name == "SRS" || name == "LRS" || name == "SI")
+		return false;
+
+	// These only add small values to the address registers
+	const bool moves_ar = name == "DAR" || name == "IAR" || name == "SUBARN" || name == "ADDARN";
+	for (int i = 0; i < op.param_count; i++)
+	{
+		const param2_t& param = op.params[i];
+		if (param.type == P_ADDR_I || param.type == P_ADDR_D)
+			return false;
+		if ((param.type & P_REG) && (param.type & P_REF) != P_REF && !moves_ar)
+		{
+			// Address, index, wrap and stack registers, config and SR
+			int reg = RegisterParam(param, op1, op2);
+			if (reg < 0x10 || reg == 0x12 || reg == 0x13)
+				return false;
+		}
+	}
+	return true;
+}
+
+struct DSPGenerator
+{
+	std::mt19937 rng;
+	std::vector<const DSPOPCTemplate*> templates;
+
+	explicit DSPGenerator(u32 seed) : rng(seed)
+	{
+		for (int i = 0; i < opcodes_size; i++)
+			templates.push_back(&opcodes[i]);
+	}
+
+	u32 Next(u32 range) { return rng() % range; }
+
+	void Inst(std::vector<u16>& code)
+	{
+		while (true)
+		{
+			const DSPOPCTemplate* op = templates[Next((u32)templates.size())];
+			const u16 op1 = op->opcode | (rng() & ~op->opcode_mask);
+			// Direct memory operands stay in DRAM
+			const u16 op2 = Next(DSP_DRAM_SIZE);
+			if (GetOpTemplate(op1) != op || !IsSafe(*op, op1, op2))
+				continue;
+
+			if (op->extended)
+			{
+				const DSPOPCTemplate* ext = extOpTable[(op1 >> 12) == 0x3 ? (op1 & 0x7F) : (op1 & 0xFF)];
+				if (ext == &cw)
+					continue;
+			}
+
+			code.push_back(op1);
+			if (op->size == 2)
+				code.push_back(op2);
+			return;
+		}
+	}
+
+	DSPTestCase Generate()
+	{
+		DSPTestCase test;
+		const u32 length = 1 + Next(MAX_STREAM_LENGTH);
+		for (u32 i = 0; i < length; i++)
+			Inst(test.code);
+		test.code.push_back(HALT);
+
+		// Each instruction moves an address register by at most two index
+		// steps, which keeps them well inside DRAM from here
+		DSP_Regs& r = test.initial.r;
+		memset(&r, 0, sizeof(r));
+		for (int i = 0; i < 4; i++)
+		{
+			r.ar[i] = 0x600 + Next(0x400);
+			r.ix[i] = (u16)((int)Next(33) - 16);
+			r.wr[i] = 0xFFFF;
+		}
+		r.cr = 0xFF;
+		r.sr = (rng() & (SR_CMP_MASK | SR_LOGIC_ZERO)) |
+		       (Next(2) ? SR_MUL_MODIFY : 0) | (Next(2) ? SR_40_MODE_BIT : 0) | (Next(2) ? SR_MUL_UNSIGNED : 0);
+		r.prod.l = rng();
+		r.prod.m = rng();
+		r.prod.h = (u16)(s8)rng();
+		r.prod.m2 = rng();
+		for (int i = 0; i < 2; i++)
+		{
+			r.ax[i].val = rng();
+			r.ac[i].l = rng();
+			r.ac[i].m = rng();
+			r.ac[i].h = (u16)(s8)rng();
+		}
+		for (u16& word : test.initial.dram)
+			word = rng();
+		return test;
+	}
+};
+
+void LoadState(const DSPTestCase& test)
+{
+	for (int i = 0; i < DSP_IRAM_SIZE; i++)
+		g_dsp.iram[i] = HALT;
+	memcpy(g_dsp.iram, &test.code[0], test.code.size() * sizeof(u16));
+	memcpy(g_dsp.dram, test.initial.dram, sizeof(test.initial.dram));
+
+	g_dsp.r = test.initial.r;
+	g_dsp.pc = 0;
+	g_dsp.cr = 0;
+	g_dsp.exceptions = 0;
+	g_dsp.external_interrupt_waiting = false;
+	for (u8& ptr : g_dsp.reg_stack_ptr)
+		ptr = 0;
+
+	if (dspjit)
+		dspjit->ClearIRAM();
+	DSPAnalyzer::Analyze();
+
+	// The JIT normally only computes the flags that a conditional branch
+	// could see. Have it compute them everywhere, so they can be compared.
+	for (size_t i = 0; i < test.code.size(); i++)
+		DSPAnalyzer::code_flags[i] |= DSPAnalyzer::CODE_UPDATE_SR;
+}
+
+void SaveState(DSPState& s)
+{
+	s.r = g_dsp.r;
+	memcpy(s.dram, g_dsp.dram, sizeof(s.dram));
+}
+
+std::string Disassemble(const DSPTestCase& test)
+{
+	std::string text;
+	for (size_t i = 0; i < test.code.size(); i++)
+	{
+		const DSPOPCTemplate* op = GetOpTemplate(test.code[i]);
+		std::string name = op->name;
+		if (op->extended)
+			name += StringFromFormat("'%s", extOpTable[(test.code[i] >> 12) == 0x3 ? (test.code[i] & 0x7F) : (test.code[i] & 0xFF)]->name);
+		if (op->size == 2)
+		{
+			text += StringFromFormat("%04x: %04x %04x  %s\n", (u32)i, test.code[i], test.code[i + 1], name.c_str());
+			i++;
+		}
+		else
+		{
+			text += StringFromFormat("%04x: %04x       %s\n", (u32)i, test.code[i], name.c_str());
+		}
+	}
+	return text;
+}
+
+// Only the low 40 bits of the accumulators and the product exist, the rest
+// of the 64 bit fields is whatever the last write left there
+u64 Acc(const DSP_Regs& r, int i)
+{
+	return r.ac[i].val & 0xFFFFFFFFFFULL;
+}
+
+u64 Prod(const DSP_Regs& r)
+{
+	s64 val = (s64)(s8)(u8)r.prod.h << 32;
+	val += ((s64)r.prod.m + r.prod.m2) << 16 | r.prod.l;
+	return (u64)val & 0xFFFFFFFFFFULL;
+}
+
+// The PC and the stacks are not compared, the JIT's HALT pops the call
+// stack where the interpreter stays on the instruction.
+bool Compare(const DSPTestCase& test, const DSPState& expected, const DSPState& actual, int index)
+{
+	const DSP_Regs& e = expected.r;
+	const DSP_Regs& a = actual.r;
+	std::string diff;
+	for (int i = 0; i < 4; i++)
+	{
+		if (e.ar[i] != a.ar[i])
+			diff += StringFromFormat("ar%d: %04x != %04x\n", i, e.ar[i], a.ar[i]);
+		if (e.ix[i] != a.ix[i])
+			diff += StringFromFormat("ix%d: %04x != %04x\n", i, e.ix[i], a.ix[i]);
+		if (e.wr[i] != a.wr[i])
+			diff += StringFromFormat("wr%d: %04x != %04x\n", i, e.wr[i], a.wr[i]);
+	}
+	if (e.cr != a.cr)
+		diff += StringFromFormat("cr: %04x != %04x\n", e.cr, a.cr);
+	if (e.sr != a.sr)
+		diff += StringFromFormat("sr: %04x != %04x\n", e.sr, a.sr);
+	if (Prod(e) != Prod(a))
+		diff += StringFromFormat("prod: %010llx != %010llx\n", (unsigned long long)Prod(e), (unsigned long long)Prod(a));
+	for (int i = 0; i < 2; i++)
+	{
+		if (e.ax[i].val != a.ax[i].val)
+			diff += StringFromFormat("ax%d: %08x != %08x\n", i, e.ax[i].val, a.ax[i].val);
+		if (Acc(e, i) != Acc(a, i))
+			diff += StringFromFormat("ac%d: %010llx != %010llx\n", i, (unsigned long long)Acc(e, i), (unsigned long long)Acc(a, i));
+	}
+	for (int i = 0; i < DSP_DRAM_SIZE; i++)
+	{
+		if (expected.dram[i] != actual.dram[i])
+		{
+			diff += StringFromFormat("dram at %04x: %04x != %04x\n", i, expected.dram[i], actual.dram[i]);
+			break;
+		}
+	}
+
+	EXPECT_TRUE(diff.empty()) << "DSPEmitter differs from the interpreter on stream " << index << ":\n"
+	                          << diff << "code:\n" << Disassemble(test);
+	return diff.empty();
+}
+
+class DSPJitFuzzTest : public testing::Test
+{
+protected:
+	static void SetUpTestCase()
+	{
+		SConfig::Init();
+		SConfig::GetInstance().m_LocalCoreStartupParameter.bDSPThread = false;
+
+		// No ROMs, nothing generated runs code from them
+		g_dsp.irom = (u16*)AllocateMemoryPages(DSP_IROM_BYTE_SIZE);
+		g_dsp.iram = (u16*)AllocateMemoryPages(DSP_IRAM_BYTE_SIZE);
+		g_dsp.dram = (u16*)AllocateMemoryPages(DSP_DRAM_BYTE_SIZE);
+		g_dsp.coef = (u16*)AllocateMemoryPages(DSP_COEF_BYTE_SIZE);
+		memset(g_dsp.irom, 0, DSP_IROM_BYTE_SIZE);
+		memset(g_dsp.coef, 0, DSP_COEF_BYTE_SIZE);
+		InitInstructionTable();
+	}
+
+	static void TearDownTestCase()
+	{
+		FreeMemoryPages(g_dsp.irom, DSP_IROM_BYTE_SIZE);
+		FreeMemoryPages(g_dsp.iram, DSP_IRAM_BYTE_SIZE);
+		FreeMemoryPages(g_dsp.dram, DSP_DRAM_BYTE_SIZE);
+		FreeMemoryPages(g_dsp.coef, DSP_COEF_BYTE_SIZE);
+		g_dsp.irom = g_dsp.iram = g_dsp.dram = g_dsp.coef = nullptr;
+		SConfig::Shutdown();
+	}
+};
+
+}
+
+TEST_F(DSPJitFuzzTest, MatchesInterpreter)
+{
+	const int num_streams = 3000;
+
+	std::vector<DSPTestCase> tests;
+	DSPGenerator generator(20140602);
+	for (int i = 0; i < num_streams; i++)
+		tests.push_back(generator.Generate());
+
+	std::vector<DSPState> expected(num_streams);
+	for (int i = 0; i < num_streams; i++)
+	{
+		LoadState(tests[i]);
+		for (int steps = 0; !(g_dsp.cr & CR_HALT) && steps < 1000; steps++)
+			DSPInterpreter::Step();
+		SaveState(expected[i]);
+		ASSERT_TRUE((g_dsp.cr & CR_HALT) != 0) << "interpreter did not reach the end of stream " << i;
+	}
+
+	dspjit = new DSPEmitter();
+	int failures = 0;
+	for (int i = 0; i < num_streams && failures < 5; i++)
+	{
+		LoadState(tests[i]);
+		DSPCore_RunCycles(1000);
+
+		DSPState actual;
+		SaveState(actual);
+		EXPECT_TRUE((g_dsp.cr & CR_HALT) != 0) << "DSPEmitter did not reach the end of stream " << i;
+		if (!Compare(tests[i], expected[i], actual, i))
+			failures++;
+	}
+	delete dspjit;
+	dspjit = nullptr;
+}
+
+namespace
+{
+
+// Loops through a call, a conditional jump back into another block and a
+// block that jumps to itself, so the JIT links blocks in every way it can
+const char* const LINKED_UCODE =
+	"	clr $ACC0\n"
+	"	clr $ACC1\n"
+	"	lri $AR0, #0x0100\n"
+	"	lri $AC1.M, #%d\n"
+	"loop:\n"
+	"	call add_one\n"
+	"	decm $AC1.M\n"
+	"	jnz loop\n"
+	"	lri $AC1.M, #30\n"
+	"tight:\n"
+	"	addis $AC0.M, #3\n"
+	"	decm $AC1.M\n"
+	"	jnz tight\n"
+	"	sr @0x0010, $AC0.M\n"
+	"	halt\n"
+	"add_one:\n"
+	"	addis $AC0.M, #1\n"
+	"	srri @$AR0, $AC0.M\n"
+	"	ret\n";
+
+DSPTestCase AssembleTest(int iterations)
+{
+	DSPTestCase test;
+	EXPECT_TRUE(Assemble(StringFromFormat(LINKED_UCODE, iterations), test.code));
+	memset(&test.initial, 0, sizeof(test.initial));
+	test.initial.r.cr = 0xFF;
+	for (int i = 0; i < 4; i++)
+		test.initial.r.wr[i] = 0xFFFF;
+	return test;
+}
+
+DSPState RunInterpreter(const DSPTestCase& test)
+{
+	DSPState state;
+	LoadState(test);
+	for (int steps = 0; !(g_dsp.cr & CR_HALT) && steps < 10000; steps++)
+		DSPInterpreter::Step();
+	SaveState(state);
+	return state;
+}
+
+// Short slices, so that the linked jumps run out of cycles now and then
+DSPState RunJit(const DSPTestCase& test)
+{
+	DSPState state;
+	LoadState(test);
+	for (int slices = 0; !(g_dsp.cr & CR_HALT) && slices < 10000; slices++)
+		DSPCore_RunCycles(7);
+	EXPECT_TRUE((g_dsp.cr & CR_HALT) != 0) << "DSPEmitter did not reach the end";
+	SaveState(state);
+	return state;
+}
+
+}
+
+TEST_F(DSPJitFuzzTest, LinkedBlocksMatchInterpreter)
+{
+	DSPTestCase test = AssembleTest(20);
+	DSPState expected = RunInterpreter(test);
+	EXPECT_EQ(20 + 90, expected.dram[0x10]);
+
+	dspjit = new DSPEmitter();
+	Compare(test, expected, RunJit(test), 0);
+	delete dspjit;
+	dspjit = nullptr;
+}
+
+TEST_F(DSPJitFuzzTest, ReloadedUCodeIsNotRecompiled)
+{
+	DSPTestCase first = AssembleTest(20);
+	DSPTestCase second = AssembleTest(25);
+	DSPState first_expected = RunInterpreter(first);
+	DSPState second_expected = RunInterpreter(second);
+
+	dspjit = new DSPEmitter();
+	Compare(first, first_expected, RunJit(first), 0);
+	Compare(second, second_expected, RunJit(second), 1);
+
+	u32 compiled = dspjit->compileCount;
+	Compare(first, first_expected, RunJit(first), 2);
+	EXPECT_EQ(compiled, dspjit->compileCount);
+
+	// Everything still works after running out of code space
+	dspjit->ClearIRAMandDSPJITCodespaceReset();
+	Compare(second, second_expected, RunJit(second), 3);
+	EXPECT_LT(compiled, dspjit->compileCount);
+	delete dspjit;
+	dspjit = nullptr;
+}
@@ -0,0 +1,216 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "VideoCommon/FrameDumpQueue.h"
+#include "VideoCommon/Statistics.h"
+
+namespace
+{
+
+const int WIDTH = 640;
+const int HEIGHT = 528;
+const size_t FRAME_SIZE = WIDTH * HEIGHT * 3;
+
+// Stands in for converting and encoding a frame
+void SlowDump(std::chrono::microseconds time)
+{
+	auto end = std::chrono::steady_clock::now() + time;
+	while (std::chrono::steady_clock::now() < end)
+		std::this_thread::yield();
+}
+
+bool AddFrame(FrameDumpQueue& queue, const std::vector<u8>& data)
+{
+	FrameDumpQueue::Frame* frame = queue.Acquire(WIDTH, HEIGHT, data.size());
+	if (!frame)
+		return false;
+	memcpy(frame->data.data(), data.data(), data.size());
+	queue.Submit(frame);
+	return true;
+}
+
+}
+
+TEST(FrameDumpQueue, ProcessesEveryFrameInOrder)
+{
+	std::vector<u64> numbers;
+	std::vector<u8> first_bytes;
+	{
+		FrameDumpQueue queue(4, false, [&](FrameDumpQueue::Frame& frame) {
+			EXPECT_EQ(WIDTH, frame.width);
+			EXPECT_EQ(HEIGHT, frame.height);
+			numbers.push_back(frame.number);
+			first_bytes.push_back(frame.data[0]);
+			SlowDump(std::chrono::microseconds(100));
+		});
+
+		std::vector<u8> data(FRAME_SIZE);
+		for (int i = 0; i < 50; ++i)
+		{
+			data[0] = (u8)i;
+			EXPECT_TRUE(AddFrame(queue, data));
+		}
+
+		queue.Flush();
+		FrameDumpQueue::Stats stats = queue.GetStats();
+		EXPECT_EQ(50u, stats.frames_submitted);
+		EXPECT_EQ(50u, stats.frames_processed);
+		EXPECT_EQ(0u, stats.frames_dropped);
+		EXPECT_EQ(0, stats.depth);
+		EXPECT_LE(stats.max_depth, 4);
+	}
+
+	ASSERT_EQ(50u, numbers.size());
+	for (int i = 0; i < 50; ++i)
+	{
+		EXPECT_EQ((u64)i, numbers[i]);
+		EXPECT_EQ((u8)i, first_bytes[i]);
+	}
+}
+
+TEST(FrameDumpQueue, DropsWhenFull)
+{
+	std::atomic<bool> blocked(true);
+	std::vector<u64> numbers;
+	FrameDumpQueue queue(3, true, [&](FrameDumpQueue::Frame& frame) {
+		while (blocked)
+			std::this_thread::yield();
+		numbers.push_back(frame.number);
+	});
+
+	std::vector<u8> data(16);
+	for (int i = 0; i < 3; ++i)
+		EXPECT_TRUE(AddFrame(queue, data));
+	EXPECT_FALSE(AddFrame(queue, data));
+	EXPECT_FALSE(AddFrame(queue, data));
+
+	blocked = false;
+	queue.Flush();
+	EXPECT_TRUE(AddFrame(queue, data));
+	queue.Flush();
+
+	// The dropped frames leave a gap in the numbers
+	ASSERT_EQ(4u, numbers.size());
+	EXPECT_EQ(5u, numbers[3]);
+
+	FrameDumpQueue::Stats stats = queue.GetStats();
+	EXPECT_EQ(2u, stats.frames_dropped);
+	EXPECT_EQ(4u, stats.frames_submitted);
+	EXPECT_EQ(3, stats.max_depth);
+}
+
+TEST(FrameDumpQueue, ReusesBuffers)
+{
+	std::set<const u8*> buffers;
+	FrameDumpQueue queue(2, false, [&](FrameDumpQueue::Frame& frame) {
+		buffers.insert(frame.data.data());
+	});
+
+	std::vector<u8> big(FRAME_SIZE), small(FRAME_SIZE / 2);
+	for (int i = 0; i < 20; ++i)
+	{
+		EXPECT_TRUE(AddFrame(queue, i & 1 ? small : big));
+		queue.Flush();
+	}
+
+	EXPECT_LE(buffers.size(), 2u);
+}
+
+TEST(FrameDumpQueue, StopDumpsQueuedFrames)
+{
+	int processed = 0;
+	{
+		FrameDumpQueue queue(8, false, [&](FrameDumpQueue::Frame& frame) {
+			SlowDump(std::chrono::microseconds(1000));
+			++processed;
+		});
+		std::vector<u8> data(16);
+		for (int i = 0; i < 8; ++i)
+			AddFrame(queue, data);
+	}
+	EXPECT_EQ(8, processed);
+}
+
+// Like AVIDump: a dropping conversion queue feeding an encoder queue, which
+// takes over the frame numbers as timestamps
+TEST(FrameDumpPipeline, KeepsGaps)
+{
+	std::atomic<bool> blocked(true);
+	std::vector<u64> timestamps;
+	std::vector<u8> values;
+	{
+		FrameDumpPipeline pipeline(2, true, 2, 2, 4,
+			[&](const FrameDumpQueue::Frame& in, FrameDumpQueue::Frame& out) {
+				while (blocked)
+					std::this_thread::yield();
+				EXPECT_EQ(4u, out.data.size());
+				out.data[0] = in.data[0] + 1;
+			},
+			[&](FrameDumpQueue::Frame& frame) {
+				timestamps.push_back(frame.number);
+				values.push_back(frame.data[0]);
+			});
+
+		std::vector<u8> data(16 * 16 * 3);
+		for (int i = 0; i < 3; ++i)
+		{
+			data[0] = i;
+			pipeline.AddFrame(data.data(), 16, 16);
+		}
+		blocked = false;
+		pipeline.Flush();
+		data[0] = 3;
+		pipeline.AddFrame(data.data(), 16, 16);
+	}
+
+	// Frame 2 was dropped, the encoder sees 0 1 3
+	ASSERT_EQ(3u, timestamps.size());
+	EXPECT_EQ(0u, timestamps[0]);
+	EXPECT_EQ(1u, timestamps[1]);
+	EXPECT_EQ(3u, timestamps[2]);
+	EXPECT_EQ(1, values[0]);
+	EXPECT_EQ(2, values[1]);
+	EXPECT_EQ(4, values[2]);
+}
+
+TEST(FrameDumpPipeline, Stats)
+{
+	std::atomic<bool> blocked(true);
+	Statistics stats = {};
+	FrameDumpPipeline pipeline(2, true, 2, 2, 4,
+		[&](const FrameDumpQueue::Frame& in, FrameDumpQueue::Frame& out) {
+			while (blocked)
+				std::this_thread::yield();
+		},
+		[](FrameDumpQueue::Frame& frame) {});
+
+	std::vector<u8> data(16 * 16 * 3);
+	for (int i = 0; i < 3; ++i)
+		pipeline.AddFrame(data.data(), 16, 16);
+	pipeline.ReportStats(stats);
+	EXPECT_EQ(1, stats.numFrameDumpDropped);
+	EXPECT_LT(0, stats.numFrameDumpQueued);
+	EXPECT_LE(stats.numFrameDumpQueued, stats.numFrameDumpQueuedMax);
+
+	blocked = false;
+	pipeline.Flush();
+	pipeline.ReportStats(stats);
+	EXPECT_EQ(0, stats.numFrameDumpQueued);
+	EXPECT_LT(0, stats.numFrameDumpQueuedMax);
+
+	// What AVIDump::Stop leaves behind, the overlay hides the frame dump lines
+	FrameDumpPipeline::ClearStats(stats);
+	EXPECT_EQ(0, stats.numFrameDumpQueued);
+	EXPECT_EQ(0, stats.numFrameDumpQueuedMax);
+	EXPECT_EQ(0, stats.numFrameDumpDropped);
+}
@@ -0,0 +1,164 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/StringUtil.h"
+#include "Core/ConfigManager.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/HW/Memmap.h"
+#include "Core/PowerPC/JitInterface.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/JitCommon/JitBase.h"
+
+#include "GekkoTest.h"
+#include "PowerPCDisasm.h"
+
+// After the emitter, which has an instruction called TEST
+#include <gtest/gtest.h>
+
+namespace GekkoTest
+{
+
+void AddEndLoop(TestCase& test)
+{
+	test.end_address = CODE_ADDRESS + (u32)test.code.size() * 4;
+	test.code.push_back(18 << 26 | 4);
+	test.code.push_back(18 << 26 | (-4 & 0x3FFFFFC));
+}
+
+TestCase Block(const std::vector<u32>& body)
+{
+	TestCase test;
+	test.code = body;
+	AddEndLoop(test);
+	memset(&test.initial, 0, sizeof(test.initial));
+	test.initial.pc = CODE_ADDRESS;
+	return test;
+}
+
+void SetCore(int core)
+{
+	SCoreStartupParameter& params = SConfig::GetInstance().m_LocalCoreStartupParameter;
+	params.iCPUCore = core;
+	Core::g_CoreStartupParameter = params;
+	PowerPC::Init(core);
+}
+
+void LoadState(const TestCase& test)
+{
+	for (u32 i = 0; i < test.code.size(); i++)
+		Memory::Write_U32(test.code[i], CODE_ADDRESS + i * 4);
+	memcpy(Memory::GetPointer(DATA_ADDRESS), test.initial.data, DATA_SIZE);
+	if (jit)
+	{
+		jit->js.fifoWriteAddresses.clear();
+		jit->js.fifoWriteAddresses.insert(test.fifo_writes.begin(), test.fifo_writes.end());
+	}
+
+	PowerPC::PowerPCState& ppc = PowerPC::ppcState;
+	const CpuState& s = test.initial;
+	memcpy(ppc.gpr, s.gpr, sizeof(s.gpr));
+	memcpy(ppc.ps, s.ps, sizeof(s.ps));
+	memcpy(ppc.cr_fast, s.cr_fast, sizeof(s.cr_fast));
+	ppc.spr[SPR_XER] = s.xer;
+	ppc.spr[SPR_LR] = s.lr;
+	ppc.spr[SPR_CTR] = s.ctr;
+	ppc.pc = ppc.npc = s.pc;
+	ppc.msr = 0x2000; // FP available
+	ppc.fpscr = 0;
+	ppc.Exceptions = 0;
+}
+
+void SaveState(CpuState& s)
+{
+	const PowerPC::PowerPCState& ppc = PowerPC::ppcState;
+	memcpy(s.gpr, ppc.gpr, sizeof(s.gpr));
+	memcpy(s.ps, ppc.ps, sizeof(s.ps));
+	memcpy(s.cr_fast, ppc.cr_fast, sizeof(s.cr_fast));
+	s.xer = ppc.spr[SPR_XER];
+	s.lr = ppc.spr[SPR_LR];
+	s.ctr = ppc.spr[SPR_CTR];
+	s.pc = ppc.pc;
+	memcpy(s.data, Memory::GetPointer(DATA_ADDRESS), DATA_SIZE);
+}
+
+bool RunInterpreter(const TestCase& test, CpuState& result)
+{
+	LoadState(test);
+	for (int steps = 0; PowerPC::ppcState.pc != test.end_address && steps < 1000; steps++)
+		PowerPC::SingleStep();
+	SaveState(result);
+	return result.pc == test.end_address;
+}
+
+void RunJit(const TestCase& test, CpuState& result)
+{
+	JitInterface::ClearCache();
+	LoadState(test);
+	CoreTiming::downcount = CoreTiming::slicelength = 2000;
+	PowerPC::SingleStep();
+	SaveState(result);
+}
+
+std::string Disassemble(const TestCase& test)
+{
+	std::string text;
+	for (u32 i = 0; i < test.code.size(); i++)
+	{
+		char disasm[256];
+		DisassembleGekko(test.code[i], CODE_ADDRESS + i * 4, disasm, sizeof(disasm));
+		text += StringFromFormat("%08x: %08x  %s\n", CODE_ADDRESS + i * 4, test.code[i], disasm);
+	}
+	return text;
+}
+
+bool Compare(const TestCase& test, const CpuState& expected, const CpuState& actual, const char* core, int index)
+{
+	std::string diff;
+	for (int i = 0; i < 32; i++)
+	{
+		if (expected.gpr[i] != actual.gpr[i])
+			diff += StringFromFormat("r%d: %08x != %08x\n", i, expected.gpr[i], actual.gpr[i]);
+		for (int j = 0; j < 2; j++)
+		{
+			if (expected.ps[i][j] != actual.ps[i][j])
+				diff += StringFromFormat("f%d.ps%d: %016llx != %016llx\n", i, j,
+				                         (unsigned long long)expected.ps[i][j], (unsigned long long)actual.ps[i][j]);
+		}
+	}
+	for (int i = 0; i < 8; i++)
+	{
+		if (expected.cr_fast[i] != actual.cr_fast[i])
+			diff += StringFromFormat("cr%d: %x != %x\n", i, expected.cr_fast[i], actual.cr_fast[i]);
+	}
+	// Only the flags, the byte count isn't touched by anything generated
+	if ((expected.xer ^ actual.xer) & 0xE0000000)
+		diff += StringFromFormat("xer: %08x != %08x\n", expected.xer, actual.xer);
+	if (expected.lr != actual.lr)
+		diff += StringFromFormat("lr: %08x != %08x\n", expected.lr, actual.lr);
+	if (expected.ctr != actual.ctr)
+		diff += StringFromFormat("ctr: %08x != %08x\n", expected.ctr, actual.ctr);
+	// The JIT may be stopped on either instruction of the final loop
+	if (actual.pc != test.end_address && actual.pc != test.end_address + 4)
+		diff += StringFromFormat("pc: %08x != %08x\n", expected.pc, actual.pc);
+	for (u32 i = 0; i < DATA_SIZE; i++)
+	{
+		if (expected.data[i] != actual.data[i])
+		{
+			diff += StringFromFormat("memory at %08x: %02x != %02x\n", DATA_ADDRESS + i, expected.data[i], actual.data[i]);
+			break;
+		}
+	}
+
+	EXPECT_TRUE(diff.empty()) << core << " differs from the interpreter on block " << index << ":\n"
+	                          << diff << "code:\n" << Disassemble(test);
+	return diff.empty();
+}
+
+}
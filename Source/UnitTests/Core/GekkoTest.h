@@ -0,0 +1,75 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Runs blocks of Gekko code from a known CPU state under the interpreter or
+// one of the JITs, for tests that compare the two. Needs CoreTestUtil::Init.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+namespace GekkoTest
+{
+
+const u32 CODE_ADDRESS = 0x80001000;
+// Loaded before and compared after every run
+const u32 DATA_ADDRESS = 0x80100000;
+const u32 DATA_SIZE = 0x1C00;
+
+const int CORE_INTERPRETER = 0;
+const int CORE_JIT64 = 1;
+const int CORE_JITIL = 2;
+
+struct CpuState
+{
+	u32 gpr[32];
+	u64 ps[32][2];
+	u8 cr_fast[8];
+	u32 xer, lr, ctr;
+	u32 pc;
+	u8 data[DATA_SIZE];
+};
+
+struct TestCase
+{
+	std::vector<u32> code;
+	u32 end_address;
+	// The JITs check for external exceptions before these, which leaves the
+	// block in the middle
+	std::vector<u32> fifo_writes;
+	CpuState initial;
+};
+
+inline u32 DForm(u32 op, u32 d, u32 a, u32 imm) { return op << 26 | d << 21 | a << 16 | (imm & 0xFFFF); }
+inline u32 XForm(u32 op, u32 d, u32 a, u32 b, u32 xo, u32 rc = 0) { return op << 26 | d << 21 | a << 16 | b << 11 | xo << 1 | rc; }
+inline u32 AForm(u32 op, u32 d, u32 a, u32 b, u32 c, u32 xo) { return op << 26 | d << 21 | a << 16 | b << 11 | c << 6 | xo << 1; }
+inline u32 SPR(u32 spr) { return (spr & 0x1F) << 16 | (spr >> 5) << 11; }
+
+// Ends the code in a two instruction loop, which keeps the JIT busy until
+// its timeslice is up, and sets end_address to it
+void AddEndLoop(TestCase& test);
+// body followed by the end loop, starting from a zeroed state
+TestCase Block(const std::vector<u32>& body);
+
+// Switches the CPU to core. Everything else comes from the SConfig
+// startup parameters.
+void SetCore(int core);
+void LoadState(const TestCase& test);
+void SaveState(CpuState& s);
+
+// Steps the interpreter to the end of the block. False if it doesn't get
+// there.
+bool RunInterpreter(const TestCase& test, CpuState& result);
+// Compiles the block from scratch and runs it for one timeslice
+void RunJit(const TestCase& test, CpuState& result);
+
+std::string Disassemble(const TestCase& test);
+// Fails the current test with a diff and the code if the states differ.
+// FPSCR is not compared, the JITs don't maintain its sticky and result bits.
+bool Compare(const TestCase& test, const CpuState& expected, const CpuState& actual, const char* core, int index);
+
+}
@@ -0,0 +1,221 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <utime.h>
+#include <gtest/gtest.h>
+#include <SOIL/SOIL.h>
+
+#include "Common/CommonPaths.h"
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Common/StringUtil.h"
+#include "VideoCommon/HiresTextures.h"
+#include "VideoCommon/VideoConfig.h"
+
+namespace
+{
+
+const char GAME_ID[] = "HTEST0";
+const int NUM_TEXTURES = 16;
+const int TEXTURE_SIZE = 256;
+
+std::string TextureName(int i)
+{
+	return StringFromFormat("%s_%08x_%i", GAME_ID, 0x1000 + i, i & 7);
+}
+
+std::vector<u8> TexturePixels(int i)
+{
+	std::vector<u8> pixels(TEXTURE_SIZE * TEXTURE_SIZE * 4);
+	for (size_t j = 0; j < pixels.size(); ++j)
+		pixels[j] = (u8)(j * 7 + i * 13 + (j >> 10));
+	return pixels;
+}
+
+}
+
+class HiresTexturesTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		char dir_template[] = "/tmp/HiresTexturesTest.XXXXXX";
+		ASSERT_NE(nullptr, mkdtemp(dir_template));
+		m_dir = std::string(dir_template) + DIR_SEP;
+		m_saved_path = File::GetUserPath(D_HIRESTEXTURES_IDX);
+		File::GetUserPath(D_HIRESTEXTURES_IDX, m_dir);
+
+		// Half of the textures in a subdirectory, which Init has to find too
+		const std::string game_dir = m_dir + GAME_ID + DIR_SEP;
+		File::CreateFullPath(game_dir + "sub" DIR_SEP);
+		for (int i = 0; i < NUM_TEXTURES; ++i)
+		{
+			std::string path = game_dir + (i & 1 ? "sub" DIR_SEP : "") + TextureName(i) + ".tga";
+			ASSERT_TRUE(SOIL_save_image(path.c_str(), SOIL_SAVE_TYPE_TGA, TEXTURE_SIZE, TEXTURE_SIZE, 4, TexturePixels(i).data()));
+		}
+
+		g_ActiveConfig.bCacheHiresTextures = false;
+		g_ActiveConfig.iCacheHiresTexturesSize = 1024;
+	}
+
+	void TearDown() override
+	{
+		HiresTextures::Shutdown();
+		File::DeleteDirRecursively(m_dir);
+		File::GetUserPath(D_HIRESTEXTURES_IDX, m_saved_path);
+	}
+
+	// Loads every texture and checks it against the one that was saved
+	void CheckAllTextures()
+	{
+		std::vector<u8> data(TEXTURE_SIZE * TEXTURE_SIZE * 4);
+		for (int i = 0; i < NUM_TEXTURES; ++i)
+		{
+			unsigned int width = 0, height = 0, required_size = 0;
+			PC_TexFormat format = HiresTextures::GetHiresTex(TextureName(i), &width, &height, &required_size, 0, (unsigned int)data.size(), data.data());
+
+			EXPECT_EQ(PC_TEX_FMT_RGBA32, format);
+			EXPECT_EQ(TEXTURE_SIZE, (int)width);
+			EXPECT_EQ(TEXTURE_SIZE, (int)height);
+			EXPECT_TRUE(TexturePixels(i) == data) << TextureName(i);
+		}
+	}
+
+	// Waits for the prefetch threads to decode count textures
+	static bool WaitForCache(size_t count)
+	{
+		for (int tries = 0; tries < 1000; ++tries)
+		{
+			size_t cached, bytes;
+			HiresTextures::GetCacheStats(&cached, &bytes);
+			if (cached == count)
+				return true;
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		return false;
+	}
+
+	std::string m_dir;
+	std::string m_saved_path;
+};
+
+TEST_F(HiresTexturesTest, LoadOnDemand)
+{
+	HiresTextures::Init(GAME_ID);
+	EXPECT_TRUE(HiresTextures::HiresTexExists(TextureName(0)));
+	EXPECT_FALSE(HiresTextures::HiresTexExists(std::string(GAME_ID) + "_ffffffff_0"));
+
+	CheckAllTextures();
+
+	size_t cached, bytes;
+	HiresTextures::GetCacheStats(&cached, &bytes);
+	EXPECT_EQ(0u, cached);
+}
+
+TEST_F(HiresTexturesTest, Prefetch)
+{
+	g_ActiveConfig.bCacheHiresTextures = true;
+	HiresTextures::Init(GAME_ID);
+	ASSERT_TRUE(WaitForCache(NUM_TEXTURES));
+
+	size_t cached, bytes;
+	HiresTextures::GetCacheStats(&cached, &bytes);
+	EXPECT_EQ((size_t)NUM_TEXTURES * TEXTURE_SIZE * TEXTURE_SIZE * 4, bytes);
+
+	CheckAllTextures();
+}
+
+TEST_F(HiresTexturesTest, PrefetchBudget)
+{
+	// Room for exactly four textures
+	g_ActiveConfig.bCacheHiresTextures = true;
+	g_ActiveConfig.iCacheHiresTexturesSize = 1;
+	HiresTextures::Init(GAME_ID);
+	ASSERT_TRUE(WaitForCache(4));
+
+	// The rest still loads from disk
+	CheckAllTextures();
+
+	size_t cached, bytes;
+	HiresTextures::GetCacheStats(&cached, &bytes);
+	EXPECT_EQ(4u, cached);
+	EXPECT_LE(bytes, 1u << 20);
+}
+
+TEST_F(HiresTexturesTest, TexturePack)
+{
+	ASSERT_TRUE(HiresTextures::WriteTexturePack(GAME_ID));
+
+	// Only the pack is left
+	File::DeleteDirRecursively(m_dir + GAME_ID);
+	g_ActiveConfig.bCacheHiresTextures = true;
+	HiresTextures::Init(GAME_ID);
+	for (int i = 0; i < NUM_TEXTURES; ++i)
+		EXPECT_TRUE(HiresTextures::HiresTexExists(TextureName(i)));
+
+	CheckAllTextures();
+
+	// Pack entries are never copied into the cache
+	size_t cached, bytes;
+	HiresTextures::GetCacheStats(&cached, &bytes);
+	EXPECT_EQ(0u, cached);
+}
+
+TEST_F(HiresTexturesTest, NewerFilesWinOverPack)
+{
+	const std::string pack_path = m_dir + GAME_ID + ".htp";
+	ASSERT_TRUE(HiresTextures::WriteTexturePack(GAME_ID));
+
+	// Texture 0 is edited after the pack was built, texture 2 only touched
+	// before it
+	const std::string game_dir = m_dir + GAME_ID + DIR_SEP;
+	std::vector<u8> edited = TexturePixels(100);
+	ASSERT_TRUE(SOIL_save_image((game_dir + TextureName(0) + ".tga").c_str(), SOIL_SAVE_TYPE_TGA, TEXTURE_SIZE, TEXTURE_SIZE, 4, edited.data()));
+	ASSERT_TRUE(SOIL_save_image((game_dir + TextureName(2) + ".tga").c_str(), SOIL_SAVE_TYPE_TGA, TEXTURE_SIZE, TEXTURE_SIZE, 4, edited.data()));
+	struct utimbuf pack_time = { 1000000000, 1000000000 };
+	struct utimbuf newer = { 1000000010, 1000000010 };
+	ASSERT_EQ(0, utime(pack_path.c_str(), &pack_time));
+	ASSERT_EQ(0, utime((game_dir + TextureName(0) + ".tga").c_str(), &newer));
+	ASSERT_EQ(0, utime((game_dir + TextureName(2) + ".tga").c_str(), &pack_time));
+
+	HiresTextures::Init(GAME_ID);
+	std::vector<u8> data(TEXTURE_SIZE * TEXTURE_SIZE * 4);
+	unsigned int width, height, required_size;
+	HiresTextures::GetHiresTex(TextureName(0), &width, &height, &required_size, 0, (unsigned int)data.size(), data.data());
+	EXPECT_TRUE(edited == data);
+	HiresTextures::GetHiresTex(TextureName(2), &width, &height, &required_size, 0, (unsigned int)data.size(), data.data());
+	EXPECT_TRUE(TexturePixels(2) == data);
+}
+
+TEST_F(HiresTexturesTest, DamagedPack)
+{
+	const std::string pack_path = m_dir + GAME_ID + ".htp";
+	ASSERT_TRUE(HiresTextures::WriteTexturePack(GAME_ID));
+
+	// Cut off the pixels of the last texture
+	u64 size = File::GetSize(pack_path);
+	{
+		File::IOFile file(pack_path, "r+b");
+		ASSERT_TRUE(file.Resize(size - 16));
+	}
+
+	File::DeleteDirRecursively(m_dir + GAME_ID);
+	HiresTextures::Init(GAME_ID);
+	EXPECT_FALSE(HiresTextures::HiresTexExists(TextureName(0)));
+}
+
+TEST_F(HiresTexturesTest, PackWithBrokenTexture)
+{
+	const std::string pack_path = m_dir + GAME_ID + ".htp";
+	File::WriteStringToFile("not an image", m_dir + GAME_ID + DIR_SEP + GAME_ID + "_00000000_0.png");
+
+	// No pack at all rather than one with a texture missing
+	EXPECT_FALSE(HiresTextures::WriteTexturePack(GAME_ID));
+	EXPECT_FALSE(File::Exists(pack_path));
+}
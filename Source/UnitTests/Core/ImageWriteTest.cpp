@@ -0,0 +1,145 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <SOIL/SOIL.h>
+
+#include "Common/CommonPaths.h"
+#include "Common/CommonTypes.h"
+#include "Common/FileUtil.h"
+#include "Common/StringUtil.h"
+#include "VideoCommon/ImageWrite.h"
+#include "VideoCommon/VideoConfig.h"
+
+namespace
+{
+
+const int SIZE = 256;
+
+// Something between noise and a flat color, so compression levels matter
+std::vector<u8> ImagePixels(int i)
+{
+	std::vector<u8> pixels(SIZE * SIZE * 4);
+	for (size_t j = 0; j < pixels.size(); ++j)
+		pixels[j] = (u8)((j / 4 % SIZE) * (i + 1) + (j / 4 / SIZE) * 3 + (j & 3) * 50);
+	return pixels;
+}
+
+}
+
+class ImageWriteTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		char dir_template[] = "/tmp/ImageWriteTest.XXXXXX";
+		ASSERT_NE(nullptr, mkdtemp(dir_template));
+		m_dir = std::string(dir_template) + DIR_SEP;
+		g_ActiveConfig.iPNGCompressionLevel = -1;
+	}
+
+	void TearDown() override
+	{
+		ShutdownPngWriter();
+		File::DeleteDirRecursively(m_dir);
+	}
+
+	std::string ImagePath(const std::string& name, int i)
+	{
+		return StringFromFormat("%s%s%i.png", m_dir.c_str(), name.c_str(), i);
+	}
+
+	std::string m_dir;
+};
+
+TEST_F(ImageWriteTest, WritesSameImage)
+{
+	// With padding between the rows
+	const int stride = SIZE * 4 + 64;
+	for (int i = 0; i < 4; ++i)
+	{
+		std::vector<u8> pixels = ImagePixels(i);
+		std::vector<u8> padded(stride * SIZE, 0xAA);
+		for (int y = 0; y < SIZE; ++y)
+			memcpy(&padded[y * stride], &pixels[y * SIZE * 4], SIZE * 4);
+		TextureToPngAsync(padded.data(), stride, ImagePath("image", i), SIZE, SIZE, i & 1);
+		// The data was copied
+		padded.assign(padded.size(), 0);
+	}
+	FlushPngWrites();
+	EXPECT_EQ(0u, GetPendingPngBytes());
+
+	for (int i = 0; i < 4; ++i)
+	{
+		int width, height, channels;
+		u8* loaded = SOIL_load_image(ImagePath("image", i).c_str(), &width, &height, &channels, SOIL_LOAD_RGBA);
+		ASSERT_NE(nullptr, loaded);
+		EXPECT_EQ(SIZE, width);
+		EXPECT_EQ(SIZE, height);
+
+		std::vector<u8> expected = ImagePixels(i);
+		if (!(i & 1))
+		{
+			for (size_t j = 3; j < expected.size(); j += 4)
+				expected[j] = 0xFF;
+		}
+		EXPECT_TRUE(std::equal(expected.begin(), expected.end(), loaded)) << i;
+		SOIL_free_image_data(loaded);
+	}
+}
+
+TEST_F(ImageWriteTest, Deduplicates)
+{
+	const std::string path = ImagePath("dedupe", 0);
+	EXPECT_FALSE(IsPngDumped(path));
+
+	std::vector<u8> pixels = ImagePixels(0);
+	TextureToPngAsync(pixels.data(), SIZE * 4, path, SIZE, SIZE);
+	// Queued counts as dumped, even before it is on disk
+	EXPECT_TRUE(IsPngDumped(path));
+	FlushPngWrites();
+	EXPECT_TRUE(File::Exists(path));
+
+	// Files from an earlier session are found on disk
+	const std::string old_path = ImagePath("old", 0);
+	ASSERT_TRUE(TextureToPng(pixels.data(), SIZE * 4, old_path, SIZE, SIZE));
+	EXPECT_TRUE(IsPngDumped(old_path));
+}
+
+TEST_F(ImageWriteTest, ReportsResult)
+{
+	std::vector<u8> pixels = ImagePixels(1);
+	std::atomic<int> written(0), failed(0);
+	auto on_written = [&](bool success) { ++(success ? written : failed); };
+
+	TextureToPngAsync(pixels.data(), SIZE * 4, ImagePath("reported", 0), SIZE, SIZE, true, on_written);
+	TextureToPngAsync(pixels.data(), SIZE * 4, m_dir + "missing" DIR_SEP "reported.png", SIZE, SIZE, true, on_written);
+	// Every callback has run once the writes are flushed
+	FlushPngWrites();
+	EXPECT_EQ(1, written.load());
+	EXPECT_EQ(1, failed.load());
+	EXPECT_TRUE(File::Exists(ImagePath("reported", 0)));
+}
+
+TEST_F(ImageWriteTest, CompressionLevel)
+{
+	std::vector<u8> pixels = ImagePixels(3);
+	u64 sizes[2];
+	const int levels[2] = { 0, 9 };
+	for (int i = 0; i < 2; ++i)
+	{
+		g_ActiveConfig.iPNGCompressionLevel = levels[i];
+		TextureToPngAsync(pixels.data(), SIZE * 4, ImagePath("level", levels[i]), SIZE, SIZE);
+		FlushPngWrites();
+		sizes[i] = File::GetSize(ImagePath("level", levels[i]));
+	}
+	EXPECT_GT(sizes[0], (u64)SIZE * SIZE * 4);
+	EXPECT_LT(sizes[1], sizes[0]);
+}
@@ -0,0 +1,406 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Runs random blocks of Gekko code under the interpreter and every JIT
+// configuration, starting from identical state, and compares the registers
+// and memory afterwards.
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
+#include "Core/PowerPC/PowerPC.h"
+
+#include "CoreTestUtil.h"
+#include "GekkoTest.h"
+
+// After the emitter, which has an instruction called TEST
+#include <gtest/gtest.h>
+
+using namespace GekkoTest;
+
+namespace
+{
+
+// Integer stores only go to the first half of the data area, floating point
+// loads read the second half, which is filled with values that don't hit
+// NaN or denormal handling, and floating point stores go past the end.
+const u32 INT_DATA_SIZE = 0x1000;
+const u32 FLOAT_DATA = INT_DATA_SIZE;
+const u32 DOUBLE_DATA = INT_DATA_SIZE + 0x400;
+const u32 FP_STORE_DATA = INT_DATA_SIZE + 0x800;
+static_assert(FP_STORE_DATA + 0x400 == DATA_SIZE, "The floating point stores need 0x400 bytes");
+
+// r29 only ever holds a valid XER value, r30 is a small offset for the
+// indexed forms, r31 points at the data
+const int XER_REG = 29;
+const int INDEX_REG = 30;
+const int BASE_REG = 31;
+
+const int MAX_BLOCK_LENGTH = 48;
+
+struct Generator
+{
+	std::mt19937 rng;
+
+	explicit Generator(u32 seed) : rng(seed) {}
+
+	u32 Next(u32 range) { return rng() % range; }
+	int GReg() { return Next(29); }
+	int FReg() { return Next(32); }
+
+	double NiceDouble()
+	{
+		// Exact in single precision, so rounding is the same everywhere
+		return ((int)Next(2001) - 1000) / 8.0;
+	}
+
+	u32 IntegerInst()
+	{
+		static const u32 xo_arith[] = { 266, 10, 138, 40, 8, 136, 235, 75, 11 };
+		static const u32 xo_unary[] = { 202, 234, 200, 232, 104 };
+		static const u32 xo_logic[] = { 28, 60, 444, 412, 316, 476, 124, 284, 24, 536, 792 };
+		static const u32 xo_logic_unary[] = { 26, 954, 922 };
+		static const u32 op_imm[] = { 14, 15, 12, 13, 8, 7 };
+		static const u32 op_logic_imm[] = { 24, 25, 26, 27, 28, 29 };
+
+		const u32 rc = Next(4) == 0;
+		switch (Next(12))
+		{
+		case 0:
+			return XForm(31, GReg(), GReg(), GReg(), xo_arith[Next(9)], rc);
+		case 1:
+			return XForm(31, GReg(), GReg(), 0, xo_unary[Next(5)], rc);
+		case 2:
+		case 3:
+			return XForm(31, GReg(), GReg(), GReg(), xo_logic[Next(11)], rc);
+		case 4:
+			return XForm(31, GReg(), GReg(), 0, xo_logic_unary[Next(3)], rc);
+		case 5:
+			return XForm(31, GReg(), GReg(), Next(32), 824, rc); // srawi
+		case 6:
+			return DForm(op_imm[Next(6)], GReg(), Next(2) ? GReg() : 0, rng());
+		case 7:
+			return DForm(op_logic_imm[Next(6)], GReg(), GReg(), rng());
+		case 8:
+			// rlwinm, rlwimi
+			return (Next(2) ? 21 : 20) << 26 | GReg() << 21 | GReg() << 16 | Next(32) << 11 | Next(32) << 6 | Next(32) << 1 | rc;
+		case 9:
+			// rlwnm
+			return 23 << 26 | GReg() << 21 | GReg() << 16 | GReg() << 11 | Next(32) << 6 | Next(32) << 1 | rc;
+		case 10:
+			// cmp, cmpl, cmpi, cmpli
+			switch (Next(4))
+			{
+			case 0: return XForm(31, Next(8) << 2, GReg(), GReg(), 0);
+			case 1: return XForm(31, Next(8) << 2, GReg(), GReg(), 32);
+			case 2: return DForm(11, Next(8) << 2, GReg(), Next(2) ? rng() : Next(8));
+			default: return DForm(10, Next(8) << 2, GReg(), Next(2) ? rng() : Next(8));
+			}
+		default:
+			// Keep some registers small, so the comparisons see equal values
+			return DForm(14, GReg(), 0, Next(4));
+		}
+	}
+
+	u32 SystemInst(bool in_leaf)
+	{
+		static const u32 xo_cr[] = { 257, 449, 193, 225, 33, 289, 129, 417 };
+		switch (Next(in_leaf ? 3 : 5))
+		{
+		case 0:
+			return XForm(19, Next(32), Next(32), Next(32), xo_cr[Next(8)]);
+		case 1:
+			return XForm(19, Next(8) << 2, Next(8) << 2, 0, 0); // mcrf
+		case 2:
+			if (Next(2))
+				return XForm(31, GReg(), 0, 0, 19); // mfcr
+			return 31 << 26 | GReg() << 21 | Next(256) << 12 | 144 << 1; // mtcrf
+		case 3:
+		{
+			// mfxer, mfspr/mtspr of LR and CTR
+			static const u32 sprs[] = { 1, 8, 9 };
+			u32 spr = sprs[Next(3)];
+			return 31 << 26 | GReg() << 21 | SPR(spr) | (spr == 1 || Next(2) ? 339 : 467) << 1;
+		}
+		default:
+			return 31 << 26 | GReg() << 21 | SPR(Next(2) ? 8 : 9) | 339 << 1;
+		}
+	}
+
+	u32 LoadStoreInst()
+	{
+		static const u32 op_load[] = { 32, 34, 40, 42 };
+		static const u32 op_store[] = { 36, 38, 44 };
+		static const u32 xo_load[] = { 23, 87, 279, 343, 534, 790 };
+		static const u32 xo_store[] = { 151, 215, 407, 662, 918 };
+		// Aligned for the largest access, the indexed forms add r30 which is
+		// below 0x100
+		const u32 offset = Next(INT_DATA_SIZE - 0x100) & ~7;
+		switch (Next(4))
+		{
+		case 0: return DForm(op_load[Next(4)], GReg(), BASE_REG, offset);
+		case 1: return DForm(op_store[Next(3)], GReg(), BASE_REG, offset);
+		case 2: return XForm(31, GReg(), BASE_REG, INDEX_REG, xo_load[Next(6)]);
+		default: return XForm(31, GReg(), BASE_REG, INDEX_REG, xo_store[Next(5)]);
+		}
+	}
+
+	u32 FloatInst()
+	{
+		static const u32 xo_double[] = { 21, 20, 25, 29, 28, 31, 30 };
+		static const u32 xo_move[] = { 72, 40, 264, 136 };
+		switch (Next(6))
+		{
+		case 0:
+		{
+			// fadd, fsub, fmul and the fused ones, double and single
+			u32 xo = xo_double[Next(7)];
+			u32 b = xo == 25 ? 0 : FReg();
+			u32 c = xo == 21 || xo == 20 ? 0 : FReg();
+			return AForm(Next(2) ? 63 : 59, FReg(), FReg(), b, c, xo);
+		}
+		case 1:
+			return XForm(63, FReg(), 0, FReg(), xo_move[Next(4)]);
+		case 2:
+			return XForm(63, Next(8) << 2, FReg(), FReg(), 0); // fcmpu
+		case 3:
+			if (Next(2))
+				return DForm(48, FReg(), BASE_REG, FLOAT_DATA + (Next(0x100) & ~3)); // lfs
+			return DForm(50, FReg(), BASE_REG, DOUBLE_DATA + (Next(0x400) & ~7)); // lfd
+		case 4:
+			if (Next(2))
+				return DForm(52, FReg(), BASE_REG, FP_STORE_DATA + (Next(0x400) & ~3)); // stfs
+			return DForm(54, FReg(), BASE_REG, FP_STORE_DATA + (Next(0x400) & ~7)); // stfd
+		default:
+		{
+			// ps_add, ps_sub, ps_mul, ps_madd, ps_merge*
+			static const u32 xo_ps[] = { 21, 20, 25, 29 };
+			static const u32 xo_merge[] = { 528, 560, 592, 624 };
+			if (Next(2))
+				return XForm(4, FReg(), FReg(), FReg(), xo_merge[Next(4)]);
+			u32 xo = xo_ps[Next(4)];
+			u32 b = xo == 25 ? 0 : FReg();
+			u32 c = xo == 21 || xo == 20 ? 0 : FReg();
+			return AForm(4, FReg(), FReg(), b, c, xo);
+		}
+		}
+	}
+
+	void Inst(std::vector<u32>& code, bool in_leaf)
+	{
+		switch (Next(10))
+		{
+		case 0: case 1: case 2: case 3:
+			code.push_back(IntegerInst());
+			break;
+		case 4: case 5:
+			code.push_back(LoadStoreInst());
+			break;
+		case 6: case 7:
+			code.push_back(FloatInst());
+			break;
+		case 8:
+			// The JITs don't emulate summary overflow, so only CA gets moved to XER
+			if (Next(2))
+				code.push_back(21 << 26 | GReg() << 21 | XER_REG << 16 | 2 << 6 | 2 << 1); // rlwinm r29, rS, 0, 2, 2
+			else
+				code.push_back(31 << 26 | XER_REG << 21 | SPR(1) | 467 << 1); // mtxer r29
+			break;
+		default:
+			code.push_back(SystemInst(in_leaf));
+			break;
+		}
+	}
+
+	TestCase Generate()
+	{
+		TestCase test;
+		std::vector<u32>& code = test.code;
+		const u32 length = 1 + Next(MAX_BLOCK_LENGTH);
+		const u32 leaf_length = Next(2) ? 1 + Next(6) : 0;
+		std::vector<size_t> calls;
+
+		for (u32 i = 0; i < length; i++)
+		{
+			// Forward branches skip at most as many instructions as are left
+			const u32 skip = 4 * (1 + Next(std::min<u32>(length - i, 6)));
+			switch (Next(16))
+			{
+			case 0:
+			{
+				// Conditional, possibly a bdnz
+				static const u32 bo[] = { 12, 4, 16, 18 };
+				code.push_back(16 << 26 | bo[Next(4)] << 21 | Next(32) << 16 | skip);
+				break;
+			}
+			case 1:
+				code.push_back(18 << 26 | skip);
+				break;
+			case 3:
+				if (i + 1 < length)
+				{
+					// A compare and a branch on its result, which the JIT fuses
+					const u32 crf = Next(8);
+					code.push_back(DForm(11, crf << 2, GReg(), Next(8)));
+					i++;
+					const u32 branch_skip = 4 * (1 + Next(std::min<u32>(length - i, 6)));
+					code.push_back(16 << 26 | (Next(2) ? 12 : 4) << 21 | (crf * 4 + Next(3)) << 16 | branch_skip);
+					break;
+				}
+				// fall through
+			case 2:
+				if (leaf_length)
+				{
+					calls.push_back(code.size());
+					code.push_back(18 << 26 | 1); // bl, the target is filled in below
+					break;
+				}
+				// fall through
+			default:
+				Inst(code, false);
+				break;
+			}
+		}
+
+		// Any leaf function comes after the end loop
+		AddEndLoop(test);
+
+		const u32 leaf_address = CODE_ADDRESS + (u32)code.size() * 4;
+		for (size_t call : calls)
+			code[call] |= leaf_address - (CODE_ADDRESS + (u32)call * 4);
+		for (u32 i = 0; i < leaf_length; i++)
+			Inst(code, true);
+		code.push_back(0x4E800020); // blr
+
+		CpuState& s = test.initial;
+		for (u32& r : s.gpr)
+			r = Next(4) ? rng() : Next(16);
+		s.gpr[XER_REG] = Next(2) << 29;
+		s.gpr[INDEX_REG] = Next(0x100) & ~7;
+		s.gpr[BASE_REG] = DATA_ADDRESS;
+		for (auto& ps : s.ps)
+		{
+			double ps0 = NiceDouble(), ps1 = NiceDouble();
+			memcpy(&ps[0], &ps0, 8);
+			memcpy(&ps[1], &ps1, 8);
+		}
+		for (u8& cr : s.cr_fast)
+			cr = Next(16);
+		s.xer = Next(2) << 29;
+		s.lr = rng();
+		s.ctr = Next(4) ? Next(4) : rng();
+		s.pc = CODE_ADDRESS;
+
+		for (u32 i = 0; i < INT_DATA_SIZE; i++)
+			s.data[i] = rng();
+		for (u32 i = FLOAT_DATA; i < DOUBLE_DATA; i += 4)
+		{
+			float value = (float)NiceDouble();
+			u32 bits;
+			memcpy(&bits, &value, 4);
+			bits = Common::swap32(bits);
+			memcpy(&s.data[i], &bits, 4);
+		}
+		for (u32 i = DOUBLE_DATA; i < FP_STORE_DATA; i += 8)
+		{
+			double value = NiceDouble();
+			u64 bits;
+			memcpy(&bits, &value, 8);
+			bits = Common::swap64(bits);
+			memcpy(&s.data[i], &bits, 8);
+		}
+		memset(&s.data[FP_STORE_DATA], 0, DATA_SIZE - FP_STORE_DATA);
+		return test;
+	}
+};
+
+bool HasPairedFma(const TestCase& test)
+{
+	for (u32 inst : test.code)
+	{
+		const u32 subop5 = inst >> 1 & 0x1F;
+		if (inst >> 26 == 4 && (subop5 == 14 || subop5 == 15 || subop5 >= 28))
+			return true;
+	}
+	return false;
+}
+
+struct JitConfig
+{
+	const char* name;
+	int core;
+	bool regions;
+	bool carry_registers;
+	// JitIL does the paired single fused ops as a float multiply and add,
+	// rounding the product
+	bool exact_paired_fma;
+};
+
+class JitFuzzTest : public testing::Test
+{
+protected:
+	static void SetUpTestCase()
+	{
+		CoreTestUtil::Init(true);
+	}
+
+	static void TearDownTestCase()
+	{
+		CoreTestUtil::Shutdown();
+	}
+
+	void SetCore(const JitConfig& config)
+	{
+		SCoreStartupParameter& params = SConfig::GetInstance().m_LocalCoreStartupParameter;
+		params.iCPUCore = config.core;
+		params.bJITRegions = config.regions;
+		params.bJITCarryRegisters = config.carry_registers;
+		GekkoTest::SetCore(config.core);
+	}
+};
+
+}
+
+TEST_F(JitFuzzTest, MatchesInterpreter)
+{
+	const int num_blocks = 1500;
+
+	std::vector<TestCase> tests;
+	Generator generator(20140601);
+	for (int i = 0; i < num_blocks; i++)
+		tests.push_back(generator.Generate());
+
+	std::vector<CpuState> expected(num_blocks);
+	SetCore({ "Interpreter", CORE_INTERPRETER, false, false, true });
+	for (int i = 0; i < num_blocks; i++)
+		ASSERT_TRUE(RunInterpreter(tests[i], expected[i])) << "interpreter did not reach the end of block " << i;
+	PowerPC::Shutdown();
+
+	const JitConfig configs[] = {
+		{ "Jit64", CORE_JIT64, false, false, true },
+		{ "Jit64 with regions and carried registers", CORE_JIT64, true, true, true },
+		{ "JitIL", CORE_JITIL, false, false, false },
+	};
+	for (const JitConfig& config : configs)
+	{
+		SetCore(config);
+		int failures = 0;
+		for (int i = 0; i < num_blocks && failures < 5; i++)
+		{
+			if (!config.exact_paired_fma && HasPairedFma(tests[i]))
+				continue;
+
+			CpuState actual;
+			RunJit(tests[i], actual);
+			if (!Compare(tests[i], expected[i], actual, config.name, i))
+				failures++;
+		}
+		PowerPC::Shutdown();
+	}
+}
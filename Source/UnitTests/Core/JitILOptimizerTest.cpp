@@ -0,0 +1,240 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Runs blocks of integer code that give the JitIL optimizer something to do
+// under the interpreter and JitIL, and looks at the IR JitIL builds for them.
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Core/PowerPC/JitInterface.h"
+#include "Core/PowerPC/PowerPC.h"
+#include "Core/PowerPC/JitILCommon/JitILBase.h"
+
+#include "CoreTestUtil.h"
+#include "GekkoTest.h"
+
+// After the emitter, which has an instruction called TEST
+#include <gtest/gtest.h>
+
+using namespace GekkoTest;
+
+namespace
+{
+
+const int MAX_BLOCK_LENGTH = 60;
+
+u32 Li(u32 d, u32 imm) { return DForm(14, d, 0, imm); }
+u32 Add(u32 d, u32 a, u32 b) { return XForm(31, d, a, b, 266); }
+u32 Xor(u32 a, u32 s, u32 b) { return XForm(31, s, a, b, 316); }
+u32 Mtctr(u32 s) { return 31 << 26 | s << 21 | SPR(9) | 467 << 1; }
+// JitIL leaves mulhw to the interpreter
+u32 Mulhw(u32 d, u32 a, u32 b) { return XForm(31, d, a, b, 75); }
+
+// Only a few registers, so values get reused and overwritten within a block.
+struct Generator
+{
+	std::mt19937 rng;
+
+	explicit Generator(u32 seed) : rng(seed) {}
+
+	u32 Next(u32 range) { return rng() % range; }
+	u32 GReg() { return 3 + Next(8); }
+
+	u32 Inst()
+	{
+		static const u32 xo_binary[] = { 266, 40, 138, 10, 75 }; // add, subf, adde, addc, mulhw
+		static const u32 xo_logic[] = { 28, 444, 316 };
+		static const u32 xo_unary[] = { 104, 922 }; // neg, extsh
+		const u32 rc = Next(8) == 0;
+		switch (Next(11))
+		{
+		case 0:
+		case 1:
+			return XForm(31, GReg(), GReg(), GReg(), xo_binary[Next(5)], rc);
+		case 2:
+			return XForm(31, GReg(), GReg(), GReg(), xo_logic[Next(3)], rc);
+		case 3:
+			return XForm(31, GReg(), GReg(), 0, xo_unary[Next(2)], rc);
+		case 4:
+			// addi, addic
+			return DForm(Next(2) ? 14 : 12, GReg(), Next(2) ? GReg() : 0, Next(2) ? rng() : Next(4));
+		case 5:
+			// rlwinm
+			return 21 << 26 | GReg() << 21 | GReg() << 16 | Next(32) << 11 | Next(32) << 6 | Next(32) << 1 | rc;
+		case 6:
+			// cmp, cmpl
+			return XForm(31, Next(8) << 2, GReg(), GReg(), Next(2) ? 32 : 0);
+		case 7:
+		{
+			// mfspr/mtspr of LR and CTR
+			const u32 spr = Next(2) ? 8 : 9;
+			return 31 << 26 | GReg() << 21 | SPR(spr) | (Next(2) ? 339 : 467) << 1;
+		}
+		case 8:
+		{
+			// mr
+			const u32 s = GReg();
+			return XForm(31, s, GReg(), s, 444);
+		}
+		default:
+			// Keep some registers small, so the comparisons see equal values
+			return Li(GReg(), Next(4));
+		}
+	}
+
+	TestCase Generate()
+	{
+		TestCase test;
+		std::vector<u32>& code = test.code;
+		const u32 length = 1 + Next(MAX_BLOCK_LENGTH);
+		for (u32 i = 0; i < length; i++)
+		{
+			if (Next(8) == 0)
+			{
+				// A conditional forward branch, possibly a bdnz, ends the
+				// block with whatever was stored so far
+				static const u32 bo[] = { 12, 4, 16 };
+				const u32 skip = 4 * (1 + Next(std::min<u32>(length - i, 6)));
+				code.push_back(16 << 26 | bo[Next(3)] << 21 | Next(32) << 16 | skip);
+			}
+			else
+			{
+				code.push_back(Inst());
+			}
+		}
+
+		AddEndLoop(test);
+
+		for (u32 i = Next(4); i > 0; i--)
+			test.fifo_writes.push_back(CODE_ADDRESS + 4 * Next(length));
+
+		CpuState& s = test.initial;
+		memset(&s, 0, sizeof(s));
+		for (u32& r : s.gpr)
+			r = Next(4) ? rng() : Next(8);
+		for (u8& cr : s.cr_fast)
+			cr = Next(16);
+		s.xer = Next(2) << 29;
+		s.lr = rng();
+		s.ctr = Next(4) ? Next(4) : rng();
+		s.pc = CODE_ADDRESS;
+		return test;
+	}
+};
+
+IREmitter::IRBuilder& GetIR()
+{
+	return static_cast<JitILBase*>(jit)->ibuild;
+}
+
+size_t CountOpcode(unsigned opcode)
+{
+	IREmitter::IRBuilder& ibuild = GetIR();
+	size_t count = 0;
+	for (unsigned i = 0; i < ibuild.getNumInsts(); i++)
+		count += IREmitter::getOpcode(ibuild.getFirstInst()[i]) == opcode;
+	return count;
+}
+
+class JitILOptimizerTest : public testing::Test
+{
+protected:
+	static void SetUpTestCase()
+	{
+		CoreTestUtil::Init(true);
+	}
+
+	static void TearDownTestCase()
+	{
+		CoreTestUtil::Shutdown();
+	}
+
+	void TearDown() override
+	{
+		PowerPC::Shutdown();
+	}
+
+	// Leaves the block's IR, after dead store elimination, in GetIR()
+	void Compile(const std::vector<u32>& body, const std::vector<u32>& fifo_writes = {})
+	{
+		TestCase test = Block(body);
+		test.fifo_writes = fifo_writes;
+		JitInterface::ClearCache();
+		LoadState(test);
+		jit->Jit(CODE_ADDRESS);
+	}
+};
+
+}
+
+TEST_F(JitILOptimizerTest, MatchesInterpreter)
+{
+	const int num_blocks = 2000;
+
+	std::vector<TestCase> tests;
+	Generator generator(1234);
+	for (int i = 0; i < num_blocks; i++)
+		tests.push_back(generator.Generate());
+
+	std::vector<CpuState> expected(num_blocks);
+	SetCore(CORE_INTERPRETER);
+	for (int i = 0; i < num_blocks; i++)
+		ASSERT_TRUE(RunInterpreter(tests[i], expected[i])) << "interpreter did not reach the end of block " << i;
+	PowerPC::Shutdown();
+
+	SetCore(CORE_JITIL);
+	int failures = 0;
+	for (int i = 0; i < num_blocks && failures < 5; i++)
+	{
+		CpuState actual;
+		RunJit(tests[i], actual);
+		if (!Compare(tests[i], expected[i], actual, "JitIL", i))
+			failures++;
+	}
+
+	// Every pass had something to do on the way
+	const IREmitter::OptimizerStats& stats = GetIR().GetStats();
+	EXPECT_GE(stats.blocks, (u64)num_blocks);
+	EXPECT_GT(stats.foldedLoads, 0u);
+	EXPECT_GT(stats.numberedValues, 0u);
+	EXPECT_GT(stats.deadStores, 0u);
+}
+
+TEST_F(JitILOptimizerTest, DeadStoresAcrossExits)
+{
+	SetCore(CORE_JITIL);
+
+	// The first store is visible if the block is left at the check before
+	// the second
+	Compile({ Li(3, 1), Li(3, 2) }, { CODE_ADDRESS + 4 });
+	EXPECT_EQ(1u, CountOpcode(IREmitter::ExtExceptionCheck));
+	EXPECT_EQ(2u, CountOpcode(IREmitter::StoreGReg));
+
+	// Without the check nothing can observe it
+	Compile({ Li(3, 1), Li(3, 2) });
+	EXPECT_EQ(1u, CountOpcode(IREmitter::StoreGReg));
+
+	// The interpreter may read anything, of the stores after it only the
+	// last one is needed
+	Compile({ Mtctr(4), Mulhw(7, 8, 9), Mtctr(5), Mtctr(6) });
+	EXPECT_EQ(2u, CountOpcode(IREmitter::StoreCTR));
+}
+
+TEST_F(JitILOptimizerTest, ValueNumbering)
+{
+	SetCore(CORE_JITIL);
+
+	Compile({ Add(3, 4, 5), Add(6, 4, 5), Add(7, 5, 4) });
+	EXPECT_EQ(1u, CountOpcode(IREmitter::Add));
+	EXPECT_EQ(2u, CountOpcode(IREmitter::LoadGReg));
+
+	// A store to a source register in between means a different value
+	Compile({ Add(3, 4, 5), Xor(4, 4, 6), Add(6, 4, 5), Add(7, 5, 4) });
+	EXPECT_EQ(2u, CountOpcode(IREmitter::Add));
+}
@@ -0,0 +1,118 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Common/ChunkFile.h"
+#include "Common/CommonTypes.h"
+#include "Core/HW/Memmap.h"
+
+#include "CoreTestUtil.h"
+
+namespace
+{
+
+const u32 DELTA_PAGE_SIZE = 0x1000;
+
+std::vector<u8> SaveMemory(bool delta)
+{
+	Memory::SetStateDelta(delta);
+
+	u8* ptr = nullptr;
+	PointerWrap measure(&ptr, PointerWrap::MODE_MEASURE);
+	Memory::DoState(measure);
+
+	std::vector<u8> buffer((size_t)ptr);
+	ptr = &buffer[0];
+	PointerWrap p(&ptr, PointerWrap::MODE_WRITE);
+	Memory::DoState(p);
+
+	Memory::SetStateDelta(false);
+	return buffer;
+}
+
+// Returns false if the state was refused
+bool LoadMemory(std::vector<u8>& buffer)
+{
+	u8* ptr = &buffer[0];
+	PointerWrap p(&ptr, PointerWrap::MODE_READ, ptr + buffer.size());
+	Memory::DoState(p);
+	return p.GetMode() == PointerWrap::MODE_READ;
+}
+
+}
+
+class MemoryStateTest : public testing::Test
+{
+protected:
+	static void SetUpTestCase()
+	{
+		CoreTestUtil::Init(false);
+	}
+
+	static void TearDownTestCase()
+	{
+		CoreTestUtil::Shutdown();
+	}
+
+	void SetUp() override
+	{
+		memset(Memory::GetPointer(0x80000000), 0, Memory::RAM_SIZE);
+		Memory::ResetStateDeltaBase();
+	}
+};
+
+TEST_F(MemoryStateTest, DeltaHoldsChangedPages)
+{
+	ASSERT_TRUE(Memory::HasStateDeltaBase());
+
+	std::vector<u8> unchanged = SaveMemory(true);
+	EXPECT_LT(unchanged.size(), (size_t)DELTA_PAGE_SIZE);
+
+	// Once through the CPU's accessors, once straight into physical memory the
+	// way DMA and the HLE code do it, neither of which the delta may miss
+	Memory::Write_U32(0x12345678, 0x80001000);
+	Memory::GetPointer(0x00400000)[0x123] = 0x42;
+	Memory::GetPointer(0x00401000)[0] = 0x43;
+
+	std::vector<u8> changed = SaveMemory(true);
+	EXPECT_GE(changed.size(), unchanged.size() + 3 * DELTA_PAGE_SIZE);
+	EXPECT_LT(changed.size(), unchanged.size() + 4 * DELTA_PAGE_SIZE);
+
+	// Without the delta all of memory is stored
+	EXPECT_GE(SaveMemory(false).size(), (size_t)Memory::RAM_SIZE);
+}
+
+TEST_F(MemoryStateTest, LoadRestoresBaseAndPages)
+{
+	Memory::Write_U32(0xCAFEBABE, 0x80002000);
+	Memory::GetPointer(0x00500000)[0x10] = 0x55;
+	std::vector<u8> state = SaveMemory(true);
+
+	// Changes on pages in and outside the delta are undone
+	Memory::Write_U32(0, 0x80002000);
+	Memory::GetPointer(0x00500000)[0x10] = 0;
+	Memory::GetPointer(0x00600000)[0x20] = 0x66;
+	Memory::GetPointer(0x00002000)[0x40] = 0x77;
+
+	ASSERT_TRUE(LoadMemory(state));
+	EXPECT_EQ(0xCAFEBABE, Memory::Read_U32(0x80002000));
+	EXPECT_EQ(0x55, Memory::GetPointer(0x00500000)[0x10]);
+	EXPECT_EQ(0, Memory::GetPointer(0x00600000)[0x20]);
+	EXPECT_EQ(0, Memory::GetPointer(0x00002040)[0]);
+}
+
+TEST_F(MemoryStateTest, OtherBaseIsRefused)
+{
+	Memory::GetPointer(0x00500000)[0] = 0x55;
+	std::vector<u8> state = SaveMemory(true);
+
+	Memory::GetPointer(0x00500000)[0] = 0x66;
+	Memory::ResetStateDeltaBase();
+	EXPECT_FALSE(LoadMemory(state));
+	EXPECT_EQ(0x66, Memory::GetPointer(0x00500000)[0]);
+}
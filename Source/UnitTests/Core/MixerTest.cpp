@@ -0,0 +1,98 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "AudioCommon/Mixer.h"
+#include "Common/CommonTypes.h"
+#include "Core/ConfigManager.h"
+#include "Core/PowerPC/PowerPC.h"
+
+class MixerTest : public testing::Test
+{
+protected:
+	static void SetUpTestCase()
+	{
+		SConfig::Init();
+		// Mix only outputs anything while the CPU runs
+		PowerPC::Start();
+	}
+
+	static void TearDownTestCase()
+	{
+		PowerPC::Stop();
+		SConfig::Shutdown();
+	}
+};
+
+TEST_F(MixerTest, StreamingUnderrunIsSilent)
+{
+	CMixer mixer(48000, 48000, 48000);
+	std::vector<short> stream(256 * 2, 1000);
+	mixer.PushStreamingSamples(stream.data(), 256, 48000);
+
+	std::vector<short> out(1024 * 2);
+	mixer.Mix(out.data(), 1024, false);
+	EXPECT_EQ(1000, out[0]);
+	EXPECT_EQ(0, out.back());
+
+	// Once the stream stopped, nothing is left of it
+	mixer.Mix(out.data(), 1024, false);
+	EXPECT_TRUE(std::all_of(out.begin(), out.end(), [](short s) { return s == 0; }));
+}
+
+TEST(MixerResample, SimdMatchesScalar)
+{
+	std::mt19937 rng(4321);
+	std::vector<short> ring(MAX_SAMPLES * 2);
+	for (ResampleQuality quality : { RESAMPLE_LINEAR, RESAMPLE_POLYPHASE })
+	{
+		for (int iteration = 0; iteration < 2000; iteration++)
+		{
+			// Full scale input every few rounds, so the filter overshoots and
+			// the sums saturate
+			const bool loud = iteration % 4 == 0;
+			for (short& sample : ring)
+				sample = loud ? (rng() & 1 ? 32767 : -32768) : (short)rng();
+
+			// Any frame in the ring, so reads wrap around its end, and an odd
+			// number of frames that may or may not run the ring dry
+			const u32 start = rng() & ~1u;
+			const u32 available = rng() % (MAX_SAMPLES - 1);
+			const u32 indexW = start + 2 * available;
+			const u32 ratio = 0x4000 + rng() % 0xC000 | 1;
+			const u32 start_frac = rng() & 0xffff;
+			const unsigned int num_frames = 1 + 2 * (rng() % 300);
+
+			std::vector<short> initial(num_frames * 2);
+			for (short& sample : initial)
+				sample = (short)rng();
+
+			std::vector<short> simd = initial, scalar = initial;
+			u32 simd_indexR = start, simd_frac = start_frac;
+			u32 scalar_indexR = start, scalar_frac = start_frac;
+			const unsigned int simd_frames = ResampleFrames(ring.data(), simd.data(), num_frames, indexW,
+			                                                simd_indexR, simd_frac, ratio, quality, true);
+			const unsigned int scalar_frames = ResampleFrames(ring.data(), scalar.data(), num_frames, indexW,
+			                                                  scalar_indexR, scalar_frac, ratio, quality, false);
+
+			ASSERT_EQ(scalar_frames, simd_frames) << "quality " << quality << ", iteration " << iteration;
+			ASSERT_EQ(scalar_indexR, simd_indexR) << "quality " << quality << ", iteration " << iteration;
+			ASSERT_EQ(scalar_frac, simd_frac) << "quality " << quality << ", iteration " << iteration;
+			ASSERT_TRUE(scalar == simd) << "quality " << quality << ", iteration " << iteration;
+		}
+	}
+}
+
+TEST(MixerResample, PolyphaseKeepsDC)
+{
+	std::vector<short> ring(MAX_SAMPLES * 2, -1234);
+	std::vector<short> out(101 * 2);
+	u32 indexR = 0, frac = 0;
+	EXPECT_EQ(101u, ResampleFrames(ring.data(), out.data(), 101, MAX_SAMPLES, indexR, frac, 0xAAAA, RESAMPLE_POLYPHASE));
+	EXPECT_TRUE(std::all_of(out.begin(), out.end(), [](short s) { return s == -1234; }));
+}
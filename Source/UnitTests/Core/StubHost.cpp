@@ -0,0 +1,55 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Stub implementation of the Host_* callbacks, for tests that link the whole
+// Core library without any frontend.
+
+#include <string>
+
+#include "Core/Host.h"
+
+bool Host_RendererHasFocus() { return false; }
+void Host_ConnectWiimote(int wm_idx, bool connect) {}
+void Host_GetRenderWindowSize(int& x, int& y, int& width, int& height) { x = y = width = height = 0; }
+void Host_Message(int Id) {}
+void Host_NotifyMapLoaded() {}
+void Host_RefreshDSPDebuggerWindow() {}
+void Host_RequestRenderWindowSize(int width, int height) {}
+void Host_SetStartupDebuggingParameters() {}
+void Host_SetWiiMoteConnectionState(int _State) {}
+void Host_ShowJitResults(unsigned int address) {}
+void Host_SysMessage(const char *fmt, ...) {}
+void Host_UpdateBreakPointView() {}
+void Host_UpdateDisasmDialog() {}
+void Host_UpdateLogDisplay() {}
+void Host_UpdateMainFrame() {}
+void Host_UpdateStatusBar(const std::string& text, int Filed) {}
+void Host_UpdateTitle(const std::string& title) {}
+void* Host_GetInstance() { return nullptr; }
+void* Host_GetRenderHandle() { return nullptr; }
+
+// The OpenGL backend gets its GL interface from the frontend. Tests never
+// create a video backend, these only have to link.
+#if defined(USE_EGL) && USE_EGL
+#include "DolphinWX/GLInterface/EGL.h"
+
+void cInterfaceEGL::SwapInterval(int Interval) {}
+void cInterfaceEGL::Swap() {}
+void cInterfaceEGL::UpdateFPSDisplay(const std::string& text) {}
+void* cInterfaceEGL::GetFuncAddress(const std::string& name) { return nullptr; }
+bool cInterfaceEGL::Create(void *&window_handle) { return false; }
+bool cInterfaceEGL::MakeCurrent() { return false; }
+void cInterfaceEGL::Shutdown() {}
+#elif !defined(__APPLE__) && !defined(_WIN32) && defined(HAVE_X11) && HAVE_X11
+#include "DolphinWX/GLInterface/GLX.h"
+
+void cInterfaceGLX::SwapInterval(int Interval) {}
+void cInterfaceGLX::Swap() {}
+void cInterfaceGLX::UpdateFPSDisplay(const std::string& text) {}
+void* cInterfaceGLX::GetFuncAddress(const std::string& name) { return nullptr; }
+bool cInterfaceGLX::Create(void *&window_handle) { return false; }
+bool cInterfaceGLX::MakeCurrent() { return false; }
+bool cInterfaceGLX::ClearCurrent() { return false; }
+void cInterfaceGLX::Shutdown() {}
+#endif
@@ -0,0 +1,122 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Core/MemTools.h"
+#include "Core/HW/Memmap.h"
+
+#include "CoreTestUtil.h"
+
+namespace
+{
+
+const u32 TEXTURE_ADDRESS = 0x80100000;
+const u32 TEXTURE_SIZE = 0x2000;
+
+// A store the way the JIT does it, through the mirror at base + address
+void CPUWrite(u32 address, u8 value)
+{
+	*(volatile u8*)(Memory::base + address) = value;
+}
+
+}
+
+class WriteWatchTest : public testing::Test
+{
+protected:
+	static void SetUpTestCase()
+	{
+		CoreTestUtil::Init(true);
+		EMM::InstallExceptionHandler();
+	}
+
+	static void TearDownTestCase()
+	{
+		CoreTestUtil::Shutdown();
+	}
+
+	void SetUp() override
+	{
+		Memory::SetWriteWatch(true);
+		ASSERT_TRUE(Memory::IsWriteWatchEnabled());
+	}
+
+	void TearDown() override
+	{
+		Memory::SetWriteWatch(false);
+	}
+};
+
+TEST_F(WriteWatchTest, UntouchedRangeIsUnchanged)
+{
+	const u64 seq = Memory::WatchRange(TEXTURE_ADDRESS, TEXTURE_SIZE);
+	ASSERT_NE(0u, seq);
+	EXPECT_TRUE(Memory::IsRangeUnchanged(TEXTURE_ADDRESS, TEXTURE_SIZE, seq));
+
+	// Reads never fault
+	u8 sum = 0;
+	for (u32 i = 0; i < TEXTURE_SIZE; i += 64)
+		sum += *(volatile u8*)(Memory::base + TEXTURE_ADDRESS + i);
+	EXPECT_EQ(0, sum);
+	EXPECT_TRUE(Memory::IsRangeUnchanged(TEXTURE_ADDRESS, TEXTURE_SIZE, seq));
+
+	// Neither do writes elsewhere
+	CPUWrite(TEXTURE_ADDRESS + 0x10000, 1);
+	EXPECT_TRUE(Memory::IsRangeUnchanged(TEXTURE_ADDRESS, TEXTURE_SIZE, seq));
+
+	// The same memory through the uncached and physical addresses
+	EXPECT_TRUE(Memory::IsRangeUnchanged(TEXTURE_ADDRESS & 0x0FFFFFFF, TEXTURE_SIZE, seq));
+	EXPECT_TRUE(Memory::IsRangeUnchanged(TEXTURE_ADDRESS | 0x40000000, TEXTURE_SIZE, seq));
+}
+
+TEST_F(WriteWatchTest, CPUWriteFaults)
+{
+	u64 seq = Memory::WatchRange(TEXTURE_ADDRESS, TEXTURE_SIZE);
+	CPUWrite(TEXTURE_ADDRESS + 0x1234, 0x42);
+	EXPECT_FALSE(Memory::IsRangeUnchanged(TEXTURE_ADDRESS, TEXTURE_SIZE, seq));
+	EXPECT_EQ(0x42, Memory::Read_U8(TEXTURE_ADDRESS + 0x1234));
+
+	// Only the written page changed
+	EXPECT_TRUE(Memory::IsRangeUnchanged(TEXTURE_ADDRESS, 0x1000, seq));
+
+	// The uncached mirror is protected too
+	seq = Memory::WatchRange(TEXTURE_ADDRESS, TEXTURE_SIZE);
+	EXPECT_TRUE(Memory::IsRangeUnchanged(TEXTURE_ADDRESS, TEXTURE_SIZE, seq));
+	CPUWrite((TEXTURE_ADDRESS | 0x40000000) + 0x10, 0x43);
+	EXPECT_FALSE(Memory::IsRangeUnchanged(TEXTURE_ADDRESS, TEXTURE_SIZE, seq));
+}
+
+TEST_F(WriteWatchTest, EmulatorWritesAreMarked)
+{
+	u64 seq = Memory::WatchRange(TEXTURE_ADDRESS, TEXTURE_SIZE);
+	const u8 data[4] = { 1, 2, 3, 4 };
+	Memory::WriteBigEData(data, TEXTURE_ADDRESS + 0x1ffc, sizeof(data));
+	EXPECT_FALSE(Memory::IsRangeUnchanged(TEXTURE_ADDRESS, TEXTURE_SIZE, seq));
+
+	seq = Memory::WatchRange(TEXTURE_ADDRESS, TEXTURE_SIZE);
+	Memory::Write_U32(0x12345678, TEXTURE_ADDRESS);
+	EXPECT_FALSE(Memory::IsRangeUnchanged(TEXTURE_ADDRESS, TEXTURE_SIZE, seq));
+
+	seq = Memory::WatchRange(TEXTURE_ADDRESS, TEXTURE_SIZE);
+	Memory::Memset(TEXTURE_ADDRESS + 0x800, 0, 0x100);
+	EXPECT_FALSE(Memory::IsRangeUnchanged(TEXTURE_ADDRESS, TEXTURE_SIZE, seq));
+}
+
+TEST_F(WriteWatchTest, DisableUnprotects)
+{
+	const u64 seq = Memory::WatchRange(TEXTURE_ADDRESS, TEXTURE_SIZE);
+	Memory::SetWriteWatch(false);
+	EXPECT_FALSE(Memory::IsRangeUnchanged(TEXTURE_ADDRESS, TEXTURE_SIZE, seq));
+
+	// Would crash if the page was still read only
+	CPUWrite(TEXTURE_ADDRESS, 7);
+	EXPECT_EQ(7, Memory::Read_U8(TEXTURE_ADDRESS));
+
+	// Nothing outside RAM can be watched
+	Memory::SetWriteWatch(true);
+	EXPECT_EQ(0u, Memory::WatchRange(0xCC000000, 0x1000));
+	EXPECT_EQ(0u, Memory::WatchRange(TEXTURE_ADDRESS, 0));
+}
@@ -0,0 +1,403 @@
+// Copyright 2014 Dolphin Emulator Project
+// Licensed under GPLv2
+// Refer to the license.txt file included.
+
+// Checks the Zelda ucode AFC decoder and synthesizers against the per sample
+// versions they replaced, and benchmarks mixing a set of voices through the
+// ucode's command lists.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "Common/CommonTypes.h"
+#include "Common/MathUtil.h"
+#include "Core/HW/DSP.h"
+#include "Core/HW/Memmap.h"
+#include "Core/HW/DSPHLE/DSPHLE.h"
+#include "Core/HW/DSPHLE/UCodes/Zelda.h"
+
+#include "CoreTestUtil.h"
+
+namespace
+{
+
+void ReferenceAFCDecode(const s16* coef, const u8* src, s16* out, s16* histp, s16* hist2p, int type)
+{
+	short delta = 1 << ((src[0] >> 4) & 0xf);
+	short idx = src[0] & 0xf;
+	src++;
+
+	short nibbles[16];
+	if (type == 9)
+	{
+		for (int i = 0; i < 16; i += 2)
+		{
+			nibbles[i + 0] = *src >> 4;
+			nibbles[i + 1] = *src & 15;
+			src++;
+		}
+		for (auto& nibble : nibbles)
+		{
+			if (nibble >= 8)
+				nibble = nibble - 16;
+			nibble <<= 11;
+		}
+	}
+	else
+	{
+		for (int i = 0; i < 16; i += 4)
+		{
+			nibbles[i + 0] = (*src >> 6) & 0x03;
+			nibbles[i + 1] = (*src >> 4) & 0x03;
+			nibbles[i + 2] = (*src >> 2) & 0x03;
+			nibbles[i + 3] = (*src >> 0) & 0x03;
+			src++;
+		}
+		for (auto& nibble : nibbles)
+		{
+			if (nibble >= 2)
+				nibble = nibble - 4;
+			nibble <<= 13;
+		}
+	}
+
+	short hist = *histp;
+	short hist2 = *hist2p;
+	for (int i = 0; i < 16; i++)
+	{
+		int sample = delta * nibbles[i] + ((int)hist * coef[idx * 2]) + ((int)hist2 * coef[idx * 2 + 1]);
+		sample >>= 11;
+		MathUtil::Clamp(&sample, -32768, 32767);
+		out[i] = sample;
+		hist2 = hist;
+		hist = (short)sample;
+	}
+	*histp = hist;
+	*hist2p = hist2;
+}
+
+void ReferenceRectWave(ZeldaVoicePB& PB, s32* buffer, int size)
+{
+	s64 ratio = ((s64)PB.RatioInt << 16) * 16;
+	s64 TrueSamplePosition = PB.CurSampleFrac;
+	unsigned int mask = PB.Format ? 3 : 1;
+	u32 pos[2] = {0, 0};
+	int i = 0;
+
+	if (PB.KeyOff != 0)
+		return;
+
+	if (PB.NeedsReset)
+	{
+		PB.RemLength = PB.Length - PB.RestartPos;
+		PB.CurAddr = PB.StartAddr + (PB.RestartPos << 1);
+		PB.ReachedEnd = 0;
+	}
+
+restart:
+	if (PB.ReachedEnd)
+	{
+		PB.ReachedEnd = 0;
+		if (PB.RepeatMode == 0)
+		{
+			PB.KeyOff = 1;
+			PB.RemLength = 0;
+			PB.CurAddr = PB.StartAddr + (PB.RestartPos << 1) + PB.Length;
+			return;
+		}
+		PB.RestartPos = PB.LoopStartPos;
+		PB.RemLength = PB.Length - PB.RestartPos;
+		PB.CurAddr = PB.StartAddr + (PB.RestartPos << 1);
+		pos[1] = 0; pos[0] = 0;
+	}
+
+	while (i < size)
+	{
+		s16 sample = ((pos[1] & mask) == mask) ? 0xc000 : 0x4000;
+		TrueSamplePosition += (ratio >> 16);
+		buffer[i++] = (s32)sample;
+
+		(*(u64*)&pos) += ratio;
+		if ((pos[1] + ((PB.CurAddr - PB.StartAddr) >> 1)) >= PB.Length)
+		{
+			PB.ReachedEnd = 1;
+			goto restart;
+		}
+	}
+
+	if (PB.RemLength < pos[1])
+	{
+		PB.RemLength = 0;
+		PB.ReachedEnd = 1;
+	}
+	else
+	{
+		PB.RemLength -= pos[1];
+	}
+
+	PB.CurSampleFrac = TrueSamplePosition & 0xFFFF;
+}
+
+u16 AddValueToReg(u32 ar, s32 ix)
+{
+	u32 wr = 0x3f;
+	u32 mx = (wr | 1) << 1;
+	u32 nar = ar + ix;
+	u32 dar = (nar ^ ar ^ ix) & mx;
+
+	if (ix >= 0)
+	{
+		if (dar > wr)
+			nar -= wr + 1;
+	}
+	else
+	{
+		if ((((nar + wr + 1) ^ nar) & dar) <= wr)
+			nar += wr + 1;
+	}
+	return nar;
+}
+
+void ReferenceWaveTable(ZeldaVoicePB& PB, s32* buffer, const s16* misc_table)
+{
+	u16 address;
+	switch (PB.Format)
+	{
+	default:
+	case 0x0004: address = 0x140; break;
+	case 0x0007: address = 0x100; break;
+	case 0x000b: address = 0x180; break;
+	case 0x000c: address = 0x1c0; break;
+	}
+
+	u64 ACC0 = PB.CurSampleFrac << 6;
+	ACC0 &= 0xffff003fffffULL;
+	address = AddValueToReg(address, ((ACC0 >> 16) & 0xffff));
+	ACC0 &= 0xffff0000ffffULL;
+
+	for (int i = 0; i < 0x50; i++)
+	{
+		buffer[i] = misc_table[address];
+		ACC0 += PB.RatioInt << 5;
+		address = AddValueToReg(address, ((ACC0 >> 16) & 0xffff));
+		ACC0 &= 0xffff0000ffffULL;
+	}
+
+	ACC0 += address << 16;
+	PB.CurSampleFrac = (ACC0 >> 6) & 0xffff;
+}
+
+// The light version of the ucode (IPL), which mixes every voice on each
+// sync mail
+const u32 LIGHT_UCODE_CRC = 0x6ba3b3ea;
+const int SAMPLES_PER_BUFFER = 5 * 16;
+
+const u32 VOICE_PBS_ADDRESS = 0x00200000;
+const u32 MISC_TABLE_ADDRESS = 0x00300000;
+const u32 AFC_COEFS_ADDRESS = 0x00301000;
+const u32 LEFT_BUFFERS_ADDRESS = 0x00302000;
+const u32 RIGHT_BUFFERS_ADDRESS = 0x00303000;
+
+void WriteVoicePB(u32 address, ZeldaVoicePB pb)
+{
+	u32* words[] = { &pb.RestartPos, &pb.CurAddr, &pb.RemLength, &pb.LoopStartPos,
+	                 &pb.Length, &pb.StartAddr, &pb.UnkAddr };
+	for (u32* word : words)
+		*word = (*word << 16) | (*word >> 16);
+
+	u16* memory = (u16*)Memory::GetPointer(address);
+	for (int i = 0; i < 0xc0; i++)
+		memory[i] = Common::swap16(pb.raw[i]);
+}
+
+void WriteTable(u32 address, const s16* table, int count)
+{
+	u16* memory = (u16*)Memory::GetPointer(address);
+	for (int i = 0; i < count; i++)
+		memory[i] = Common::swap16((u16)table[i]);
+}
+
+}
+
+class ZeldaUCodeTest : public testing::Test
+{
+protected:
+	static void SetUpTestCase()
+	{
+		CoreTestUtil::Init(false);
+		DSP::Init(true);
+	}
+
+	static void TearDownTestCase()
+	{
+		DSP::Shutdown();
+		CoreTestUtil::Shutdown();
+	}
+};
+
+TEST_F(ZeldaUCodeTest, AFCDecodeMatchesReference)
+{
+	std::mt19937 rng(1);
+	s16 coefs[32];
+	for (s16& coef : coefs)
+		coef = (s16)(rng() % 0x2000) - 0x1000;
+
+	for (int type = 5; type <= 9; type += 4)
+	{
+		s16 ref_hist = 0, ref_hist2 = 0, hist = 0, hist2 = 0;
+		for (int block = 0; block < 1000; block++)
+		{
+			u8 data[9];
+			for (u8& byte : data)
+				byte = (u8)rng();
+
+			s16 expected[16], result[16];
+			ReferenceAFCDecode(coefs, data, expected, &ref_hist, &ref_hist2, type);
+			ZeldaUCode::AFCdecodebuffer(coefs, (const char*)data, result, &hist, &hist2, type);
+
+			ASSERT_EQ(0, memcmp(expected, result, sizeof (result))) << "type " << type << " block " << block;
+			ASSERT_EQ(ref_hist, hist);
+			ASSERT_EQ(ref_hist2, hist2);
+		}
+	}
+}
+
+TEST_F(ZeldaUCodeTest, RectWaveMatchesReference)
+{
+	std::mt19937 rng(2);
+	for (int voice = 0; voice < 200; voice++)
+	{
+		ZeldaVoicePB pb;
+		memset(&pb, 0, sizeof (pb));
+		pb.Format = voice & 1 ? 0x0003 : 0x0000;
+		pb.RatioInt = voice < 10 ? voice * 0x1000 : rng() % 0x10000;
+		pb.NeedsReset = 1;
+		pb.RepeatMode = voice % 5 != 0;
+		pb.StartAddr = rng() % 0x10000;
+		pb.Length = 1 + rng() % 400;
+		pb.RestartPos = rng() % pb.Length;
+		pb.LoopStartPos = rng() % pb.Length;
+		pb.CurSampleFrac = rng() % 0x10000;
+
+		ZeldaVoicePB ref_pb = pb;
+		for (int frame = 0; frame < 8; frame++)
+		{
+			s32 expected[SAMPLES_PER_BUFFER], result[SAMPLES_PER_BUFFER];
+			memset(expected, 0, sizeof (expected));
+			memset(result, 0, sizeof (result));
+
+			ReferenceRectWave(ref_pb, expected, SAMPLES_PER_BUFFER);
+			ZeldaUCode::RenderSynth_RectWave(pb, result, SAMPLES_PER_BUFFER);
+			ref_pb.NeedsReset = pb.NeedsReset = 0;
+
+			ASSERT_EQ(0, memcmp(expected, result, sizeof (result))) << "voice " << voice << " frame " << frame;
+			ASSERT_EQ(0, memcmp(&ref_pb, &pb, sizeof (pb))) << "voice " << voice << " frame " << frame;
+		}
+	}
+}
+
+TEST_F(ZeldaUCodeTest, WaveTableMatchesReference)
+{
+	std::mt19937 rng(3);
+	s16 misc_table[0x280];
+	for (s16& value : misc_table)
+		value = (s16)rng();
+
+	const u16 formats[] = { 0x0004, 0x0007, 0x000b, 0x000c };
+	for (int voice = 0; voice < 200; voice++)
+	{
+		ZeldaVoicePB pb;
+		memset(&pb, 0, sizeof (pb));
+		pb.Format = formats[voice & 3];
+		pb.RatioInt = voice < 4 ? 0xFFFF * (voice & 1) : rng() % 0x10000;
+		pb.CurSampleFrac = rng() % 0x10000;
+
+		ZeldaVoicePB ref_pb = pb;
+		for (int frame = 0; frame < 8; frame++)
+		{
+			s32 expected[SAMPLES_PER_BUFFER], result[SAMPLES_PER_BUFFER];
+			ReferenceWaveTable(ref_pb, expected, misc_table);
+			ZeldaUCode::RenderSynth_WaveTable(pb, result, SAMPLES_PER_BUFFER, misc_table);
+
+			ASSERT_EQ(0, memcmp(expected, result, sizeof (result))) << "voice " << voice << " frame " << frame;
+			ASSERT_EQ(ref_pb.CurSampleFrac, pb.CurSampleFrac);
+		}
+	}
+}
+
+// Sets up 64 looping voices (mostly AFC, with some rectangle and wave table
+// ones) and mixes them through the ucode's DsetupTable and DsyncFrame lists.
+TEST_F(ZeldaUCodeTest, Benchmark)
+{
+	const u32 num_voices = 64;
+	const u32 num_buffers = 4;
+	const int num_frames = 50;
+
+	std::mt19937 rng(4);
+	u8* aram = DSP::GetARAMPtr();
+	for (u32 i = 0; i < 0x100000; i++)
+		aram[i] = (u8)rng();
+
+	s16 misc_table[0x280];
+	for (s16& value : misc_table)
+		value = (s16)(rng() % 0x4000) - 0x2000;
+	WriteTable(MISC_TABLE_ADDRESS, misc_table, 0x280);
+
+	s16 afc_coefs[32];
+	for (s16& coef : afc_coefs)
+		coef = (s16)(rng() % 0x1000) - 0x800;
+	WriteTable(AFC_COEFS_ADDRESS, afc_coefs, 32);
+
+	for (u32 i = 0; i < num_voices; i++)
+	{
+		ZeldaVoicePB pb;
+		memset(&pb, 0, sizeof (pb));
+		pb.Status = 1;
+		pb.NeedsReset = 1;
+		pb.RatioInt = 0x800 + rng() % 0x1000;
+		pb.Format = i % 8 == 7 ? 0x0000 : i % 8 == 6 ? 0x0004 : (i & 1 ? 0x0009 : 0x0005);
+		pb.RepeatMode = 1;
+		pb.StartAddr = i * 0x4000;
+		pb.Length = 0x4000;
+		pb.SoundType = 1;
+		pb.volumeLeft1 = 0x4000;
+		pb.volumeLeft2 = 0x3000;
+		WriteVoicePB(VOICE_PBS_ADDRESS + i * 0x180, pb);
+	}
+
+	DSPHLE dsphle;
+	ZeldaUCode ucode(&dsphle, LIGHT_UCODE_CRC);
+
+	ucode.HandleMail(0x01000000 | num_voices);
+	ucode.HandleMail(VOICE_PBS_ADDRESS);
+	ucode.HandleMail(MISC_TABLE_ADDRESS);
+	ucode.HandleMail(AFC_COEFS_ADDRESS);
+	ucode.HandleMail(0);
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int frame = 0; frame < num_frames; frame++)
+	{
+		ucode.HandleMail(0x02000000 | (num_buffers << 16));
+		ucode.HandleMail(LEFT_BUFFERS_ADDRESS);
+		ucode.HandleMail(RIGHT_BUFFERS_ADDRESS);
+		for (u32 buffer = 0; buffer < num_buffers; buffer++)
+			ucode.HandleMail(0);
+		dsphle.AccessMailHandler().Clear();
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	double us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() /
+	            (double)(num_frames * num_buffers);
+
+	printf("Zelda: %u voices: %.1f us per %d sample buffer\n", num_voices, us, SAMPLES_PER_BUFFER);
+
+	// Something made it to the output
+	const s16* left = (const s16*)Memory::GetPointer(LEFT_BUFFERS_ADDRESS);
+	bool any = false;
+	for (u32 i = 0; i < num_buffers * SAMPLES_PER_BUFFER; i++)
+		any |= left[i] != 0;
+	EXPECT_TRUE(any);
+}
@@ -0,0 +1,19 @@
+	clr $ACC0
+	clr $ACC1
+	lri $AR0, #0x0100
+	lri $AC1.M, #25
+loop:
+	call add_one
+	decm $AC1.M
+	jnz loop
+	lri $AC1.M, #30
+tight:
+	addis $AC0.M, #3
+	decm $AC1.M
+	jnz tight
+	sr @0x0010, $AC0.M
+	halt
+add_one:
+	addis $AC0.M, #1
+	srri @$AR0, $AC0.M
+	ret